@@ -0,0 +1,92 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "cadef.h"
+#include "epicsStdio.h"
+#include "epicsTime.h"
+#include "caDiagnostics.h"
+
+static unsigned connCount = 0u;
+
+extern "C" void caConnRateConnHandler ( struct connection_handler_args args )
+{
+    if ( args.op == CA_OP_CONN_UP ) {
+        connCount++;
+    }
+    else if ( args.op == CA_OP_CONN_DOWN ) {
+        connCount--;
+    }
+}
+
+/*
+ * caConnRate ()
+ *
+ * For each channel count, time creating that many channels and
+ * waiting for all of them to connect. When nNames
+ * is more than one, a number below nNames is appended to the PV name
+ * so that the channels are spread over that many PVs.
+ */
+void caConnRate ( const char *pName, unsigned nNames,
+    const unsigned *pCounts, unsigned nCounts )
+{
+    static const double connectTimeout = 300.0;
+    size_t nameSize = strlen ( pName ) + 16u;
+    char *pNameBuf = new char [ nameSize ];
+
+    printf ( "%10s %12s %12s %14s\n", "channels", "create (s)",
+        "connect (s)", "channels/s" );
+
+    for ( unsigned j = 0u; j < nCounts; j++ ) {
+        unsigned channelCount = pCounts[j];
+        chid *pChans = new chid [ channelCount ];
+
+        int status = ca_context_create ( ca_disable_preemptive_callback );
+        SEVCHK ( status, "CA init failed" );
+
+        connCount = 0u;
+        epicsTime begin = epicsTime::getCurrent ();
+
+        for ( unsigned i = 0u; i < channelCount; i++ ) {
+            const char *pChanName = pName;
+            if ( nNames > 1u ) {
+                epicsSnprintf ( pNameBuf, nameSize, "%s%u",
+                    pName, i % nNames );
+                pChanName = pNameBuf;
+            }
+            status = ca_create_channel ( pChanName,
+                caConnRateConnHandler, 0, 0, & pChans[i] );
+            SEVCHK ( status, "CA search problems" );
+        }
+        ca_flush_io ();
+
+        epicsTime created = epicsTime::getCurrent ();
+
+        double delay = 0.0;
+        while ( connCount < channelCount && delay < connectTimeout ) {
+            ca_pend_event ( 0.01 );
+            delay = epicsTime::getCurrent () - begin;
+        }
+
+        if ( connCount < channelCount ) {
+            printf ( "%10u %12.3f only %u connected after %.0f s\n",
+                channelCount, created - begin, connCount, delay );
+        }
+        else {
+            printf ( "%10u %12.3f %12.3f %14.0f\n", channelCount,
+                created - begin, delay, channelCount / delay );
+        }
+        fflush ( stdout );
+
+        // a new context for each count, so none reuses a circuit
+        ca_context_destroy ();
+        delete [] pChans;
+    }
+
+    delete [] pNameBuf;
+}
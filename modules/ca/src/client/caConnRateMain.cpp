@@ -0,0 +1,49 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+
+#include "caDiagnostics.h"
+
+int main ( int argc, char **argv )
+{
+    static const unsigned defaultCounts[] = { 10000u, 100000u, 1000000u };
+    unsigned counts[16];
+    unsigned nCounts = 0u;
+    unsigned nNames = 1u;
+
+    if ( argc < 2 || argc > 3 + 16 ) {
+        printf ( "usage: %s < PV name > [ < name count > [ < channel count > ... ] ]\n",
+            argv[0] );
+        return -1;
+    }
+
+    if ( argc >= 3 ) {
+        if ( sscanf ( argv[2], "%u", &nNames ) != 1 || nNames == 0u ) {
+            printf ( "expected positive integer name count \"%s\"\n", argv[2] );
+            return -1;
+        }
+    }
+
+    for ( int i = 3; i < argc; i++ ) {
+        if ( sscanf ( argv[i], "%u", &counts[nCounts] ) != 1 ||
+                counts[nCounts] == 0u ) {
+            printf ( "expected positive integer channel count \"%s\"\n", argv[i] );
+            return -1;
+        }
+        nCounts++;
+    }
+
+    if ( nCounts ) {
+        caConnRate ( argv[1], nNames, counts, nCounts );
+    }
+    else {
+        caConnRate ( argv[1], nNames, defaultCounts,
+            sizeof ( defaultCounts ) / sizeof ( defaultCounts[0] ) );
+    }
+
+    return 0;
+}
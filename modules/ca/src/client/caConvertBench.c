@@ -0,0 +1,105 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS Base is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Measure how fast caNetConvert() converts arrays of each DBR type
+ *  between host and network format. swapCopyTest checks the results.
+ *
+ *  usage: caConvertBench [elements] [repetitions]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epicsTime.h"
+#include "net_convert.h"
+#include "swapCopy.h"
+
+static double convertRate ( unsigned type, void *pSrc, void *pDest,
+    int hton, arrayElementCount count, unsigned reps )
+{
+    epicsTimeStamp start, stop;
+    double best = 0.0;
+    unsigned i;
+
+    for ( i = 0u; i < reps; i++ ) {
+        double secs;
+
+        epicsTimeGetCurrent ( &start );
+        caNetConvert ( type, pSrc, pDest, hton, count );
+        epicsTimeGetCurrent ( &stop );
+        secs = epicsTimeDiffInSeconds ( &stop, &start );
+        if ( secs > 0.0 ) {
+            double rate = dbr_size_n ( type, count ) / secs / 1e9;
+            if ( rate > best ) {
+                best = rate;
+            }
+        }
+    }
+    return best;
+}
+
+int main ( int argc, char **argv )
+{
+    static const unsigned types[] = {
+        DBR_STRING, DBR_SHORT, DBR_FLOAT, DBR_ENUM, DBR_CHAR, DBR_LONG,
+        DBR_DOUBLE, DBR_TIME_SHORT, DBR_TIME_FLOAT, DBR_TIME_LONG,
+        DBR_TIME_DOUBLE, DBR_CTRL_DOUBLE
+    };
+    arrayElementCount count = 1000000;
+    unsigned reps = 20u;
+    size_t size;
+    char *pSrc, *pDest;
+    unsigned i;
+
+    if ( argc > 1 ) {
+        count = strtoul ( argv[1], NULL, 10 );
+    }
+    if ( argc > 2 ) {
+        reps = (unsigned) strtoul ( argv[2], NULL, 10 );
+    }
+    if ( count < 1 || reps < 1 ) {
+        fprintf ( stderr, "usage: %s [elements] [repetitions]\n", argv[0] );
+        return 1;
+    }
+
+    size = dbr_size_n ( DBR_STRING, count );
+    pSrc = malloc ( size );
+    pDest = malloc ( size );
+    if ( ! pSrc || ! pDest ) {
+        fprintf ( stderr, "%s: Out of memory\n", argv[0] );
+        return 1;
+    }
+    for ( i = 0u; i < size; i++ ) {
+        pSrc[i] = (char) ( i * 7u );
+    }
+
+    printf ( "Byte swapping with %s instructions\n", swapCopyKernel () );
+    printf ( "Best of %u conversions of %lu elements, GB/s\n",
+        reps, (unsigned long) count );
+    printf ( "%-18s %10s %10s %10s\n",
+        "type", "to net", "from net", "in place" );
+    for ( i = 0u; i < sizeof ( types ) / sizeof ( types[0] ); i++ ) {
+        unsigned type = types[i];
+        double toNet, fromNet, inPlace;
+
+        toNet = convertRate ( type, pSrc, pDest, 1, count, reps );
+        fromNet = convertRate ( type, pDest, pSrc, 0, count, reps );
+        printf ( "%-18s %10.2f %10.2f", dbr_type_to_text ( type ),
+            toNet, fromNet );
+        /* nothing to do for these */
+        if ( type == DBR_STRING || type == DBR_CHAR ) {
+            printf ( " %10s\n", "-" );
+        }
+        else {
+            inPlace = convertRate ( type, pDest, pDest, 0, count, reps );
+            printf ( " %10.2f\n", inPlace );
+        }
+    }
+
+    free ( pSrc );
+    free ( pDest );
+    return 0;
+}
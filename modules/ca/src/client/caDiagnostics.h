@@ -32,6 +32,8 @@ int acctst ( const char *pname, unsigned logggingInterestLevel,
 #endif
 
 void caConnTest ( const char *pNameIn, unsigned channelCountIn, double delayIn );
+void caConnRate ( const char *pName, unsigned nNames,
+    const unsigned *pCounts, unsigned nCounts );
 
 #endif /* ifndef INC_caDiagnostics_H */
 
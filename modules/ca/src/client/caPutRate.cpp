@@ -0,0 +1,88 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <math.h>
+
+#include "cadef.h"
+#include "dbDefs.h"
+#include "epicsTime.h"
+#include "errlog.h"
+#include "caProto.h"
+
+/*
+ * caPutRate ()
+ *
+ * Measures the rate at which the client library can send puts to a
+ * server by repeatedly queuing count puts and flushing them. A get
+ * after each flush waits until the server has seen them all.
+ */
+void caPutRate ( const char *pName, unsigned count )
+{
+    static const double initialSamplePeriod = 1.0;
+    static const double maxSamplePeriod = 60.0 * 5.0;
+    chid chan;
+
+    {
+        printf ( "Connecting to CA Channel \"%s\".", pName );
+        fflush ( stdout );
+
+        int status = ca_create_channel ( pName, 0, 0, 0, & chan );
+        SEVCHK ( status, NULL );
+
+        status = ca_pend_io ( 10.0 );
+        if ( status != ECA_NORMAL ) {
+            fprintf ( stderr, " not found.\n" );
+            return;
+        }
+        printf ( " done.\n" );
+    }
+
+    unsigned bytesPerPut = sizeof ( caHdr ) + dbr_size[DBR_DOUBLE];
+    printf ( "Sending %u puts of %u bytes per flush.\n", count, bytesPerPut );
+
+    double samplePeriod = initialSamplePeriod;
+    double X = 0.0;
+    double XX = 0.0;
+    unsigned N = 0u;
+    while ( true ) {
+        unsigned nPuts = 0u;
+
+        epicsTime begin = epicsTime::getCurrent ();
+        double period;
+        do {
+            for ( unsigned i = 0u; i < count; i++ ) {
+                dbr_double_t value = i;
+                int status = ca_put ( DBR_DOUBLE, chan, & value );
+                SEVCHK ( status, NULL );
+            }
+            dbr_double_t value;
+            int status = ca_get ( DBR_DOUBLE, chan, & value );
+            SEVCHK ( status, NULL );
+            status = ca_pend_io ( 30.0 );
+            SEVCHK ( status, NULL );
+            nPuts += count;
+            period = epicsTime::getCurrent () - begin;
+        } while ( period < samplePeriod );
+
+        N++;
+
+        double Hz = nPuts / period;
+
+        X += Hz;
+        XX += Hz * Hz;
+
+        double mean = X / N;
+        double stdDev = sqrt ( XX / N - mean * mean );
+
+        printf ( "CA Put Rate (Hz): current %g mean %g std dev %g (%g MB/s)\n",
+            Hz, mean, stdDev, Hz * bytesPerPut / 1e6 );
+
+        if ( samplePeriod < maxSamplePeriod ) {
+            samplePeriod += samplePeriod;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void caPutRate ( const char *pName, unsigned count );
+
+int main ( int argc, char **argv )
+{
+    if ( argc < 2 || argc > 3 ) {
+        fprintf ( stderr, "usage: %s < PV name > [puts per flush]\n", argv[0] );
+        return 0;
+    }
+
+    unsigned count;
+    if ( argc == 3 ) {
+        int status = sscanf ( argv[2], " %u ", & count );
+        if ( status != 1 || count == 0u ) {
+            fprintf ( stderr, "expected positive integer 2nd argument\n" );
+            return 0;
+        }
+    }
+    else {
+        count = 10000u;
+    }
+
+    caPutRate ( argv[1], count );
+
+    return 0;
+}
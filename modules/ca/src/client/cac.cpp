@@ -136,7 +136,8 @@ cac::cac (
     cbMutex ( callbackControlIn ),
     ipToAEngine ( ipAddrToAsciiEngine::allocate () ),
     timerQueue ( epicsTimerQueueActive::allocate ( false,
-        lowestPriorityLevelAbove(epicsThreadGetPrioritySelf()) ) ),
+        lowestPriorityLevelAbove(epicsThreadGetPrioritySelf()),
+        epicsTimerQueueTimingWheel ) ),
     pUserName ( 0 ),
     pudpiiu ( 0 ),
     tcpSmallRecvBufFreeList ( 0 ),
@@ -418,6 +419,9 @@ void cac::show (
     if ( level > 0u ) {
         this->serverTable.show ( level - 1u );
         ::printf ( "\tconnection time out watchdog period %f\n", this->connTMO );
+        if ( this->pudpiiu ) {
+            this->pudpiiu->showSearchStatistics ( guard );
+        }
     }
 
     if ( level > 1u ) {
@@ -495,7 +499,7 @@ void cac::beaconNotify ( const inetAddrID & addr, const epicsTime & currentTime,
 
     this->beaconAnomalyCount++;
 
-    this->pudpiiu->beaconAnomalyNotify ( guard );
+    this->pudpiiu->beaconAnomalyNotify ( guard, addr );
 
 #   ifdef DEBUG
     {
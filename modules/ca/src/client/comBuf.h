@@ -33,6 +33,7 @@
 #include "tsDLList.h"
 #include "osiWireFormat.h"
 #include "compilerDependencies.h"
+#include "swapCopy.h"
 
 static const unsigned comBufSize = 0x4000;
 
@@ -80,6 +81,7 @@ public:
     unsigned unoccupiedBytes () const;
     unsigned occupiedBytes () const;
     unsigned uncommittedBytes () const;
+    const void * occupiedData () const;
     static unsigned capacityBytes ();
     void clear ();
     unsigned copyInBytes ( const void *pBuf, unsigned nBytes );
@@ -91,6 +93,14 @@ public:
     unsigned push ( const epicsInt8 * pValue, unsigned nElem );
     unsigned push ( const epicsUInt8 * pValue, unsigned nElem );
     unsigned push ( const epicsOldString * pValue, unsigned nElem );
+#ifdef SWAP_COPY_INTEGER
+    unsigned push ( const epicsInt16 * pValue, unsigned nElem );
+    unsigned push ( const epicsInt32 * pValue, unsigned nElem );
+    unsigned push ( const epicsFloat32 * pValue, unsigned nElem );
+#endif
+#ifdef SWAP_COPY_DOUBLE
+    unsigned push ( const epicsFloat64 * pValue, unsigned nElem );
+#endif
     void commitIncomming ();
     void clearUncommittedIncomming ();
     bool copyInAllBytes ( const void *pBuf, unsigned nBytes );
@@ -117,6 +127,8 @@ private:
     void operator delete ( void * );
     template < class T >
     bool push ( const T * ); // disabled
+    unsigned swapIn ( const void * pValue, unsigned nElem, unsigned elemSize,
+        void ( * pSwap ) ( void *, const void *, arrayElementCount ) );
 };
 
 inline void * comBuf::operator new ( size_t size,
@@ -160,6 +172,11 @@ inline unsigned comBuf :: uncommittedBytes () const
     return this->nextWriteIndex - this->commitIndex;
 }
 
+inline const void * comBuf :: occupiedData () const
+{
+    return & this->buf[this->nextReadIndex];
+}
+
 inline unsigned comBuf :: push ( comBuf & bufIn )
 {
     unsigned nBytes = this->copyInBytes (
@@ -222,6 +239,46 @@ inline unsigned comBuf :: push ( const epicsOldString * pValue, unsigned nElem )
     return nElem;
 }
 
+// copy in as many whole elements as fit, reversing the byte order of each
+inline unsigned comBuf :: swapIn ( const void * pValue, unsigned nElem,
+    unsigned elemSize,
+    void ( * pSwap ) ( void *, const void *, arrayElementCount ) )
+{
+    unsigned index = this->nextWriteIndex;
+    unsigned available = sizeof ( this->buf ) - index;
+    // elemSize * nElem could overflow
+    if ( nElem > available / elemSize ) {
+        nElem = available / elemSize;
+    }
+    pSwap ( & this->buf[index], pValue, nElem );
+    this->nextWriteIndex = index + elemSize * nElem;
+    return nElem;
+}
+
+#ifdef SWAP_COPY_INTEGER
+inline unsigned comBuf :: push ( const epicsInt16 * pValue, unsigned nElem )
+{
+    return swapIn ( pValue, nElem, sizeof ( *pValue ), swapCopy16 );
+}
+
+inline unsigned comBuf :: push ( const epicsInt32 * pValue, unsigned nElem )
+{
+    return swapIn ( pValue, nElem, sizeof ( *pValue ), swapCopy32 );
+}
+
+inline unsigned comBuf :: push ( const epicsFloat32 * pValue, unsigned nElem )
+{
+    return swapIn ( pValue, nElem, sizeof ( *pValue ), swapCopy32 );
+}
+#endif
+
+#ifdef SWAP_COPY_DOUBLE
+inline unsigned comBuf :: push ( const epicsFloat64 * pValue, unsigned nElem )
+{
+    return swapIn ( pValue, nElem, sizeof ( *pValue ), swapCopy64 );
+}
+#endif
+
 template < class T >
 unsigned comBuf :: push ( const T * pValue, unsigned nElem )
 {
@@ -33,6 +33,7 @@
 #include "iocinf.h"
 #include "caProto.h"
 #include "caerr.h"
+#include "swapCopy.h"
 
 /*
  * NOOP if this isnt required
@@ -134,6 +135,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef SWAP_COPY_INTEGER
+    swapCopy16 ( d, s, num );
+#else
     dbr_short_t         *pSrc = (dbr_short_t *) s;
     dbr_short_t         *pDest = (dbr_short_t *) d;
 
@@ -147,6 +151,7 @@ arrayElementCount   num         /* number of values     */
             pDest[i] = dbr_ntohs( pSrc[i] );
         }
     }
+#endif
 }
 
 /*
@@ -184,6 +189,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef SWAP_COPY_INTEGER
+    swapCopy32 ( d, s, num );
+#else
     dbr_long_t          *pSrc = (dbr_long_t *) s;
     dbr_long_t          *pDest = (dbr_long_t *) d;
 
@@ -197,6 +205,7 @@ arrayElementCount   num         /* number of values     */
             pDest[i] = dbr_ntohl( pSrc[i] );
         }
     }
+#endif
 }
 
 /*
@@ -213,6 +222,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef SWAP_COPY_INTEGER
+    swapCopy16 ( d, s, num );
+#else
     dbr_enum_t          *pSrc = (dbr_enum_t *) s;
     dbr_enum_t          *pDest = (dbr_enum_t *) d;
 
@@ -226,6 +238,7 @@ arrayElementCount   num         /* number of values     */
             pDest[i] = dbr_ntohs ( pSrc[i] );
         }
     }
+#endif
 }
 
 /*
@@ -244,6 +257,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef SWAP_COPY_INTEGER
+    swapCopy32 ( d, s, num );
+#else
     const dbr_float_t   *pSrc = (const dbr_float_t *) s;
     dbr_float_t         *pDest = (dbr_float_t *) d;
 
@@ -257,6 +273,7 @@ arrayElementCount   num         /* number of values     */
             dbr_ntohf ( &pSrc[i], &pDest[i] );
         }
     }
+#endif
 }
 
 /*
@@ -269,6 +286,9 @@ int                 encode,     /* cvrt HOST to NET if T    */
 arrayElementCount   num         /* number of values     */
 )
 {
+#ifdef SWAP_COPY_DOUBLE
+    swapCopy64 ( d, s, num );
+#else
     dbr_double_t        *pSrc = (dbr_double_t *) s;
     dbr_double_t        *pDest = (dbr_double_t *) d;
 
@@ -282,6 +302,7 @@ arrayElementCount   num         /* number of values     */
             dbr_ntohd( &pSrc[i], &pDest[i] );
         }
     }
+#endif
 }
 
 /****************************************************************************
@@ -62,6 +62,7 @@ nciu::nciu ( cac & cacIn, netiiu & iiuIn, cacChannelNotify & chanIn,
     }
 
     this->nameLength = static_cast <unsigned short> ( nameLengthTmp );
+    this->lastServerAddr.sa.sa_family = AF_UNSPEC;
 
     this->pNameStr = new char [ this->nameLength ];
     strcpy ( this->pNameStr, pNameIn );
@@ -185,6 +186,10 @@ void nciu::setServerAddressUnknown ( netiiu & newiiu,
                                 epicsGuard < epicsMutex > & guard )
 {
     guard.assertIdenticalMutex ( this->cacCtx.mutexRef () );
+    osiSockAddr addr = this->piiu->getNetworkAddress ( guard );
+    if ( addr.sa.sa_family == AF_INET ) {
+        this->lastServerAddr = addr;
+    }
     this->piiu = & newiiu;
     this->retry = 0;
     this->typeCode = USHRT_MAX;
@@ -503,6 +508,11 @@ void nciu::show (
             static_cast <void *> ( this->piiu ) );
         ::printf ( "\tserver identifier %u\n", this->sid );
         ::printf ( "\tsearch retry number=%u\n", this->retry );
+        if ( this->lastServerAddr.sa.sa_family == AF_INET ) {
+            char buf[64];
+            sockAddrToDottedIP ( &this->lastServerAddr.sa, buf, sizeof ( buf ) );
+            ::printf ( "\tlast server address %s\n", buf );
+        }
         ::printf ( "\tname length=%u\n", this->nameLength );
     }
 }
@@ -30,6 +30,7 @@
 #include "tsFreeList.h"
 #include "epicsMutex.h"
 #include "compilerDependencies.h"
+#include "osiSock.h"
 
 #include "libCaAPI.h"
 
@@ -56,6 +57,8 @@ private:
     enum channelState {
         cs_none,
         cs_disconnGov,
+        cs_unicastSearchReqPending,
+        cs_unicastSearchRespPending,
         // note: indexing is used here
         // so these must be contiguous
         cs_searchReqPending0,
@@ -112,6 +115,7 @@ private:
     friend class tcpSendThread;
     friend class searchTimer;
     friend class disconnectGovernorTimer;
+    friend class unicastSearchTimer;
 };
 
 class privateInterfaceForIO {
@@ -164,6 +168,8 @@ public:
         epicsGuard < epicsMutex > & );
     const netiiu * getConstPIIU (
         epicsGuard < epicsMutex > & ) const;
+    osiSockAddr getLastServerAddress (
+        epicsGuard < epicsMutex > & ) const;
     cac & getClient ();
     void searchReplySetUp ( netiiu &iiu, unsigned sidIn,
         ca_uint16_t typeIn, arrayElementCount countIn,
@@ -206,6 +212,7 @@ private:
     cac & cacCtx;
     char * pNameStr;
     netiiu * piiu;
+    osiSockAddr lastServerAddr; // of the last circuit
     ca_uint32_t sid; // server id
     unsigned count;
     unsigned retry; // search retry number
@@ -325,6 +332,12 @@ inline netiiu * nciu::getPIIU (
     return this->piiu;
 }
 
+inline osiSockAddr nciu::getLastServerAddress (
+    epicsGuard < epicsMutex > & ) const
+{
+    return this->lastServerAddr;
+}
+
 inline void nciu::writeException (
     epicsGuard < epicsMutex > & /* cbGuard */,
     epicsGuard < epicsMutex > & guard,
@@ -29,6 +29,8 @@
 #include "iocinf.h"
 #include "udpiiu.h"
 #include "nciu.h"
+#include "inetAddrID.h"
+#include "unicastSearchTimer.h"
 
 static const unsigned initialTriesPerFrame = 1u; // initial UDP frames per search try
 static const unsigned maxTriesPerFrame = 64u; // max UDP frames per search try
@@ -118,6 +120,44 @@ void searchTimer::moveChannels (
     }
 }
 
+//
+// move only the channels last connected to the
+// server which the unicast search timer is for
+//
+void searchTimer::moveChannels (
+    epicsGuard < epicsMutex > & guard, unicastSearchTimer & dest )
+{
+    tsDLIter < nciu > pChan = this->chanListRespPending.firstIter ();
+    while ( pChan.valid () ) {
+        tsDLIter < nciu > pNext = pChan;
+        pNext++;
+        osiSockAddr addr = pChan->getLastServerAddress ( guard );
+        if ( addr.sa.sa_family == AF_INET &&
+                inetAddrID ( addr.ia ) == dest ) {
+            this->chanListRespPending.remove ( *pChan );
+            pChan->channelNode::listMember = channelNode::cs_none;
+            if ( this->searchAttempts > 0 ) {
+                this->searchAttempts--;
+            }
+            dest.installChannel ( guard, *pChan );
+        }
+        pChan = pNext;
+    }
+    pChan = this->chanListReqPending.firstIter ();
+    while ( pChan.valid () ) {
+        tsDLIter < nciu > pNext = pChan;
+        pNext++;
+        osiSockAddr addr = pChan->getLastServerAddress ( guard );
+        if ( addr.sa.sa_family == AF_INET &&
+                inetAddrID ( addr.ia ) == dest ) {
+            this->chanListReqPending.remove ( *pChan );
+            pChan->channelNode::listMember = channelNode::cs_none;
+            dest.installChannel ( guard, *pChan );
+        }
+        pChan = pNext;
+    }
+}
+
 //
 // searchTimer::expire ()
 //
@@ -63,6 +63,8 @@ public:
         epicsGuard < epicsMutex > & guard );
     void moveChannels (
         epicsGuard < epicsMutex > &, searchTimer & dest );
+    void moveChannels (
+        epicsGuard < epicsMutex > &, class unicastSearchTimer & dest );
     void installChannel (
         epicsGuard < epicsMutex > &, nciu & );
     void uninstallChan (
@@ -0,0 +1,355 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Byte order reversing array copies for CA data conversion.
+ *
+ *  The bulk of an array is done with SSE2 or AVX2 on x86, where AVX2 is
+ *  used only if the CPU running the code supports it, or with NEON on
+ *  ARM. The remaining elements and other targets use a scalar loop.
+ */
+
+#include <string.h>
+
+#include "epicsTypes.h"
+#include "osiWireFormat.h"
+
+#include "swapCopy.h"
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || \
+    ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#   define SWAP_COPY_SSE2
+#   include <emmintrin.h>
+#endif
+
+/* AVX2 code is compiled by function attribute, and chosen at run time */
+#if defined ( SWAP_COPY_SSE2 ) && \
+    ( defined ( __x86_64__ ) || defined ( __i386__ ) ) && \
+    ( defined ( __clang__ ) || ( defined ( __GNUC__ ) && __GNUC__ >= 5 ) )
+#   define SWAP_COPY_AVX2
+#   include <immintrin.h>
+#endif
+
+#if ! defined ( SWAP_COPY_SSE2 ) && \
+    ( defined ( __ARM_NEON ) || defined ( __ARM_NEON__ ) )
+#   define SWAP_COPY_NEON
+#   include <arm_neon.h>
+#endif
+
+typedef arrayElementCount vectorSwapFunc (
+    epicsUInt8 * pDest, const epicsUInt8 * pSrc, arrayElementCount nBytes );
+
+struct swapKernel {
+    const char * pName;
+    vectorSwapFunc * pSwap16;
+    vectorSwapFunc * pSwap32;
+    vectorSwapFunc * pSwap64;
+};
+
+static inline epicsUInt16 swapBytes ( epicsUInt16 src )
+{
+    return byteSwap ( src );
+}
+
+static inline epicsUInt32 swapBytes ( epicsUInt32 src )
+{
+    return byteSwap ( src );
+}
+
+static inline epicsUInt64 swapBytes ( epicsUInt64 src )
+{
+    epicsUInt64 hi = byteSwap ( static_cast < epicsUInt32 > ( src ) );
+    return ( hi << 32u ) |
+        byteSwap ( static_cast < epicsUInt32 > ( src >> 32u ) );
+}
+
+template < class T >
+static void swapCopyScalar ( epicsUInt8 * pDest, const epicsUInt8 * pSrc,
+    arrayElementCount count )
+{
+    for ( arrayElementCount i = 0u; i < count; i++ ) {
+        // copy through memcpy so that the data may be of any type
+        T tmp;
+        memcpy ( & tmp, pSrc + i * sizeof ( T ), sizeof ( T ) );
+        tmp = swapBytes ( tmp );
+        memcpy ( pDest + i * sizeof ( T ), & tmp, sizeof ( T ) );
+    }
+}
+
+static arrayElementCount noVector ( epicsUInt8 *, const epicsUInt8 *,
+    arrayElementCount )
+{
+    return 0u;
+}
+
+static const swapKernel scalarKernel = {
+    "scalar", noVector, noVector, noVector
+};
+
+#ifdef SWAP_COPY_SSE2
+
+/*
+ * SSE2 has no byte shuffle, the 16 bit words are reordered first and
+ * then the bytes in each of them are swapped by shifts
+ */
+struct sse2Swap16 {
+    static __m128i swap ( __m128i v )
+    {
+        return _mm_or_si128 ( _mm_slli_epi16 ( v, 8 ),
+            _mm_srli_epi16 ( v, 8 ) );
+    }
+};
+
+struct sse2Swap32 {
+    static __m128i swap ( __m128i v )
+    {
+        v = _mm_shufflelo_epi16 ( v, _MM_SHUFFLE ( 2, 3, 0, 1 ) );
+        v = _mm_shufflehi_epi16 ( v, _MM_SHUFFLE ( 2, 3, 0, 1 ) );
+        return sse2Swap16::swap ( v );
+    }
+};
+
+struct sse2Swap64 {
+    static __m128i swap ( __m128i v )
+    {
+        v = _mm_shufflelo_epi16 ( v, _MM_SHUFFLE ( 0, 1, 2, 3 ) );
+        v = _mm_shufflehi_epi16 ( v, _MM_SHUFFLE ( 0, 1, 2, 3 ) );
+        return sse2Swap16::swap ( v );
+    }
+};
+
+template < class SWAP >
+static arrayElementCount sse2SwapCopy ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    arrayElementCount i = 0u;
+    for ( ; i + 32u <= nBytes; i += 32u ) {
+        __m128i a = _mm_loadu_si128 (
+            reinterpret_cast < const __m128i * > ( pSrc + i ) );
+        __m128i b = _mm_loadu_si128 (
+            reinterpret_cast < const __m128i * > ( pSrc + i + 16u ) );
+        _mm_storeu_si128 ( reinterpret_cast < __m128i * > ( pDest + i ),
+            SWAP::swap ( a ) );
+        _mm_storeu_si128 ( reinterpret_cast < __m128i * > ( pDest + i + 16u ),
+            SWAP::swap ( b ) );
+    }
+    for ( ; i + 16u <= nBytes; i += 16u ) {
+        __m128i a = _mm_loadu_si128 (
+            reinterpret_cast < const __m128i * > ( pSrc + i ) );
+        _mm_storeu_si128 ( reinterpret_cast < __m128i * > ( pDest + i ),
+            SWAP::swap ( a ) );
+    }
+    return i;
+}
+
+static const swapKernel sse2Kernel = {
+    "SSE2",
+    sse2SwapCopy < sse2Swap16 >,
+    sse2SwapCopy < sse2Swap32 >,
+    sse2SwapCopy < sse2Swap64 >
+};
+
+#endif /* SWAP_COPY_SSE2 */
+
+#ifdef SWAP_COPY_AVX2
+
+/* byte shuffles within each 128 bit lane */
+static const epicsUInt8 avx2Mask16[32] = {
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+    1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14
+};
+static const epicsUInt8 avx2Mask32[32] = {
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+};
+static const epicsUInt8 avx2Mask64[32] = {
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+    7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8
+};
+
+__attribute__ (( target ( "avx2" ) ))
+static arrayElementCount avx2SwapCopy ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes,
+    const epicsUInt8 * pMask )
+{
+    const __m256i mask = _mm256_loadu_si256 (
+        reinterpret_cast < const __m256i * > ( pMask ) );
+    arrayElementCount i = 0u;
+    for ( ; i + 64u <= nBytes; i += 64u ) {
+        __m256i a = _mm256_loadu_si256 (
+            reinterpret_cast < const __m256i * > ( pSrc + i ) );
+        __m256i b = _mm256_loadu_si256 (
+            reinterpret_cast < const __m256i * > ( pSrc + i + 32u ) );
+        _mm256_storeu_si256 ( reinterpret_cast < __m256i * > ( pDest + i ),
+            _mm256_shuffle_epi8 ( a, mask ) );
+        _mm256_storeu_si256 (
+            reinterpret_cast < __m256i * > ( pDest + i + 32u ),
+            _mm256_shuffle_epi8 ( b, mask ) );
+    }
+    for ( ; i + 32u <= nBytes; i += 32u ) {
+        __m256i a = _mm256_loadu_si256 (
+            reinterpret_cast < const __m256i * > ( pSrc + i ) );
+        _mm256_storeu_si256 ( reinterpret_cast < __m256i * > ( pDest + i ),
+            _mm256_shuffle_epi8 ( a, mask ) );
+    }
+    return i;
+}
+
+static arrayElementCount avx2SwapCopy16 ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    return avx2SwapCopy ( pDest, pSrc, nBytes, avx2Mask16 );
+}
+
+static arrayElementCount avx2SwapCopy32 ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    return avx2SwapCopy ( pDest, pSrc, nBytes, avx2Mask32 );
+}
+
+static arrayElementCount avx2SwapCopy64 ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    return avx2SwapCopy ( pDest, pSrc, nBytes, avx2Mask64 );
+}
+
+static const swapKernel avx2Kernel = {
+    "AVX2", avx2SwapCopy16, avx2SwapCopy32, avx2SwapCopy64
+};
+
+#endif /* SWAP_COPY_AVX2 */
+
+#ifdef SWAP_COPY_NEON
+
+static arrayElementCount neonSwapCopy16 ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    arrayElementCount i = 0u;
+    for ( ; i + 16u <= nBytes; i += 16u ) {
+        vst1q_u8 ( pDest + i, vrev16q_u8 ( vld1q_u8 ( pSrc + i ) ) );
+    }
+    return i;
+}
+
+static arrayElementCount neonSwapCopy32 ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    arrayElementCount i = 0u;
+    for ( ; i + 16u <= nBytes; i += 16u ) {
+        vst1q_u8 ( pDest + i, vrev32q_u8 ( vld1q_u8 ( pSrc + i ) ) );
+    }
+    return i;
+}
+
+static arrayElementCount neonSwapCopy64 ( epicsUInt8 * pDest,
+    const epicsUInt8 * pSrc, arrayElementCount nBytes )
+{
+    arrayElementCount i = 0u;
+    for ( ; i + 16u <= nBytes; i += 16u ) {
+        vst1q_u8 ( pDest + i, vrev64q_u8 ( vld1q_u8 ( pSrc + i ) ) );
+    }
+    return i;
+}
+
+static const swapKernel neonKernel = {
+    "NEON", neonSwapCopy16, neonSwapCopy32, neonSwapCopy64
+};
+
+#endif /* SWAP_COPY_NEON */
+
+static const swapKernel * chooseKernel ()
+{
+#if defined ( SWAP_COPY_AVX2 )
+    __builtin_cpu_init ();
+    if ( __builtin_cpu_supports ( "avx2" ) ) {
+        return & avx2Kernel;
+    }
+#endif
+#if defined ( SWAP_COPY_SSE2 )
+    return & sse2Kernel;
+#elif defined ( SWAP_COPY_NEON )
+    return & neonKernel;
+#else
+    return & scalarKernel;
+#endif
+}
+
+// set by swapCopyUseKernel ()
+static const swapKernel * pKernelUsed = 0;
+
+static const swapKernel & kernel ()
+{
+    // chosen on first use, which may be before static constructors run
+    static const swapKernel * const pKernel = chooseKernel ();
+    return pKernelUsed ? * pKernelUsed : * pKernel;
+}
+
+void swapCopy16 ( void * pDest, const void * pSrc, arrayElementCount count )
+{
+    epicsUInt8 * pD = static_cast < epicsUInt8 * > ( pDest );
+    const epicsUInt8 * pS = static_cast < const epicsUInt8 * > ( pSrc );
+    arrayElementCount done = kernel().pSwap16 ( pD, pS, count * 2u );
+    swapCopyScalar < epicsUInt16 > ( pD + done, pS + done,
+        count - done / 2u );
+}
+
+void swapCopy32 ( void * pDest, const void * pSrc, arrayElementCount count )
+{
+    epicsUInt8 * pD = static_cast < epicsUInt8 * > ( pDest );
+    const epicsUInt8 * pS = static_cast < const epicsUInt8 * > ( pSrc );
+    arrayElementCount done = kernel().pSwap32 ( pD, pS, count * 4u );
+    swapCopyScalar < epicsUInt32 > ( pD + done, pS + done,
+        count - done / 4u );
+}
+
+void swapCopy64 ( void * pDest, const void * pSrc, arrayElementCount count )
+{
+    epicsUInt8 * pD = static_cast < epicsUInt8 * > ( pDest );
+    const epicsUInt8 * pS = static_cast < const epicsUInt8 * > ( pSrc );
+    arrayElementCount done = kernel().pSwap64 ( pD, pS, count * 8u );
+    swapCopyScalar < epicsUInt64 > ( pD + done, pS + done,
+        count - done / 8u );
+}
+
+const char * swapCopyKernel ()
+{
+    return kernel().pName;
+}
+
+int swapCopyUseKernel ( const char * pName )
+{
+    static const swapKernel * const kernels[] = {
+        & scalarKernel,
+#if defined ( SWAP_COPY_SSE2 )
+        & sse2Kernel,
+#endif
+#if defined ( SWAP_COPY_AVX2 )
+        & avx2Kernel,
+#endif
+#if defined ( SWAP_COPY_NEON )
+        & neonKernel,
+#endif
+    };
+
+    if ( ! pName ) {
+        pKernelUsed = 0;
+        return 1;
+    }
+    for ( unsigned i = 0u; i < sizeof ( kernels ) / sizeof ( kernels[0] ); i++ ) {
+        if ( strcmp ( pName, kernels[i]->pName ) == 0 ) {
+#if defined ( SWAP_COPY_AVX2 )
+            if ( kernels[i] == & avx2Kernel ) {
+                __builtin_cpu_init ();
+                if ( ! __builtin_cpu_supports ( "avx2" ) ) {
+                    return 0;
+                }
+            }
+#endif
+            pKernelUsed = kernels[i];
+            return 1;
+        }
+    }
+    return 0;
+}
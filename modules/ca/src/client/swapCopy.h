@@ -0,0 +1,56 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Copy arrays of 2, 4 or 8 byte elements reversing the byte order of
+ *  each, using the widest vector instructions the CPU supports. The
+ *  source and destination may be the same, but must not otherwise
+ *  overlap.
+ */
+
+#ifndef INC_swapCopy_H
+#define INC_swapCopy_H
+
+#include "epicsEndian.h"
+#include "net_convert.h"
+
+/*
+ * Defined where the wire format of integers and floats, or of doubles,
+ * is the host format with the byte order reversed
+ */
+#if EPICS_BYTE_ORDER == EPICS_ENDIAN_LITTLE
+#   define SWAP_COPY_INTEGER
+#   if EPICS_FLOAT_WORD_ORDER == EPICS_ENDIAN_LITTLE
+#       define SWAP_COPY_DOUBLE
+#   endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+LIBCA_API void swapCopy16 ( void * pDest, const void * pSrc,
+    arrayElementCount count );
+LIBCA_API void swapCopy32 ( void * pDest, const void * pSrc,
+    arrayElementCount count );
+LIBCA_API void swapCopy64 ( void * pDest, const void * pSrc,
+    arrayElementCount count );
+
+/* Name of the instruction set used, for diagnostics */
+LIBCA_API const char * swapCopyKernel ( void );
+
+/*
+ * For tests, use the named instruction set ("scalar", "SSE2", "AVX2" or
+ * "NEON") instead of the best one, or the best one again if pName is
+ * NULL. Returns 0 if it isn't built in or the CPU doesn't support it.
+ * Not thread safe.
+ */
+LIBCA_API int swapCopyUseKernel ( const char * pName );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ifndef INC_swapCopy_H */
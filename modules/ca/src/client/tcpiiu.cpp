@@ -47,6 +47,17 @@
 
 using namespace std;
 
+/*
+ * POSIX targets send all of the buffers ready when the send thread
+ * flushes with one sendmsg() call, elsewhere they are sent one by one.
+ */
+#if !defined(_WIN32)
+#   define CA_GATHER_SEND
+#endif
+
+// at most this many buffers (1 MiB) are sent by one system call
+static const unsigned maxGatherBufs = 64u;
+
 tcpSendThread::tcpSendThread (
         class tcpiiu & iiuIn, const char * pName,
         unsigned stackSize, unsigned priority ) :
@@ -245,56 +256,138 @@ unsigned tcpiiu::sendBytes ( const void *pBuf,
             // printf("SEND: %u\n", nBytes );
             break;
         }
-        else {
-            epicsGuard < epicsMutex > guard ( this->mutex );
-            if ( this->state != iiucs_connected &&
-                this->state != iiucs_clean_shutdown ) {
-                break;
-            }
-            // winsock indicates disconnect by returning zero here
-            if ( status == 0 ) {
-                this->disconnectNotify ( guard );
-                break;
-            }
+        else if ( ! this->sendRetry ( status ) ) {
+            break;
+        }
+    }
 
-            int localError = SOCKERRNO;
+    this->sendDog.cancel ();
 
-            if ( localError == SOCK_EINTR ) {
-                continue;
-            }
+    return nBytes;
+}
 
-            if ( localError == SOCK_ENOBUFS ) {
-                errlogPrintf (
-                    "CAC: system low on network buffers "
-                    "- send retry in 15 seconds\n" );
-                {
-                    epicsGuardRelease < epicsMutex > unguard ( guard );
-                    epicsThreadSleep ( 15.0 );
-                }
-                continue;
-            }
+// send the occupied bytes of several buffers, returning false
+// if the circuit was lost
+bool tcpiiu::sendComBufs ( comBuf * const * ppBufs,
+    unsigned nBufs, const epicsTime & currentTime )
+{
+#ifdef CA_GATHER_SEND
+    bool success = true;
+    unsigned first = 0u;
 
-            if (
-                    localError != SOCK_EPIPE &&
-                    localError != SOCK_ECONNRESET &&
-                    localError != SOCK_ETIMEDOUT &&
-                    localError != SOCK_ECONNABORTED &&
-                    localError != SOCK_SHUTDOWN ) {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString (
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-                errlogPrintf ( "CAC: unexpected TCP send error: %s\n",
-                    sockErrBuf );
-            }
+    assert ( nBufs <= maxGatherBufs );
+
+    this->sendDog.start ( currentTime );
+
+    while ( first < nBufs ) {
+        struct iovec iov[maxGatherBufs];
+        struct msghdr msg;
+        unsigned n = 0u;
 
-            this->disconnectNotify ( guard );
+        for ( unsigned i = first; i < nBufs; i++ ) {
+            iov[n].iov_base = const_cast < void * > (
+                ppBufs[i]->occupiedData () );
+            iov[n].iov_len = ppBufs[i]->occupiedBytes ();
+            n++;
+        }
+        memset ( & msg, 0, sizeof ( msg ) );
+        msg.msg_iov = iov;
+        msg.msg_iovlen = n;
+
+        int status = static_cast < int > ( ::sendmsg ( this->sock, & msg, 0 ) );
+        if ( status > 0 ) {
+            unsigned nBytes = static_cast < unsigned > ( status );
+            while ( first < nBufs ) {
+                nBytes -= ppBufs[first]->removeBytes ( nBytes );
+                if ( ppBufs[first]->occupiedBytes () ) {
+                    break;
+                }
+                first++;
+            }
+        }
+        else if ( ! this->sendRetry ( status ) ) {
+            success = false;
             break;
         }
     }
 
     this->sendDog.cancel ();
 
-    return nBytes;
+    return success;
+#else
+    for ( unsigned i = 0u; i < nBufs; i++ ) {
+        if ( ! ppBufs[i]->flushToWire ( *this, currentTime ) ) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+// returns true if a failed send should be tried again
+bool tcpiiu::sendRetry ( int status )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    if ( this->state != iiucs_connected &&
+        this->state != iiucs_clean_shutdown ) {
+        return false;
+    }
+    // winsock indicates disconnect by returning zero here
+    if ( status == 0 ) {
+        this->disconnectNotify ( guard );
+        return false;
+    }
+
+    int localError = SOCKERRNO;
+
+    if ( localError == SOCK_EINTR ) {
+        return true;
+    }
+
+    if ( localError == SOCK_ENOBUFS ) {
+        errlogPrintf (
+            "CAC: system low on network buffers "
+            "- send retry in 15 seconds\n" );
+        {
+            epicsGuardRelease < epicsMutex > unguard ( guard );
+            epicsThreadSleep ( 15.0 );
+        }
+        return true;
+    }
+
+    if (
+            localError != SOCK_EPIPE &&
+            localError != SOCK_ECONNRESET &&
+            localError != SOCK_ETIMEDOUT &&
+            localError != SOCK_ECONNABORTED &&
+            localError != SOCK_SHUTDOWN ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "CAC: unexpected TCP send error: %s\n",
+            sockErrBuf );
+    }
+
+    this->disconnectNotify ( guard );
+    return false;
+}
+
+// while corked the IP kernel holds back partly filled segments, so
+// a flush needing several system calls leaves no runt segments
+void tcpiiu::sendCork ( bool cork )
+{
+#ifdef TCP_CORK
+    int flag = cork;
+    int status = setsockopt ( this->sock, IPPROTO_TCP, TCP_CORK,
+                (char *) &flag, sizeof ( flag ) );
+    if ( status < 0 ) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        errlogPrintf ( "CAC: problems setting socket option TCP_CORK = \"%s\"\n",
+            sockErrBuf );
+    }
+#endif
 }
 
 void tcpiiu::recvBytes (
@@ -1668,21 +1761,42 @@ bool tcpiiu::sendThreadFlush ( epicsGuard < epicsMutex > & guard )
     guard.assertIdenticalMutex ( this->mutex );
 
     if ( this->sendQue.occupiedBytes() > 0 ) {
-        while ( comBuf * pBuf = this->sendQue.popNextComBufToSend () ) {
+        bool corked = this->sendQue.occupiedBytes () >
+            maxGatherBufs * comBuf::capacityBytes ();
+        if ( corked ) {
+            this->sendCork ( true );
+        }
+        while ( true ) {
+            comBuf * bufs[maxGatherBufs];
+            unsigned nBufs = 0u;
+            unsigned bytesToBeSent = 0u;
+            while ( nBufs < maxGatherBufs ) {
+                comBuf * pBuf = this->sendQue.popNextComBufToSend ();
+                if ( ! pBuf ) {
+                    break;
+                }
+                bytesToBeSent += pBuf->occupiedBytes ();
+                bufs[nBufs++] = pBuf;
+            }
+            if ( nBufs == 0u ) {
+                break;
+            }
+
             epicsTime current = epicsTime::getCurrent ();
 
-            unsigned bytesToBeSent = pBuf->occupiedBytes ();
             bool success = false;
             {
                 // no lock while blocking to send
                 epicsGuardRelease < epicsMutex > unguard ( guard );
-                success = pBuf->flushToWire ( *this, current );
-                pBuf->~comBuf ();
-                this->comBufMemMgr.release ( pBuf );
+                success = this->sendComBufs ( bufs, nBufs, current );
+                for ( unsigned i = 0u; i < nBufs; i++ ) {
+                    bufs[i]->~comBuf ();
+                    this->comBufMemMgr.release ( bufs[i] );
+                }
             }
 
             if ( ! success ) {
-                while ( ( pBuf = this->sendQue.popNextComBufToSend () ) ) {
+                while ( comBuf * pBuf = this->sendQue.popNextComBufToSend () ) {
                     pBuf->~comBuf ();
                     this->comBufMemMgr.release ( pBuf );
                 }
@@ -1697,6 +1811,9 @@ bool tcpiiu::sendThreadFlush ( epicsGuard < epicsMutex > & guard )
                 this->recvDog.sendBacklogProgressNotify ( guard );
             }
         }
+        if ( corked ) {
+            this->sendCork ( false );
+        }
     }
 
     this->earlyFlush = false;
@@ -0,0 +1,149 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Check that each instruction set swapCopy16(), swapCopy32() and
+ *  swapCopy64() can use reverses the bytes of every element, whatever
+ *  the alignment of the arrays and the number of elements left over
+ *  after the vector loops.
+ */
+
+#include <string.h>
+
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#include "comBuf.h"
+#include "swapCopy.h"
+
+namespace {
+
+typedef void swapFunc ( void * pDest, const void * pSrc,
+    arrayElementCount count );
+
+// longer than two of the widest vector loops, with a tail of every length
+const arrayElementCount maxCount = 200u;
+const unsigned maxOffset = 8u;
+
+epicsUInt8 src [ maxCount * 8u + maxOffset ];
+epicsUInt8 dest [ maxCount * 8u + maxOffset + 1u ];
+
+// Each element of pDest must be that of pSrc with its bytes reversed
+bool swapped ( const epicsUInt8 * pDest, const epicsUInt8 * pSrc,
+    unsigned size, arrayElementCount count )
+{
+    for ( arrayElementCount i = 0u; i < count; i++ ) {
+        for ( unsigned j = 0u; j < size; j++ ) {
+            if ( pDest[i * size + j] != pSrc[i * size + size - 1u - j] ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Copy from each alignment to each alignment, and check that the byte
+// after the last element is left alone
+bool checkCopy ( swapFunc * pSwap, unsigned size )
+{
+    for ( unsigned srcOff = 0u; srcOff < maxOffset; srcOff++ ) {
+        for ( unsigned destOff = 0u; destOff < maxOffset; destOff++ ) {
+            for ( arrayElementCount n = 0u; n <= maxCount; n++ ) {
+                memset ( dest, 0xa5, sizeof ( dest ) );
+                pSwap ( dest + destOff, src + srcOff, n );
+                if ( ! swapped ( dest + destOff, src + srcOff, size, n ) ||
+                        dest[destOff + n * size] != 0xa5 ) {
+                    testDiag ( "%u byte elements, %lu from offset %u to %u",
+                        size, (unsigned long) n, srcOff, destOff );
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool checkInPlace ( swapFunc * pSwap, unsigned size )
+{
+    epicsUInt8 copy [ sizeof ( src ) ];
+
+    for ( unsigned off = 0u; off < maxOffset; off++ ) {
+        for ( arrayElementCount n = 0u; n <= maxCount; n++ ) {
+            memcpy ( copy, src, sizeof ( copy ) );
+            pSwap ( copy + off, copy + off, n );
+            if ( ! swapped ( copy + off, src + off, size, n ) ||
+                    memcmp ( copy + off + n * size, src + off + n * size,
+                        sizeof ( copy ) - off - n * size ) ) {
+                testDiag ( "%u byte elements, %lu in place at offset %u",
+                    size, (unsigned long) n, off );
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void testKernel ( const char * pName )
+{
+    static swapFunc * const funcs[] = { swapCopy16, swapCopy32, swapCopy64 };
+
+    if ( ! swapCopyUseKernel ( pName ) ) {
+        testSkip ( 7, "No support here" );
+        return;
+    }
+    testOk ( strcmp ( swapCopyKernel (), pName ) == 0,
+        "Using %s", swapCopyKernel () );
+    for ( unsigned i = 0u; i < 3u; i++ ) {
+        unsigned size = 2u << i;
+        testOk ( checkCopy ( funcs[i], size ),
+            "%s copies %u byte elements", pName, size );
+        testOk ( checkInPlace ( funcs[i], size ),
+            "%s swaps %u byte elements in place", pName, size );
+    }
+}
+
+// A count so large that the size in bytes overflows fills the buffer
+void testSwapInBound ()
+{
+#ifdef SWAP_COPY_INTEGER
+    static epicsInt16 values [ comBufSize / sizeof ( epicsInt16 ) ];
+    comBuf buf;
+
+    buf.push ( values, 3u );
+    unsigned n = buf.push ( values, 0x80000001u );
+    testOk ( n == comBufSize / sizeof ( epicsInt16 ) - 3u,
+        "comBuf::push() of 0x80000001 elements pushed %u", n );
+    testOk1 ( buf.unoccupiedBytes () == 0u );
+#else
+    testSkip ( 2, "Integers aren't byte swapped here" );
+#endif
+}
+
+} // namespace
+
+MAIN(swapCopyTest)
+{
+    static const char * const names[] = { "scalar", "SSE2", "AVX2", "NEON" };
+
+    testPlan(32);
+
+    for ( unsigned i = 0u; i < sizeof ( src ); i++ ) {
+        src[i] = static_cast < epicsUInt8 > ( i * 13u + 1u );
+    }
+
+    testDiag ( "Best instruction set is %s", swapCopyKernel () );
+    for ( unsigned i = 0u; i < sizeof ( names ) / sizeof ( names[0] ); i++ ) {
+        testDiag ( "Instruction set %s", names[i] );
+        testKernel ( names[i] );
+    }
+
+    testOk1 ( ! swapCopyUseKernel ( "MMX" ) );
+    testOk1 ( swapCopyUseKernel ( NULL ) );
+    testDiag ( "Back to %s", swapCopyKernel () );
+
+    testSwapInBound ();
+
+    return testDone ();
+}
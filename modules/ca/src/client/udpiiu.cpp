@@ -115,7 +115,7 @@ unsigned getNTimers(double maxPeriod)
 //
 udpiiu::udpiiu (
     epicsGuard < epicsMutex > & cacGuard,
-    epicsTimerQueueActive & timerQueue,
+    epicsTimerQueueActive & timerQueueIn,
     epicsMutex & cbMutexIn,
     epicsMutex & cacMutexIn,
     cacContextNotify & ctxNotifyIn,
@@ -129,8 +129,9 @@ udpiiu::udpiiu (
                 cac.getInitializingThreadsPriority () ) ) ),
     m_repeaterTimerNotify ( *this ),
     repeaterSubscribeTmr (
-        m_repeaterTimerNotify, timerQueue, cbMutexIn, ctxNotifyIn ),
-    govTmr ( *this, timerQueue, cacMutexIn ),
+        m_repeaterTimerNotify, timerQueueIn, cbMutexIn, ctxNotifyIn ),
+    govTmr ( *this, timerQueueIn, cacMutexIn ),
+    timerQueue ( timerQueueIn ),
     maxPeriod ( getMaxPeriod() ),
     rtteMean ( minRoundTripEstimate ),
     rtteMeanDev ( 0 ),
@@ -141,6 +142,11 @@ udpiiu::udpiiu (
     ppSearchTmr ( nTimers ),
     nBytesInXmitBuf ( 0 ),
     beaconAnomalyTimerIndex ( 0 ),
+    searchFramesToAddrList ( 0u ),
+    searchFramesToLastServer ( 0u ),
+    searchRespToAddrList ( 0u ),
+    searchRespToLastServer ( 0u ),
+    lastServerSearchFailures ( 0u ),
     sequenceNumber ( 0 ),
     lastReceivedSeqNo ( 0 ),
     sock ( 0 ),
@@ -160,7 +166,7 @@ udpiiu::udpiiu (
 
     for ( unsigned i = 0; i < this->nTimers; i++ ) {
         this->ppSearchTmr[i].reset (
-            new searchTimer ( *this, timerQueue, i, cacMutexIn,
+            new searchTimer ( *this, timerQueueIn, i, cacMutexIn,
                 i > this->beaconAnomalyTimerIndex ) );
     }
 
@@ -327,6 +333,12 @@ udpiiu::~udpiiu ()
         delete & curr;
     }
 
+    tsSLList < unicastSearchTimer > lanes;
+    this->unicastSearchTable.removeAll ( lanes );
+    while ( unicastSearchTimer * pTimer = lanes.get () ) {
+        delete pTimer;
+    }
+
     epicsSocketDestroy ( this->sock );
 }
 
@@ -335,14 +347,22 @@ void udpiiu::shutdown (
     epicsGuard < epicsMutex > & guard )
 {
     // stop all of the timers
+    this->shutdownCmd = true;
     this->repeaterSubscribeTmr.shutdown ( cbGuard, guard );
     this->govTmr.shutdown ( cbGuard, guard );
+    {
+        resTable < unicastSearchTimer, inetAddrID > :: iterator
+            iter = this->unicastSearchTable.firstIter ();
+        while ( iter.valid () ) {
+            iter->shutdown ( cbGuard, guard );
+            iter++;
+        }
+    }
     for ( unsigned i =0; i < this->nTimers; i++ ) {
         this->ppSearchTmr[i]->shutdown ( cbGuard, guard );
     }
 
     {
-        this->shutdownCmd = true;
         epicsGuardRelease < epicsMutex > unguard ( guard );
         {
             epicsGuardRelease < epicsMutex > cbUnguard ( cbGuard );
@@ -1118,7 +1138,28 @@ void udpiiu :: SearchRespCallback :: show (
 }
 
 bool udpiiu :: datagramFlush (
-    epicsGuard < epicsMutex > & guard, const epicsTime & currentTime )
+    epicsGuard < epicsMutex > & guard, const epicsTime & /* currentTime */ )
+{
+    bool sent = this->datagramSend ( guard, _searchDestList );
+    if ( sent ) {
+        this->searchFramesToAddrList++;
+    }
+    return sent;
+}
+
+bool udpiiu :: datagramFlush (
+    epicsGuard < epicsMutex > & guard, tsDLList < SearchDest > & destList,
+    const epicsTime & /* currentTime */ )
+{
+    bool sent = this->datagramSend ( guard, destList );
+    if ( sent ) {
+        this->searchFramesToLastServer++;
+    }
+    return sent;
+}
+
+bool udpiiu :: datagramSend (
+    epicsGuard < epicsMutex > & guard, tsDLList < SearchDest > & destList )
 {
     guard.assertIdenticalMutex ( cacMutex );
 
@@ -1127,7 +1168,7 @@ bool udpiiu :: datagramFlush (
         return false;
     }
 
-    tsDLIter < SearchDest > iter ( _searchDestList.firstIter () );
+    tsDLIter < SearchDest > iter ( destList.firstIter () );
     while ( iter.valid () )
     {
         iter->searchRequest ( guard, this->xmitBuf, this->nBytesInXmitBuf );
@@ -1169,6 +1210,12 @@ void udpiiu :: show ( unsigned level ) const
         this->recvThread.show ( level - 2u );
         this->repeaterSubscribeTmr.show ( level - 2u );
         this->govTmr.show ( level - 2u );
+        resTable < unicastSearchTimer, inetAddrID > :: iteratorConst
+            iter = this->unicastSearchTable.firstIter ();
+        while ( iter.valid () ) {
+            iter->show ( guard, level - 3u );
+            iter++;
+        }
     }
     if ( level > 3u ) {
         for ( unsigned i =0; i < this->nTimers; i++ ) {
@@ -1177,6 +1224,22 @@ void udpiiu :: show ( unsigned level ) const
     }
 }
 
+void udpiiu :: showSearchStatistics (
+    epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->cacMutex );
+    ::printf ( "\tsearch frames sent to the address list %u, "
+        "to last known servers %u\n",
+        this->searchFramesToAddrList, this->searchFramesToLastServer );
+    ::printf ( "\tchannels found by the address list %u, "
+        "by last known servers %u\n",
+        this->searchRespToAddrList, this->searchRespToLastServer );
+    ::printf ( "\tchannels not found by last known servers %u\n",
+        this->lastServerSearchFailures );
+    ::printf ( "\tlast known servers %u\n",
+        this->unicastSearchTable.numEntriesInstalled () );
+}
+
 bool udpiiu::wakeupMsg ()
 {
     caHdr msg;
@@ -1199,8 +1262,17 @@ bool udpiiu::wakeupMsg ()
 }
 
 void udpiiu::beaconAnomalyNotify (
-    epicsGuard < epicsMutex > & cacGuard )
-{
+    epicsGuard < epicsMutex > & cacGuard, const inetAddrID & addr )
+{
+    // the channels last connected to this server are
+    // searched for there first
+    unicastSearchTimer * pTimer = this->unicastSearchTable.lookup ( addr );
+    if ( pTimer && ! this->shutdownCmd ) {
+        for ( unsigned i = 0u; i < this->nTimers; i++ ) {
+            this->ppSearchTmr[i]->moveChannels ( cacGuard, *pTimer );
+        }
+        pTimer->serverRestartNotify ( cacGuard );
+    }
     for ( unsigned i = this->beaconAnomalyTimerIndex+1u;
             i < this->nTimers; i++ ) {
         this->ppSearchTmr[i]->moveChannels ( cacGuard,
@@ -1217,7 +1289,16 @@ void udpiiu::uninstallChanDueToSuccessfulSearchResponse (
     if ( chanState == channelNode::cs_disconnGov ) {
         this->govTmr.uninstallChan ( guard, chan );
     }
+    else if ( chanState == channelNode::cs_unicastSearchReqPending ||
+            chanState == channelNode::cs_unicastSearchRespPending ) {
+        this->searchRespToLastServer++;
+        this->findUnicastSearchTimer ( guard,
+            chan.getLastServerAddress ( guard ), false )->
+                uninstallChanDueToSuccessfulSearchResponse (
+                    guard, chan, currentTime );
+    }
     else {
+        this->searchRespToAddrList++;
         this->ppSearchTmr[ chan.getSearchTimerIndex ( guard ) ]->
             uninstallChanDueToSuccessfulSearchResponse (
             guard, chan, this->lastReceivedSeqNo,
@@ -1233,6 +1314,12 @@ void udpiiu::uninstallChan (
     if ( chanState == channelNode::cs_disconnGov ) {
         this->govTmr.uninstallChan ( guard, chan );
     }
+    else if ( chanState == channelNode::cs_unicastSearchReqPending ||
+            chanState == channelNode::cs_unicastSearchRespPending ) {
+        this->findUnicastSearchTimer ( guard,
+            chan.getLastServerAddress ( guard ), false )->
+                uninstallChan ( guard, chan );
+    }
     else {
         this->ppSearchTmr[ chan.getSearchTimerIndex ( guard ) ]->
             uninstallChan ( guard, chan );
@@ -1290,7 +1377,57 @@ void udpiiu::boostChannel (
 void udpiiu::govExpireNotify (
     epicsGuard < epicsMutex > & guard, nciu & chan )
 {
-    this->ppSearchTmr[0]->installChannel ( guard, chan );
+    unicastSearchTimer * pTimer = this->findUnicastSearchTimer (
+        guard, chan.getLastServerAddress ( guard ), true );
+    if ( pTimer ) {
+        pTimer->installChannel ( guard, chan );
+    }
+    else {
+        this->ppSearchTmr[0]->installChannel ( guard, chan );
+    }
+}
+
+void udpiiu::unicastSearchFailNotify (
+    epicsGuard < epicsMutex > & guard, nciu & chan, unsigned nTries )
+{
+    this->lastServerSearchFailures++;
+    if ( nTries >= this->nTimers ) {
+        nTries = this->nTimers - 1;
+    }
+    this->ppSearchTmr[nTries]->installChannel ( guard, chan );
+}
+
+//
+// the channels last connected to a server are searched for there,
+// by unicast, before the address list is used
+//
+unicastSearchTimer * udpiiu::findUnicastSearchTimer (
+    epicsGuard < epicsMutex > & guard,
+    const osiSockAddr & serverAddr, bool create )
+{
+    guard.assertIdenticalMutex ( this->cacMutex );
+    if ( serverAddr.sa.sa_family != AF_INET ) {
+        return 0;
+    }
+    unicastSearchTimer * pTimer =
+        this->unicastSearchTable.lookup ( serverAddr.ia );
+    if ( pTimer || ! create || this->shutdownCmd ) {
+        return pTimer;
+    }
+
+    // A server whose TCP port was taken by another server on the
+    // same host still listens for searches at the default port
+    tsDLList < SearchDest > destList;
+    destList.add ( * new SearchDestUDP ( serverAddr, *this ) );
+    if ( ntohs ( serverAddr.ia.sin_port ) != this->serverPort ) {
+        osiSockAddr defaultPortAddr = serverAddr;
+        defaultPortAddr.ia.sin_port = htons ( this->serverPort );
+        destList.add ( * new SearchDestUDP ( defaultPortAddr, *this ) );
+    }
+    pTimer = new unicastSearchTimer ( *this, this->timerQueue,
+        this->cacMutex, serverAddr.ia, destList );
+    this->unicastSearchTable.add ( *pTimer );
+    return pTimer;
 }
 
 int udpiiu :: M_repeaterTimerNotify :: printFormated (
@@ -37,6 +37,7 @@
 #include "netiiu.h"
 #include "searchTimer.h"
 #include "disconnectGovernorTimer.h"
+#include "unicastSearchTimer.h"
 #include "repeaterSubscribeTimer.h"
 #include "SearchDest.h"
 
@@ -91,7 +92,8 @@ static const double beaconAnomalySearchPeriod = 5.0; // seconds
 class udpiiu :
     private netiiu,
     private searchTimerNotify,
-    private disconnectGovernorNotify {
+    private disconnectGovernorNotify,
+    private unicastSearchNotify {
 public:
     udpiiu (
         epicsGuard < epicsMutex > & cacGuard,
@@ -108,10 +110,11 @@ public:
     void installDisconnectedChannel (
         epicsGuard < epicsMutex > &, nciu & );
     void beaconAnomalyNotify (
-        epicsGuard < epicsMutex > & guard );
+        epicsGuard < epicsMutex > & guard, const inetAddrID & addr );
     void shutdown ( epicsGuard < epicsMutex > & cbGuard,
         epicsGuard < epicsMutex > & guard );
     void show ( unsigned level ) const;
+    void showSearchStatistics ( epicsGuard < epicsMutex > & ) const;
 
     // exceptions
     class noSocket {};
@@ -163,7 +166,9 @@ private:
     M_repeaterTimerNotify m_repeaterTimerNotify;
     repeaterSubscribeTimer repeaterSubscribeTmr;
     disconnectGovernorTimer govTmr;
+    resTable < unicastSearchTimer, inetAddrID > unicastSearchTable;
     tsDLList < SearchDest > _searchDestList;
+    epicsTimerQueue & timerQueue;
     const double maxPeriod;
     double rtteMean;
     double rtteMeanDev;
@@ -183,6 +188,12 @@ private:
     } ppSearchTmr;
     unsigned nBytesInXmitBuf;
     unsigned beaconAnomalyTimerIndex;
+    // search statistics
+    unsigned searchFramesToAddrList;
+    unsigned searchFramesToLastServer;
+    unsigned searchRespToAddrList;
+    unsigned searchRespToLastServer;
+    unsigned lastServerSearchFailures;
     ca_uint32_t sequenceNumber;
     ca_uint32_t lastReceivedSeqNo;
     SOCKET sock;
@@ -203,6 +214,11 @@ private:
         const caHdr & hdr, const void * pExt,
         ca_uint16_t extsize);
 
+    bool datagramSend (
+        epicsGuard < epicsMutex > &, tsDLList < SearchDest > & );
+    unicastSearchTimer * findUnicastSearchTimer (
+        epicsGuard < epicsMutex > &, const osiSockAddr &, bool create );
+
     typedef bool ( udpiiu::*pProtoStubUDP ) (
         const caHdr &,
         const osiSockAddr &, const epicsTime & );
@@ -306,6 +322,13 @@ private:
     void govExpireNotify (
         epicsGuard < epicsMutex > &, nciu & );
 
+    // unicastSearchNotify
+    bool datagramFlush (
+        epicsGuard < epicsMutex > &, tsDLList < SearchDest > &,
+        const epicsTime & currentTime );
+    void unicastSearchFailNotify (
+        epicsGuard < epicsMutex > &, nciu &, unsigned nTries );
+
     udpiiu ( const udpiiu & );
     udpiiu & operator = ( const udpiiu & );
 
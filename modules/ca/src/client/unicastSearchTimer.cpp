@@ -0,0 +1,328 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// When a server goes away its channels are first searched for by
+// unicast to that server alone. Once the server answers, channels
+// it doesnt answer for are handed to the broadcast search timers at
+// once, and if it doesnt answer at all after a few tries with an
+// increasing period then all of them are.
+//
+
+#include <stdexcept>
+#include <string> // vxWorks 6.0 requires this include
+#include <limits.h>
+
+#include "iocinf.h"
+#include "udpiiu.h"
+#include "nciu.h"
+#include "unicastSearchTimer.h"
+
+static const unsigned maxUnicastSearchTries = 6u; // before using broadcast
+static const double maxFramesPerTry = 64.0; // max UDP frames per search try
+
+unicastSearchTimer::unicastSearchTimer (
+        unicastSearchNotify & iiuIn,
+        epicsTimerQueue & queueIn,
+        epicsMutex & mutexIn,
+        const struct sockaddr_in & serverAddr,
+        tsDLList < SearchDest > & destListIn ) :
+    inetAddrID ( serverAddr ),
+    timeAtLastSend ( epicsTime::getCurrent () ),
+    timer ( queueIn.createTimer () ),
+    iiu ( iiuIn ),
+    mutex ( mutexIn ),
+    rtteMean ( minRoundTripEstimate ),
+    rtteMeanDev ( 0 ),
+    framesPerTry ( 1.0 ),
+    retry ( 0u ),
+    searchAttempts ( 0u ),
+    searchResponses ( 0u ),
+    searchRequestsTotal ( 0u ),
+    searchResponsesTotal ( 0u ),
+    failuresTotal ( 0u ),
+    stopped ( false )
+{
+    this->destList.add ( destListIn );
+}
+
+unicastSearchTimer::~unicastSearchTimer ()
+{
+    assert ( this->chanListReqPending.count() == 0 );
+    assert ( this->chanListRespPending.count() == 0 );
+    this->timer.destroy ();
+    while ( SearchDest * pDest = this->destList.get () ) {
+        delete pDest;
+    }
+}
+
+void unicastSearchTimer::shutdown (
+    epicsGuard < epicsMutex > & cbGuard,
+    epicsGuard < epicsMutex > & guard )
+{
+    this->stopped = true;
+    {
+        epicsGuardRelease < epicsMutex > unguard ( guard );
+        {
+            epicsGuardRelease < epicsMutex > cbUnguard ( cbGuard );
+            this->timer.cancel ();
+        }
+    }
+
+    while ( nciu * pChan = this->chanListReqPending.get () ) {
+        pChan->channelNode::listMember =
+            channelNode::cs_none;
+        pChan->serviceShutdownNotify ( cbGuard, guard );
+    }
+    while ( nciu * pChan = this->chanListRespPending.get () ) {
+        pChan->channelNode::listMember =
+            channelNode::cs_none;
+        pChan->serviceShutdownNotify ( cbGuard, guard );
+    }
+}
+
+void unicastSearchTimer::installChannel (
+    epicsGuard < epicsMutex > & guard, nciu & chan )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    bool idle = this->channelCount ( guard ) == 0u;
+    this->chanListReqPending.add ( chan );
+    chan.channelNode::listMember =
+        channelNode::cs_unicastSearchReqPending;
+    if ( idle && ! this->stopped ) {
+        this->timer.start ( *this, 0.0 );
+    }
+}
+
+//
+// the server's beacons show that it has restarted so
+// search for its channels again right away
+//
+void unicastSearchTimer::serverRestartNotify (
+    epicsGuard < epicsMutex > & guard )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    this->retry = 0u;
+    while ( nciu * pChan = this->chanListRespPending.get () ) {
+        this->chanListReqPending.add ( *pChan );
+        pChan->channelNode::listMember =
+            channelNode::cs_unicastSearchReqPending;
+    }
+    if ( this->chanListReqPending.count () && ! this->stopped ) {
+        this->timer.start ( *this, 0.0 );
+    }
+}
+
+void unicastSearchTimer::giveUp (
+    epicsGuard < epicsMutex > & guard,
+    tsDLList < nciu > & list, unsigned nTries )
+{
+    while ( nciu * pChan = list.get () ) {
+        pChan->channelNode::listMember =
+            channelNode::cs_none;
+        this->failuresTotal++;
+        this->iiu.unicastSearchFailNotify ( guard, *pChan, nTries );
+    }
+}
+
+epicsTimerNotify::expireStatus unicastSearchTimer::expire (
+    const epicsTime & currentTime )
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+
+    if ( this->chanListRespPending.count () ) {
+        if ( this->searchResponses ) {
+            // the server is there, but it doesnt have these channels
+            this->giveUp ( guard, this->chanListRespPending, 0u );
+        }
+        else if ( this->retry + 1u < maxUnicastSearchTries ) {
+            this->retry++;
+            this->framesPerTry = 1.0;
+            while ( nciu * pChan = this->chanListRespPending.get () ) {
+                this->chanListReqPending.add ( *pChan );
+                pChan->channelNode::listMember =
+                    channelNode::cs_unicastSearchReqPending;
+            }
+        }
+        else {
+            // the server isnt answering so search everywhere
+            this->giveUp ( guard, this->chanListRespPending, maxUnicastSearchTries );
+            this->giveUp ( guard, this->chanListReqPending, maxUnicastSearchTries );
+            this->retry = 0u;
+        }
+    }
+
+    if ( this->searchAttempts &&
+            this->searchResponses == this->searchAttempts ) {
+        this->framesPerTry += this->framesPerTry;
+        if ( this->framesPerTry > maxFramesPerTry ) {
+            this->framesPerTry = maxFramesPerTry;
+        }
+    }
+
+    this->searchAttempts = 0u;
+    this->searchResponses = 0u;
+
+    if ( this->chanListReqPending.count () == 0u ) {
+        return noRestart;
+    }
+
+    this->timeAtLastSend = currentTime;
+
+    unsigned nFrameSent = 0u;
+    while ( nciu * pChan = this->chanListReqPending.get () ) {
+        pChan->channelNode::listMember =
+            channelNode::cs_none;
+
+        bool success = pChan->searchMsg ( guard );
+        if ( ! success ) {
+            if ( this->iiu.datagramFlush ( guard, this->destList, currentTime ) ) {
+                nFrameSent++;
+                if ( nFrameSent < this->framesPerTry ) {
+                    success = pChan->searchMsg ( guard );
+                }
+            }
+            if ( ! success ) {
+                this->chanListReqPending.push ( *pChan );
+                pChan->channelNode::listMember =
+                    channelNode::cs_unicastSearchReqPending;
+                break;
+            }
+        }
+
+        this->chanListRespPending.add ( *pChan );
+        pChan->channelNode::listMember =
+            channelNode::cs_unicastSearchRespPending;
+
+        if ( this->searchAttempts < UINT_MAX ) {
+            this->searchAttempts++;
+        }
+        this->searchRequestsTotal++;
+    }
+
+    // flush out the search request buffer
+    this->iiu.datagramFlush ( guard, this->destList, currentTime );
+
+    return expireStatus ( restart, this->period ( guard ) );
+}
+
+void unicastSearchTimer::uninstallChanDueToSuccessfulSearchResponse (
+    epicsGuard < epicsMutex > & guard, nciu & chan,
+    const epicsTime & currentTime )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    bool respPending = chan.channelNode::listMember ==
+        channelNode::cs_unicastSearchRespPending;
+    this->uninstallChan ( guard, chan );
+    this->searchResponsesTotal++;
+
+    if ( this->stopped || ! respPending ) {
+        return;
+    }
+
+    double measured = currentTime - this->timeAtLastSend;
+    if ( measured > maxRoundTripEstimate ) {
+        measured = maxRoundTripEstimate;
+    }
+    if ( measured < minRoundTripEstimate ) {
+        measured = minRoundTripEstimate;
+    }
+    double error = measured - this->rtteMean;
+    this->rtteMean += 0.125 * error;
+    if ( error < 0.0 ) {
+        error = - error;
+    }
+    this->rtteMeanDev = this->rtteMeanDev + .25 * ( error - this->rtteMeanDev );
+
+    this->retry = 0u;
+    if ( this->searchResponses < UINT_MAX ) {
+        this->searchResponses++;
+        if ( this->searchResponses == this->searchAttempts ) {
+            if ( this->chanListReqPending.count () ) {
+                // when we get 100% success immediately
+                // send another search request
+                this->timer.start ( *this, currentTime );
+            }
+        }
+    }
+}
+
+void unicastSearchTimer::uninstallChan (
+    epicsGuard < epicsMutex > & guard, nciu & chan )
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    if ( chan.channelNode::listMember ==
+            channelNode::cs_unicastSearchReqPending ) {
+        this->chanListReqPending.remove ( chan );
+    }
+    else if ( chan.channelNode::listMember ==
+            channelNode::cs_unicastSearchRespPending ) {
+        this->chanListRespPending.remove ( chan );
+    }
+    else {
+        throw std::runtime_error (
+            "uninstalling channel unicast search timer, but channel "
+            "state is wrong" );
+    }
+    chan.channelNode::listMember = channelNode::cs_none;
+}
+
+double unicastSearchTimer::period (
+    epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    double rtte = this->rtteMean + 4 * this->rtteMeanDev;
+    double broadcastRTTE = this->iiu.getRTTE ( guard );
+    if ( rtte < broadcastRTTE && this->searchResponsesTotal == 0u ) {
+        rtte = broadcastRTTE;
+    }
+    return ( 1 << this->retry ) * rtte;
+}
+
+void unicastSearchTimer::show ( unsigned level ) const
+{
+    epicsGuard < epicsMutex > guard ( this->mutex );
+    this->show ( guard, level );
+}
+
+void unicastSearchTimer::show (
+    epicsGuard < epicsMutex > & guard, unsigned level ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    char buf[64];
+    this->name ( buf, sizeof ( buf ) );
+    ::printf ( "unicast search of \"%s\" with period %f\n",
+        buf, this->period ( guard ) );
+    ::printf ( "\tsearch requests %u, responses %u, handed to broadcast %u\n",
+        this->searchRequestsTotal, this->searchResponsesTotal,
+        this->failuresTotal );
+    if ( level > 0u ) {
+        ::printf ( "\tchannels with search request pending = %u\n",
+            this->chanListReqPending.count () );
+        ::printf ( "\tchannels with search response pending = %u\n",
+            this->chanListRespPending.count () );
+        tsDLIterConst < SearchDest > iter ( this->destList.firstIter () );
+        while ( iter.valid () ) {
+            iter->show ( guard, level - 1u );
+            iter++;
+        }
+    }
+    if ( level > 1u ) {
+        tsDLIterConst < nciu > pChan =
+            this->chanListReqPending.firstIter ();
+        while ( pChan.valid () ) {
+            pChan->show ( guard, level - 2u );
+            pChan++;
+        }
+        pChan = this->chanListRespPending.firstIter ();
+        while ( pChan.valid () ) {
+            pChan->show ( guard, level - 2u );
+            pChan++;
+        }
+    }
+}
+
+unicastSearchNotify::~unicastSearchNotify () {}
@@ -0,0 +1,100 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+//
+// Searches, by unicast, for the channels last connected to one server
+// before they are handed to the broadcast search timers. Each server
+// has its own backoff and round trip time estimate.
+//
+
+#ifndef INC_unicastSearchTimer_H
+#define INC_unicastSearchTimer_H
+
+#include "epicsMutex.h"
+#include "epicsGuard.h"
+#include "epicsTimer.h"
+#include "tsSLList.h"
+
+#include "libCaAPI.h"
+#include "caProto.h"
+#include "netiiu.h"
+#include "inetAddrID.h"
+#include "SearchDest.h"
+
+class unicastSearchNotify {
+public:
+    virtual ~unicastSearchNotify () = 0;
+    virtual double getRTTE ( epicsGuard < epicsMutex > & ) const = 0;
+    virtual bool datagramFlush (
+        epicsGuard < epicsMutex > &, tsDLList < SearchDest > &,
+        const epicsTime & currentTime ) = 0;
+    virtual void unicastSearchFailNotify (
+        epicsGuard < epicsMutex > &, nciu &, unsigned nTries ) = 0;
+};
+
+class unicastSearchTimer :
+        public tsSLNode < unicastSearchTimer >,
+        public inetAddrID,
+        private epicsTimerNotify {
+public:
+    // the search destinations are owned by the timer
+    unicastSearchTimer (
+        class unicastSearchNotify &, epicsTimerQueue &, epicsMutex &,
+        const struct sockaddr_in & serverAddr,
+        tsDLList < SearchDest > & destList );
+    virtual ~unicastSearchTimer ();
+    void shutdown (
+        epicsGuard < epicsMutex > & cbGuard,
+        epicsGuard < epicsMutex > & guard );
+    void installChannel (
+        epicsGuard < epicsMutex > &, nciu & );
+    void uninstallChan (
+        epicsGuard < epicsMutex > &, nciu & );
+    void uninstallChanDueToSuccessfulSearchResponse (
+        epicsGuard < epicsMutex > &, nciu &,
+        const epicsTime & currentTime );
+    void serverRestartNotify (
+        epicsGuard < epicsMutex > & );
+    unsigned channelCount (
+        epicsGuard < epicsMutex > & ) const;
+    void show ( unsigned level ) const;
+    void show ( epicsGuard < epicsMutex > &, unsigned level ) const;
+private:
+    tsDLList < nciu > chanListReqPending;
+    tsDLList < nciu > chanListRespPending;
+    tsDLList < SearchDest > destList;
+    epicsTime timeAtLastSend;
+    epicsTimer & timer;
+    unicastSearchNotify & iiu;
+    epicsMutex & mutex;
+    double rtteMean;
+    double rtteMeanDev;
+    double framesPerTry;
+    unsigned retry; /* consecutive tries without any response */
+    unsigned searchAttempts; /* num search tries after last timer experation */
+    unsigned searchResponses; /* num search resp after last timer experation */
+    unsigned searchRequestsTotal;
+    unsigned searchResponsesTotal;
+    unsigned failuresTotal;
+    bool stopped;
+
+    expireStatus expire ( const epicsTime & currentTime );
+    void giveUp ( epicsGuard < epicsMutex > &,
+        tsDLList < nciu > &, unsigned nTries );
+    double period ( epicsGuard < epicsMutex > & ) const;
+    unicastSearchTimer ( const unicastSearchTimer & ); // not implemented
+    unicastSearchTimer & operator = ( const unicastSearchTimer & ); // not implemented
+};
+
+inline unsigned unicastSearchTimer::channelCount (
+    epicsGuard < epicsMutex > & guard ) const
+{
+    guard.assertIdenticalMutex ( this->mutex );
+    return this->chanListReqPending.count () +
+        this->chanListRespPending.count ();
+}
+
+#endif // ifdef INC_unicastSearchTimer_H
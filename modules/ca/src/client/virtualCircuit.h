@@ -262,6 +262,10 @@ private:
         const epicsTime & currentTime, callbackManager & );
     unsigned sendBytes ( const void *pBuf,
         unsigned nBytesInBuf, const epicsTime & currentTime );
+    bool sendComBufs ( comBuf * const * ppBufs,
+        unsigned nBufs, const epicsTime & currentTime );
+    bool sendRetry ( int status );
+    void sendCork ( bool cork );
     void recvBytes (
         void * pBuf, unsigned nBytesInBuf, statusWireIO & );
     const char * pHostName (
@@ -51,6 +51,45 @@
 
 static int callbackQueueSize = 2000;
 
+/* Queue implementation, selected by callbackSetQueueMode() */
+enum cbMode_t {
+    cbModeLocked,   /* one epicsRingPointerLocked per priority */
+    cbModeLockFree, /* lock-free MPMC ring plus per-worker local rings */
+};
+static int callbackQueueMode = cbModeLocked;
+
+/* Size of the per-worker local rings used in lock-free mode */
+#define CB_LOCAL_RING_SIZE 256
+
+/* Most callbacks one thread takes off its locked ring at once */
+#define CB_BATCH 16
+
+/* Bounded multi-producer/multi-consumer ring after D. Vyukov.
+ * Each cell carries a sequence number which tells producers and
+ * consumers whether the cell is free for the current lap.
+ */
+typedef struct cbLfCell {
+    size_t seq;
+    void *data;
+} cbLfCell;
+
+typedef struct cbLfRing {
+    size_t head;    /* next cell to pop */
+    char pad1[64 - sizeof(size_t)];
+    size_t tail;    /* next cell to push */
+    char pad2[64 - sizeof(size_t)];
+    size_t mask;
+    cbLfCell *cells;
+} cbLfRing;
+
+struct cbQueueSet;
+
+typedef struct cbWorker {
+    struct cbQueueSet *set;
+    int index;
+    cbLfRing local;     /* requests made by this worker for its own set */
+} cbWorker;
+
 typedef struct cbQueueSet {
     epicsEventId semWakeUp;
     epicsRingPointerId queue;
@@ -59,6 +98,12 @@ typedef struct cbQueueSet {
     int shutdown; // use atomic
     int threadsConfigured;
     int threadsRunning;
+    /* Lock-free mode only */
+    cbLfRing *lfQueue;
+    cbWorker *workers;
+    int used;       /* callbacks queued in lfQueue and all local rings */
+    int maxUsed;
+    int sleepers;   /* workers waiting on semWakeUp */
 } cbQueueSet;
 
 static cbQueueSet callbackQueue[NUM_CALLBACK_PRIORITIES];
@@ -97,6 +142,99 @@ static unsigned int threadPriority[NUM_CALLBACK_PRIORITIES] = {
 };
 static int priorityValue[NUM_CALLBACK_PRIORITIES] = {0, 1, 2};
 
+/* Identifies the cbWorker of the current thread in lock-free mode */
+static epicsThreadPrivateId cbWorkerId;
+
+
+static int cbLfRingInit(cbLfRing *ring, int size)
+{
+    size_t n = 1, i;
+
+    while (n < (size_t)size)
+        n <<= 1;
+    ring->cells = calloc(n, sizeof(cbLfCell));
+    if (!ring->cells)
+        return -1;
+    for (i = 0; i < n; i++)
+        ring->cells[i].seq = i;
+    ring->mask = n - 1;
+    ring->head = ring->tail = 0;
+    return 0;
+}
+
+static void cbLfRingFree(cbLfRing *ring)
+{
+    free(ring->cells);
+    ring->cells = NULL;
+}
+
+/* Returns 0 if the ring is full */
+static int cbLfRingPush(cbLfRing *ring, void *data)
+{
+    size_t pos = epicsAtomicGetSizeT(&ring->tail);
+    cbLfCell *cell;
+
+    for (;;) {
+        size_t seq;
+        ptrdiff_t diff;
+
+        cell = &ring->cells[pos & ring->mask];
+        seq = epicsAtomicGetSizeT(&cell->seq);
+        diff = (ptrdiff_t)(seq - pos);
+        if (diff == 0) {
+            size_t prev = epicsAtomicCmpAndSwapSizeT(&ring->tail, pos, pos + 1);
+
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0) {
+            return 0;
+        }
+        else {
+            pos = epicsAtomicGetSizeT(&ring->tail);
+        }
+    }
+    cell->data = data;
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetSizeT(&cell->seq, pos + 1);
+    return 1;
+}
+
+/* Returns NULL if the ring is empty */
+static void * cbLfRingPop(cbLfRing *ring)
+{
+    size_t pos = epicsAtomicGetSizeT(&ring->head);
+    cbLfCell *cell;
+    void *data;
+
+    for (;;) {
+        size_t seq;
+        ptrdiff_t diff;
+
+        cell = &ring->cells[pos & ring->mask];
+        seq = epicsAtomicGetSizeT(&cell->seq);
+        diff = (ptrdiff_t)(seq - (pos + 1));
+        if (diff == 0) {
+            size_t prev = epicsAtomicCmpAndSwapSizeT(&ring->head, pos, pos + 1);
+
+            if (prev == pos)
+                break;
+            pos = prev;
+        }
+        else if (diff < 0) {
+            return NULL;
+        }
+        else {
+            pos = epicsAtomicGetSizeT(&ring->head);
+        }
+    }
+    data = cell->data;
+    epicsAtomicReadMemoryBarrier();
+    epicsAtomicSetSizeT(&cell->seq, pos + ring->mask + 1);
+    return data;
+}
+
 
 int callbackSetQueueSize(int size)
 {
@@ -116,10 +254,17 @@ int callbackQueueStatus(const int reset, callbackQueueStats *result)
         int prio;
         result->size = callbackQueueSize;
         for(prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsRingPointerId qId = callbackQueue[prio].queue;
-            result->numUsed[prio] = epicsRingPointerGetUsed(qId);
-            result->maxUsed[prio] = epicsRingPointerGetHighWaterMark(qId);
-            result->numOverflow[prio] = epicsAtomicGetIntT(&callbackQueue[prio].queueOverflows);
+            cbQueueSet *mySet = &callbackQueue[prio];
+
+            if (callbackQueueMode == cbModeLockFree) {
+                result->numUsed[prio] = epicsAtomicGetIntT(&mySet->used);
+                result->maxUsed[prio] = epicsAtomicGetIntT(&mySet->maxUsed);
+            }
+            else {
+                result->numUsed[prio] = epicsRingPointerGetUsed(mySet->queue);
+                result->maxUsed[prio] = epicsRingPointerGetHighWaterMark(mySet->queue);
+            }
+            result->numOverflow[prio] = epicsAtomicGetIntT(&mySet->queueOverflows);
         }
         ret = 0;
     } else {
@@ -128,7 +273,13 @@ int callbackQueueStatus(const int reset, callbackQueueStats *result)
     if (reset) {
         int prio;
         for(prio = 0; prio < NUM_CALLBACK_PRIORITIES; prio++) {
-            epicsRingPointerResetHighWaterMark(callbackQueue[prio].queue);
+            cbQueueSet *mySet = &callbackQueue[prio];
+
+            if (callbackQueueMode == cbModeLockFree)
+                epicsAtomicSetIntT(&mySet->maxUsed,
+                    epicsAtomicGetIntT(&mySet->used));
+            else
+                epicsRingPointerResetHighWaterMark(mySet->queue);
         }
     }
     return ret;
@@ -153,6 +304,24 @@ void callbackQueueShow(const int reset)
     }
 }
 
+int callbackSetQueueMode(const char *mode)
+{
+    if (epicsAtomicGetIntT(&cbState)!=cbInit) {
+        fprintf(stderr, "Callback system already initialized\n");
+        return -1;
+    }
+    if (!mode || *mode == 0 || epicsStrCaseCmp(mode, "locked") == 0)
+        callbackQueueMode = cbModeLocked;
+    else if (epicsStrCaseCmp(mode, "lockfree") == 0)
+        callbackQueueMode = cbModeLockFree;
+    else {
+        fprintf(stderr, "callbackSetQueueMode: "
+            "Unknown mode \"%s\", use \"locked\" or \"lockfree\"\n", mode);
+        return -1;
+    }
+    return 0;
+}
+
 int callbackParallelThreads(int count, const char *prio)
 {
     if (epicsAtomicGetIntT(&cbState)!=cbInit) {
@@ -207,21 +376,28 @@ static void callbackTask(void *arg)
 {
     int prio = *(int*)arg;
     cbQueueSet *mySet = &callbackQueue[prio];
+    /* Parallel threads take one at a time, to share the work out */
+    int batch = mySet->threadsConfigured > 1 ? 1 : CB_BATCH;
 
     taskwdInsert(0, NULL, NULL);
     epicsEventSignal(startStopEvent);
 
     while(!epicsAtomicGetIntT(&mySet->shutdown)) {
-        void *ptr;
+        void *ptrs[CB_BATCH];
+        int i, n;
+
         if (epicsRingPointerIsEmpty(mySet->queue))
             epicsEventMustWait(mySet->semWakeUp);
 
-        while ((ptr = epicsRingPointerPop(mySet->queue))) {
-            epicsCallback *pcallback = (epicsCallback *)ptr;
+        while ((n = epicsRingPointerPopN(mySet->queue, ptrs, batch)) > 0) {
             if(!epicsRingPointerIsEmpty(mySet->queue))
                 epicsEventMustTrigger(mySet->semWakeUp);
             mySet->queueOverflow = FALSE;
-            (*pcallback->callback)(pcallback);
+            for (i = 0; i < n; i++) {
+                epicsCallback *pcallback = (epicsCallback *)ptrs[i];
+
+                (*pcallback->callback)(pcallback);
+            }
         }
     }
 
@@ -230,6 +406,65 @@ static void callbackTask(void *arg)
     taskwdRemove(0);
 }
 
+/* Lock-free mode: own local ring first, then the shared ring,
+ * then steal from the other workers of this priority.
+ */
+static epicsCallback * cbLfTake(cbQueueSet *mySet, cbWorker *me)
+{
+    int n = mySet->threadsConfigured;
+    void *ptr;
+    int i;
+
+    if ((ptr = cbLfRingPop(&me->local)))
+        return (epicsCallback *)ptr;
+    if ((ptr = cbLfRingPop(mySet->lfQueue)))
+        return (epicsCallback *)ptr;
+    for (i = 1; i < n; i++) {
+        cbWorker *victim = &mySet->workers[(me->index + i) % n];
+
+        if ((ptr = cbLfRingPop(&victim->local)))
+            return (epicsCallback *)ptr;
+    }
+    return NULL;
+}
+
+static void callbackTaskLockFree(void *arg)
+{
+    cbWorker *me = (cbWorker *)arg;
+    cbQueueSet *mySet = me->set;
+
+    taskwdInsert(0, NULL, NULL);
+    epicsThreadPrivateSet(cbWorkerId, me);
+    epicsEventSignal(startStopEvent);
+
+    while(!epicsAtomicGetIntT(&mySet->shutdown)) {
+        epicsCallback *pcallback = cbLfTake(mySet, me);
+
+        if (!pcallback) {
+            /* Producers only signal semWakeUp when they see a sleeper,
+             * so announce ourselves before checking for work again.
+             */
+            epicsAtomicIncrIntT(&mySet->sleepers);
+            if (!epicsAtomicGetIntT(&mySet->used) &&
+                !epicsAtomicGetIntT(&mySet->shutdown))
+                epicsEventMustWait(mySet->semWakeUp);
+            epicsAtomicDecrIntT(&mySet->sleepers);
+            continue;
+        }
+
+        if (epicsAtomicDecrIntT(&mySet->used) &&
+            epicsAtomicGetIntT(&mySet->sleepers))
+            epicsEventMustTrigger(mySet->semWakeUp);
+        mySet->queueOverflow = FALSE;
+        (*pcallback->callback)(pcallback);
+    }
+
+    epicsThreadPrivateSet(cbWorkerId, NULL);
+    if(!epicsAtomicDecrIntT(&mySet->threadsRunning))
+        epicsEventSignal(startStopEvent);
+    taskwdRemove(0);
+}
+
 void callbackStop(void)
 {
     int i;
@@ -264,7 +499,17 @@ void callbackCleanup(void)
 
         assert(epicsAtomicGetIntT(&mySet->threadsRunning)==0);
         epicsEventDestroy(mySet->semWakeUp);
-        epicsRingPointerDelete(mySet->queue);
+        if (mySet->queue)
+            epicsRingPointerDelete(mySet->queue);
+        if (mySet->lfQueue) {
+            int j;
+
+            for (j = 0; j < mySet->threadsConfigured; j++)
+                cbLfRingFree(&mySet->workers[j].local);
+            free(mySet->workers);
+            cbLfRingFree(mySet->lfQueue);
+            free(mySet->lfQueue);
+        }
     }
 
     epicsTimerQueueRelease(timerQueue);
@@ -284,29 +529,59 @@ void callbackInit(void)
 
     if(!startStopEvent)
         startStopEvent = epicsEventMustCreate(epicsEventEmpty);
+    if(!cbWorkerId)
+        cbWorkerId = epicsThreadPrivateCreate();
 
-    timerQueue = epicsTimerQueueAllocate(0, epicsThreadPriorityScanHigh);
+    /* callbackRequestDelayed() may keep many timers pending */
+    timerQueue = epicsTimerQueueAllocateBackend(0, epicsThreadPriorityScanHigh,
+        epicsTimerQueueTimingWheel);
 
     for (i = 0; i < NUM_CALLBACK_PRIORITIES; i++) {
         epicsThreadId tid;
 
         callbackQueue[i].semWakeUp = epicsEventMustCreate(epicsEventEmpty);
-        callbackQueue[i].queue = epicsRingPointerLockedCreate(callbackQueueSize);
-        if (callbackQueue[i].queue == 0)
-            cantProceed("epicsRingPointerLockedCreate failed for %s\n",
-                threadNamePrefix[i]);
         callbackQueue[i].queueOverflow = FALSE;
         if (callbackQueue[i].threadsConfigured == 0)
             callbackQueue[i].threadsConfigured = callbackThreadsDefault;
 
+        if (callbackQueueMode == cbModeLockFree) {
+            cbQueueSet *mySet = &callbackQueue[i];
+
+            mySet->lfQueue = callocMustSucceed(1, sizeof(cbLfRing),
+                "callbackInit");
+            if (cbLfRingInit(mySet->lfQueue, callbackQueueSize))
+                cantProceed("cbLfRingInit failed for %s\n",
+                    threadNamePrefix[i]);
+            mySet->workers = callocMustSucceed(mySet->threadsConfigured,
+                sizeof(cbWorker), "callbackInit");
+            for (j = 0; j < mySet->threadsConfigured; j++) {
+                mySet->workers[j].set = mySet;
+                mySet->workers[j].index = j;
+                if (cbLfRingInit(&mySet->workers[j].local, CB_LOCAL_RING_SIZE))
+                    cantProceed("cbLfRingInit failed for %s\n",
+                        threadNamePrefix[i]);
+            }
+        }
+        else {
+            callbackQueue[i].queue = epicsRingPointerLockedCreate(callbackQueueSize);
+            if (callbackQueue[i].queue == 0)
+                cantProceed("epicsRingPointerLockedCreate failed for %s\n",
+                    threadNamePrefix[i]);
+        }
+
         for (j = 0; j < callbackQueue[i].threadsConfigured; j++) {
             if (callbackQueue[i].threadsConfigured > 1 )
                 sprintf(threadName, "%s-%d", threadNamePrefix[i], j);
             else
                 strcpy(threadName, threadNamePrefix[i]);
-            tid = epicsThreadCreate(threadName, threadPriority[i],
-                epicsThreadGetStackSize(epicsThreadStackBig),
-                (EPICSTHREADFUNC)callbackTask, &priorityValue[i]);
+            if (callbackQueueMode == cbModeLockFree)
+                tid = epicsThreadCreate(threadName, threadPriority[i],
+                    epicsThreadGetStackSize(epicsThreadStackBig),
+                    callbackTaskLockFree, &callbackQueue[i].workers[j]);
+            else
+                tid = epicsThreadCreate(threadName, threadPriority[i],
+                    epicsThreadGetStackSize(epicsThreadStackBig),
+                    (EPICSTHREADFUNC)callbackTask, &priorityValue[i]);
             if (tid == 0) {
                 cantProceed("Failed to spawn callback thread %s\n", threadName);
             } else {
@@ -317,6 +592,42 @@ void callbackInit(void)
     }
 }
 
+/* Lock-free mode: reserve space against callbackQueueSize, then queue
+ * on the caller's local ring when it is a worker of the same priority.
+ */
+static int callbackRequestLockFree(cbQueueSet *mySet, epicsCallback *pcallback)
+{
+    cbWorker *me = NULL;
+    int used = epicsAtomicIncrIntT(&mySet->used);
+    int hwm = epicsAtomicGetIntT(&mySet->maxUsed);
+
+    if (used > callbackQueueSize) {
+        epicsAtomicDecrIntT(&mySet->used);
+        return 0;
+    }
+    while (used > hwm) {
+        int prev = epicsAtomicCmpAndSwapIntT(&mySet->maxUsed, hwm, used);
+
+        if (prev == hwm)
+            break;
+        hwm = prev;
+    }
+
+    if (mySet->threadsConfigured > 1 && !epicsInterruptIsInterruptContext())
+        me = (cbWorker *)epicsThreadPrivateGet(cbWorkerId);
+    if (!me || me->set != mySet || !cbLfRingPush(&me->local, pcallback)) {
+        /* Can't fail, lfQueue holds at least callbackQueueSize entries */
+        if (!cbLfRingPush(mySet->lfQueue, pcallback)) {
+            epicsAtomicDecrIntT(&mySet->used);
+            return 0;
+        }
+    }
+
+    if (epicsAtomicAddIntT(&mySet->sleepers, 0))
+        epicsEventSignal(mySet->semWakeUp);
+    return 1;
+}
+
 /* This routine can be called from interrupt context */
 int callbackRequest(epicsCallback *pcallback)
 {
@@ -336,7 +647,14 @@ int callbackRequest(epicsCallback *pcallback)
     mySet = &callbackQueue[priority];
     if (mySet->queueOverflow) return S_db_bufFull;
 
-    pushOK = epicsRingPointerPush(mySet->queue, pcallback);
+    if (callbackQueueMode == cbModeLockFree) {
+        pushOK = callbackRequestLockFree(mySet, pcallback);
+    }
+    else {
+        pushOK = epicsRingPointerPush(mySet->queue, pcallback);
+        if (pushOK)
+            epicsEventSignal(mySet->semWakeUp);
+    }
 
     if (!pushOK) {
         epicsInterruptContextMessage(fullMessage[priority]);
@@ -344,7 +662,6 @@ int callbackRequest(epicsCallback *pcallback)
         epicsAtomicIncrIntT(&mySet->queueOverflows);
         return S_db_bufFull;
     }
-    epicsEventSignal(mySet->semWakeUp);
     return 0;
 }
 
@@ -40,6 +40,7 @@
 #include "callback.h"
 #include "dbAccessDefs.h"
 #include "dbAddr.h"
+#include "dbArrayBuf.h"
 #include "dbBase.h"
 #include "dbBkpt.h"
 #include "dbCommonPvt.h"
@@ -1335,7 +1336,10 @@ long dbPut(DBADDR *paddr, short dbrType,
         prset && prset->get_array_info) {
         long dummy;
 
+        /* the record may have to swap out a shared buffer */
+        dbArrayBufSetPutting(1);
         status = prset->get_array_info(paddr, &dummy, &offset);
+        dbArrayBufSetPutting(0);
         /* paddr->pfield may be modified */
         if (status) goto done;
         if (no_elements < nRequest)
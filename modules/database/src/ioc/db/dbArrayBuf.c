@@ -0,0 +1,307 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS Base is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Reference counted array buffers.
+ *
+ * Each buffer is preceded by a header holding its reference count.
+ * The pool holds one reference to its current buffer, each field log
+ * which shares it holds another. When the last reference goes the
+ * buffer is kept by the pool for reuse, up to MAXSPARE of them, so a
+ * record which swaps buffers on every update doesn't have to allocate
+ * and fault in a new one each time.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "epicsAtomic.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+
+#define epicsExportSharedSymbols
+#include "dbArrayBuf.h"
+#include "db_field_log.h"
+#include "epicsExport.h"
+
+#define MAXSPARE 2
+
+int dbArrayBufShare = 0;
+epicsExportAddress(int, dbArrayBufShare);
+
+/* Set in a thread while dbPut() asks for the address to write to */
+static epicsThreadOnceId putOnce = EPICS_THREAD_ONCE_INIT;
+static epicsThreadPrivateId putId;
+static char putting;
+
+typedef struct bufHeader {
+    struct bufHeader *next;     /* on the pool's spare list */
+    dbArrayBufPool *pool;
+    size_t refs;
+    /* derived copy, guarded by the pool's lock */
+    void *derived;
+    size_t derivedSize;
+    dbArrayBufConvert *func;
+    void *arg;
+} bufHeader;
+
+/* Keep the data aligned for any element type */
+#define HDRSIZE ((sizeof(bufHeader) + 15u) & ~(size_t) 15u)
+#define HDR(buf) ((bufHeader *) ((char *) (buf) - HDRSIZE))
+#define BUF(phdr) ((void *) ((char *) (phdr) + HDRSIZE))
+
+struct dbArrayBufPool {
+    epicsMutexId lock;
+    size_t size;
+    void *current;
+    bufHeader *spare;
+    size_t nSpare;
+    size_t nBuffers;
+    size_t maxBuffers;
+    size_t nCopies;
+};
+
+static bufHeader * allocBuf(dbArrayBufPool *pool)
+{
+    bufHeader *phdr;
+
+    epicsMutexMustLock(pool->lock);
+    phdr = pool->spare;
+    if (phdr) {
+        pool->spare = phdr->next;
+        pool->nSpare--;
+    }
+    epicsMutexUnlock(pool->lock);
+
+    if (!phdr) {
+        phdr = calloc(1, HDRSIZE + pool->size);
+        if (!phdr)
+            return NULL;
+        phdr->pool = pool;
+        epicsMutexMustLock(pool->lock);
+        if (++pool->nBuffers > pool->maxBuffers)
+            pool->maxBuffers = pool->nBuffers;
+        epicsMutexUnlock(pool->lock);
+    }
+    phdr->next = NULL;
+    epicsAtomicSetSizeT(&phdr->refs, 1);
+    return phdr;
+}
+
+dbArrayBufPool * dbArrayBufPoolCreate(size_t size)
+{
+    dbArrayBufPool *pool = callocMustSucceed(1, sizeof(*pool),
+        "dbArrayBufPoolCreate");
+    bufHeader *phdr;
+
+    pool->lock = epicsMutexMustCreate();
+    pool->size = size;
+    phdr = allocBuf(pool);
+    if (!phdr)
+        cantProceed("dbArrayBufPoolCreate: no memory for %lu bytes\n",
+            (unsigned long) size);
+    pool->current = BUF(phdr);
+    return pool;
+}
+
+void dbArrayBufPoolDestroy(dbArrayBufPool *pool)
+{
+    bufHeader *phdr;
+
+    if (!pool)
+        return;
+    if (pool->current) {
+        phdr = HDR(pool->current);
+        free(phdr->derived);
+        free(phdr);
+    }
+    while ((phdr = pool->spare)) {
+        pool->spare = phdr->next;
+        free(phdr);
+    }
+    epicsMutexDestroy(pool->lock);
+    free(pool);
+}
+
+void * dbArrayBufCurrent(dbArrayBufPool *pool)
+{
+    return pool ? pool->current : NULL;
+}
+
+void dbArrayBufPoolStats(dbArrayBufPool *pool, dbArrayBufStats *pstats)
+{
+    epicsMutexMustLock(pool->lock);
+    pstats->size = pool->size;
+    pstats->nBuffers = pool->nBuffers;
+    pstats->maxBuffers = pool->maxBuffers;
+    pstats->nCopies = pool->nCopies;
+    epicsMutexUnlock(pool->lock);
+}
+
+void * dbArrayBufShareable(dbArrayBufPool *pool, void *buf)
+{
+    if (!dbArrayBufShare || !pool || !buf || buf != pool->current)
+        return NULL;
+    return buf;
+}
+
+void * dbArrayBufWritable(dbArrayBufPool *pool, void *buf, size_t keep)
+{
+    bufHeader *phdr, *pnew;
+
+    /* Device support may have replaced the buffer */
+    if (!pool || !buf || buf != pool->current)
+        return buf;
+
+    phdr = HDR(buf);
+    if (epicsAtomicGetSizeT(&phdr->refs) == 1) {
+        /* Nobody else can see it, but its derived copy is now stale */
+        if (phdr->derived) {
+            epicsMutexMustLock(pool->lock);
+            free(phdr->derived);
+            phdr->derived = NULL;
+            epicsMutexUnlock(pool->lock);
+        }
+        return buf;
+    }
+
+    pnew = allocBuf(pool);
+    if (!pnew)
+        return buf;     /* Readers may see it change */
+
+    if (keep > pool->size)
+        keep = pool->size;
+    if (keep) {
+        memcpy(BUF(pnew), buf, keep);
+        epicsMutexMustLock(pool->lock);
+        pool->nCopies++;
+        epicsMutexUnlock(pool->lock);
+    }
+    pool->current = BUF(pnew);
+    dbArrayBufRelease(buf);
+    return pool->current;
+}
+
+void dbArrayBufRef(void *buf)
+{
+    epicsAtomicIncrSizeT(&HDR(buf)->refs);
+}
+
+void dbArrayBufRelease(void *buf)
+{
+    bufHeader *phdr = HDR(buf);
+    dbArrayBufPool *pool = phdr->pool;
+
+    if (epicsAtomicDecrSizeT(&phdr->refs) > 0)
+        return;
+
+    free(phdr->derived);
+    phdr->derived = NULL;
+
+    epicsMutexMustLock(pool->lock);
+    if (pool->nSpare < MAXSPARE) {
+        phdr->next = pool->spare;
+        pool->spare = phdr;
+        pool->nSpare++;
+        phdr = NULL;
+    }
+    else {
+        pool->nBuffers--;
+    }
+    epicsMutexUnlock(pool->lock);
+    free(phdr);
+}
+
+static void putInit(void *junk)
+{
+    putId = epicsThreadPrivateCreate();
+}
+
+void dbArrayBufSetPutting(int on)
+{
+    epicsThreadOnce(&putOnce, putInit, NULL);
+    epicsThreadPrivateSet(putId, on ? &putting : NULL);
+}
+
+int dbArrayBufPutting(void)
+{
+    epicsThreadOnce(&putOnce, putInit, NULL);
+    return epicsThreadPrivateGet(putId) != NULL;
+}
+
+int dbArrayBufShared(const void *buf)
+{
+    return epicsAtomicGetSizeT(&HDR(buf)->refs) > 1;
+}
+
+const void * dbArrayBufDerived(void *buf, size_t size,
+    dbArrayBufConvert *func, void *arg)
+{
+    bufHeader *phdr = HDR(buf);
+    dbArrayBufPool *pool = phdr->pool;
+    const void *result = NULL;
+    void *copy;
+
+    if (size > pool->size)
+        return NULL;
+
+    epicsMutexMustLock(pool->lock);
+    if (phdr->derived) {
+        if (phdr->func == func && phdr->arg == arg &&
+            phdr->derivedSize >= size)
+            result = phdr->derived;
+        epicsMutexUnlock(pool->lock);
+        return result;
+    }
+    epicsMutexUnlock(pool->lock);
+
+    /* Several readers may race to make the first copy */
+    copy = malloc(size ? size : 1);
+    if (!copy)
+        return NULL;
+    if (func(copy, buf, size, arg)) {
+        free(copy);
+        return NULL;
+    }
+
+    epicsMutexMustLock(pool->lock);
+    if (!phdr->derived) {
+        phdr->derived = copy;
+        phdr->derivedSize = size;
+        phdr->func = func;
+        phdr->arg = arg;
+        result = copy;
+        copy = NULL;
+    }
+    else if (phdr->func == func && phdr->arg == arg &&
+        phdr->derivedSize >= size) {
+        result = phdr->derived;
+    }
+    epicsMutexUnlock(pool->lock);
+    free(copy);
+    return result;
+}
+
+static void releaseLog(db_field_log *pfl)
+{
+    dbArrayBufRelease(pfl->u.r.pvt);
+}
+
+void dbArrayBufRefLog(db_field_log *pfl, void *buf)
+{
+    dbArrayBufRef(buf);
+    pfl->type = dbfl_type_ref;
+    pfl->u.r.dtor = releaseLog;
+    pfl->u.r.pvt = buf;
+    pfl->u.r.field = buf;
+}
+
+void * dbArrayBufFromLog(const db_field_log *pfl)
+{
+    if (pfl && pfl->type == dbfl_type_ref && pfl->u.r.dtor == releaseLog)
+        return pfl->u.r.pvt;
+    return NULL;
+}
@@ -0,0 +1,92 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS Base is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Reference counted array buffers, shared between a record and the
+ * field logs of its monitors.
+ *
+ * A record keeps the data of an array field in the current buffer of a
+ * dbArrayBufPool. When it posts a new value its monitors are given a
+ * reference to that buffer (see db_post_events_ref()) rather than each
+ * of them copying the data. A buffer must not change while anything
+ * else holds a reference to it, so before writing into it the record
+ * calls dbArrayBufWritable(), which swaps in another buffer from the
+ * pool if the current one is still shared. It does so when it processes,
+ * and in get_array_info() when dbArrayBufPutting() says that dbPut() is
+ * about to write to the field. Reads of the field use the current
+ * buffer as it is.
+ */
+
+#ifndef INC_dbArrayBuf_H
+#define INC_dbArrayBuf_H
+
+#include <stddef.h>
+
+#include "db_field_log.h"
+#include "dbCoreAPI.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct dbArrayBufPool dbArrayBufPool;
+
+typedef struct dbArrayBufStats {
+    size_t size;        /* bytes in each buffer */
+    size_t nBuffers;    /* buffers allocated now */
+    size_t maxBuffers;  /* most buffers ever allocated at once */
+    size_t nCopies;     /* data copies made by dbArrayBufWritable() */
+} dbArrayBufStats;
+
+/* Makes a derived copy of size bytes, returns 0 on success */
+typedef int dbArrayBufConvert(void *pdst, const void *psrc, size_t size,
+    void *arg);
+
+/* Nonzero to post array fields by reference, zero (the default) to
+ * post them by value */
+DBCORE_API extern int dbArrayBufShare;
+
+/* Pool of buffers of size bytes, the first of which is current */
+DBCORE_API dbArrayBufPool * dbArrayBufPoolCreate(size_t size);
+/* Only once the current buffer is no longer shared */
+DBCORE_API void dbArrayBufPoolDestroy(dbArrayBufPool *pool);
+DBCORE_API void * dbArrayBufCurrent(dbArrayBufPool *pool);
+DBCORE_API void dbArrayBufPoolStats(dbArrayBufPool *pool,
+    dbArrayBufStats *pstats);
+
+/* Returns buf if it is the current buffer of pool and monitors may be
+ * given references to it, else NULL */
+DBCORE_API void * dbArrayBufShareable(dbArrayBufPool *pool, void *buf);
+/* Returns a buffer which can be written to in place of buf, with its
+ * first keep bytes copied if it had to be swapped */
+DBCORE_API void * dbArrayBufWritable(dbArrayBufPool *pool, void *buf,
+    size_t keep);
+
+/* Nonzero in get_array_info() when it's called by dbPut(), which then
+ * writes to the address it returns */
+DBCORE_API int dbArrayBufPutting(void);
+/* For dbPut() */
+DBCORE_API void dbArrayBufSetPutting(int on);
+
+DBCORE_API void dbArrayBufRef(void *buf);
+DBCORE_API void dbArrayBufRelease(void *buf);
+DBCORE_API int dbArrayBufShared(const void *buf);
+
+/* A copy of the first size bytes of buf made by func(arg), cached with
+ * the buffer. NULL if a different copy is cached already. */
+DBCORE_API const void * dbArrayBufDerived(void *buf, size_t size,
+    dbArrayBufConvert *func, void *arg);
+
+/* Point a field log at buf, taking a reference which is released with
+ * the log */
+DBCORE_API void dbArrayBufRefLog(db_field_log *pfl, void *buf);
+/* The buffer a field log shares, or NULL */
+DBCORE_API void * dbArrayBufFromLog(const db_field_log *pfl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_dbArrayBuf_H */
@@ -346,6 +346,11 @@ long dbChannelTest(const char *name)
     return status;
 }
 
+unsigned int dbChannelTestGeneration(void)
+{
+    return pdbbase ? dbPvdGeneration(pdbbase) : 0;
+}
+
 #define TRY(Func, Arg) \
 if (Func) { \
     result = Func Arg; \
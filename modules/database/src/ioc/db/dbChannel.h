@@ -42,6 +42,7 @@ typedef struct evSubscrip {
     db_field_log            **pLastLog;
     unsigned long           npend;  /* n times this event is on the queue */
     unsigned long           nreplace;  /* n times replacing event on the queue */
+    unsigned long           ncoalesce; /* n times merged with queued empty event */
     unsigned char           select;
     char                    useValque;
     char                    callBackInProgress;
@@ -152,6 +153,8 @@ struct dbFldDes;
 DBCORE_API void dbChannelInit (void);
 DBCORE_API void dbChannelExit(void);
 DBCORE_API long dbChannelTest(const char *name);
+/* Changes when records are added, so dbChannelTest() failures may be cached */
+DBCORE_API unsigned int dbChannelTestGeneration(void);
 DBCORE_API dbChannel * dbChannelCreate(const char *name);
 DBCORE_API long dbChannelOpen(dbChannel *chan);
 
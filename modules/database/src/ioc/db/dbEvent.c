@@ -40,6 +40,7 @@
 #define epicsExportSharedSymbols
 #include "dbAccessDefs.h"
 #include "dbAddr.h"
+#include "dbArrayBuf.h"
 #include "dbBase.h"
 #include "dbChannel.h"
 #include "dbCommon.h"
@@ -47,6 +48,7 @@
 #include "db_field_log.h"
 #include "dbFldTypes.h"
 #include "dbLock.h"
+#include "epicsExport.h"
 #include "link.h"
 #include "special.h"
 
@@ -59,19 +61,31 @@
 #define EVENTSPERQUE    36
 #define EVENTENTRIES    4      /* the number of que entries for each event */
 #define EVENTQUESIZE    (EVENTENTRIES  * EVENTSPERQUE)
+#define EVENTQUEMINSIZE (EVENTENTRIES * 2)
+#define EVENTQUEMAXSIZE 0x8000
 #define EVENTQEMPTY     ((struct evSubscrip *)NULL)
 
+/* Default number of entries in each event que of a new context,
+ * may be changed per context with db_set_event_queue_size().
+ */
+int dbEventQueueSize = EVENTQUESIZE;
+epicsExportAddress(int, dbEventQueueSize);
+
 /*
  * really a ring buffer
+ *
+ * valque and evque share one slab of quesize entries each, which is
+ * allocated when the que is created.
  */
 struct event_que {
     /* lock writers to the ring buffer only */
     /* readers must never slow up writers */
     epicsMutexId            writelock;
-    db_field_log            *valque[EVENTQUESIZE];
-    struct evSubscrip       *evque[EVENTQUESIZE];
+    db_field_log            **valque;
+    struct evSubscrip       **evque;
     struct event_que        *nextque;       /* in case que quota exceeded */
     struct event_user       *evUser;        /* event user parent struct */
+    unsigned short          quesize;        /* the number of ring entries */
     unsigned short          putix;
     unsigned short          getix;
     unsigned short          quota;          /* the number of assigned entries*/
@@ -92,6 +106,7 @@ struct event_user {
     epicsThreadId       taskid;         /* event handler task id */
     struct evSubscrip   *pSuicideEvent; /* event that is deleteing itself */
     unsigned            queovr;         /* event que overflow count */
+    unsigned short      quesize;        /* entries in each event que */
     unsigned char       pendexit;       /* exit pend task */
     unsigned char       extra_labor;    /* if set call extra labor func */
     unsigned char       flowCtrlMode;   /* replace existing monitor */
@@ -106,8 +121,8 @@ struct event_user {
  * into only 10 or 20 total steps part of the time.
  */
 
-#define RNGINC(OLD)\
-( (unsigned short) ( (OLD) >= (EVENTQUESIZE-1) ? 0 : (OLD)+1 ) )
+#define RNGINC(EV_QUE, OLD)\
+( (unsigned short) ( (OLD) >= ((EV_QUE)->quesize-1) ? 0 : (OLD)+1 ) )
 
 #define LOCKEVQUE(EV_QUE)   epicsMutexMustLock((EV_QUE)->writelock)
 #define UNLOCKEVQUE(EV_QUE) epicsMutexUnlock((EV_QUE)->writelock)
@@ -130,12 +145,57 @@ static unsigned short ringSpace ( const struct event_que *pevq )
             return ( unsigned short ) ( pevq->getix - pevq->putix );
         }
         else {
-            return ( unsigned short ) ( ( EVENTQUESIZE + pevq->getix ) - pevq->putix );
+            return ( unsigned short ) ( ( pevq->quesize + pevq->getix ) - pevq->putix );
         }
     }
     return 0;
 }
 
+/*
+ * event_que_size()
+ *
+ * Clip a requested que size to the supported range, rounded
+ * up to a whole number of EVENTENTRIES
+ */
+static unsigned short event_que_size ( unsigned nEntries )
+{
+    if ( nEntries < EVENTQUEMINSIZE ) {
+        nEntries = EVENTQUEMINSIZE;
+    }
+    else if ( nEntries > EVENTQUEMAXSIZE ) {
+        nEntries = EVENTQUEMAXSIZE;
+    }
+    nEntries = ( nEntries + EVENTENTRIES - 1 ) / EVENTENTRIES * EVENTENTRIES;
+    return ( unsigned short ) nEntries;
+}
+
+/*
+ * alloc_que_entries()
+ *
+ * Allocate the slab holding valque and evque, all entries start empty
+ */
+static int alloc_que_entries ( struct event_que *ev_que, unsigned short quesize )
+{
+    void *slab = calloc ( quesize,
+        sizeof ( *ev_que->valque ) + sizeof ( *ev_que->evque ) );
+
+    if ( ! slab ) {
+        return DB_EVENT_ERROR;
+    }
+    ev_que->valque = ( db_field_log ** ) slab;
+    ev_que->evque = ( struct evSubscrip ** ) ( ev_que->valque + quesize );
+    ev_que->quesize = quesize;
+    ev_que->putix = ev_que->getix = 0;
+    return DB_EVENT_OK;
+}
+
+static void free_que_entries ( struct event_que *ev_que )
+{
+    free ( ev_que->valque );
+    ev_que->valque = NULL;
+    ev_que->evque = NULL;
+}
+
 /*
  *  db_event_list ()
  */
@@ -193,16 +253,18 @@ int dbel ( const char *pname, unsigned level )
 
             if ( level > 1 ) {
                 unsigned nEntriesFree;
+                unsigned quesize;
                 const void * taskId;
                 LOCKEVQUE(pevent->ev_que);
                 nEntriesFree = ringSpace ( pevent->ev_que );
+                quesize = pevent->ev_que->quesize;
                 taskId = ( void * ) pevent->ev_que->evUser->taskid;
                 UNLOCKEVQUE(pevent->ev_que);
                 if ( nEntriesFree == 0u ) {
                     printf ( ", thread=%p, queue full",
                         (void *) taskId );
                 }
-                else if ( nEntriesFree == EVENTQUESIZE ) {
+                else if ( nEntriesFree == quesize ) {
                     printf ( ", thread=%p, queue empty",
                         (void *) taskId );
                 }
@@ -210,6 +272,7 @@ int dbel ( const char *pname, unsigned level )
                     printf ( ", thread=%p, unused entries=%u",
                         (void *) taskId, nEntriesFree );
                 }
+                printf ( ", queue size=%u", quesize );
             }
 
             if ( level > 2 ) {
@@ -218,6 +281,9 @@ int dbel ( const char *pname, unsigned level )
                 if ( pevent->nreplace ) {
                     printf (", discarded by replacement=%ld", pevent->nreplace);
                 }
+                if ( pevent->ncoalesce ) {
+                    printf (", coalesced=%ld", pevent->ncoalesce);
+                }
                 if ( ! pevent->useValque ) {
                     printf (", queueing disabled" );
                 }
@@ -274,8 +340,9 @@ void db_init_event_freelists (void)
             sizeof(struct evSubscrip),256);
     }
     if (!dbevFieldLogFreeList) {
-        freeListInitPvt(&dbevFieldLogFreeList,
-            sizeof(struct db_field_log),2048);
+        /* allocated by posting threads, freed by event tasks */
+        freeListInitPvtCached(&dbevFieldLogFreeList,
+            sizeof(struct db_field_log),2048,32);
     }
 }
 
@@ -300,6 +367,11 @@ dbEventCtx db_init_events (void)
         return NULL;
     }
 
+    evUser->quesize = event_que_size(dbEventQueueSize > 0 ?
+        (unsigned) dbEventQueueSize : EVENTQUESIZE);
+    if (alloc_que_entries(&evUser->firstque, evUser->quesize))
+        goto fail;
+
     evUser->firstque.evUser = evUser;
     evUser->firstque.writelock = epicsMutexCreate();
     if (!evUser->firstque.writelock)
@@ -328,10 +400,47 @@ fail:
         epicsEventDestroy (evUser->ppendsem);
     if(evUser->pflush_sem)
         epicsEventDestroy (evUser->pflush_sem);
+    free_que_entries(&evUser->firstque);
     freeListFree(dbevEventUserFreeList,evUser);
     return NULL;
 }
 
+/*
+ * DB_SET_EVENT_QUEUE_SIZE()
+ *
+ * Change the number of entries in each event que of this context.
+ * Must be called before the first db_add_event() on the context.
+ */
+int db_set_event_queue_size (dbEventCtx ctx, unsigned nEntries)
+{
+    struct event_user * const evUser = (struct event_user *) ctx;
+    struct event_que * const ev_que = &evUser->firstque;
+    unsigned short quesize = event_que_size(nEntries);
+    int status = DB_EVENT_OK;
+
+    epicsMutexMustLock ( evUser->lock );
+    LOCKEVQUE ( ev_que );
+    if ( ev_que->quota || ev_que->nCanceled || ev_que->nextque ) {
+        status = DB_EVENT_ERROR;
+    }
+    else if ( quesize != ev_que->quesize ) {
+        struct event_que tmp;
+
+        status = alloc_que_entries ( &tmp, quesize );
+        if ( status == DB_EVENT_OK ) {
+            free_que_entries ( ev_que );
+            ev_que->valque = tmp.valque;
+            ev_que->evque = tmp.evque;
+            ev_que->quesize = tmp.quesize;
+            ev_que->putix = ev_que->getix = 0;
+            evUser->quesize = quesize;
+        }
+    }
+    UNLOCKEVQUE ( ev_que );
+    epicsMutexUnlock ( evUser->lock );
+    return status;
+}
+
 
 epicsShareFunc void db_cleanup_events(void)
 {
@@ -390,8 +499,13 @@ static struct event_que * create_ev_que ( struct event_user * const evUser )
     if ( ! ev_que ) {
         return NULL;
     }
+    if ( alloc_que_entries ( ev_que, evUser->quesize ) ) {
+        freeListFree ( dbevEventQueueFreeList, ev_que );
+        return NULL;
+    }
     ev_que->writelock = epicsMutexCreate();
     if ( ! ev_que->writelock ) {
+        free_que_entries ( ev_que );
         freeListFree ( dbevEventQueueFreeList, ev_que );
         return NULL;
     }
@@ -430,7 +544,7 @@ dbEventSubscription db_add_event (
         int success = 0;
         LOCKEVQUE ( ev_que );
         success = ( ev_que->quota + ev_que->nCanceled <
-                                EVENTQUESIZE - EVENTENTRIES );
+                                ev_que->quesize - EVENTENTRIES );
         if ( success ) {
             ev_que->quota += EVENTENTRIES;
         }
@@ -456,6 +570,7 @@ dbEventSubscription db_add_event (
 
     pevent->npend =     0ul;
     pevent->nreplace =  0ul;
+    pevent->ncoalesce = 0ul;
     pevent->user_sub =  user_sub;
     pevent->user_arg =  user_arg;
     pevent->chan =      chan;
@@ -578,7 +693,7 @@ void db_cancel_event (dbEventSubscription event)
             pevent->ev_que->nCanceled++;
             event_remove ( pevent->ev_que, getix, &canceledEvent );
         }
-        getix = RNGINC ( getix );
+        getix = RNGINC ( pevent->ev_que, getix );
         if ( getix == pevent->ev_que->getix ) {
             break;
         }
@@ -720,22 +835,42 @@ db_field_log* db_create_read_log (struct dbChannel *chan)
 }
 
 /*
- *  DB_QUEUE_EVENT_LOG()
+ *  CREATE_REF_LOG()
  *
+ *  NOTE: This assumes that the db scan lock is already applied
+ *        (as it copies meta-data from the record)
  */
-static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
+static db_field_log* create_ref_log (struct evSubscrip *pevent,
+    void *pBuffer, long no_elements)
 {
-    struct event_que    *ev_que;
-    int firstEventFlag;
-    unsigned rngSpace;
+    db_field_log *pLog = (db_field_log *) freeListCalloc(dbevFieldLogFreeList);
 
-    ev_que = pevent->ev_que;
-    /*
-     * evUser ring buffer must be locked for the multiple
-     * threads writing/reading it
-     */
+    if (pLog) {
+        struct dbChannel *chan = pevent->chan;
+        struct dbCommon  *prec = dbChannelRecord(chan);
+        pLog->ctx  = dbfl_context_event;
+        pLog->stat = prec->stat;
+        pLog->sevr = prec->sevr;
+        pLog->time = prec->time;
+        pLog->field_type  = dbChannelFieldType(chan);
+        pLog->field_size  = dbChannelFieldSize(chan);
+        pLog->no_elements = no_elements;
+        dbArrayBufRefLog(pLog, pBuffer);
+    }
+    return pLog;
+}
 
-    LOCKEVQUE (ev_que);
+/*
+ *  QUEUE_EVENT_LOG_LOCKED()
+ *
+ *  event queue lock _must_ be applied
+ *  returns non-zero if the event task must be notified
+ */
+static int queue_event_log_locked (evSubscrip *pevent, db_field_log *pLog)
+{
+    struct event_que * const ev_que = pevent->ev_que;
+    int firstEventFlag;
+    unsigned rngSpace;
 
     /*
      * if we have an event on the queue and both the last
@@ -747,8 +882,23 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
         (*pevent->pLastLog)->type == dbfl_type_rec &&
         pLog->type == dbfl_type_rec) {
         db_delete_field_log(pLog);
-        UNLOCKEVQUE (ev_que);
-        return;
+        pevent->ncoalesce++;
+        return 0;
+    }
+
+    /*
+     * a shared array which hasn't been sent yet is replaced by the
+     * newer one, just as the record would have been read later on,
+     * unless the monitor's filters might want to see each update
+     */
+    if (pevent->npend > 0u &&
+        ellCount(&pevent->chan->pre_chain) == 0 &&
+        dbArrayBufFromLog(*pevent->pLastLog) &&
+        dbArrayBufFromLog(pLog)) {
+        db_delete_field_log(*pevent->pLastLog);
+        *pevent->pLastLog = pLog;
+        pevent->ncoalesce++;
+        return 0;
     }
 
     /*
@@ -762,7 +912,8 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
      */
     rngSpace = ringSpace ( ev_que );
     if ( pevent->npend>0u &&
-        (ev_que->evUser->flowCtrlMode || rngSpace<=EVENTSPERQUE) ) {
+        (ev_que->evUser->flowCtrlMode ||
+         rngSpace <= ev_que->quesize / EVENTENTRIES) ) {
         /*
          * replace last event if no space is left
          */
@@ -794,15 +945,33 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
          * if the ring buffer was empty before
          * adding this event
          */
-        if (rngSpace==EVENTQUESIZE) {
+        if (rngSpace==ev_que->quesize) {
             firstEventFlag = 1;
         }
         else {
             firstEventFlag = 0;
         }
-        ev_que->putix = RNGINC ( ev_que->putix );
+        ev_que->putix = RNGINC ( ev_que, ev_que->putix );
     }
 
+    return firstEventFlag;
+}
+
+/*
+ *  DB_QUEUE_EVENT_LOG()
+ *
+ */
+static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
+{
+    struct event_que * const ev_que = pevent->ev_que;
+    int firstEventFlag;
+
+    /*
+     * evUser ring buffer must be locked for the multiple
+     * threads writing/reading it
+     */
+    LOCKEVQUE (ev_que);
+    firstEventFlag = queue_event_log_locked (pevent, pLog);
     UNLOCKEVQUE (ev_que);
 
     /*
@@ -820,22 +989,83 @@ static void db_queue_event_log (evSubscrip *pevent, db_field_log *pLog)
 }
 
 /*
- *  DB_POST_EVENTS()
+ * Event logs for one db_post_events() call which are waiting
+ * to be queued, so that each event que is locked only once
+ * and each event task is notified only once per batch.
+ */
+#define POSTBATCHSIZE 64
+
+typedef struct postBatch {
+    unsigned            count;
+    struct evSubscrip   *pevent[POSTBATCHSIZE];
+    db_field_log        *pLog[POSTBATCHSIZE];
+} postBatch;
+
+/*
+ *  FLUSH_POST_BATCH()
+ *
+ */
+static void flush_post_batch (postBatch *pBatch)
+{
+    struct event_user *notify[POSTBATCHSIZE];
+    unsigned nNotify = 0u;
+    unsigned i, j;
+
+    for (i = 0u; i < pBatch->count; i++) {
+        struct event_que *ev_que;
+        int firstEventFlag = FALSE;
+
+        /* already queued along with an earlier entry */
+        if (!pBatch->pevent[i]) continue;
+
+        ev_que = pBatch->pevent[i]->ev_que;
+        LOCKEVQUE (ev_que);
+        for (j = i; j < pBatch->count; j++) {
+            if (pBatch->pevent[j] && pBatch->pevent[j]->ev_que == ev_que) {
+                firstEventFlag |= queue_event_log_locked (pBatch->pevent[j],
+                    pBatch->pLog[j]);
+                pBatch->pevent[j] = NULL;
+            }
+        }
+        UNLOCKEVQUE (ev_que);
+
+        if (firstEventFlag) {
+            for (j = 0u; j < nNotify; j++) {
+                if (notify[j] == ev_que->evUser) break;
+            }
+            if (j == nNotify) {
+                notify[nNotify++] = ev_que->evUser;
+            }
+        }
+    }
+
+    /*
+     * notify the event handlers after all of the
+     * event que locks have been released
+     */
+    for (i = 0u; i < nNotify; i++) {
+        epicsEventSignal(notify[i]->ppendsem);
+    }
+    pBatch->count = 0u;
+}
+
+/*
+ *  POST_EVENTS()
  *
  *  NOTE: This assumes that the db scan lock is already applied
  *
  */
-int db_post_events(
-void            *pRecord,
-void            *pField,
-unsigned int    caEventMask
-)
+static int post_events (void *pRecord, void *pField,
+    unsigned int caEventMask, void *pBuffer, long no_elements)
 {
     struct dbCommon   * const prec = (struct dbCommon *) pRecord;
     struct evSubscrip *pevent;
+    postBatch batch;
 
     if (prec->mlis.count == 0) return DB_EVENT_OK;       /* no monitors set */
 
+    batch.count = 0u;
+
     LOCKREC (prec);
 
     for (pevent = (struct evSubscrip *) prec->mlis.node.next;
@@ -847,17 +1077,60 @@ unsigned int    caEventMask
          */
         if ( (dbChannelField(pevent->chan) == (void *)pField || pField==NULL) &&
             (caEventMask & pevent->select)) {
-            db_field_log *pLog = db_create_event_log(pevent);
+            db_field_log *pLog = pBuffer && pField ?
+                create_ref_log(pevent, pBuffer, no_elements) :
+                db_create_event_log(pevent);
             pLog = dbChannelRunPreChain(pevent->chan, pLog);
-            if (pLog) db_queue_event_log(pevent, pLog);
+            if (pLog) {
+                batch.pevent[batch.count] = pevent;
+                batch.pLog[batch.count] = pLog;
+                if (++batch.count == POSTBATCHSIZE) {
+                    flush_post_batch(&batch);
+                }
+            }
         }
     }
 
+    if (batch.count) {
+        flush_post_batch(&batch);
+    }
+
     UNLOCKREC (prec);
     return DB_EVENT_OK;
 
 }
 
+/*
+ *  DB_POST_EVENTS()
+ *
+ *  NOTE: This assumes that the db scan lock is already applied
+ *
+ */
+int db_post_events(
+void            *pRecord,
+void            *pField,
+unsigned int    caEventMask
+)
+{
+    return post_events(pRecord, pField, caEventMask, NULL, 0);
+}
+
+/*
+ *  DB_POST_EVENTS_REF()
+ *
+ *  The monitors of pField are given a reference to the dbArrayBuf at
+ *  pBuffer holding no_elements, instead of reading the field when the
+ *  update is sent. With pBuffer NULL this is db_post_events().
+ *
+ *  NOTE: This assumes that the db scan lock is already applied
+ *
+ */
+int db_post_events_ref(void *pRecord, void *pField, unsigned caEventMask,
+    void *pBuffer, long no_elements)
+{
+    return post_events(pRecord, pField, caEventMask, pBuffer, no_elements);
+}
+
 /*
  *  DB_POST_SINGLE_EVENT()
  */
@@ -911,7 +1184,7 @@ static int event_read ( struct event_que *ev_que )
                 db_delete_field_log(ev_que->valque[ev_que->getix]);
                 ev_que->valque[ev_que->getix] = NULL;
             }
-            ev_que->getix = RNGINC ( ev_que->getix );
+            ev_que->getix = RNGINC ( ev_que, ev_que->getix );
             assert ( ev_que->nCanceled > 0 );
             ev_que->nCanceled--;
             continue;
@@ -924,7 +1197,7 @@ static int event_read ( struct event_que *ev_que )
          */
 
         event_remove ( ev_que, ev_que->getix, EVENTQEMPTY );
-        ev_que->getix = RNGINC ( ev_que->getix );
+        ev_que->getix = RNGINC ( ev_que, ev_que->getix );
 
         /*
          * create a local copy of the call back parameters while
@@ -1044,6 +1317,7 @@ static void event_task (void *pParm)
     } while( ! pendexit );
 
     epicsMutexDestroy(evUser->firstque.writelock);
+    free_que_entries(&evUser->firstque);
 
     {
         struct event_que    *nextque;
@@ -1052,6 +1326,7 @@ static void event_task (void *pParm)
         while (ev_que) {
             nextque = ev_que->nextque;
             epicsMutexDestroy(ev_que->writelock);
+            free_que_entries(ev_que);
             freeListFree(dbevEventQueueFreeList, ev_que);
             ev_que = nextque;
         }
@@ -47,11 +47,16 @@ epicsShareFunc int dbel (
     const char *name, unsigned level);
 epicsShareFunc int db_post_events (
     void *pRecord, void *pField, unsigned caEventMask );
+/* Monitors get a reference to the dbArrayBuf at pBuffer, if not NULL */
+epicsShareFunc int db_post_events_ref (
+    void *pRecord, void *pField, unsigned caEventMask,
+    void *pBuffer, long no_elements );
 
 typedef void * dbEventCtx;
 
 typedef void EXTRALABORFUNC (void *extralabor_arg);
 epicsShareFunc dbEventCtx db_init_events (void);
+epicsShareFunc int db_set_event_queue_size (dbEventCtx ctx, unsigned nEntries);
 epicsShareFunc int db_start_events (
     dbEventCtx ctx, const char *taskname, void (*init_func)(void *),
     void *init_func_arg, unsigned osiPriority );
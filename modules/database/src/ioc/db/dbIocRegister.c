@@ -345,6 +345,41 @@ static void scanOnceSetQueueSizeCallFunc(const iocshArgBuf *args)
     scanOnceSetQueueSize(args[0].ival);
 }
 
+/* scanPeriodicWheel */
+static const iocshArg scanPeriodicWheelArg0 = { "nthreads",iocshArgInt};
+static const iocshArg * const scanPeriodicWheelArgs[1] =
+    {&scanPeriodicWheelArg0};
+static const iocshFuncDef scanPeriodicWheelFuncDef =
+    {"scanPeriodicWheel",1,scanPeriodicWheelArgs,
+     "Scan all periodic lists from a timer wheel using nthreads workers\n"
+     "instead of one thread per scan period.\n"
+     "  nthreads>0: use that many worker threads\n"
+     "  nthreads<0: use #CPUs + nthreads workers (at least one)\n"
+     "  nthreads=0: use one thread per scan period (default)\n"
+     "Must be called before iocInit().\n"};
+static void scanPeriodicWheelCallFunc(const iocshArgBuf *args)
+{
+    scanPeriodicWheel(args[0].ival);
+}
+
+/* scanPeriodicParallel */
+static const iocshArg scanPeriodicParallelArg0 = { "nthreads",iocshArgInt};
+static const iocshArg * const scanPeriodicParallelArgs[1] =
+    {&scanPeriodicParallelArg0};
+static const iocshFuncDef scanPeriodicParallelFuncDef =
+    {"scanPeriodicParallel",1,scanPeriodicParallelArgs,
+     "Process each periodic scan list in parallel, split by lockset,\n"
+     "using a pool of nthreads workers as well as the scan thread.\n"
+     "Records in the same lockset are still processed in list order.\n"
+     "  nthreads>0: use that many worker threads\n"
+     "  nthreads<0: use #CPUs + nthreads workers\n"
+     "  nthreads=0: process lists serially (default)\n"
+     "Must be called before iocInit().\n"};
+static void scanPeriodicParallelCallFunc(const iocshArgBuf *args)
+{
+    scanPeriodicParallel(args[0].ival);
+}
+
 /* scanOnceQueueShow */
 static const iocshArg scanOnceQueueShowArg0 = { "reset",iocshArgInt};
 static const iocshArg * const scanOnceQueueShowArgs[1] =
@@ -402,6 +437,20 @@ static void callbackSetQueueSizeCallFunc(const iocshArgBuf *args)
     callbackSetQueueSize(args[0].ival);
 }
 
+/* callbackSetQueueMode */
+static const iocshArg callbackSetQueueModeArg0 = { "mode",iocshArgString};
+static const iocshArg * const callbackSetQueueModeArgs[1] =
+    {&callbackSetQueueModeArg0};
+static const iocshFuncDef callbackSetQueueModeFuncDef =
+    {"callbackSetQueueMode",1,callbackSetQueueModeArgs,
+     "Select the queue implementation for callback workers.\n"
+     "mode is \"locked\" (default) or \"lockfree\".\n"
+     "Must be called before iocInit().\n"};
+static void callbackSetQueueModeCallFunc(const iocshArgBuf *args)
+{
+    callbackSetQueueMode(args[0].sval);
+}
+
 /* callbackQueueShow */
 static const iocshArg callbackQueueShowArg0 = { "reset", iocshArgInt};
 static const iocshArg * const callbackQueueShowArgs[1] =
@@ -529,12 +578,15 @@ void dbIocRegister(void)
 
     iocshRegister(&scanOnceSetQueueSizeFuncDef,scanOnceSetQueueSizeCallFunc);
     iocshRegister(&scanOnceQueueShowFuncDef,scanOnceQueueShowCallFunc);
+    iocshRegister(&scanPeriodicWheelFuncDef,scanPeriodicWheelCallFunc);
+    iocshRegister(&scanPeriodicParallelFuncDef,scanPeriodicParallelCallFunc);
     iocshRegister(&scanpplFuncDef,scanpplCallFunc);
     iocshRegister(&scanpelFuncDef,scanpelCallFunc);
     iocshRegister(&postEventFuncDef,postEventCallFunc);
     iocshRegister(&scanpiolFuncDef,scanpiolCallFunc);
 
     iocshRegister(&callbackSetQueueSizeFuncDef,callbackSetQueueSizeCallFunc);
+    iocshRegister(&callbackSetQueueModeFuncDef,callbackSetQueueModeCallFunc);
     iocshRegister(&callbackQueueShowFuncDef,callbackQueueShowCallFunc);
     iocshRegister(&callbackParallelThreadsFuncDef,callbackParallelThreadsCallFunc);
 
@@ -34,7 +34,9 @@
 #include "epicsStdlib.h"
 #include "epicsString.h"
 #include "epicsThread.h"
+#include "epicsThreadPool.h"
 #include "epicsTime.h"
+#include "epicsTimer.h"
 #include "taskwd.h"
 
 #define epicsExportSharedSymbols
@@ -86,6 +88,17 @@ typedef struct scan_element{
 
 /* PERIODIC */
 
+struct periodic_scan_list;
+
+/* One lockset-disjoint part of a periodic list, see scanPeriodicParallel() */
+typedef struct scan_partition {
+    struct periodic_scan_list *ppsl;
+    epicsJob            *job;
+    size_t              first;      /* range in ppsl->precs */
+    size_t              count;
+    double              busy;       /* seconds spent processing */
+} scan_partition;
+
 #define OVERRUN_REPORT_DELAY 10.0   /* Time between initial reports */
 #define OVERRUN_REPORT_MAX 3600.0   /* Maximum time between reports */
 typedef struct periodic_scan_list {
@@ -95,12 +108,56 @@ typedef struct periodic_scan_list {
     unsigned long       overruns;
     volatile enum ctl   scanCtl;
     epicsEventId        loopEvent;
+    /* Statistics, times in seconds */
+    unsigned long       nscans;
+    double              latencySum; /* scan start after its due time */
+    double              latencyMax;
+    double              scanTimeMax;/* time taken by scanList() */
+    /* Timer wheel engine only */
+    epicsTimerId        timer;      /* expires when the next scan is due */
+    ELLNODE             workNode;   /* in the work queue */
+    unsigned int        priority;   /* of the thread for this rate */
+    epicsTimeStamp      due;        /* time the next scan is due */
+    epicsTimeStamp      dispatched; /* due time of the queued scan */
+    int                 busy;       /* queued or being scanned */
+    /* Parallel scanning only */
+    scan_partition      *parts;     /* array of nParts */
+    struct dbCommon     **precs;    /* snapshot, grouped by partition */
+    struct dbCommon     **psnap;    /* snapshot, in list order */
+    unsigned            *pidx;      /* partition of each psnap entry */
+    size_t              capacity;   /* of precs, psnap and pidx */
+    int                 pending;    /* partitions still being processed */
+    epicsEventId        doneEvent;
+    double              busySum;    /* partition processing time */
+    double              wallSum;    /* elapsed time of parallel scans */
 } periodic_scan_list;
 
 static int nPeriodic = 0;
 static periodic_scan_list **papPeriodic; /* pointer to array of pointers */
 static epicsThreadId *periodicTaskId;    /* array of thread ids */
 
+/* Timer wheel engine, see scanPeriodicWheel() */
+
+typedef struct scan_wheel {
+    epicsTimerQueueId   queue;      /* a timing wheel backed timer queue */
+    epicsMutexId        lock;       /* protects work and busy flags */
+    ELLLIST             work;       /* lists due, fastest rate first */
+    epicsEventId        workEvent;
+    epicsEventId        exitEvent;  /* signalled by each exiting thread */
+    volatile enum ctl   ctl;
+    int                 nworkers;
+    int                 nexited;    /* threads which have exited */
+} scan_wheel;
+
+static int wheelThreads;                /* 0: one thread per scan period */
+static scan_wheel *pwheel;
+
+/* Parallel processing of periodic lists, see scanPeriodicParallel() */
+
+static int parallelThreads;             /* 0: process lists serially */
+static unsigned nParts;                 /* partitions per list */
+static epicsThreadPool *scanPool;
+
 
 static char *priorityName[NUM_CALLBACK_PRIORITIES] = {
     "Low", "Medium", "High"
@@ -142,6 +199,11 @@ static void periodicTask(void *arg);
 static void initPeriodic(void);
 static void deletePeriodic(void);
 static void spawnPeriodic(int ind);
+static void spawnWheel(void);
+static void deleteWheel(void);
+static void initParallel(void);
+static void deleteParallel(void);
+static void scanPeriodicList(periodic_scan_list *ppsl);
 static void eventCallback(epicsCallback *pcallback);
 static void ioscanInit(void);
 static void ioscanCallback(epicsCallback *pcallback);
@@ -161,7 +223,23 @@ void scanStop(void)
 
     interruptAccept = FALSE;
 
-    for (i = 0; i < nPeriodic; i++) {
+    if (pwheel) {
+        for (i = 0; i < nPeriodic; i++) {
+            periodic_scan_list *ppsl = papPeriodic[i];
+
+            if (!ppsl) continue;
+            ppsl->scanCtl = ctlExit;
+            epicsTimerCancel(ppsl->timer);
+        }
+        pwheel->ctl = ctlExit;
+        /* Several threads can exit between our waits, and their signals
+         * merge, so count them instead */
+        while (epicsAtomicGetIntT(&pwheel->nexited) < pwheel->nworkers) {
+            epicsEventSignal(pwheel->workEvent);
+            epicsEventWait(pwheel->exitEvent);
+        }
+    }
+    else for (i = 0; i < nPeriodic; i++) {
         periodic_scan_list *ppsl = papPeriodic[i];
 
         if (!ppsl) continue;
@@ -177,6 +255,8 @@ void scanStop(void)
 void scanCleanup(void)
 {
 
+    deleteWheel();
+    deleteParallel();
     deletePeriodic();
     ioscanDestroy();
 
@@ -198,7 +278,10 @@ long scanInit(void)
     initPeriodic();
     initOnce();
     buildScanLists();
-    for (i = 0; i < nPeriodic; i++)
+    initParallel();
+    if (wheelThreads)
+        spawnWheel();
+    else for (i = 0; i < nPeriodic; i++)
         spawnPeriodic(i);
 
     return 0;
@@ -376,7 +459,7 @@ double scanPeriod(int scan) {
 int scanppl(double period)      /* print periodic scan list(s) */
 {
     dbMenu *pmenu = dbFindMenu(pdbbase, "menuScan");
-    char message[80];
+    char message[200];
     int i;
 
     if (!pmenu || !papPeriodic) {
@@ -398,8 +481,25 @@ int scanppl(double period)      /* print periodic scan list(s) */
             (fabs(period - ppsl->period) > 0.05))
             continue;
 
-        sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
-            ppsl->name, ppsl->overruns);
+        if (ppsl->nscans && ppsl->wallSum > 0.0)
+            epicsSnprintf(message, sizeof(message),
+                "Records with SCAN = '%s' (%lu over-runs, %lu scans,\n"
+                "  latency %.3f ms avg %.3f ms max, scan time %.3f ms max,\n"
+                "  parallel speedup %.2f):",
+                ppsl->name, ppsl->overruns, ppsl->nscans,
+                ppsl->latencySum / ppsl->nscans * 1e3,
+                ppsl->latencyMax * 1e3, ppsl->scanTimeMax * 1e3,
+                ppsl->busySum / ppsl->wallSum);
+        else if (ppsl->nscans)
+            epicsSnprintf(message, sizeof(message),
+                "Records with SCAN = '%s' (%lu over-runs, %lu scans,\n"
+                "  latency %.3f ms avg %.3f ms max, scan time %.3f ms max):",
+                ppsl->name, ppsl->overruns, ppsl->nscans,
+                ppsl->latencySum / ppsl->nscans * 1e3,
+                ppsl->latencyMax * 1e3, ppsl->scanTimeMax * 1e3);
+        else
+            sprintf(message, "Records with SCAN = '%s' (%lu over-runs):",
+                ppsl->name, ppsl->overruns);
         printList(&ppsl->scan_list, message);
     }
     return 0;
@@ -697,21 +797,28 @@ static void onceTask(void *arg)
 
         epicsEventMustWait(onceSem);
         while(1) {
-            onceEntry ent;
-            int bytes = epicsRingBytesGet(onceQ, (void*)&ent, sizeof(ent));
+            /* Entries are put whole, so several can be taken at once */
+            onceEntry ents[16];
+            int bytes = epicsRingBytesGet(onceQ, (void*)ents, sizeof(ents));
+            int i, n = bytes / sizeof(onceEntry);
             if(bytes==0)
                 break;
-            if(bytes!=sizeof(ent)) {
+            if(bytes % sizeof(onceEntry)) {
                 errlogPrintf("onceTask: received incomplete %d of %u\n",
-                             bytes, (unsigned)sizeof(ent));
+                             bytes, (unsigned)sizeof(onceEntry));
                 continue; /* what to do? */
-            } else if (ent.prec == (void*)&exitOnce) goto shutdown;
+            }
 
-            dbScanLock(ent.prec);
-            dbProcess(ent.prec);
-            dbScanUnlock(ent.prec);
-            if(ent.cb)
-                ent.cb(ent.usr, ent.prec);
+            for(i = 0; i < n; i++) {
+                onceEntry *pent = &ents[i];
+
+                if (pent->prec == (void*)&exitOnce) goto shutdown;
+                dbScanLock(pent->prec);
+                dbProcess(pent->prec);
+                dbScanUnlock(pent->prec);
+                if(pent->cb)
+                    pent->cb(pent->usr, pent->prec);
+            }
         }
     }
 
@@ -726,6 +833,27 @@ int scanOnceSetQueueSize(int size)
     return 0;
 }
 
+int scanPeriodicWheel(int nthreads)
+{
+    if (papPeriodic) {
+        errlogPrintf("scanPeriodicWheel: Scan engine can't be changed "
+            "after iocInit\n");
+        return -1;
+    }
+    wheelThreads = nthreads;
+    return 0;
+}
+
+int scanPeriodicParallel(int nthreads)
+{
+    if (papPeriodic) {
+        errlogPrintf("scanPeriodicParallel: Can't be changed after iocInit\n");
+        return -1;
+    }
+    parallelThreads = nthreads;
+    return 0;
+}
+
 int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result)
 {
     int ret;
@@ -774,6 +902,23 @@ static void initOnce(void)
     epicsEventWait(startStopEvent);
 }
 
+static void periodicStats(periodic_scan_list *ppsl,
+    const epicsTimeStamp *due, const epicsTimeStamp *start,
+    const epicsTimeStamp *end)
+{
+    double latency = epicsTimeDiffInSeconds(start, due);
+    double scanTime = epicsTimeDiffInSeconds(end, start);
+
+    if (latency < 0.0)
+        latency = 0.0;
+    ppsl->nscans++;
+    ppsl->latencySum += latency;
+    if (latency > ppsl->latencyMax)
+        ppsl->latencyMax = latency;
+    if (scanTime > ppsl->scanTimeMax)
+        ppsl->scanTimeMax = scanTime;
+}
+
 static void periodicTask(void *arg)
 {
     periodic_scan_list *ppsl = (periodic_scan_list *)arg;
@@ -793,13 +938,16 @@ static void periodicTask(void *arg)
 
     while (ppsl->scanCtl != ctlExit) {
         double delay;
-        epicsTimeStamp now;
+        epicsTimeStamp start, now;
 
+        epicsTimeGetMonotonic(&start);
         if (ppsl->scanCtl == ctlRun)
-            scanList(&ppsl->scan_list);
+            scanPeriodicList(ppsl);
+        epicsTimeGetMonotonic(&now);
+        if (ppsl->scanCtl == ctlRun)
+            periodicStats(ppsl, &next, &start, &now);
 
         epicsTimeAddSeconds(&next, ppsl->period);
-        epicsTimeGetMonotonic(&now);
         delay = epicsTimeDiffInSeconds(&next, &now);
         if (delay <= 0.0) {
             if (overtime == 0.0) {
@@ -945,6 +1093,379 @@ static void spawnPeriodic(int ind)
     epicsEventWait(startStopEvent);
 }
 
+/* A list is due: queue it for a worker, ahead of any slower lists, and
+ * restart its timer for the next scan. Runs in the timer queue thread.
+ */
+static void wheelExpire(void *arg)
+{
+    periodic_scan_list *ppsl = (periodic_scan_list *)arg;
+    scan_wheel *pw = pwheel;
+    const double penalty = (ppsl->period >= 2) ? 1 : (ppsl->period / 2);
+    epicsTimeStamp now;
+    int signal = FALSE;
+
+    if (ppsl->scanCtl == ctlExit)
+        return;
+
+    if (ppsl->scanCtl == ctlRun) {
+        epicsMutexMustLock(pw->lock);
+        if (ppsl->busy) {
+            ppsl->overruns++;
+        }
+        else {
+            ELLNODE *prev = NULL, *node;
+
+            for (node = ellFirst(&pw->work); node; node = ellNext(node)) {
+                if (CONTAINER(node, periodic_scan_list, workNode)->period >
+                    ppsl->period)
+                    break;
+                prev = node;
+            }
+            ppsl->busy = TRUE;
+            ppsl->dispatched = ppsl->due;
+            ellInsert(&pw->work, prev, &ppsl->workNode);
+            signal = TRUE;
+        }
+        epicsMutexUnlock(pw->lock);
+        if (signal)
+            epicsEventSignal(pw->workEvent);
+    }
+
+    /* Deadlines are absolute on the monotonic clock so the phase doesn't
+     * drift, unless the queue fell a whole period behind. */
+    epicsTimeGetMonotonic(&now);
+    epicsTimeAddSeconds(&ppsl->due, ppsl->period);
+    if (epicsTimeDiffInSeconds(&ppsl->due, &now) <= 0.0) {
+        ppsl->due = now;
+        epicsTimeAddSeconds(&ppsl->due, penalty);
+    }
+    epicsTimerStartDelay(ppsl->timer,
+        epicsTimeDiffInSeconds(&ppsl->due, &now));
+}
+
+static void wheelWorker(void *arg)
+{
+    scan_wheel *pw = (scan_wheel *)arg;
+    epicsThreadId self = epicsThreadGetIdSelf();
+    unsigned int idlePriority = epicsThreadGetPrioritySelf();
+
+    taskwdInsert(0, NULL, NULL);
+    epicsEventSignal(startStopEvent);
+
+    while (pw->ctl != ctlExit) {
+        periodic_scan_list *ppsl;
+        epicsTimeStamp start, end;
+        ELLNODE *node;
+        int more;
+
+        epicsMutexMustLock(pw->lock);
+        node = ellGet(&pw->work);
+        more = ellCount(&pw->work) > 0;
+        epicsMutexUnlock(pw->lock);
+
+        if (!node) {
+            epicsThreadSetPriority(self, idlePriority);
+            epicsEventMustWait(pw->workEvent);
+            continue;
+        }
+        if (more)
+            epicsEventSignal(pw->workEvent);
+
+        /* Scan at the priority the thread for this rate would have */
+        ppsl = CONTAINER(node, periodic_scan_list, workNode);
+        epicsThreadSetPriority(self, ppsl->priority);
+        epicsTimeGetMonotonic(&start);
+        if (ppsl->scanCtl == ctlRun) {
+            scanPeriodicList(ppsl);
+            epicsTimeGetMonotonic(&end);
+            periodicStats(ppsl, &ppsl->dispatched, &start, &end);
+        }
+
+        epicsMutexMustLock(pw->lock);
+        ppsl->busy = FALSE;
+        epicsMutexUnlock(pw->lock);
+    }
+
+    taskwdRemove(0);
+    epicsAtomicIncrIntT(&pw->nexited);
+    epicsEventSignal(pw->exitEvent);
+    /* Pass the wakeup on to any other worker still waiting */
+    epicsEventSignal(pw->workEvent);
+}
+
+static void spawnWheel(void)
+{
+    scan_wheel *pw = dbCalloc(1, sizeof(scan_wheel));
+    int nworkers = wheelThreads;
+    epicsTimeStamp start;
+    char taskName[32];
+    int i;
+
+    if (nworkers < 0)
+        nworkers += epicsThreadGetCPUs();
+    if (nworkers < 1)
+        nworkers = 1;
+
+    pw->queue = epicsTimerQueueAllocateBackend(0,
+        epicsThreadPriorityScanHigh, epicsTimerQueueTimingWheel);
+    if (!pw->queue)
+        cantProceed("spawnWheel: Can't create timer queue\n");
+    ellInit(&pw->work);
+    pw->workEvent = epicsEventMustCreate(epicsEventEmpty);
+    pw->exitEvent = epicsEventMustCreate(epicsEventEmpty);
+    pw->lock = epicsMutexMustCreate();
+    pw->ctl = ctlRun;
+    pwheel = pw;
+
+    /* Idle workers wait at the priority of the fastest rate */
+    for (i = 0; i < nworkers; i++) {
+        sprintf(taskName, "scanWheel-%d", i);
+        epicsThreadCreate(taskName, epicsThreadPriorityScanLow + nPeriodic - 1,
+            epicsThreadGetStackSize(epicsThreadStackBig), wheelWorker, pw);
+        epicsEventWait(startStopEvent);
+        pw->nworkers++;
+    }
+
+    /* Spread the first scans of each list over its period, so lists
+     * with a common multiple don't all become due at the same time. */
+    epicsTimeGetMonotonic(&start);
+    for (i = 0; i < nPeriodic; i++) {
+        periodic_scan_list *ppsl = papPeriodic[i];
+        double delay;
+
+        if (!ppsl) continue;
+        delay = ppsl->period * i / nPeriodic;
+        ppsl->priority = epicsThreadPriorityScanLow + i;
+        ppsl->timer = epicsTimerQueueCreateTimer(pw->queue, wheelExpire, ppsl);
+        ppsl->due = start;
+        epicsTimeAddSeconds(&ppsl->due, delay);
+        epicsTimerStartDelay(ppsl->timer, delay);
+    }
+}
+
+static void deleteWheel(void)
+{
+    scan_wheel *pw = pwheel;
+    int i;
+
+    if (!pw) return;
+    for (i = 0; i < nPeriodic; i++) {
+        periodic_scan_list *ppsl = papPeriodic[i];
+
+        if (!ppsl || !ppsl->timer) continue;
+        epicsTimerQueueDestroyTimer(pw->queue, ppsl->timer);
+        ppsl->timer = NULL;
+    }
+    epicsTimerQueueRelease(pw->queue);
+    epicsEventDestroy(pw->workEvent);
+    epicsEventDestroy(pw->exitEvent);
+    epicsMutexDestroy(pw->lock);
+    free(pw);
+    pwheel = NULL;
+}
+
+/* Process the records of one partition, in list order */
+static void scanPartition(scan_partition *ppart)
+{
+    periodic_scan_list *ppsl = ppart->ppsl;
+    struct dbCommon **precs = ppsl->precs + ppart->first;
+    epicsTimeStamp start, end;
+    size_t i;
+
+    epicsTimeGetMonotonic(&start);
+    for (i = 0; i < ppart->count; i++) {
+        struct dbCommon *precord = precs[i];
+        scan_element *pse;
+
+        dbScanLock(precord);
+        /* Skip records that left the list since the snapshot. Changing
+         * SCAN needs the record lock, so this test is stable here. */
+        pse = (scan_element *)precord->spvt;
+        if (pse && pse->pscan_list == &ppsl->scan_list)
+            dbProcess(precord);
+        dbScanUnlock(precord);
+    }
+    epicsTimeGetMonotonic(&end);
+    ppart->busy = epicsTimeDiffInSeconds(&end, &start);
+}
+
+static void scanPartitionJob(void *arg, epicsJobMode mode)
+{
+    scan_partition *ppart = (scan_partition *)arg;
+    periodic_scan_list *ppsl = ppart->ppsl;
+
+    if (mode == epicsJobModeCleanup)
+        return;
+
+    scanPartition(ppart);
+    if (epicsAtomicDecrIntT(&ppsl->pending) == 0)
+        epicsEventMustTrigger(ppsl->doneEvent);
+}
+
+/* Take a snapshot of the list, assigning each record to a partition by
+ * its lockset so records which share a lockset stay in list (and PHAS)
+ * order in one partition. Returns the number of partitions with work.
+ */
+static unsigned snapshotPartitions(periodic_scan_list *ppsl)
+{
+    scan_list *psl = &ppsl->scan_list;
+    scan_element *pse;
+    size_t n = 0, i;
+    unsigned p, used = 0;
+
+    epicsMutexMustLock(psl->lock);
+    if ((size_t)ellCount(&psl->list) > ppsl->capacity) {
+        size_t capacity = ellCount(&psl->list) * 2;
+
+        free(ppsl->precs);
+        free(ppsl->psnap);
+        free(ppsl->pidx);
+        ppsl->precs = dbCalloc(capacity, sizeof(struct dbCommon *));
+        ppsl->psnap = dbCalloc(capacity, sizeof(struct dbCommon *));
+        ppsl->pidx = dbCalloc(capacity, sizeof(unsigned));
+        ppsl->capacity = capacity;
+    }
+    for (pse = (scan_element *)ellFirst(&psl->list); pse;
+         pse = (scan_element *)ellNext(&pse->node))
+        ppsl->psnap[n++] = pse->precord;
+    epicsMutexUnlock(psl->lock);
+
+    for (p = 0; p < nParts; p++)
+        ppsl->parts[p].count = 0;
+    for (i = 0; i < n; i++) {
+        p = dbLockGetLockId(ppsl->psnap[i]) % nParts;
+        ppsl->pidx[i] = p;
+        if (ppsl->parts[p].count++ == 0)
+            used++;
+    }
+    for (p = 0, i = 0; p < nParts; p++) {
+        ppsl->parts[p].first = i;
+        i += ppsl->parts[p].count;
+        ppsl->parts[p].count = 0;
+    }
+    for (i = 0; i < n; i++) {
+        scan_partition *ppart = &ppsl->parts[ppsl->pidx[i]];
+
+        ppsl->precs[ppart->first + ppart->count++] = ppsl->psnap[i];
+    }
+    return used;
+}
+
+static void scanPeriodicList(periodic_scan_list *ppsl)
+{
+    epicsTimeStamp start, end;
+    double busy = 0.0;
+    unsigned p, first;
+
+    if (!scanPool || snapshotPartitions(ppsl) < 2) {
+        scanList(&ppsl->scan_list);
+        return;
+    }
+
+    epicsTimeGetMonotonic(&start);
+
+    /* This thread processes the first partition with work */
+    first = 0;
+    while (!ppsl->parts[first].count)
+        first++;
+    epicsAtomicSetIntT(&ppsl->pending, 1);
+    for (p = nParts - 1; p > first; p--) {
+        scan_partition *ppart = &ppsl->parts[p];
+
+        if (!ppart->count) continue;
+        epicsAtomicIncrIntT(&ppsl->pending);
+        if (epicsJobQueue(ppart->job)) {
+            epicsAtomicDecrIntT(&ppsl->pending);
+            scanPartition(ppart);
+        }
+    }
+    scanPartition(&ppsl->parts[first]);
+    if (epicsAtomicDecrIntT(&ppsl->pending) != 0)
+        epicsEventMustWait(ppsl->doneEvent);
+
+    epicsTimeGetMonotonic(&end);
+    for (p = 0; p < nParts; p++) {
+        if (ppsl->parts[p].count)
+            busy += ppsl->parts[p].busy;
+    }
+    ppsl->busySum += busy;
+    ppsl->wallSum += epicsTimeDiffInSeconds(&end, &start);
+}
+
+static void initParallel(void)
+{
+    epicsThreadPoolConfig conf;
+    int nthreads = parallelThreads;
+    int i;
+    unsigned p;
+
+    if (!nthreads)
+        return;
+    if (nthreads < 0)
+        nthreads += epicsThreadGetCPUs();
+    if (nthreads < 1)
+        return;
+
+    epicsThreadPoolConfigDefaults(&conf);
+    conf.initialThreads = conf.maxThreads = nthreads;
+    conf.workerPriority = epicsThreadPriorityScanLow + nPeriodic - 1;
+    conf.workerStack = epicsThreadGetStackSize(epicsThreadStackBig);
+    scanPool = epicsThreadPoolCreate(&conf);
+    if (!scanPool) {
+        errlogPrintf("scanPeriodicParallel: Can't create thread pool, "
+            "processing lists serially\n");
+        return;
+    }
+
+    /* The scan thread processes one partition itself */
+    nParts = nthreads + 1;
+
+    for (i = 0; i < nPeriodic; i++) {
+        periodic_scan_list *ppsl = papPeriodic[i];
+
+        if (!ppsl) continue;
+        ppsl->doneEvent = epicsEventMustCreate(epicsEventEmpty);
+        ppsl->parts = dbCalloc(nParts, sizeof(scan_partition));
+        for (p = 0; p < nParts; p++) {
+            scan_partition *ppart = &ppsl->parts[p];
+
+            ppart->ppsl = ppsl;
+            ppart->job = epicsJobCreate(scanPool, scanPartitionJob, ppart);
+            if (!ppart->job)
+                cantProceed("initParallel: epicsJobCreate failed\n");
+        }
+    }
+}
+
+static void deleteParallel(void)
+{
+    int i;
+    unsigned p;
+
+    if (!scanPool)
+        return;
+
+    for (i = 0; i < nPeriodic; i++) {
+        periodic_scan_list *ppsl = papPeriodic[i];
+
+        if (!ppsl) continue;
+        for (p = 0; p < nParts; p++)
+            epicsJobDestroy(ppsl->parts[p].job);
+        free(ppsl->parts);
+        free(ppsl->precs);
+        free(ppsl->psnap);
+        free(ppsl->pidx);
+        epicsEventDestroy(ppsl->doneEvent);
+        ppsl->parts = NULL;
+        ppsl->precs = ppsl->psnap = NULL;
+        ppsl->pidx = NULL;
+        ppsl->capacity = 0;
+    }
+    epicsThreadPoolDestroy(scanPool);
+    scanPool = NULL;
+    nParts = 0;
+}
+
 static void ioscanCallback(epicsCallback *pcallback)
 {
     ioscan_head *piosh;
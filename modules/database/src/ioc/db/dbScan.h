@@ -65,6 +65,8 @@ epicsShareFunc double scanPeriod(int scan);
 epicsShareFunc int scanOnce(struct dbCommon *);
 epicsShareFunc int scanOnceCallback(struct dbCommon *, once_complete cb, void *usr);
 epicsShareFunc int scanOnceSetQueueSize(int size);
+epicsShareFunc int scanPeriodicWheel(int nthreads);
+epicsShareFunc int scanPeriodicParallel(int nthreads);
 epicsShareFunc int scanOnceQueueStatus(const int reset, scanOnceQueueStats *result);
 epicsShareFunc void scanOnceQueueShow(const int reset);
 
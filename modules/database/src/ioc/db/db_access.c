@@ -805,6 +805,42 @@ int dbChannel_get_count(
     return 0;
 }
 
+/* Whether the array data of a field log can be sent to a buffer_type
+ * client directly, without going through dbChannel_get_count().  This
+ * needs a field log which owns a private copy of the data, or shares
+ * one with other monitors (see dbArrayBufFromLog()), stored with the
+ * value type of buffer_type. */
+int dbChannel_field_log_sendable(int buffer_type, void *pvfl)
+{
+    db_field_log *pfl = (db_field_log *) pvfl;
+    short field_type;
+
+    if (!pfl || pfl->type != dbfl_type_ref || !pfl->u.r.dtor ||
+        !pfl->u.r.field || pfl->no_elements < 1 ||
+        buffer_type < 0 || buffer_type > oldDBR_CTRL_DOUBLE)
+        return 0;
+
+    field_type = pfl->field_type;
+    switch (buffer_type % (oldDBR_DOUBLE + 1)) {
+    case oldDBR_STRING:
+        return field_type == DBF_STRING &&
+            pfl->field_size == MAX_STRING_SIZE;
+    case oldDBR_SHORT:
+        return field_type == DBF_SHORT;
+    case oldDBR_FLOAT:
+        return field_type == DBF_FLOAT;
+    case oldDBR_ENUM:
+        return field_type == DBF_ENUM;
+    case oldDBR_CHAR:
+        return field_type == DBF_CHAR || field_type == DBF_UCHAR;
+    case oldDBR_LONG:
+        return field_type == DBF_LONG;
+    case oldDBR_DOUBLE:
+        return field_type == DBF_DOUBLE;
+    }
+    return 0;
+}
+
 int dbChannel_put(struct dbChannel *chan, int src_type,
     const void *psrc, long no_elements)
 {
@@ -36,6 +36,7 @@ epicsShareFunc int dbChannel_put(struct dbChannel *chan, int src_type,
     const void *psrc, long no_elements);
 epicsShareFunc int dbChannel_get_count(struct dbChannel *chan,
     int buffer_type, void *pbuffer, long *nRequest, void *pfl);
+epicsShareFunc int dbChannel_field_log_sendable(int buffer_type, void *pfl);
 
 
 #ifdef __cplusplus
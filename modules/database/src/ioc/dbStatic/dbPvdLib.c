@@ -16,7 +16,7 @@
 #include <string.h>
 
 #include "dbDefs.h"
-#include "ellLib.h"
+#include "epicsAtomic.h"
 #include "epicsMutex.h"
 #include "epicsStdio.h"
 #include "epicsString.h"
@@ -26,15 +26,25 @@
 #include "dbStaticLib.h"
 #include "dbStaticPvt.h"
 
+/* The directory is an open addressing hash table using linear probing.
+ * Each slot keeps the hash, length and name of its record next to the
+ * entry, so a probe sequence only touches the table until a likely match
+ * is found and comparing that match needs no further pointer chasing.
+ */
 typedef struct {
-    ELLLIST      list;
-    epicsMutexId lock;
-} dbPvdBucket;
+    unsigned int hash;
+    unsigned int len;
+    const char   *name;
+    PVDENTRY     *ppvdNode;     /* NULL if the slot is empty */
+} dbPvdSlot;
 
 typedef struct dbPvd {
-    unsigned int size;
+    unsigned int size;          /* number of slots, a power of 2 */
     unsigned int mask;
-    dbPvdBucket **buckets;
+    unsigned int count;         /* number of entries */
+    int          generation;    /* changed by each add and delete */
+    dbPvdSlot    *slots;
+    epicsMutexId lock;
 } dbPvd;
 
 unsigned int dbPvdHashTableSize = 0;
@@ -43,6 +53,9 @@ unsigned int dbPvdHashTableSize = 0;
 #define DEFAULT_SIZE 512
 #define MAX_SIZE 65536
 
+/* Grow when more than this fraction of the slots are in use */
+#define MAX_LOAD(size) ((size) / 2)
+
 
 int dbPvdTableSize(int size)
 {
@@ -72,95 +85,150 @@ void dbPvdInitPvt(dbBase *pdbbase)
     }
 
     ppvd = (dbPvd *)dbMalloc(sizeof(dbPvd));
-    ppvd->size    = dbPvdHashTableSize;
-    ppvd->mask    = dbPvdHashTableSize - 1;
-    ppvd->buckets = dbCalloc(ppvd->size, sizeof(dbPvdBucket *));
+    ppvd->size  = dbPvdHashTableSize;
+    ppvd->mask  = dbPvdHashTableSize - 1;
+    ppvd->count = 0;
+    ppvd->generation = 0;
+    ppvd->slots = dbCalloc(ppvd->size, sizeof(dbPvdSlot));
+    ppvd->lock  = epicsMutexMustCreate();
 
     pdbbase->ppvd = ppvd;
     return;
 }
 
-PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
+/* Returns the slot holding name, or the empty slot ending its probe */
+static dbPvdSlot *dbPvdProbe(dbPvd *ppvd, const char *name,
+    unsigned int len, unsigned int hash)
 {
-    dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
-    PVDENTRY *ppvdNode;
+    unsigned int h = hash & ppvd->mask;
 
-    pbucket = ppvd->buckets[epicsMemHash(name, lenName, 0) & ppvd->mask];
-    if (pbucket == NULL) return NULL;
+    for (;; h = (h + 1) & ppvd->mask) {
+        dbPvdSlot *pslot = &ppvd->slots[h];
 
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        const char *recordname = ppvdNode->precnode->recordname;
+        if (!pslot->ppvdNode)
+            return pslot;
+        if (pslot->hash == hash && pslot->len == len &&
+            memcmp(name, pslot->name, len) == 0)
+            return pslot;
+    }
+}
 
-        if (strncmp(name, recordname, lenName) == 0 &&
-            strlen(recordname) == lenName)
-            break;
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
+static void dbPvdGrow(dbPvd *ppvd)
+{
+    dbPvdSlot *old = ppvd->slots;
+    unsigned int oldSize = ppvd->size;
+    unsigned int i;
+
+    ppvd->size *= 2;
+    ppvd->mask = ppvd->size - 1;
+    ppvd->slots = dbCalloc(ppvd->size, sizeof(dbPvdSlot));
+
+    for (i = 0; i < oldSize; i++) {
+        unsigned int h;
+
+        if (!old[i].ppvdNode) continue;
+        h = old[i].hash & ppvd->mask;
+        while (ppvd->slots[h].ppvdNode)
+            h = (h + 1) & ppvd->mask;
+        ppvd->slots[h] = old[i];
     }
-    epicsMutexUnlock(pbucket->lock);
+    free(old);
+}
+
+PVDENTRY *dbPvdFind(dbBase *pdbbase, const char *name, size_t lenName)
+{
+    dbPvd *ppvd = pdbbase->ppvd;
+    unsigned int hash = epicsMemHash(name, lenName, 0);
+    PVDENTRY *ppvdNode;
+
+    epicsMutexMustLock(ppvd->lock);
+    ppvdNode = dbPvdProbe(ppvd, name, (unsigned int) lenName, hash)->ppvdNode;
+    epicsMutexUnlock(ppvd->lock);
     return ppvdNode;
 }
-
+
 PVDENTRY *dbPvdAdd(dbBase *pdbbase, dbRecordType *precordType,
     dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
+    dbPvdSlot *pslot;
     PVDENTRY *ppvdNode;
     char *name = precnode->recordname;
-    unsigned int h;
-
-    h = epicsStrHash(name, 0) & ppvd->mask;
-    pbucket = ppvd->buckets[h];
-    if (pbucket == NULL) {
-        pbucket = dbCalloc(1, sizeof(dbPvdBucket));
-        ellInit(&pbucket->list);
-        pbucket->lock = epicsMutexCreate();
-        ppvd->buckets[h] = pbucket;
+    unsigned int len = (unsigned int) strlen(name);
+    unsigned int hash = epicsMemHash(name, len, 0);
+
+    epicsMutexMustLock(ppvd->lock);
+    pslot = dbPvdProbe(ppvd, name, len, hash);
+    if (pslot->ppvdNode) {
+        epicsMutexUnlock(ppvd->lock);
+        return NULL;
     }
-
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        if (strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            epicsMutexUnlock(pbucket->lock);
-            return NULL;
-        }
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
+    if (ppvd->count + 1 > MAX_LOAD(ppvd->size)) {
+        dbPvdGrow(ppvd);
+        pslot = dbPvdProbe(ppvd, name, len, hash);
     }
     ppvdNode = dbCalloc(1, sizeof(PVDENTRY));
     ppvdNode->precordType = precordType;
     ppvdNode->precnode = precnode;
-    ellAdd(&pbucket->list, (ELLNODE *)ppvdNode);
-    epicsMutexUnlock(pbucket->lock);
+    pslot->hash = hash;
+    pslot->len = len;
+    pslot->name = name;
+    pslot->ppvdNode = ppvdNode;
+    ppvd->count++;
+    epicsAtomicIncrIntT(&ppvd->generation);
+    epicsMutexUnlock(ppvd->lock);
     return ppvdNode;
 }
 
+/* Lets callers cache names which weren't found until a record is added.
+ * Read without the lock, so checking a cached name never contends with
+ * lookups.
+ */
+unsigned int dbPvdGeneration(dbBase *pdbbase)
+{
+    dbPvd *ppvd = pdbbase->ppvd;
+
+    if (!ppvd) return 0;
+    return (unsigned int) epicsAtomicGetIntT(&ppvd->generation);
+}
+
 void dbPvdDelete(dbBase *pdbbase, dbRecordNode *precnode)
 {
     dbPvd *ppvd = pdbbase->ppvd;
-    dbPvdBucket *pbucket;
-    PVDENTRY *ppvdNode;
+    dbPvdSlot *pslot;
     char *name = precnode->recordname;
+    unsigned int len, hash, i, j;
+
+    if (!name) return;
+    len = (unsigned int) strlen(name);
+    hash = epicsMemHash(name, len, 0);
 
-    pbucket = ppvd->buckets[epicsStrHash(name, 0) & ppvd->mask];
-    if (pbucket == NULL) return;
-
-    epicsMutexMustLock(pbucket->lock);
-    ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-    while (ppvdNode) {
-        if (ppvdNode->precnode &&
-            ppvdNode->precnode->recordname &&
-            strcmp(name, ppvdNode->precnode->recordname) == 0) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
-            free(ppvdNode);
-            break;
+    epicsMutexMustLock(ppvd->lock);
+    pslot = dbPvdProbe(ppvd, name, len, hash);
+    if (!pslot->ppvdNode) {
+        epicsMutexUnlock(ppvd->lock);
+        return;
+    }
+    free(pslot->ppvdNode);
+    pslot->ppvdNode = NULL;
+    ppvd->count--;
+    epicsAtomicIncrIntT(&ppvd->generation);
+
+    /* Shift later members of the probe sequence back over the hole, so
+     * lookups never need to step past deleted entries. */
+    i = (unsigned int) (pslot - ppvd->slots);
+    for (j = (i + 1) & ppvd->mask; ppvd->slots[j].ppvdNode;
+         j = (j + 1) & ppvd->mask) {
+        unsigned int home = ppvd->slots[j].hash & ppvd->mask;
+
+        /* Entry at j can move to i only if its home isn't in (i, j] */
+        if (((j - home) & ppvd->mask) >= ((j - i) & ppvd->mask)) {
+            ppvd->slots[i] = ppvd->slots[j];
+            ppvd->slots[j].ppvdNode = NULL;
+            i = j;
         }
-        ppvdNode = (PVDENTRY *) ellNext((ELLNODE *)ppvdNode);
     }
-    epicsMutexUnlock(pbucket->lock);
+    epicsMutexUnlock(ppvd->lock);
     return;
 }
 
@@ -173,27 +241,17 @@ void dbPvdFreeMem(dbBase *pdbbase)
     pdbbase->ppvd = NULL;
 
     for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
-        PVDENTRY *ppvdNode;
-
-        if (pbucket == NULL) continue;
-        epicsMutexMustLock(pbucket->lock);
-        ppvd->buckets[h] = NULL;
-        while ((ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list))) {
-            ellDelete(&pbucket->list, (ELLNODE *)ppvdNode);
-            free(ppvdNode);
-        }
-        epicsMutexUnlock(pbucket->lock);
-        epicsMutexDestroy(pbucket->lock);
-        free(pbucket);
+        free(ppvd->slots[h].ppvdNode);
     }
-    free(ppvd->buckets);
+    epicsMutexDestroy(ppvd->lock);
+    free(ppvd->slots);
     free(ppvd);
 }
 
 void dbPvdDump(dbBase *pdbbase, int verbose)
 {
-    unsigned int empty = 0;
+    unsigned long probes = 0;
+    unsigned int maxProbe = 0;
     dbPvd *ppvd;
     unsigned int h;
 
@@ -204,27 +262,26 @@ void dbPvdDump(dbBase *pdbbase, int verbose)
     ppvd = pdbbase->ppvd;
     if (ppvd == NULL) return;
 
-    printf("Process Variable Directory has %u buckets", ppvd->size);
+    epicsMutexMustLock(ppvd->lock);
+    printf("Process Variable Directory has %u entries in %u slots",
+        ppvd->count, ppvd->size);
 
     for (h = 0; h < ppvd->size; h++) {
-        dbPvdBucket *pbucket = ppvd->buckets[h];
-        PVDENTRY *ppvdNode;
-        int i = 1;
-
-        if (pbucket == NULL) {
-            empty++;
-            continue;
-        }
-        epicsMutexMustLock(pbucket->lock);
-        ppvdNode = (PVDENTRY *) ellFirst(&pbucket->list);
-        printf("\n [%4u] %4d  ", h, ellCount(&pbucket->list));
-        while (ppvdNode && verbose) {
-            if (!(++i % 4))
-                printf("\n         ");
-            printf("  %s", ppvdNode->precnode->recordname);
-            ppvdNode = (PVDENTRY *) ellNext((ELLNODE*)ppvdNode);
-        }
-        epicsMutexUnlock(pbucket->lock);
+        dbPvdSlot *pslot = &ppvd->slots[h];
+        unsigned int dist;
+
+        if (!pslot->ppvdNode) continue;
+        dist = (h - pslot->hash) & ppvd->mask;
+        probes += dist + 1;
+        if (dist + 1 > maxProbe)
+            maxProbe = dist + 1;
+        if (verbose)
+            printf("\n [%6u] %4u  %s", h, dist, pslot->name);
     }
-    printf("\n%u buckets empty.\n", empty);
+    if (ppvd->count)
+        printf("\nAverage lookup probes %.2f, maximum %u.\n",
+            (double) probes / ppvd->count, maxProbe);
+    else
+        printf("\n");
+    epicsMutexUnlock(ppvd->lock);
 }
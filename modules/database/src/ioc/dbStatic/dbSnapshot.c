@@ -0,0 +1,711 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS Base is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Binary snapshots of the record instances in a dbBase.
+ *
+ * A snapshot holds what the .db files added to the database: records,
+ * their field values, info items, aliases and visibility. Record types,
+ * menus and device support are not saved, the same DBD must be loaded
+ * and registered before dbLoadSnapshot() is called. Each record type's
+ * layout is hashed so that a snapshot made against a different DBD or a
+ * different build is refused rather than misread.
+ *
+ * The file is a sequence of 32-bit words in host byte order. Strings and
+ * field values are stored as a length word followed by the bytes, padded
+ * to a multiple of 4. Only fields which differ from their initial value
+ * are stored.
+ *
+ *  header:  "EPICSDBS" version byteOrder nTypes
+ *  type:    name layoutHash nRecords nAliases
+ *  record:  name flags nFields nInfo {index value}... {name string}...
+ *  alias:   alias recordName
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "ellLib.h"
+#include "epicsPrint.h"
+#include "epicsString.h"
+#include "epicsTypes.h"
+#include "errlog.h"
+#include "gpHash.h"
+
+#define epicsExportSharedSymbols
+#include "dbBase.h"
+#include "dbCommonPvt.h"
+#include "dbStaticLib.h"
+#include "dbStaticPvt.h"
+#include "link.h"
+#include "iocInit.h"
+
+#define SNAP_MAGIC "EPICSDBS"
+#define SNAP_VERSION 1
+#define SNAP_BYTE_ORDER 0x01020304u
+
+#define SNAP_PAD(n) (((n) + 3u) & ~(size_t)3u)
+
+
+/* Output buffer, written to the file in one go */
+
+typedef struct snapBuf {
+    char *base;
+    size_t len;
+    size_t size;
+    int nomem;
+} snapBuf;
+
+static char * snapReserve(snapBuf *pbuf, size_t n)
+{
+    size_t padded = SNAP_PAD(n);
+    char *p;
+
+    if (pbuf->nomem)
+        return NULL;
+    if (pbuf->len + padded > pbuf->size) {
+        size_t size = pbuf->size ? 2 * pbuf->size : 65536;
+        char *base;
+
+        while (size < pbuf->len + padded)
+            size *= 2;
+        base = realloc(pbuf->base, size);
+        if (!base) {
+            pbuf->nomem = 1;
+            return NULL;
+        }
+        pbuf->base = base;
+        pbuf->size = size;
+    }
+    p = pbuf->base + pbuf->len;
+    memset(p + n, 0, padded - n);
+    pbuf->len += padded;
+    return p;
+}
+
+static void snapPutU32(snapBuf *pbuf, epicsUInt32 value)
+{
+    char *p = snapReserve(pbuf, sizeof(value));
+
+    if (p)
+        memcpy(p, &value, sizeof(value));
+}
+
+static void snapPutBlob(snapBuf *pbuf, const void *data, size_t len)
+{
+    char *p;
+
+    snapPutU32(pbuf, (epicsUInt32) len);
+    p = snapReserve(pbuf, len);
+    if (p && len)
+        memcpy(p, data, len);
+}
+
+/* NULL is stored with length 0, so it can be told apart from "" */
+static void snapPutString(snapBuf *pbuf, const char *str)
+{
+    snapPutBlob(pbuf, str, str ? strlen(str) + 1 : 0);
+}
+
+
+/* Input cursor, every read is bounds checked */
+
+typedef struct snapCursor {
+    const char *pos;
+    const char *end;
+    int bad;
+} snapCursor;
+
+static const char * snapGetBytes(snapCursor *pcur, size_t n)
+{
+    const char *p = pcur->pos;
+
+    if (pcur->bad || (size_t)(pcur->end - p) < SNAP_PAD(n)) {
+        pcur->bad = 1;
+        return NULL;
+    }
+    pcur->pos += SNAP_PAD(n);
+    return p;
+}
+
+static epicsUInt32 snapGetU32(snapCursor *pcur)
+{
+    const char *p = snapGetBytes(pcur, sizeof(epicsUInt32));
+    epicsUInt32 value = 0;
+
+    if (p)
+        memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static const char * snapGetBlob(snapCursor *pcur, epicsUInt32 *plen)
+{
+    *plen = snapGetU32(pcur);
+    return snapGetBytes(pcur, *plen);
+}
+
+/* Returns NULL for a stored NULL, sets bad if not terminated */
+static const char * snapGetString(snapCursor *pcur)
+{
+    epicsUInt32 len;
+    const char *str = snapGetBlob(pcur, &len);
+
+    if (!str || !len)
+        return NULL;
+    if (str[len - 1] != '\0') {
+        pcur->bad = 1;
+        return NULL;
+    }
+    return str;
+}
+
+
+/* Anything which changes how field values are stored changes the hash */
+static epicsUInt32 snapLayoutHash(dbRecordType *pdbRecordType)
+{
+    unsigned int hash = epicsStrHash(pdbRecordType->name, 0);
+    devSup *pdevSup;
+    int i;
+
+    hash = epicsMemHash((const char *) &pdbRecordType->rec_size,
+        sizeof(pdbRecordType->rec_size), hash);
+    hash = epicsMemHash((const char *) &pdbRecordType->no_fields,
+        sizeof(pdbRecordType->no_fields), hash);
+    for (i = 0; i < pdbRecordType->no_fields; i++) {
+        dbFldDes *pflddes = pdbRecordType->papFldDes[i];
+        int field_type = pflddes->field_type;
+
+        hash = epicsStrHash(pflddes->name, hash);
+        hash = epicsMemHash((const char *) &field_type, sizeof(field_type), hash);
+        hash = epicsMemHash((const char *) &pflddes->size,
+            sizeof(pflddes->size), hash);
+        hash = epicsMemHash((const char *) &pflddes->offset,
+            sizeof(pflddes->offset), hash);
+        if (pflddes->field_type == DBF_MENU && pflddes->ftPvt) {
+            dbMenu *pdbMenu = pflddes->ftPvt;
+            int j;
+
+            for (j = 0; j < pdbMenu->nChoice; j++)
+                hash = epicsStrHash(pdbMenu->papChoiceValue[j], hash);
+        }
+    }
+    for (pdevSup = (devSup *) ellFirst(&pdbRecordType->devList); pdevSup;
+         pdevSup = (devSup *) ellNext(&pdevSup->node)) {
+        hash = epicsStrHash(pdevSup->choice, hash);
+    }
+    return hash;
+}
+
+/* A record of this type holding only initial values */
+static dbCommon * snapDefaultRecord(DBBASE *pdbbase,
+    dbRecordType *pdbRecordType, dbRecordNode *pnode)
+{
+    DBENTRY dbentry;
+    long status;
+
+    memset(pnode, 0, sizeof(*pnode));
+    dbInitEntry(pdbbase, &dbentry);
+    dbentry.precordType = pdbRecordType;
+    dbentry.precnode = pnode;
+    status = dbAllocRecord(&dbentry, "");
+    dbFinishEntry(&dbentry);
+    if (status) {
+        if (pnode->precord)
+            free(dbRec2Pvt(pnode->precord));
+        return NULL;
+    }
+    return pnode->precord;
+}
+
+static void snapFreeDefault(dbRecordType *pdbRecordType, dbCommon *precord)
+{
+    int i;
+
+    if (!precord)
+        return;
+    for (i = 0; i < pdbRecordType->no_links; i++) {
+        dbFldDes *pflddes = pdbRecordType->papFldDes[pdbRecordType->link_ind[i]];
+        DBLINK *plink = (DBLINK *)((char *) precord + pflddes->offset);
+
+        free(plink->text);
+    }
+    free(dbRec2Pvt(precord));
+}
+
+static int snapFieldDiffers(const dbFldDes *pflddes, const char *pfield,
+    const char *pdefault)
+{
+    switch (pflddes->field_type) {
+    case DBF_STRING:
+        return strcmp(pfield, pdefault) != 0;
+
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK: {
+            const char *text = ((const DBLINK *) pfield)->text;
+            const char *deftext = ((const DBLINK *) pdefault)->text;
+
+            if (!text || !deftext)
+                return text != deftext;
+            return strcmp(text, deftext) != 0;
+        }
+
+    default:
+        return memcmp(pfield, pdefault, pflddes->size) != 0;
+    }
+}
+
+static void snapPutField(snapBuf *pbuf, const dbFldDes *pflddes,
+    const char *pfield)
+{
+    switch (pflddes->field_type) {
+    case DBF_STRING:
+        snapPutString(pbuf, pfield);
+        break;
+
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK:
+        snapPutString(pbuf, ((const DBLINK *) pfield)->text);
+        break;
+
+    default:
+        snapPutBlob(pbuf, pfield, pflddes->size);
+    }
+}
+
+static int snapSkipField(const dbFldDes *pflddes)
+{
+    return pflddes->field_type == DBF_NOACCESS;
+}
+
+static void snapPutRecordType(snapBuf *pbuf, dbRecordType *pdbRecordType,
+    const dbCommon *pdefault)
+{
+    int nAliases = pdbRecordType->no_aliases;
+    int nRecords = ellCount(&pdbRecordType->recList) - nAliases;
+    dbRecordNode *precnode;
+
+    snapPutString(pbuf, pdbRecordType->name);
+    snapPutU32(pbuf, snapLayoutHash(pdbRecordType));
+    snapPutU32(pbuf, nRecords);
+    snapPutU32(pbuf, nAliases);
+
+    for (precnode = (dbRecordNode *) ellFirst(&pdbRecordType->recList);
+         precnode; precnode = (dbRecordNode *) ellNext(&precnode->node)) {
+        const char *precord = precnode->precord;
+        size_t countAt;
+        epicsUInt32 nFields = 0;
+        dbInfoNode *pinfo;
+        int i;
+
+        if (precnode->flags & DBRN_FLAGS_ISALIAS)
+            continue;
+
+        snapPutString(pbuf, precnode->recordname);
+        snapPutU32(pbuf, precnode->flags & DBRN_FLAGS_VISIBLE);
+        countAt = pbuf->len;
+        snapPutU32(pbuf, 0);
+        snapPutU32(pbuf, ellCount(&precnode->infoList));
+
+        /* Field 0 is the NAME */
+        for (i = 1; i < pdbRecordType->no_fields; i++) {
+            dbFldDes *pflddes = pdbRecordType->papFldDes[i];
+
+            if (snapSkipField(pflddes) ||
+                !snapFieldDiffers(pflddes, precord + pflddes->offset,
+                    (const char *) pdefault + pflddes->offset))
+                continue;
+            snapPutU32(pbuf, i);
+            snapPutField(pbuf, pflddes, precord + pflddes->offset);
+            nFields++;
+        }
+        if (!pbuf->nomem)
+            memcpy(pbuf->base + countAt, &nFields, sizeof(nFields));
+
+        for (pinfo = (dbInfoNode *) ellFirst(&precnode->infoList); pinfo;
+             pinfo = (dbInfoNode *) ellNext(&pinfo->node)) {
+            snapPutString(pbuf, pinfo->name);
+            snapPutString(pbuf, pinfo->string);
+        }
+    }
+
+    for (precnode = (dbRecordNode *) ellFirst(&pdbRecordType->recList);
+         precnode; precnode = (dbRecordNode *) ellNext(&precnode->node)) {
+        if (!(precnode->flags & DBRN_FLAGS_ISALIAS))
+            continue;
+        snapPutString(pbuf, precnode->recordname);
+        snapPutString(pbuf, precnode->aliasedRecnode->recordname);
+    }
+}
+
+long dbSaveSnapshot(DBBASE *pdbbase, const char *filename)
+{
+    snapBuf buf = {NULL, 0, 0, 0};
+    dbRecordType *pdbRecordType;
+    epicsUInt32 nTypes = 0;
+    size_t countAt;
+    long status = 0;
+    FILE *fp;
+
+    if (!pdbbase) {
+        errlogPrintf("dbSaveSnapshot: No database definition loaded\n");
+        return S_dbLib_recNotFound;
+    }
+    if (getIocState() != iocVoid) {
+        errlogPrintf("dbSaveSnapshot: Links are only text before iocInit\n");
+        return S_dbLib_badSnapshot;
+    }
+
+    snapReserve(&buf, 8);
+    if (buf.nomem)
+        return S_dbLib_outMem;
+    memcpy(buf.base, SNAP_MAGIC, 8);
+    snapPutU32(&buf, SNAP_VERSION);
+    snapPutU32(&buf, SNAP_BYTE_ORDER);
+    countAt = buf.len;
+    snapPutU32(&buf, 0);
+
+    for (pdbRecordType = (dbRecordType *) ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *) ellNext(&pdbRecordType->node)) {
+        dbRecordNode node;
+        dbCommon *pdefault;
+
+        if (!ellCount(&pdbRecordType->recList))
+            continue;
+        pdefault = snapDefaultRecord(pdbbase, pdbRecordType, &node);
+        if (!pdefault) {
+            status = S_dbLib_noRecSup;
+            break;
+        }
+        snapPutRecordType(&buf, pdbRecordType, pdefault);
+        snapFreeDefault(pdbRecordType, pdefault);
+        nTypes++;
+    }
+    if (!status && buf.nomem)
+        status = S_dbLib_outMem;
+    if (status) {
+        errlogPrintf("dbSaveSnapshot: Can't build snapshot for '%s'\n",
+            filename);
+        free(buf.base);
+        return status;
+    }
+    memcpy(buf.base + countAt, &nTypes, sizeof(nTypes));
+
+    fp = fopen(filename, "wb");
+    if (!fp) {
+        errlogPrintf("dbSaveSnapshot: Can't open '%s'\n", filename);
+        free(buf.base);
+        return S_dbLib_badSnapshot;
+    }
+    if (fwrite(buf.base, 1, buf.len, fp) != buf.len)
+        status = S_dbLib_badSnapshot;
+    if (fclose(fp))
+        status = S_dbLib_badSnapshot;
+    if (status)
+        errlogPrintf("dbSaveSnapshot: Error writing '%s'\n", filename);
+    free(buf.base);
+    return status;
+}
+
+
+static int snapValueOk(const dbFldDes *pflddes, const char *value,
+    epicsUInt32 len)
+{
+    switch (pflddes->field_type) {
+    case DBF_STRING:
+        return len > 0 && len <= (epicsUInt32) pflddes->size &&
+            value[len - 1] == '\0';
+
+    case DBF_INLINK:
+    case DBF_OUTLINK:
+    case DBF_FWDLINK:
+        return len == 0 || value[len - 1] == '\0';
+
+    default:
+        return len == (epicsUInt32) pflddes->size;
+    }
+}
+
+/* A record or alias name must be new, and not repeated in the file */
+static long snapCheckName(DBBASE *pdbbase, struct gphPvt *pnames,
+    const char *name)
+{
+    if (dbPvdFind(pdbbase, name, strlen(name)) ||
+        gphFind(pnames, name, NULL)) {
+        errlogPrintf("dbLoadSnapshot: Record '%s' already exists\n", name);
+        return S_dbLib_recExists;
+    }
+    return gphAdd(pnames, name, NULL) ? 0 : S_dbLib_outMem;
+}
+
+/* Check a record type section, leaving the cursor after it */
+static long snapCheckRecordType(DBBASE *pdbbase, snapCursor *pcur,
+    struct gphPvt *pnames, dbRecordType **ppdbRecordType)
+{
+    const char *name = snapGetString(pcur);
+    epicsUInt32 hash = snapGetU32(pcur);
+    epicsUInt32 nRecords = snapGetU32(pcur);
+    epicsUInt32 nAliases = snapGetU32(pcur);
+    dbRecordType *pdbRecordType;
+    DBENTRY dbentry;
+    long status;
+
+    if (pcur->bad || !name)
+        return S_dbLib_badSnapshot;
+
+    dbInitEntry(pdbbase, &dbentry);
+    status = dbFindRecordType(&dbentry, name);
+    pdbRecordType = dbentry.precordType;
+    dbFinishEntry(&dbentry);
+    if (status) {
+        errlogPrintf("dbLoadSnapshot: Record type '%s' not loaded\n", name);
+        return status;
+    }
+    if (pdbRecordType->rec_size == 0) {
+        errlogPrintf("dbLoadSnapshot: Record type '%s' not registered\n",
+            name);
+        return S_dbLib_noRecSup;
+    }
+    if (hash != snapLayoutHash(pdbRecordType)) {
+        errlogPrintf("dbLoadSnapshot: Record type '%s' has changed\n", name);
+        return S_dbLib_badSnapshot;
+    }
+    *ppdbRecordType = pdbRecordType;
+
+    while (nRecords-- && !pcur->bad) {
+        const char *recname = snapGetString(pcur);
+        epicsUInt32 nFields, nInfo;
+
+        snapGetU32(pcur);
+        nFields = snapGetU32(pcur);
+        nInfo = snapGetU32(pcur);
+        if (!recname)
+            return S_dbLib_badSnapshot;
+        if (strlen(recname) >= sizeof(((dbCommon *) 0)->name))
+            return S_dbLib_nameLength;
+        status = snapCheckName(pdbbase, pnames, recname);
+        if (status)
+            return status;
+        while (nFields-- && !pcur->bad) {
+            epicsUInt32 index = snapGetU32(pcur);
+            epicsUInt32 len;
+            const char *value = snapGetBlob(pcur, &len);
+
+            if (pcur->bad || index == 0 ||
+                index >= (epicsUInt32) pdbRecordType->no_fields ||
+                snapSkipField(pdbRecordType->papFldDes[index]) ||
+                !snapValueOk(pdbRecordType->papFldDes[index], value, len))
+                return S_dbLib_badSnapshot;
+        }
+        while (nInfo-- && !pcur->bad) {
+            if (!snapGetString(pcur) || !snapGetString(pcur))
+                return S_dbLib_badSnapshot;
+        }
+    }
+    while (nAliases-- && !pcur->bad) {
+        const char *alias = snapGetString(pcur);
+
+        if (!alias || !snapGetString(pcur))
+            return S_dbLib_badSnapshot;
+        status = snapCheckName(pdbbase, pnames, alias);
+        if (status)
+            return status;
+    }
+    return pcur->bad ? S_dbLib_badSnapshot : 0;
+}
+
+static long snapLoadRecordType(DBBASE *pdbbase, snapCursor *pcur,
+    dbRecordType *pdbRecordType, const dbCommon *pdefault)
+{
+    epicsUInt32 nRecords, nAliases;
+    DBENTRY dbentry;
+    long status = 0;
+
+    snapGetString(pcur);
+    snapGetU32(pcur);
+    nRecords = snapGetU32(pcur);
+    nAliases = snapGetU32(pcur);
+
+    dbInitEntry(pdbbase, &dbentry);
+    dbentry.precordType = pdbRecordType;
+
+    while (nRecords-- && !status) {
+        const char *recname = snapGetString(pcur);
+        epicsUInt32 flags = snapGetU32(pcur);
+        epicsUInt32 nFields = snapGetU32(pcur);
+        epicsUInt32 nInfo = snapGetU32(pcur);
+        dbRecordNode *precnode;
+        char *precord;
+
+        precnode = dbCalloc(1, sizeof(dbRecordNode));
+        dbentry.precnode = precnode;
+        status = dbAllocRecordCopy(&dbentry, recname, pdefault);
+        if (status) {
+            free(precnode);
+            break;
+        }
+        precnode->recordname = dbRecordName(&dbentry);
+        precnode->flags = flags & DBRN_FLAGS_VISIBLE;
+        ellInit(&precnode->infoList);
+        ellAdd(&pdbRecordType->recList, &precnode->node);
+        if (!dbPvdAdd(pdbbase, pdbRecordType, precnode)) {
+            errMessage(-1, "dbLoadSnapshot: Add to PVD failed");
+            status = -1;
+            break;
+        }
+
+        precord = precnode->precord;
+        while (nFields--) {
+            epicsUInt32 index = snapGetU32(pcur);
+            epicsUInt32 len;
+            const char *value = snapGetBlob(pcur, &len);
+            dbFldDes *pflddes = pdbRecordType->papFldDes[index];
+            char *pfield = precord + pflddes->offset;
+
+            switch (pflddes->field_type) {
+            case DBF_INLINK:
+            case DBF_OUTLINK:
+            case DBF_FWDLINK: {
+                    DBLINK *plink = (DBLINK *) pfield;
+
+                    free(plink->text);
+                    plink->text = len ? epicsStrDup(value) : NULL;
+                }
+                break;
+
+            default:
+                memcpy(pfield, value, len);
+            }
+        }
+        while (nInfo--) {
+            const char *name = snapGetString(pcur);
+            const char *string = snapGetString(pcur);
+
+            dbPutInfo(&dbentry, name, string);
+        }
+    }
+
+    while (nAliases-- && !status) {
+        const char *alias = snapGetString(pcur);
+        const char *recname = snapGetString(pcur);
+
+        status = dbFindRecord(&dbentry, recname);
+        if (!status)
+            status = dbCreateAlias(&dbentry, alias);
+        if (status)
+            errlogPrintf("dbLoadSnapshot: Can't create alias '%s' for '%s'\n",
+                alias, recname);
+    }
+    dbFinishEntry(&dbentry);
+    return status;
+}
+
+static char * snapReadFile(const char *filename, size_t *plen)
+{
+    FILE *fp = fopen(filename, "rb");
+    char *data = NULL;
+    long len;
+
+    if (!fp)
+        return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) >= 0 &&
+        fseek(fp, 0, SEEK_SET) == 0) {
+        data = malloc(len ? len : 1);
+        if (data && fread(data, 1, len, fp) != (size_t) len) {
+            free(data);
+            data = NULL;
+        }
+        *plen = len;
+    }
+    fclose(fp);
+    return data;
+}
+
+long dbLoadSnapshot(DBBASE *pdbbase, const char *filename)
+{
+    snapCursor cur;
+    const char *start;
+    epicsUInt32 nTypes, i;
+    dbRecordType **papType = NULL;
+    struct gphPvt *pnames = NULL;
+    int tableSize = 256;
+    size_t len = 0;
+    char *data;
+    long status = 0;
+
+    if (!pdbbase) {
+        errlogPrintf("dbLoadSnapshot: No database definition loaded\n");
+        return S_dbLib_recordTypeNotFound;
+    }
+    if (getIocState() != iocVoid) {
+        errlogPrintf("dbLoadSnapshot: Can't load records after iocInit\n");
+        return S_dbLib_badSnapshot;
+    }
+
+    data = snapReadFile(filename, &len);
+    if (!data) {
+        errlogPrintf("dbLoadSnapshot: Can't read '%s'\n", filename);
+        return S_dbLib_badSnapshot;
+    }
+    cur.pos = data;
+    cur.end = data + len;
+    cur.bad = 0;
+
+    start = snapGetBytes(&cur, 8);
+    if (!start || memcmp(start, SNAP_MAGIC, 8) != 0 ||
+        snapGetU32(&cur) != SNAP_VERSION ||
+        snapGetU32(&cur) != SNAP_BYTE_ORDER) {
+        errlogPrintf("dbLoadSnapshot: '%s' is not a version %d snapshot "
+            "for this architecture\n", filename, SNAP_VERSION);
+        free(data);
+        return S_dbLib_badSnapshot;
+    }
+    nTypes = snapGetU32(&cur);
+    if (cur.bad || nTypes > (epicsUInt32) ellCount(&pdbbase->recordTypeList))
+        status = S_dbLib_badSnapshot;
+    else
+        papType = dbCalloc(nTypes ? nTypes : 1, sizeof(dbRecordType *));
+
+    /* Check everything before changing the database, so a bad file
+     * loads nothing. The names are collected to find repeats. */
+    while (tableSize < 65536 && (size_t) tableSize * 256 < len)
+        tableSize <<= 1;
+    gphInitPvt(&pnames, tableSize);
+    start = cur.pos;
+    for (i = 0; i < nTypes && !status; i++)
+        status = snapCheckRecordType(pdbbase, &cur, pnames, &papType[i]);
+    if (!status && cur.pos != cur.end)
+        status = S_dbLib_badSnapshot;
+    gphFreeMem(pnames);
+    if (status) {
+        errlogPrintf("dbLoadSnapshot: '%s' can't be loaded\n", filename);
+        free(papType);
+        free(data);
+        return status;
+    }
+
+    cur.pos = start;
+    for (i = 0; i < nTypes && !status; i++) {
+        dbRecordNode node;
+        dbCommon *pdefault = snapDefaultRecord(pdbbase, papType[i], &node);
+
+        if (!pdefault) {
+            status = S_dbLib_noRecSup;
+            break;
+        }
+        status = snapLoadRecordType(pdbbase, &cur, papType[i], pdefault);
+        snapFreeDefault(papType[i], pdefault);
+    }
+    if (status)
+        errlogPrintf("dbLoadSnapshot: Error loading '%s'\n", filename);
+    free(papType);
+    free(data);
+    return status;
+}
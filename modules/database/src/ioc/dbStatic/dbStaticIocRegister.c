@@ -161,6 +161,26 @@ static void dbReportDeviceConfigCallFunc(const iocshArgBuf *args)
     dbReportDeviceConfig(*iocshPpdbbase,stdout);
 }
 
+/* dbSaveSnapshot */
+static const iocshArg dbSnapshotArg0 = { "file name",iocshArgString};
+static const iocshArg * const dbSnapshotArgs[] = {&dbSnapshotArg0};
+static const iocshFuncDef dbSaveSnapshotFuncDef = {"dbSaveSnapshot",1,dbSnapshotArgs,
+    "Write the records loaded so far to a binary snapshot file.\n"
+    "Must be run before iocInit.\n"};
+static void dbSaveSnapshotCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(dbSaveSnapshot(*iocshPpdbbase,args[0].sval) ? 1 : 0);
+}
+
+/* dbLoadSnapshot */
+static const iocshFuncDef dbLoadSnapshotFuncDef = {"dbLoadSnapshot",1,dbSnapshotArgs,
+    "Load records from a file written by dbSaveSnapshot.\n"
+    "The same record types and device support must be loaded first.\n"};
+static void dbLoadSnapshotCallFunc(const iocshArgBuf *args)
+{
+    iocshSetError(dbLoadSnapshot(*iocshPpdbbase,args[0].sval) ? 1 : 0);
+}
+
 void dbStaticIocRegister(void)
 {
     iocshRegister(&dbDumpPathFuncDef, dbDumpPathCallFunc);
@@ -178,4 +198,6 @@ void dbStaticIocRegister(void)
     iocshRegister(&dbPvdDumpFuncDef, dbPvdDumpCallFunc);
     iocshRegister(&dbPvdTableSizeFuncDef,dbPvdTableSizeCallFunc);
     iocshRegister(&dbReportDeviceConfigFuncDef, dbReportDeviceConfigCallFunc);
+    iocshRegister(&dbSaveSnapshotFuncDef, dbSaveSnapshotCallFunc);
+    iocshRegister(&dbLoadSnapshotFuncDef, dbLoadSnapshotCallFunc);
 }
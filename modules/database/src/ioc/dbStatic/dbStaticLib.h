@@ -67,6 +67,8 @@ epicsShareFunc char * dbGetPromptGroupNameFromKey(DBBASE *pdbbase,
     const short key);
 epicsShareFunc short dbGetPromptGroupKeyFromName(DBBASE *pdbbase,
     const char *name);
+epicsShareFunc long dbSaveSnapshot(DBBASE *pdbbase, const char *filename);
+epicsShareFunc long dbLoadSnapshot(DBBASE *pdbbase, const char *filename);
 epicsShareFunc long dbWriteRecord(DBBASE *ppdbbase,
     const char *filename, const char *precordTypename, int level);
 epicsShareFunc long dbWriteRecordFP(DBBASE *ppdbbase,
@@ -222,6 +224,7 @@ epicsShareFunc void dbDumpVariable(DBBASE *pdbbase);
 epicsShareFunc void dbDumpBreaktable(DBBASE *pdbbase,
     const char *name);
 epicsShareFunc void dbPvdDump(DBBASE *pdbbase, int verbose);
+epicsShareFunc unsigned int dbPvdGeneration(DBBASE *pdbbase);
 epicsShareFunc void dbReportDeviceConfig(DBBASE *pdbbase,
     FILE *report);
 
@@ -248,6 +251,7 @@ extern int dbConvertStrict;
 #define S_dbLib_noSizeOffset (M_dbLib|23)      /* Missing SizeOffset Routine - No record support? */
 #define S_dbLib_outMem (M_dbLib|27)            /* Out of memory */
 #define S_dbLib_infoNotFound (M_dbLib|29)      /* Info item Not Found */
+#define S_dbLib_badSnapshot (M_dbLib|31)       /* Invalid or incompatible database snapshot */
 
 #ifdef __cplusplus
 }
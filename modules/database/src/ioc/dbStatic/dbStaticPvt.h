@@ -28,6 +28,8 @@ int dbIsMacroOk(DBENTRY *pdbentry);
 
 /*The following routines have different versions for run-time no-run-time*/
 long dbAllocRecord(DBENTRY *pdbentry,const char *precordName);
+long dbAllocRecordCopy(DBENTRY *pdbentry, const char *precordName,
+    const struct dbCommon *pfrom);
 long dbFreeRecord(DBENTRY *pdbentry);
 
 long dbGetFieldAddress(DBENTRY *pdbentry);
@@ -93,7 +95,6 @@ typedef struct dbGuiGroup {
 /*The following are in dbPvdLib.c*/
 /*directory*/
 typedef struct{
-    ELLNODE         node;
     dbRecordType    *precordType;
     dbRecordNode    *precnode;
 }PVDENTRY;
@@ -20,6 +20,7 @@
 #include "ellLib.h"
 #include "epicsPrint.h"
 #include "epicsStdlib.h"
+#include "epicsString.h"
 #include "epicsTypes.h"
 #include "errMdef.h"
 
@@ -171,6 +172,44 @@ long dbAllocRecord(DBENTRY *pdbentry,const char *precordName)
     return(0);
 }
 
+/*
+ * Allocate a record like dbAllocRecord(), but copy its fields from pfrom,
+ * a record of the same type, instead of setting their initial values.
+ * Link text is copied, other pointers in pfrom must be NULL.
+ */
+long dbAllocRecordCopy(DBENTRY *pdbentry, const char *precordName,
+    const struct dbCommon *pfrom)
+{
+    dbRecordType    *pdbRecordType = pdbentry->precordType;
+    dbRecordNode    *precnode = pdbentry->precnode;
+    dbCommonPvt     *ppvt;
+    dbCommon        *precord;
+    int             i;
+
+    if(!pdbRecordType) return(S_dbLib_recordTypeNotFound);
+    if(!precnode) return(S_dbLib_recNotFound);
+    if(pdbRecordType->rec_size < sizeof(*precord)) return(S_dbLib_noRecSup);
+    if(strlen(precordName) >= sizeof(precord->name))
+        return(S_dbLib_nameLength);
+
+    ppvt = dbMalloc(offsetof(dbCommonPvt, common) + pdbRecordType->rec_size);
+    memset(ppvt, 0, offsetof(dbCommonPvt, common));
+    precord = &ppvt->common;
+    memcpy(precord, pfrom, pdbRecordType->rec_size);
+    ppvt->recnode = precnode;
+    precnode->precord = precord;
+    strcpy(precord->name, precordName);
+
+    for(i=0; i<pdbRecordType->no_links; i++) {
+        dbFldDes *pflddes = pdbRecordType->papFldDes[pdbRecordType->link_ind[i]];
+        DBLINK *plink = (DBLINK *)((char *)precord + pflddes->offset);
+
+        if(plink->text)
+            plink->text = epicsStrDup(plink->text);
+    }
+    return(0);
+}
+
 long dbFreeRecord(DBENTRY *pdbentry)
 {
     dbRecordType *pdbRecordType = pdbentry->precordType;
@@ -23,16 +23,21 @@
 #include <errno.h>
 #include <limits.h>
 
+#include "cantProceed.h"
 #include "dbDefs.h"
 #include "ellLib.h"
 #include "envDefs.h"
+#include "epicsAtomic.h"
 #include "epicsExit.h"
 #include "epicsGeneralTime.h"
 #include "epicsPrint.h"
 #include "epicsSignal.h"
+#include "epicsString.h"
 #include "epicsThread.h"
+#include "epicsThreadPool.h"
 #include "errMdef.h"
 #include "iocsh.h"
+#include "registry.h"
 #include "taskwd.h"
 
 #include "caeventmask.h"
@@ -98,6 +103,14 @@ static void iterateRecords(recIterFunc func, void *user);
 int dbThreadRealtimeLock = 1;
 epicsExportAddress(int, dbThreadRealtimeLock);
 
+/* Worker threads for init_record() of thread-safe record types,
+ * 0: initialize serially, <0: relative to the number of CPUs */
+int dbInitRecordThreads = 0;
+epicsExportAddress(int, dbInitRecordThreads);
+
+static void * const threadSafeRecordTypeID = "thread-safe record type";
+static void * const threadSafeDeviceID = "thread-safe device support";
+
 enum iocStateEnum getIocState(void)
 {
     return iocState;
@@ -492,6 +505,201 @@ static void iterateRecords(recIterFunc func, void *user)
     return;
 }
 
+/*
+ * Parallel record initialization, see iocInitRecordTypeThreadSafe().
+ * The records of one record type are initialized by the pool's worker
+ * threads and the iocInit thread together, taking INIT_CHUNK records at
+ * a time; record types are still initialized one after another.
+ */
+#define INIT_CHUNK 64
+
+static struct {
+    epicsThreadPool *pool;
+    epicsJob **jobs;
+    int njobs;
+    recIterFunc func;
+    dbRecordType *rtyp;
+    dbCommon **precs;
+    size_t count;
+    size_t next;
+} initPar;
+
+static void declareThreadSafe(void *id, const char *name)
+{
+    char *copy;
+
+    if (!name || registryFind(id, name))
+        return;
+    copy = epicsStrDup(name);
+    if (!registryAdd(id, copy, id))
+        free(copy);
+}
+
+void iocInitRecordTypeThreadSafe(const char *recordTypeName)
+{
+    declareThreadSafe(threadSafeRecordTypeID, recordTypeName);
+}
+
+void iocInitDeviceThreadSafe(const char *dsetName)
+{
+    declareThreadSafe(threadSafeDeviceID, dsetName);
+}
+
+static void initChunks(void)
+{
+    size_t i;
+
+    while ((i = epicsAtomicAddSizeT(&initPar.next, INIT_CHUNK) - INIT_CHUNK)
+           < initPar.count) {
+        size_t end = i + INIT_CHUNK;
+
+        if (end > initPar.count)
+            end = initPar.count;
+        for (; i < end; i++)
+            initPar.func(initPar.rtyp, initPar.precs[i], NULL);
+    }
+}
+
+static void initChunksJob(void *arg, epicsJobMode mode)
+{
+    if (mode == epicsJobModeRun)
+        initChunks();
+}
+
+static void initParallelCreate(void)
+{
+    epicsThreadPoolConfig conf;
+    dbRecordType *pdbRecordType;
+    int nthreads = dbInitRecordThreads;
+    int maxRecords = 0;
+    int i;
+
+    if (nthreads < 0)
+        nthreads += epicsThreadGetCPUs();
+    if (nthreads < 1)
+        return;
+
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node)) {
+        if (registryFind(threadSafeRecordTypeID, pdbRecordType->name) &&
+            ellCount(&pdbRecordType->recList) > maxRecords)
+            maxRecords = ellCount(&pdbRecordType->recList);
+    }
+    if (maxRecords <= INIT_CHUNK)
+        return;
+
+    epicsThreadPoolConfigDefaults(&conf);
+    conf.initialThreads = conf.maxThreads = nthreads;
+    conf.workerPriority = epicsThreadGetPrioritySelf();
+    conf.workerStack = epicsThreadGetStackSize(epicsThreadStackBig);
+    initPar.pool = epicsThreadPoolCreate(&conf);
+    if (!initPar.pool) {
+        errlogPrintf("iocInit: Can't create thread pool, "
+            "initializing records serially\n");
+        return;
+    }
+
+    initPar.jobs = dbCalloc(nthreads, sizeof(epicsJob *));
+    for (i = 0; i < nthreads; i++) {
+        initPar.jobs[i] = epicsJobCreate(initPar.pool, initChunksJob, NULL);
+        if (!initPar.jobs[i])
+            cantProceed("iocInit: epicsJobCreate failed\n");
+    }
+    initPar.njobs = nthreads;
+    initPar.precs = dbCalloc(maxRecords, sizeof(dbCommon *));
+}
+
+static void initParallelDelete(void)
+{
+    int i;
+
+    if (!initPar.pool)
+        return;
+
+    for (i = 0; i < initPar.njobs; i++)
+        epicsJobDestroy(initPar.jobs[i]);
+    epicsThreadPoolDestroy(initPar.pool);
+    free(initPar.jobs);
+    free(initPar.precs);
+    memset(&initPar, 0, sizeof(initPar));
+}
+
+static void initParallelRun(dbRecordType *pdbRecordType, recIterFunc func)
+{
+    size_t nchunks = (initPar.count + INIT_CHUNK - 1) / INIT_CHUNK;
+    int queued = 0;
+    int i;
+
+    initPar.func = func;
+    initPar.rtyp = pdbRecordType;
+    initPar.next = 0;
+
+    /* This thread initializes one chunk itself */
+    for (i = 0; i < initPar.njobs && i + 1 < nchunks; i++) {
+        if (!epicsJobQueue(initPar.jobs[i]))
+            queued++;
+    }
+    initChunks();
+    if (queued)
+        epicsThreadPoolWait(initPar.pool, -1.0);
+}
+
+/*
+ * Like iterateRecords(), but the records of thread-safe record types
+ * that use thread-safe device support are given to the thread pool.
+ */
+static void iterateRecordsParallel(recIterFunc func)
+{
+    dbRecordType *pdbRecordType;
+
+    if (!initPar.pool) {
+        iterateRecords(func, NULL);
+        return;
+    }
+
+    for (pdbRecordType = (dbRecordType *)ellFirst(&pdbbase->recordTypeList);
+         pdbRecordType;
+         pdbRecordType = (dbRecordType *)ellNext(&pdbRecordType->node)) {
+        int ndev = ellCount(&pdbRecordType->devList);
+        char *devSafe = NULL;
+        dbRecordNode *pdbRecordNode;
+
+        initPar.count = 0;
+        if (registryFind(threadSafeRecordTypeID, pdbRecordType->name)) {
+            devSup *pdevSup;
+            int i = 0;
+
+            devSafe = dbCalloc(ndev + 1, 1);
+            for (pdevSup = (devSup *)ellFirst(&pdbRecordType->devList);
+                 pdevSup;
+                 pdevSup = (devSup *)ellNext(&pdevSup->node), i++) {
+                devSafe[i] = !!registryFind(threadSafeDeviceID, pdevSup->name);
+            }
+        }
+
+        for (pdbRecordNode = (dbRecordNode *)ellFirst(&pdbRecordType->recList);
+             pdbRecordNode;
+             pdbRecordNode = (dbRecordNode *)ellNext(&pdbRecordNode->node)) {
+            dbCommon *precord = pdbRecordNode->precord;
+
+            if (!precord->name[0] ||
+                pdbRecordNode->flags & DBRN_FLAGS_ISALIAS)
+                continue;
+
+            if (devSafe && (ndev == 0 ||
+                    (precord->dtyp < ndev && devSafe[precord->dtyp])))
+                initPar.precs[initPar.count++] = precord;
+            else
+                func(pdbRecordType, precord, NULL);
+        }
+        free(devSafe);
+
+        if (initPar.count)
+            initParallelRun(pdbRecordType, func);
+    }
+}
+
 static void doInitRecord0(dbRecordType *pdbRecordType, dbCommon *precord,
     void *user)
 {
@@ -560,9 +768,11 @@ static void doInitRecord1(dbRecordType *pdbRecordType, dbCommon *precord,
 static void initDatabase(void)
 {
     dbChannelInit();
-    iterateRecords(doInitRecord0, NULL);
+    initParallelCreate();
+    iterateRecordsParallel(doInitRecord0);
     iterateRecords(doResolveLinks, NULL);
-    iterateRecords(doInitRecord1, NULL);
+    iterateRecordsParallel(doInitRecord1);
+    initParallelDelete();
 
     epicsAtExit(exitDatabase, NULL);
     return;
@@ -30,6 +30,17 @@ epicsShareFunc int iocRun(void);
 epicsShareFunc int iocPause(void);
 epicsShareFunc int iocShutdown(void);
 
+/* Declare that init_record() may be called for different records of a
+ * record type, or of records using a device support (named as in its
+ * device() entry), from more than one thread at once. Records get
+ * initialized in parallel when dbInitRecordThreads is set and both their
+ * record type and device support have been declared. Must be called
+ * before iocInit, usually from a registrar() function.
+ */
+epicsShareExtern int dbInitRecordThreads;
+epicsShareFunc void iocInitRecordTypeThreadSafe(const char *recordTypeName);
+epicsShareFunc void iocInitDeviceThreadSafe(const char *dsetName);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,7 @@
 #include "callback.h"
 #include "db_access.h"
 #include "db_access_routines.h"
+#include "dbArrayBuf.h"
 #include "dbChannel.h"
 #include "dbCommon.h"
 #include "dbEvent.h"
@@ -480,8 +481,129 @@ static void no_read_access_event ( struct client *pClient,
     }
 }
 
+static void release_field_log ( void *pPvt )
+{
+    db_field_log *pfl = ( db_field_log * ) pPvt;
+    pfl->u.r.dtor ( pfl );
+    free ( pfl );
+}
+
+static void release_array_buf ( void *pPvt )
+{
+    dbArrayBufRelease ( pPvt );
+}
+
+static int net_convert_array ( void *pdst, const void *psrc, size_t size,
+    void *arg )
+{
+    unsigned type = ( unsigned ) ( size_t ) arg;
+
+    return caNetConvert ( type, psrc, pdst, TRUE /* host -> net format */,
+        size / dbr_value_size[type] ) != ECA_NORMAL;
+}
+
+/*
+ *  read_reply_ref()
+ *
+ * Large arrays in a field log which has its own copy of the data are
+ * byte swapped in place and sent from there, instead of being copied
+ * into the send buffer. The copy is taken over from the field log and
+ * released once sent. An array shared with other monitors of the record
+ * is not touched, one byte swapped copy is made and sent to all of them.
+ * Returns FALSE if the update must be copied.
+ *
+ * Takes the LOCK itself, only to queue the swapped data.
+ */
+static int read_reply_ref ( struct event_ext *pevext, struct dbChannel *dbch,
+    db_field_log *pfl, int autosize, int eventsRemaining )
+{
+    struct client *pClient = pevext->pciu->client;
+    unsigned type = pevext->msg.m_dataType;
+    union db_access_val meta;
+    db_field_log *pref;
+    void *pbuf;
+    long item_count, one = 1;
+    ca_uint32_t payload_size;
+    unsigned metaSize;
+    int status, cacStatus;
+
+    if ( pClient->proto != IPPROTO_TCP ||
+        ! dbChannel_field_log_sendable ( type, pfl ) )
+        return FALSE;
+
+    item_count = autosize ? pfl->no_elements : pevext->msg.m_count;
+    if ( item_count > pfl->no_elements )
+        return FALSE;
+    payload_size = dbr_size_n ( type, item_count );
+    if ( payload_size <= MAX_TCP )
+        return FALSE;
+
+    /* Fetch the meta-data with the first element, then drop that */
+    metaSize = dbr_size[type] - dbr_value_size[type];
+    if ( dbChannel_get_count ( dbch, type, &meta, &one, pfl ) < 0 ||
+        caNetConvert ( type, &meta, &meta, TRUE, 1 ) != ECA_NORMAL )
+        return FALSE;
+
+    pbuf = dbArrayBufFromLog ( pfl );
+    if ( pbuf ) {
+        unsigned valueType = type % ( LAST_TYPE + 1 );
+        const void *pValue = dbArrayBufDerived ( pbuf,
+            pfl->no_elements * dbr_value_size[valueType],
+            net_convert_array, ( void * ) ( size_t ) valueType );
+
+        if ( ! pValue )
+            return FALSE;
+        dbArrayBufRef ( pbuf );
+        SEND_LOCK ( pClient );
+        status = cas_copy_in_header_ref ( pClient, pevext->msg.m_cmmd,
+            payload_size, type, item_count, ECA_NORMAL,
+            pevext->msg.m_available, &meta, metaSize, pValue,
+            release_array_buf, pbuf );
+        if ( status != ECA_NORMAL ) {
+            SEND_UNLOCK ( pClient );
+            dbArrayBufRelease ( pbuf );
+            return FALSE;
+        }
+        cas_commit_msg ( pClient, payload_size );
+        if ( ! eventsRemaining )
+            cas_send_bs_msg ( pClient, FALSE );
+        SEND_UNLOCK ( pClient );
+        return TRUE;
+    }
+
+    pref = malloc ( sizeof ( *pref ) );
+    if ( ! pref )
+        return FALSE;
+    *pref = *pfl;
+
+    cacStatus = caNetConvert ( type % ( LAST_TYPE + 1 ), pref->u.r.field,
+        pref->u.r.field, TRUE /* host -> net format */, item_count );
+
+    SEND_LOCK ( pClient );
+    status = cas_copy_in_header_ref ( pClient, pevext->msg.m_cmmd,
+        payload_size, type, item_count, cacStatus, pevext->msg.m_available,
+        &meta, metaSize, pref->u.r.field, release_field_log, pref );
+    if ( status != ECA_NORMAL ) {
+        SEND_UNLOCK ( pClient );
+        if ( cacStatus == ECA_NORMAL )
+            caNetConvert ( type % ( LAST_TYPE + 1 ), pref->u.r.field,
+                pref->u.r.field, FALSE /* net -> host format */, item_count );
+        free ( pref );
+        return FALSE;
+    }
+    pfl->u.r.dtor = NULL;
+    cas_commit_msg ( pClient, payload_size );
+    if ( ! eventsRemaining )
+        cas_send_bs_msg ( pClient, FALSE );
+    SEND_UNLOCK ( pClient );
+    return TRUE;
+}
+
 /*
  *  read_reply()
+ *
+ * The reply is built in this thread's staging buffer, and the LOCK
+ * only taken to queue it.
  */
 static void read_reply ( void *pArg, struct dbChannel *dbch,
                        int eventsRemaining, db_field_log *pfl )
@@ -499,36 +621,18 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
     ca_uint32_t payload_size;
     dbAddr *paddr=&dbch->addr;
 
-    SEND_LOCK ( pClient );
-
     cid = ECA_NORMAL;
 
     /* If the client has requested a zero element count we interpret this as a
      * request for all avaiable elements.  In this case we initialise the
      * header with the maximum element size specified by the database. */
     autosize = pevext->msg.m_count == 0;
-    item_count =
-        autosize ? paddr->no_elements : pevext->msg.m_count;
-    payload_size = dbr_size_n(pevext->msg.m_dataType, item_count);
-    status = cas_copy_in_header(
-        pClient, pevext->msg.m_cmmd, payload_size,
-        pevext->msg.m_dataType, item_count, cid, pevext->msg.m_available,
-        &pPayload );
-    if ( status != ECA_NORMAL ) {
-        send_err ( &pevext->msg, status, pClient,
-            "server unable to load read (or subscription update) response "
-            "into protocol buffer PV=\"%s\" dbf=%u count=%ld avail=%u max bytes=%u",
-            RECORD_NAME ( dbch ), pevext->msg.m_dataType, item_count, pevext->msg.m_available, rsrvSizeofLargeBufTCP );
-        if ( ! eventsRemaining )
-            cas_send_bs_msg ( pClient, FALSE );
-        SEND_UNLOCK ( pClient );
-        return;
-    }
 
     /*
      * verify read access
      */
     if ( ! readAccess ) {
+        SEND_LOCK ( pClient );
         no_read_access_event ( pClient, pevext );
         if ( ! eventsRemaining )
             cas_send_bs_msg ( pClient, FALSE );
@@ -537,7 +641,8 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
     }
 
     /* If filters are involved in a read, create field log and run filters */
-    if (!pfl && (ellCount(&dbch->pre_chain) || ellCount(&dbch->post_chain))) {
+    if (!pfl &&
+        (ellCount(&dbch->pre_chain) || ellCount(&dbch->post_chain))) {
         pfl = db_create_read_log(dbch);
         if (pfl) {
             local_fl = 1;
@@ -546,53 +651,80 @@ static void read_reply ( void *pArg, struct dbChannel *dbch,
         }
     }
 
-    status = dbChannel_get_count ( dbch, pevext->msg.m_dataType,
-                  pPayload, &item_count, pfl);
+    if ( read_reply_ref ( pevext, dbch, pfl, autosize, eventsRemaining ) ) {
+        if (local_fl) db_delete_field_log(pfl);
+        return;
+    }
 
-    if (local_fl) db_delete_field_log(pfl);
+    item_count =
+        autosize ? paddr->no_elements : pevext->msg.m_count;
+    payload_size = dbr_size_n(pevext->msg.m_dataType, item_count);
+    status = cas_stage_payload ( pClient, payload_size, item_count,
+        &pPayload );
+    if ( status == ECA_NORMAL ) {
+        long getStatus = dbChannel_get_count ( dbch, pevext->msg.m_dataType,
+                      pPayload, &item_count, pfl);
 
-    if ( status < 0 ) {
-        /* Clients recv the status of the operation directly to the
-         * event/put/get callback.  (from CA_V41())
-         *
-         * Fetched value is set to zero in case they use it even when the
-         * status indicates failure -- unless the client selected autosizing
-         * data, in which case they'd better know what they're doing!
-         *
-         * The m_cid field in the protocol header is abused to carry the
-         * status */
-        if (autosize) {
-            payload_size = dbr_size_n(pevext->msg.m_dataType, 0);
-            cas_set_header_count(pClient, 0);
-        }
-        memset ( pPayload, 0, payload_size );
-        cas_set_header_cid ( pClient, ECA_GETFAIL );
-        cas_commit_msg ( pClient, payload_size );
-    }
-    else {
-        int cacStatus = caNetConvert (
-            pevext->msg.m_dataType, pPayload, pPayload,
-            TRUE /* host -> net format */, item_count );
-        if ( cacStatus == ECA_NORMAL ) {
-            ca_uint32_t data_size =
-                dbr_size_n(pevext->msg.m_dataType, item_count);
+        if ( getStatus < 0 ) {
+            /* Clients recv the status of the operation directly to the
+             * event/put/get callback.  (from CA_V41())
+             *
+             * Fetched value is set to zero in case they use it even when
+             * the status indicates failure -- unless the client selected
+             * autosizing data, in which case they'd better know what
+             * they're doing!
+             *
+             * The m_cid field in the protocol header is abused to carry
+             * the status */
             if (autosize) {
-                payload_size = data_size;
-                cas_set_header_count(pClient, item_count);
+                payload_size = dbr_size_n(pevext->msg.m_dataType, 0);
+                item_count = 0;
             }
-            else if (payload_size > data_size)
-                memset(
-                    (char *) pPayload + data_size, 0, payload_size - data_size);
+            memset ( pPayload, 0, payload_size );
+            cid = ECA_GETFAIL;
         }
         else {
-            if (autosize) {
-                payload_size = dbr_size_n(pevext->msg.m_dataType, 0);
-                cas_set_header_count(pClient, 0);
+            int cacStatus = caNetConvert (
+                pevext->msg.m_dataType, pPayload, pPayload,
+                TRUE /* host -> net format */, item_count );
+            if ( cacStatus == ECA_NORMAL ) {
+                ca_uint32_t data_size =
+                    dbr_size_n(pevext->msg.m_dataType, item_count);
+                if (autosize) {
+                    payload_size = data_size;
+                }
+                else if (payload_size > data_size)
+                    memset((char *) pPayload + data_size, 0,
+                        payload_size - data_size);
+            }
+            else {
+                if (autosize) {
+                    payload_size = dbr_size_n(pevext->msg.m_dataType, 0);
+                    item_count = 0;
+                }
+                memset ( pPayload, 0, payload_size );
+                cid = cacStatus;
             }
-            memset ( pPayload, 0, payload_size );
-            cas_set_header_cid ( pClient, cacStatus );
         }
-        cas_commit_msg ( pClient, payload_size );
+        if ( ! autosize ) {
+            item_count = pevext->msg.m_count;
+        }
+    }
+
+    if (local_fl) db_delete_field_log(pfl);
+
+    SEND_LOCK ( pClient );
+
+    if ( status == ECA_NORMAL ) {
+        status = cas_commit_staged ( pClient, pevext->msg.m_cmmd,
+            pevext->msg.m_dataType, item_count, cid, pevext->msg.m_available,
+            payload_size );
+    }
+    if ( status != ECA_NORMAL ) {
+        send_err ( &pevext->msg, status, pClient,
+            "server unable to load read (or subscription update) response "
+            "into protocol buffer PV=\"%s\" dbf=%u count=%ld avail=%u max bytes=%u",
+            RECORD_NAME ( dbch ), pevext->msg.m_dataType, item_count, pevext->msg.m_available, rsrvSizeofLargeBufTCP );
     }
 
     /*
@@ -626,36 +758,36 @@ static int read_action ( caHdrLargeArray *mp, void *pPayloadIn, struct client *p
     }
     readAccess = asCheckGet ( pciu->asClientPVT );
 
-    SEND_LOCK ( pClient );
-
     if ( INVALID_DB_REQ ( mp->m_dataType ) ) {
+        SEND_LOCK ( pClient );
         send_err ( mp, ECA_BADTYPE, pClient, RECORD_NAME ( pciu->dbch ) );
         SEND_UNLOCK ( pClient );
         return RSRV_ERROR;
     }
 
-    payloadSize = dbr_size_n ( mp->m_dataType, mp->m_count );
-    status = cas_copy_in_header ( pClient, mp->m_cmmd, payloadSize,
-        mp->m_dataType, mp->m_count, pciu->cid, mp->m_available, &pPayload );
-    if ( status != ECA_NORMAL ) {
-        send_err ( mp, status, pClient,
-            "server unable to load read response into protocol buffer PV=\"%s\" dbf=%u count=%u avail=%u max bytes=%u",
-            RECORD_NAME ( pciu->dbch ), mp->m_dataType, mp->m_count, mp->m_available, rsrvSizeofLargeBufTCP );
-        SEND_UNLOCK ( pClient );
-        return RSRV_OK;
-    }
-
     /*
      * verify read access
      */
     if ( ! readAccess ) {
-        status = ECA_NORDACCESS;
-        send_err ( mp, status,
+        SEND_LOCK ( pClient );
+        send_err ( mp, ECA_NORDACCESS,
             pClient, RECORD_NAME ( pciu->dbch ) );
         SEND_UNLOCK ( pClient );
         return RSRV_OK;
     }
 
+    payloadSize = dbr_size_n ( mp->m_dataType, mp->m_count );
+    status = cas_stage_payload ( pClient, payloadSize, mp->m_count,
+        &pPayload );
+    if ( status != ECA_NORMAL ) {
+        SEND_LOCK ( pClient );
+        send_err ( mp, status, pClient,
+            "server unable to load read response into protocol buffer PV=\"%s\" dbf=%u count=%u avail=%u max bytes=%u",
+            RECORD_NAME ( pciu->dbch ), mp->m_dataType, mp->m_count, mp->m_available, rsrvSizeofLargeBufTCP );
+        SEND_UNLOCK ( pClient );
+        return RSRV_OK;
+    }
+
     /* If filters are involved in a read, create field log and run filters */
     if (ellCount(&pciu->dbch->pre_chain) || ellCount(&pciu->dbch->post_chain)) {
         pfl = db_create_read_log(pciu->dbch);
@@ -672,6 +804,7 @@ static int read_action ( caHdrLargeArray *mp, void *pPayloadIn, struct client *p
     if (local_fl) db_delete_field_log(pfl);
 
     if ( status < 0 ) {
+        SEND_LOCK ( pClient );
         send_err ( mp, ECA_GETFAIL, pClient, RECORD_NAME ( pciu->dbch ) );
         SEND_UNLOCK ( pClient );
         return RSRV_OK;
@@ -681,6 +814,7 @@ static int read_action ( caHdrLargeArray *mp, void *pPayloadIn, struct client *p
         mp->m_dataType, pPayload, pPayload,
         TRUE /* host -> net format */, mp->m_count );
     if ( status != ECA_NORMAL ) {
+        SEND_LOCK ( pClient );
         send_err ( mp, status, pClient, RECORD_NAME ( pciu->dbch ) );
         SEND_UNLOCK ( pClient );
         return RSRV_OK;
@@ -704,8 +838,15 @@ static int read_action ( caHdrLargeArray *mp, void *pPayloadIn, struct client *p
                 pStr );
         }
     }
-    cas_commit_msg ( pClient, payloadSize );
 
+    SEND_LOCK ( pClient );
+    status = cas_commit_staged ( pClient, mp->m_cmmd, mp->m_dataType,
+        mp->m_count, pciu->cid, mp->m_available, payloadSize );
+    if ( status != ECA_NORMAL ) {
+        send_err ( mp, status, pClient,
+            "server unable to load read response into protocol buffer PV=\"%s\" dbf=%u count=%u avail=%u max bytes=%u",
+            RECORD_NAME ( pciu->dbch ), mp->m_dataType, mp->m_count, mp->m_available, rsrvSizeofLargeBufTCP );
+    }
     SEND_UNLOCK ( pClient );
 
     return RSRV_OK;
@@ -2160,6 +2301,74 @@ int rsrv_version_reply ( struct client *client )
     return RSRV_OK;
 }
 
+/*
+ * Names searched for over UDP which this server doesn't have. Most UDP
+ * searches are for other servers' names, and clients repeat them until
+ * someone answers. The cache is direct mapped, and an entry is only used
+ * while no records have been added or deleted since it was made.
+ *
+ * There is one UDP client for each interface the server listens on, not
+ * one per remote client, so an IOC only has a few of these 64 KB caches.
+ */
+#define SEARCH_CACHE_SLOTS 1024u    /* a power of 2 */
+#define SEARCH_CACHE_NAME 56u       /* longest name cached, with the nil */
+
+typedef struct search_cache_slot {
+    unsigned        hash;
+    unsigned        generation;
+    char            name[SEARCH_CACHE_NAME]; /* empty if slot unused */
+} search_cache_slot;
+
+struct search_cache {
+    search_cache_slot slots[SEARCH_CACHE_SLOTS];
+};
+
+struct search_cache *rsrvSearchCacheCreate ( void )
+{
+    return calloc ( 1, sizeof ( struct search_cache ) );
+}
+
+void rsrvSearchCacheDestroy ( struct search_cache *pCache )
+{
+    free ( pCache );
+}
+
+/*
+ * Is the name known to this server? Updates the client's search counters.
+ */
+static int search_name_known ( struct client *client, const char *pName )
+{
+    struct search_cache *pCache = client->pSearchCache;
+    search_cache_slot *pSlot = NULL;
+    unsigned generation = 0;
+    unsigned hash = 0;
+
+    if ( pCache ) {
+        hash = epicsStrHash ( pName, 0 );
+        generation = dbChannelTestGeneration ();
+        pSlot = &pCache->slots[hash & ( SEARCH_CACHE_SLOTS - 1u )];
+        if ( pSlot->name[0] && pSlot->hash == hash &&
+                pSlot->generation == generation &&
+                strcmp ( pSlot->name, pName ) == 0 ) {
+            client->nSearchCached++;
+            return FALSE;
+        }
+    }
+
+    if ( dbChannelTest ( pName ) == 0 ) {
+        client->nSearchFound++;
+        return TRUE;
+    }
+
+    client->nSearchNotFound++;
+    if ( pSlot && strlen ( pName ) < SEARCH_CACHE_NAME ) {
+        pSlot->hash = hash;
+        pSlot->generation = generation;
+        strcpy ( pSlot->name, pName );
+    }
+    return FALSE;
+}
+
 /*
  *  search_reply_udp ()
  */
@@ -2191,7 +2400,7 @@ static int search_reply_udp ( caHdrLargeArray *mp, void *pPayload, struct client
     pName[mp->m_postsize-1] = '\0';
 
     /* Exit quickly if channel not on this node */
-    if (dbChannelTest(pName)) {
+    if (!search_name_known(client, pName)) {
         DLOG ( 2, ( "CAS: Lookup for channel \"%s\" failed\n", pPayLoad ) );
         return RSRV_OK;
     }
@@ -33,6 +33,164 @@
 #define epicsExportSharedSymbols
 #include "server.h"
 
+/*
+ * POSIX targets send the send buffer and any queued large messages
+ * with one sendmsg() call, elsewhere they are sent piece by piece.
+ */
+#if !defined(_WIN32)
+#  define CAS_GATHER_SEND
+#endif
+
+#define CAS_SEND_SEGS 64u
+
+/*
+ * A message too large for the client's send buffer, queued to be sent
+ * after the first bufOffset bytes of that buffer. The header and any
+ * meta-data are stored in data[]. The value is either copied in after
+ * them, or is sent from pValue which is released when no longer needed.
+ */
+struct send_block {
+    ELLNODE             node;
+    unsigned            bufOffset;
+    size_t              capacity;   /* bytes available in data[] */
+    unsigned            inlineSize; /* bytes of data[] to send */
+    unsigned            metaSize;   /* payload bytes in data[] */
+    const char          *pValue;
+    unsigned            valueSize;
+    unsigned            padSize;
+    cas_release_func    *pRelease;
+    void                *pPvt;
+    double              data[1];    /* aligned for caHdr */
+};
+
+typedef struct send_seg {
+    const char          *p;
+    size_t              n;
+} send_seg;
+
+static const char casPadBytes[8];
+
+/*
+ * Keep the largest released block for the next message, so a client
+ * receiving a large array at a steady rate does not allocate each time
+ */
+static void cas_release_block ( struct client *pclient,
+    struct send_block *pBlock )
+{
+    if ( pBlock->pRelease ) {
+        pBlock->pRelease ( pBlock->pPvt );
+        pBlock->pRelease = NULL;
+    }
+    if ( ! pclient->pSpareBlock ) {
+        pclient->pSpareBlock = pBlock;
+    }
+    else if ( pclient->pSpareBlock->capacity < pBlock->capacity ) {
+        free ( pclient->pSpareBlock );
+        pclient->pSpareBlock = pBlock;
+    }
+    else {
+        free ( pBlock );
+    }
+}
+
+static void cas_release_queued_blocks ( struct client *pclient )
+{
+    struct send_block *pBlock;
+
+    while ( ( pBlock = (struct send_block *)
+            ellGet ( &pclient->sendBlocks ) ) ) {
+        cas_release_block ( pclient, pBlock );
+    }
+    pclient->sendBlockBytes = 0u;
+}
+
+/*
+ * cas_discard_send_blocks()
+ *
+ * Release all large messages, sent or not, and free the spare block
+ */
+void cas_discard_send_blocks ( struct client *pclient )
+{
+    if ( pclient->pSendBlock ) {
+        cas_release_block ( pclient, pclient->pSendBlock );
+        pclient->pSendBlock = NULL;
+    }
+    cas_release_queued_blocks ( pclient );
+    free ( pclient->pSpareBlock );
+    pclient->pSpareBlock = NULL;
+    free ( pclient->pStage[0] );
+    pclient->pStage[0] = NULL;
+    free ( pclient->pStage[1] );
+    pclient->pStage[1] = NULL;
+}
+
+static unsigned cas_add_seg ( send_seg *pSegs, unsigned n, size_t *pSkip,
+    const char *p, size_t len )
+{
+    if ( n >= CAS_SEND_SEGS || len == 0u ) {
+        return n;
+    }
+    if ( *pSkip >= len ) {
+        *pSkip -= len;
+        return n;
+    }
+    pSegs[n].p = p + *pSkip;
+    pSegs[n].n = len - *pSkip;
+    *pSkip = 0u;
+    return n + 1u;
+}
+
+/*
+ * Fill in the pieces of the send buffer and the queued large messages
+ * in the order they go on the wire, skipping the first done bytes
+ */
+static unsigned cas_send_segs ( struct client *pclient, size_t done,
+    send_seg *pSegs )
+{
+    struct send_block *pBlock =
+        (struct send_block *) ellFirst ( &pclient->sendBlocks );
+    unsigned bufStart = 0u;
+    unsigned n = 0u;
+
+    while ( n < CAS_SEND_SEGS ) {
+        unsigned bufEnd = pBlock ? pBlock->bufOffset : pclient->send.stk;
+
+        n = cas_add_seg ( pSegs, n, &done, &pclient->send.buf[bufStart],
+            bufEnd - bufStart );
+        if ( ! pBlock ) {
+            break;
+        }
+        n = cas_add_seg ( pSegs, n, &done, (const char *) pBlock->data,
+            pBlock->inlineSize );
+        n = cas_add_seg ( pSegs, n, &done, pBlock->pValue,
+            pBlock->valueSize );
+        n = cas_add_seg ( pSegs, n, &done, casPadBytes, pBlock->padSize );
+        bufStart = bufEnd;
+        pBlock = (struct send_block *) ellNext ( &pBlock->node );
+    }
+    return n;
+}
+
+static int cas_send_gather ( SOCKET sock, const send_seg *pSegs, unsigned n )
+{
+#ifdef CAS_GATHER_SEND
+    struct iovec iov[CAS_SEND_SEGS];
+    struct msghdr msg;
+    unsigned i;
+
+    for ( i = 0u; i < n; i++ ) {
+        iov[i].iov_base = (void *) pSegs[i].p;
+        iov[i].iov_len = pSegs[i].n;
+    }
+    memset ( &msg, 0, sizeof ( msg ) );
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+    return (int) sendmsg ( sock, &msg, 0 );
+#else
+    return send ( sock, pSegs[0].p, (int) pSegs[0].n, 0 );
+#endif
+}
+
 /*
  *  cas_send_bs_msg()
  *
@@ -43,14 +201,18 @@
  */
 void cas_send_bs_msg ( struct client *pclient, int lock_needed )
 {
+    size_t total, done = 0u;
     int status;
 
     if ( lock_needed ) {
         SEND_LOCK ( pclient );
     }
 
-    if ( CASDEBUG > 2 && pclient->send.stk ) {
-        errlogPrintf ( "CAS: Sending a message of %d bytes\n", pclient->send.stk );
+    total = pclient->send.stk + pclient->sendBlockBytes;
+
+    if ( CASDEBUG > 2 && total ) {
+        errlogPrintf ( "CAS: Sending a message of %lu bytes\n",
+            (unsigned long) total );
     }
 
     if ( pclient->disconnect ) {
@@ -59,26 +221,23 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
                 (int)pclient->sock, (unsigned) pclient->addr.sin_addr.s_addr );
         }
         pclient->send.stk = 0u;
+        cas_release_queued_blocks ( pclient );
         if(lock_needed)
             SEND_UNLOCK(pclient);
         return;
     }
 
-    while ( pclient->send.stk && ! pclient->disconnect ) {
-        status = send ( pclient->sock, pclient->send.buf, pclient->send.stk, 0 );
+    while ( done < total && ! pclient->disconnect ) {
+        send_seg segs[CAS_SEND_SEGS];
+        unsigned nSegs = cas_send_segs ( pclient, done, segs );
+
+        status = cas_send_gather ( pclient->sock, segs, nSegs );
         if ( status >= 0 ) {
-            unsigned transferSize = (unsigned) status;
-            if ( transferSize >= pclient->send.stk ) {
-                pclient->send.stk = 0;
+            done += (unsigned) status;
+            if ( done >= total ) {
                 epicsTimeGetCurrent ( &pclient->time_at_last_send );
                 break;
             }
-            else {
-                unsigned bytesLeft = pclient->send.stk - transferSize;
-                memmove ( pclient->send.buf, &pclient->send.buf[transferSize],
-                    bytesLeft );
-                pclient->send.stk = bytesLeft;
-            }
         }
         else {
             int causeWasSocketHangup = 0;
@@ -156,6 +315,9 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
         }
     }
 
+    pclient->send.stk = 0u;
+    cas_release_queued_blocks ( pclient );
+
     if ( lock_needed ) {
         SEND_UNLOCK(pclient);
     }
@@ -165,10 +327,123 @@ void cas_send_bs_msg ( struct client *pclient, int lock_needed )
     return;
 }
 
+static void cas_dg_send_failed ( const struct sockaddr_in *pAddr )
+{
+    char sockErrBuf[64];
+    char buf[128];
+    epicsSocketConvertErrnoToString (
+        sockErrBuf, sizeof ( sockErrBuf ) );
+    ipAddrToDottedIP ( pAddr, buf, sizeof(buf) );
+    errlogPrintf( "CAS: UDP send to %s failed: %s\n",
+        buf, sockErrBuf);
+}
+
+#if RSRV_UDP_BATCH > 1u
+
+/*
+ * Replies which cas_send_dg_msg() has finished, waiting to be sent
+ * together by cas_flush_dg_msgs()
+ */
+struct send_dg_batch {
+    unsigned            count;
+    struct mmsghdr      msgs[RSRV_UDP_BATCH];
+    struct iovec        iov[RSRV_UDP_BATCH];
+    struct sockaddr_in  addrs[RSRV_UDP_BATCH];
+    char                bufs[RSRV_UDP_BATCH][MAX_UDP_SEND];
+};
+
+int cas_enable_dg_batch ( struct client *pclient )
+{
+    struct send_dg_batch *pBatch = calloc ( 1, sizeof ( *pBatch ) );
+    unsigned i;
+
+    if ( ! pBatch ) {
+        return -1;
+    }
+    for ( i = 0u; i < RSRV_UDP_BATCH; i++ ) {
+        pBatch->iov[i].iov_base = pBatch->bufs[i];
+        pBatch->msgs[i].msg_hdr.msg_iov = &pBatch->iov[i];
+        pBatch->msgs[i].msg_hdr.msg_iovlen = 1;
+        pBatch->msgs[i].msg_hdr.msg_name = &pBatch->addrs[i];
+        pBatch->msgs[i].msg_hdr.msg_namelen = sizeof ( pBatch->addrs[i] );
+    }
+    pclient->pSendBatch = pBatch;
+    return 0;
+}
+
+void cas_disable_dg_batch ( struct client *pclient )
+{
+    free ( pclient->pSendBatch );
+    pclient->pSendBatch = NULL;
+}
+
+/*
+ * send lock must be on while in this routine
+ */
+static void cas_send_dg_batch ( struct client *pclient )
+{
+    struct send_dg_batch *pBatch = pclient->pSendBatch;
+    unsigned sent = 0u;
+
+    while ( sent < pBatch->count ) {
+        int status = sendmmsg ( pclient->sock, &pBatch->msgs[sent],
+            pBatch->count - sent, 0 );
+        if ( status > 0 ) {
+            sent += (unsigned) status;
+        }
+        else if ( status < 0 && SOCKERRNO == SOCK_EINTR ) {
+            continue;
+        }
+        else {
+            /* report and drop the reply which failed, then carry on */
+            cas_dg_send_failed ( &pBatch->addrs[sent] );
+            sent++;
+        }
+    }
+    if ( pBatch->count ) {
+        epicsTimeGetCurrent ( &pclient->time_at_last_send );
+    }
+    pBatch->count = 0u;
+}
+
+#else /* RSRV_UDP_BATCH */
+
+int cas_enable_dg_batch ( struct client *pclient )
+{
+    return -1;
+}
+
+void cas_disable_dg_batch ( struct client *pclient )
+{
+}
+
+#endif /* RSRV_UDP_BATCH */
+
+/*
+ *  cas_flush_dg_msgs()
+ *
+ *  Send the current udp message and any earlier ones still
+ *  waiting in the client's batch
+ */
+void cas_flush_dg_msgs ( struct client * pclient )
+{
+    SEND_LOCK ( pclient );
+    cas_send_dg_msg ( pclient );
+#if RSRV_UDP_BATCH > 1u
+    if ( pclient->pSendBatch ) {
+        cas_send_dg_batch ( pclient );
+    }
+#endif
+    SEND_UNLOCK ( pclient );
+}
+
 /*
  *  cas_send_dg_msg()
  *
  *  (channel access server send udp message)
+ *
+ *  If the client has a batch, the message is only queued there
+ *  and cas_flush_dg_msgs() sends it.
  */
 void cas_send_dg_msg ( struct client * pclient )
 {
@@ -201,26 +476,38 @@ void cas_send_dg_msg ( struct client * pclient )
         sizeDG -= sizeof (caHdr);
     }
 
-    status = sendto ( pclient->sock, pDG, sizeDG, 0,
-       (struct sockaddr *)&pclient->addr, sizeof(pclient->addr) );
-    if ( status >= 0 ) {
-        if ( status >= sizeDG ) {
-            epicsTimeGetCurrent ( &pclient->time_at_last_send );
+#if RSRV_UDP_BATCH > 1u
+    if ( pclient->pSendBatch ) {
+        struct send_dg_batch *pBatch = pclient->pSendBatch;
+        unsigned i;
+
+        if ( pBatch->count >= RSRV_UDP_BATCH ) {
+            cas_send_dg_batch ( pclient );
+        }
+        i = pBatch->count++;
+        memcpy ( pBatch->bufs[i], pDG, sizeDG );
+        pBatch->iov[i].iov_len = sizeDG;
+        pBatch->addrs[i] = pclient->addr;
+        pBatch->msgs[i].msg_hdr.msg_namelen = sizeof ( pBatch->addrs[i] );
+    }
+    else
+#endif
+    {
+        status = sendto ( pclient->sock, pDG, sizeDG, 0,
+           (struct sockaddr *)&pclient->addr, sizeof(pclient->addr) );
+        if ( status >= 0 ) {
+            if ( status >= sizeDG ) {
+                epicsTimeGetCurrent ( &pclient->time_at_last_send );
+            }
+            else {
+                errlogPrintf (
+                    "CAS: System failed to send entire udp frame?\n" );
+            }
         }
         else {
-            errlogPrintf (
-                "CAS: System failed to send entire udp frame?\n" );
+            cas_dg_send_failed ( &pclient->addr );
         }
     }
-    else {
-        char sockErrBuf[64];
-        char buf[128];
-        epicsSocketConvertErrnoToString (
-            sockErrBuf, sizeof ( sockErrBuf ) );
-        ipAddrToDottedIP ( &pclient->addr, buf, sizeof(buf) );
-        errlogPrintf( "CAS: UDP send to %s failed: %s\n",
-            buf, sockErrBuf);
-    }
 
     pclient->send.stk = 0u;
 
@@ -236,26 +523,11 @@ void cas_send_dg_msg ( struct client * pclient )
     return;
 }
 
-/*
- *
- *  cas_copy_in_header()
- *
- *  Allocate space in the outgoing message buffer and
- *  copy in message header. Return pointer to message body.
- *
- *  send lock must be on while in this routine
- *
- *  Returns a valid ptr to message body or NULL if the msg
- *  will not fit.
- */
-int cas_copy_in_header (
-    struct client *pclient, ca_uint16_t response, ca_uint32_t payloadSize,
-    ca_uint16_t dataType, ca_uint32_t nElem, ca_uint32_t cid,
-    ca_uint32_t responseSpecific, void **ppPayload )
+static int cas_msg_size ( struct client *pclient, ca_uint32_t payloadSize,
+    ca_uint32_t nElem, unsigned *pMsgSize, ca_uint32_t *pAlignedPayloadSize )
 {
-    unsigned    msgSize;
     ca_uint32_t alignedPayloadSize;
-    caHdr *pMsg;
+    unsigned    msgSize;
 
     if ( payloadSize > UINT_MAX - sizeof ( caHdr ) - 8u ) {
         return ECA_TOLARGE;
@@ -271,31 +543,79 @@ int cas_copy_in_header (
         msgSize += 2 * sizeof ( ca_uint32_t );
     }
 
-    if ( msgSize > pclient->send.maxstk ) {
-        casExpandSendBuffer ( pclient, msgSize );
-        if ( msgSize > pclient->send.maxstk ) {
-            return ECA_TOLARGE;
-        }
+    *pMsgSize = msgSize;
+    *pAlignedPayloadSize = alignedPayloadSize;
+    return ECA_NORMAL;
+}
+
+/*
+ * Check that a message too large for the send buffer may be queued.
+ * Queued blocks are sent first if this one would take them over the
+ * EPICS_CA_MAX_ARRAY_BYTES limit.
+ */
+static int cas_make_room_for_block ( struct client *pclient,
+    unsigned msgSize )
+{
+    size_t queueLimit = rsrvSizeofLargeBufTCP;
+
+    if ( pclient->proto != IPPROTO_TCP ) {
+        return ECA_TOLARGE;
+    }
+    if ( rsrvLargeBufFreeListTCP && msgSize > rsrvSizeofLargeBufTCP ) {
+        return ECA_TOLARGE;
     }
 
-    if ( pclient->send.stk > pclient->send.maxstk - msgSize ) {
-        if ( pclient->disconnect ) {
-            pclient->send.stk = 0;
-        }
-        else{
-            if ( pclient->proto == IPPROTO_TCP) {
-                cas_send_bs_msg ( pclient, FALSE );
-            }
-            else if ( pclient->proto == IPPROTO_UDP ) {
-                cas_send_dg_msg ( pclient );
-            }
-            else {
-                return ECA_INTERNAL;
-            }
+    if ( queueLimit < msgSize ) {
+        queueLimit = msgSize;
+    }
+    if ( pclient->sendBlockBytes &&
+            pclient->sendBlockBytes + msgSize > queueLimit ) {
+        cas_send_bs_msg ( pclient, FALSE );
+    }
+    return ECA_NORMAL;
+}
+
+/*
+ * Start a message which is too large for the send buffer in a block
+ * with space for inlineSize bytes of it.
+ */
+static int cas_begin_block ( struct client *pclient, unsigned msgSize,
+    size_t inlineSize )
+{
+    struct send_block *pBlock;
+    int status = cas_make_room_for_block ( pclient, msgSize );
+
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+
+    pBlock = pclient->pSpareBlock;
+    if ( pBlock && pBlock->capacity >= inlineSize ) {
+        pclient->pSpareBlock = NULL;
+    }
+    else {
+        pBlock = malloc ( offsetof ( struct send_block, data ) + inlineSize );
+        if ( ! pBlock ) {
+            return ECA_ALLOCMEM;
         }
+        pBlock->capacity = inlineSize;
     }
+    pBlock->bufOffset = 0u;
+    pBlock->inlineSize = 0u;
+    pBlock->metaSize = 0u;
+    pBlock->pValue = NULL;
+    pBlock->valueSize = 0u;
+    pBlock->padSize = 0u;
+    pBlock->pRelease = NULL;
+    pBlock->pPvt = NULL;
+    pclient->pSendBlock = pBlock;
+    return ECA_NORMAL;
+}
 
-    pMsg = (caHdr *) &pclient->send.buf[pclient->send.stk];
+static void * cas_fill_header ( caHdr *pMsg, ca_uint16_t response,
+    ca_uint32_t alignedPayloadSize, ca_uint16_t dataType, ca_uint32_t nElem,
+    ca_uint32_t cid, ca_uint32_t responseSpecific )
+{
     pMsg->m_cmmd = htons(response);
     pMsg->m_dataType = htons(dataType);
     pMsg->m_cid = htonl(cid);
@@ -303,8 +623,7 @@ int cas_copy_in_header (
     if (alignedPayloadSize < 0xffff && nElem < 0xffff) {
         pMsg->m_postsize = htons(((ca_uint16_t) alignedPayloadSize));
         pMsg->m_count = htons(((ca_uint16_t) nElem));
-        if (ppPayload)
-            *ppPayload = (void *) (pMsg + 1);
+        return (void *) (pMsg + 1);
     }
     else {
         ca_uint32_t *pW32 = (ca_uint32_t *) (pMsg + 1);
@@ -312,13 +631,90 @@ int cas_copy_in_header (
         pMsg->m_count = htons(0u);
         pW32[0] = htonl(alignedPayloadSize);
         pW32[1] = htonl(nElem);
-        if (ppPayload)
-            *ppPayload = (void *) (pW32 + 2);
+        return (void *) (pW32 + 2);
+    }
+}
+
+static caHdr * cas_current_header ( struct client *pClient )
+{
+    if ( pClient->pSendBlock ) {
+        return (caHdr *) pClient->pSendBlock->data;
+    }
+    return (caHdr *) &pClient->send.buf[pClient->send.stk];
+}
+
+/*
+ *
+ *  cas_copy_in_header()
+ *
+ *  Allocate space in the outgoing message buffer and
+ *  copy in message header. Return pointer to message body.
+ *  TCP messages too large for the buffer get a block of
+ *  their own, which is sent together with it.
+ *
+ *  send lock must be on while in this routine
+ *
+ *  Returns a valid ptr to message body or NULL if the msg
+ *  will not fit.
+ */
+int cas_copy_in_header (
+    struct client *pclient, ca_uint16_t response, ca_uint32_t payloadSize,
+    ca_uint16_t dataType, ca_uint32_t nElem, ca_uint32_t cid,
+    ca_uint32_t responseSpecific, void **ppPayload )
+{
+    unsigned    msgSize;
+    ca_uint32_t alignedPayloadSize;
+    caHdr *pMsg;
+    void *pPayload;
+    int status;
+
+    if ( pclient->pSendBlock ) {
+        cas_release_block ( pclient, pclient->pSendBlock );
+        pclient->pSendBlock = NULL;
+    }
+
+    status = cas_msg_size ( pclient, payloadSize, nElem,
+        &msgSize, &alignedPayloadSize );
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+
+    if ( msgSize > pclient->send.maxstk ) {
+        status = cas_begin_block ( pclient, msgSize, msgSize );
+        if ( status != ECA_NORMAL ) {
+            return status;
+        }
+        pMsg = (caHdr *) pclient->pSendBlock->data;
+    }
+    else {
+        if ( pclient->send.stk > pclient->send.maxstk - msgSize ) {
+            if ( pclient->disconnect ) {
+                pclient->send.stk = 0;
+            }
+            else{
+                if ( pclient->proto == IPPROTO_TCP) {
+                    cas_send_bs_msg ( pclient, FALSE );
+                }
+                else if ( pclient->proto == IPPROTO_UDP ) {
+                    cas_send_dg_msg ( pclient );
+                }
+                else {
+                    return ECA_INTERNAL;
+                }
+            }
+        }
+        pMsg = (caHdr *) &pclient->send.buf[pclient->send.stk];
+    }
+
+    pPayload = cas_fill_header ( pMsg, response, alignedPayloadSize,
+        dataType, nElem, cid, responseSpecific );
+    if ( ppPayload ) {
+        *ppPayload = pPayload;
     }
 
     /* zero out pad bytes */
     if ( alignedPayloadSize > payloadSize ) {
-        char *p = ( char * ) *ppPayload;
+        char *p = ( char * ) pPayload;
         memset ( p + payloadSize, '\0',
             alignedPayloadSize - payloadSize );
     }
@@ -326,15 +722,69 @@ int cas_copy_in_header (
     return ECA_NORMAL;
 }
 
+/*
+ *  cas_copy_in_header_ref()
+ *
+ *  Start a TCP message whose payload is metaSize bytes copied from
+ *  pMeta followed by the value at pValue, which is sent from where
+ *  it is. On success pRelease(pPvt) is called once pValue is no
+ *  longer needed, even if the message is never committed.
+ *
+ *  send lock must be on while in this routine
+ */
+int cas_copy_in_header_ref (
+    struct client *pclient, ca_uint16_t response, ca_uint32_t payloadSize,
+    ca_uint16_t dataType, ca_uint32_t nElem, ca_uint32_t cid,
+    ca_uint32_t responseSpecific, const void *pMeta, unsigned metaSize,
+    const void *pValue, cas_release_func *pRelease, void *pPvt )
+{
+    unsigned    msgSize;
+    ca_uint32_t alignedPayloadSize;
+    struct send_block *pBlock;
+    void *pPayload;
+    int status;
+
+    if ( pclient->pSendBlock ) {
+        cas_release_block ( pclient, pclient->pSendBlock );
+        pclient->pSendBlock = NULL;
+    }
+
+    if ( metaSize > payloadSize ) {
+        return ECA_INTERNAL;
+    }
+    status = cas_msg_size ( pclient, payloadSize, nElem,
+        &msgSize, &alignedPayloadSize );
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+
+    status = cas_begin_block ( pclient, msgSize,
+        msgSize - alignedPayloadSize + metaSize );
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+    pBlock = pclient->pSendBlock;
+
+    pPayload = cas_fill_header ( (caHdr *) pBlock->data, response,
+        alignedPayloadSize, dataType, nElem, cid, responseSpecific );
+    memcpy ( pPayload, pMeta, metaSize );
+    pBlock->metaSize = metaSize;
+    pBlock->pValue = (const char *) pValue;
+    pBlock->pRelease = pRelease;
+    pBlock->pPvt = pPvt;
+
+    return ECA_NORMAL;
+}
+
 void cas_set_header_cid ( struct client *pClient, ca_uint32_t cid )
 {
-    caHdr *pMsg = ( caHdr * ) &pClient->send.buf[pClient->send.stk];
+    caHdr *pMsg = cas_current_header ( pClient );
     pMsg->m_cid = htonl ( cid );
 }
 
 void cas_set_header_count (struct client *pClient, ca_uint32_t count)
 {
-    caHdr *pMsg = (caHdr *) &pClient->send.buf[pClient->send.stk];
+    caHdr *pMsg = cas_current_header ( pClient );
     if (pMsg->m_postsize == htons(0xffff)) {
         ca_uint32_t *pLW;
 
@@ -348,9 +798,41 @@ void cas_set_header_count (struct client *pClient, ca_uint32_t count)
     }
 }
 
+/*
+ * A committed block goes on the queue, the bytes of the send
+ * buffer before it are sent first
+ */
+static void cas_commit_block ( struct client *pClient,
+    ca_uint32_t payloadSize, ca_uint32_t msgSize )
+{
+    struct send_block *pBlock = pClient->pSendBlock;
+
+    if ( pBlock->pValue ) {
+        unsigned hdrSize = msgSize - CA_MESSAGE_ALIGN ( payloadSize );
+
+        if ( payloadSize > pBlock->metaSize ) {
+            pBlock->inlineSize = hdrSize + pBlock->metaSize;
+            pBlock->valueSize = payloadSize - pBlock->metaSize;
+        }
+        else {
+            pBlock->inlineSize = hdrSize + payloadSize;
+            pBlock->valueSize = 0u;
+        }
+        pBlock->padSize = msgSize - pBlock->inlineSize - pBlock->valueSize;
+    }
+    else {
+        pBlock->inlineSize = msgSize;
+    }
+    pBlock->bufOffset = pClient->send.stk;
+    ellAdd ( &pClient->sendBlocks, &pBlock->node );
+    pClient->sendBlockBytes += msgSize;
+    pClient->pSendBlock = NULL;
+}
+
 void cas_commit_msg ( struct client *pClient, ca_uint32_t size )
 {
-    caHdr * pMsg = ( caHdr * ) &pClient->send.buf[pClient->send.stk];
+    caHdr * pMsg = cas_current_header ( pClient );
+    ca_uint32_t payloadSize = size;
     size = CA_MESSAGE_ALIGN ( size );
     if ( pMsg->m_postsize == htons ( 0xffff ) ) {
         ca_uint32_t * pLW = ( ca_uint32_t * ) ( pMsg + 1 );
@@ -363,7 +845,180 @@ void cas_commit_msg ( struct client *pClient, ca_uint32_t size )
         pMsg->m_postsize = htons ( (ca_uint16_t) size );
         size += sizeof ( caHdr );
     }
-    pClient->send.stk += size;
+    if ( pClient->pSendBlock ) {
+        cas_commit_block ( pClient, payloadSize, size );
+    }
+    else {
+        pClient->send.stk += size;
+    }
+}
+
+/*
+ * Replies are staged after space for the largest header, so a large
+ * one can be queued as it is
+ */
+#define CAS_STAGE_HDR ( sizeof ( caHdr ) + 2 * sizeof ( ca_uint32_t ) )
+
+static struct send_block ** cas_stage_slot ( struct client *pClient )
+{
+    if ( epicsThreadPrivateGet ( rsrvCurrentClient ) == pClient ) {
+        return &pClient->pStage[0];
+    }
+    return &pClient->pStage[1];
+}
+
+/*
+ *  cas_stage_payload()
+ *
+ *  Find space for a reply body of up to payloadSize bytes which the
+ *  calling thread fills in without SEND_LOCK(), to be sent by
+ *  cas_commit_staged(). The client's receive thread and its event
+ *  task each have their own staging buffer.
+ */
+int cas_stage_payload ( struct client *pClient, ca_uint32_t payloadSize,
+    ca_uint32_t nElem, void **ppPayload )
+{
+    struct send_block **ppStage = cas_stage_slot ( pClient );
+    struct send_block *pStage = *ppStage;
+    unsigned msgSize;
+    ca_uint32_t alignedPayloadSize;
+    size_t need;
+    int status;
+
+    status = cas_msg_size ( pClient, payloadSize, nElem,
+        &msgSize, &alignedPayloadSize );
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+    if ( msgSize > pClient->send.maxstk &&
+        ( pClient->proto != IPPROTO_TCP ||
+          ( rsrvLargeBufFreeListTCP && msgSize > rsrvSizeofLargeBufTCP ) ) ) {
+        return ECA_TOLARGE;
+    }
+
+    need = CAS_STAGE_HDR + alignedPayloadSize;
+    if ( ! pStage || pStage->capacity < need ) {
+        free ( pStage );
+        if ( need < CAS_STAGE_HDR + MAX_TCP ) {
+            need = CAS_STAGE_HDR + MAX_TCP;
+        }
+        pStage = malloc ( offsetof ( struct send_block, data ) + need );
+        *ppStage = pStage;
+        if ( ! pStage ) {
+            return ECA_ALLOCMEM;
+        }
+        pStage->capacity = need;
+    }
+    *ppPayload = ( char * ) pStage->data + CAS_STAGE_HDR;
+    return ECA_NORMAL;
+}
+
+/*
+ *  cas_commit_staged()
+ *
+ *  Send the first size bytes of the reply body returned by the last
+ *  cas_stage_payload() of this thread. Bodies which fit are copied
+ *  into the send buffer. Larger ones are queued without copying, and
+ *  the thread takes the client's spare block as its staging buffer.
+ *
+ *  send lock must be on while in this routine
+ */
+int cas_commit_staged (
+    struct client *pClient, ca_uint16_t response, ca_uint16_t dataType,
+    ca_uint32_t nElem, ca_uint32_t cid, ca_uint32_t responseSpecific,
+    ca_uint32_t size )
+{
+    struct send_block **ppStage = cas_stage_slot ( pClient );
+    struct send_block *pStage = *ppStage;
+    const char *pStaged = ( const char * ) pStage->data + CAS_STAGE_HDR;
+    unsigned msgSize;
+    ca_uint32_t alignedPayloadSize;
+    void *pPayload;
+    int status;
+
+    status = cas_msg_size ( pClient, size, nElem,
+        &msgSize, &alignedPayloadSize );
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+
+    if ( msgSize <= pClient->send.maxstk ) {
+        status = cas_copy_in_header ( pClient, response, size, dataType,
+            nElem, cid, responseSpecific, &pPayload );
+        if ( status == ECA_NORMAL ) {
+            memcpy ( pPayload, pStaged, size );
+            cas_commit_msg ( pClient, size );
+        }
+        return status;
+    }
+
+    if ( pClient->pSendBlock ) {
+        cas_release_block ( pClient, pClient->pSendBlock );
+        pClient->pSendBlock = NULL;
+    }
+    status = cas_make_room_for_block ( pClient, msgSize );
+    if ( status != ECA_NORMAL ) {
+        return status;
+    }
+
+    cas_fill_header ( ( caHdr * ) pStage->data, response,
+        alignedPayloadSize, dataType, nElem, cid, responseSpecific );
+    pStage->inlineSize = msgSize - alignedPayloadSize;
+    pStage->metaSize = 0u;
+    pStage->pValue = pStaged;
+    pStage->valueSize = size;
+    pStage->padSize = alignedPayloadSize - size;
+    pStage->pRelease = NULL;
+    pStage->pPvt = NULL;
+    pStage->bufOffset = pClient->send.stk;
+    ellAdd ( &pClient->sendBlocks, &pStage->node );
+    pClient->sendBlockBytes += msgSize;
+
+    *ppStage = pClient->pSpareBlock;
+    pClient->pSpareBlock = NULL;
+    return ECA_NORMAL;
+}
+
+/*
+ * SEND_LOCK() and SEND_UNLOCK() also keep statistics of how long the
+ * lock is held and waited for, shown by casr 3
+ */
+void cas_send_lock ( struct client *pClient )
+{
+    if ( epicsMutexTryLock ( pClient->lock ) == epicsMutexLockOK ) {
+        if ( pClient->sendLockDepth++ ) {
+            return;
+        }
+        pClient->sendLockTaken = epicsMonotonicGet ();
+    }
+    else {
+        epicsUInt64 start = epicsMonotonicGet ();
+        epicsUInt64 waited;
+
+        epicsMutexMustLock ( pClient->lock );
+        pClient->sendLockDepth++;
+        pClient->sendLockTaken = epicsMonotonicGet ();
+        waited = pClient->sendLockTaken - start;
+        pClient->nSendLockWait++;
+        pClient->sendLockWaited += waited;
+        if ( waited > pClient->sendLockWaitedMax ) {
+            pClient->sendLockWaitedMax = waited;
+        }
+    }
+    pClient->nSendLock++;
+}
+
+void cas_send_unlock ( struct client *pClient )
+{
+    if ( --pClient->sendLockDepth == 0u ) {
+        epicsUInt64 held = epicsMonotonicGet () - pClient->sendLockTaken;
+
+        pClient->sendLockHeld += held;
+        if ( held > pClient->sendLockHeldMax ) {
+            pClient->sendLockHeldMax = held;
+        }
+    }
+    epicsMutexUnlock ( pClient->lock );
 }
 
 /*
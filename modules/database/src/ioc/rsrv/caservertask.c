@@ -818,6 +818,10 @@ static void log_one_client (struct client *client, unsigned level)
     ipAddrToDottedIP (&client->addr, clientIP, sizeof(clientIP));
 
     if ( client->proto == IPPROTO_UDP ) {
+        printf ( "\tSearches: %lu found, %lu not found (%lu from cache)\n",
+            client->nSearchFound,
+            client->nSearchNotFound + client->nSearchCached,
+            client->nSearchCached );
         printf ( "\tLast name requested by %s:\n",
             clientIP );
     }
@@ -858,14 +862,29 @@ static void log_one_client (struct client *client, unsigned level)
         printf(
         "\tUnprocessed request bytes = %u, Undelivered response bytes = %u\n",
             client->recv.cnt - client->recv.stk,
-            client->send.stk );
+            client->send.stk + (unsigned) client->sendBlockBytes );
         printf(
         "\tState = %s%s%s\n",
             state[client->disconnect?1:0],
-            client->send.type == mbtLargeTCP ? " jumbo-send-buf" : "",
+            client->pSpareBlock ? " jumbo-send-buf" : "",
             client->recv.type == mbtLargeTCP ? " jumbo-recv-buf" : "");
     }
 
+    /* casr 3 */
+    if ( level >= 2u && client->proto == IPPROTO_TCP && client->nSendLock ) {
+        printf(
+        "\tSend lock taken %lu times, held %.3f ms on average, %.3f ms max\n",
+            client->nSendLock,
+            client->sendLockHeld * 1e-6 / client->nSendLock,
+            client->sendLockHeldMax * 1e-6 );
+        printf(
+        "\tSend lock busy %lu times, waited %.3f ms on average, %.3f ms max\n",
+            client->nSendLockWait,
+            client->nSendLockWait ?
+                client->sendLockWaited * 1e-6 / client->nSendLockWait : 0.0,
+            client->sendLockWaitedMax * 1e-6 );
+    }
+
     if ( level >= 1u ) {
         showChanList ( client, level - 1u, & client->chanList );
         showChanList ( client, level - 1u, & client->chanPendingUpdateARList );
@@ -1060,6 +1079,7 @@ void destroy_client ( struct client *client )
     }
 
     if ( client->proto == IPPROTO_TCP ) {
+        cas_discard_send_blocks ( client );
         if ( client->send.buf ) {
             if ( client->send.type == mbtSmallTCP ) {
                 freeListFree ( rsrvSmallBufFreeListTCP,  client->send.buf );
@@ -1098,6 +1118,8 @@ void destroy_client ( struct client *client )
         if ( client->recv.buf ) {
             free ( client->recv.buf );
         }
+        rsrvSearchCacheDestroy ( client->pSearchCache );
+        cas_disable_dg_batch ( client );
     }
 
     if ( client->eventqLock ) {
@@ -1285,6 +1307,8 @@ struct client * create_client ( SOCKET sock, int proto )
         client->recv.buf = malloc ( MAX_UDP_RECV );
         client->recv.maxstk = MAX_UDP_RECV;
         client->recv.type = mbtUDP;
+        /* optional, searches just aren't cached without it */
+        client->pSearchCache = rsrvSearchCacheCreate ();
     }
     if ( ! client->send.buf || ! client->recv.buf ) {
         destroy_client ( client );
@@ -1387,11 +1411,6 @@ void casExpandBuffer ( struct message_buffer *buf, ca_uint32_t size, int sendbuf
     }
 }
 
-void casExpandSendBuffer ( struct client *pClient, ca_uint32_t size )
-{
-    casExpandBuffer (&pClient->send, size, 1);
-}
-
 void casExpandRecvBuffer ( struct client *pClient, ca_uint32_t size )
 {
     casExpandBuffer (&pClient->recv, size, 0);
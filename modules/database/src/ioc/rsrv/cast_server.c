@@ -108,6 +108,175 @@ static void clean_addrq(struct client *client)
 
 }
 
+#if RSRV_UDP_BATCH > 1u
+/*
+ * Datagrams received together by recvmmsg()
+ */
+typedef struct recv_dg_batch {
+    struct mmsghdr      msgs[RSRV_UDP_BATCH];
+    struct iovec        iov[RSRV_UDP_BATCH];
+    struct sockaddr_in  addrs[RSRV_UDP_BATCH];
+    char                *bufs[RSRV_UDP_BATCH];
+} recv_dg_batch;
+
+static recv_dg_batch * create_recv_batch ( struct client *client )
+{
+    recv_dg_batch *pBatch = calloc ( 1, sizeof ( *pBatch ) );
+    unsigned i;
+
+    if ( ! pBatch ) {
+        return NULL;
+    }
+    /* the first datagram is received into the client's own buffer */
+    pBatch->bufs[0] = client->recv.buf;
+    for ( i = 1u; i < RSRV_UDP_BATCH; i++ ) {
+        pBatch->bufs[i] = malloc ( client->recv.maxstk );
+        if ( ! pBatch->bufs[i] ) {
+            break;
+        }
+    }
+    if ( i < RSRV_UDP_BATCH ) {
+        while ( --i > 0u ) {
+            free ( pBatch->bufs[i] );
+        }
+        free ( pBatch );
+        return NULL;
+    }
+    for ( i = 0u; i < RSRV_UDP_BATCH; i++ ) {
+        pBatch->iov[i].iov_base = pBatch->bufs[i];
+        pBatch->iov[i].iov_len = client->recv.maxstk;
+        pBatch->msgs[i].msg_hdr.msg_iov = &pBatch->iov[i];
+        pBatch->msgs[i].msg_hdr.msg_iovlen = 1;
+        pBatch->msgs[i].msg_hdr.msg_name = &pBatch->addrs[i];
+    }
+    return pBatch;
+}
+
+static void destroy_recv_batch ( recv_dg_batch *pBatch )
+{
+    unsigned i;
+
+    for ( i = 1u; i < RSRV_UDP_BATCH; i++ ) {
+        free ( pBatch->bufs[i] );
+    }
+    free ( pBatch );
+}
+#endif /* RSRV_UDP_BATCH */
+
+static void recv_error ( void )
+{
+    if (SOCKERRNO != SOCK_EINTR) {
+        char sockErrBuf[64];
+        epicsSocketConvertErrnoToString (
+            sockErrBuf, sizeof ( sockErrBuf ) );
+        epicsPrintf ("CAS: UDP recv error: %s\n",
+                sockErrBuf);
+        epicsThreadSleep(1.0);
+    }
+}
+
+/*
+ * Handle one datagram, already in client->recv.buf
+ */
+static void cast_dg ( struct client *client, unsigned nbytes,
+    const struct sockaddr_in *pAddr )
+{
+    int                 status;
+    int                 count=0;
+    size_t              idx;
+
+    for(idx=0; casIgnoreAddrs[idx]; idx++)
+    {
+        if(pAddr->sin_addr.s_addr==casIgnoreAddrs[idx]) {
+            return; /* ignore */
+        }
+    }
+
+    if (casudp_ctl != ctlRun)
+        return;
+
+    client->recv.cnt = nbytes;
+    client->recv.stk = 0ul;
+    epicsTimeGetCurrent(&client->time_at_last_recv);
+
+    client->minor_version_number = CA_UKN_MINOR_VERSION;
+    client->seqNoOfReq = 0;
+
+    /*
+     * If we are talking to a new client flush to the old one
+     * in case we are holding UDP messages waiting to
+     * see if the next message is for this same client.
+     */
+    if (client->send.stk>sizeof(caHdr)) {
+        status = memcmp(&client->addr,
+            pAddr, sizeof(*pAddr));
+        if(status){
+            /*
+             * if the address is different
+             */
+            cas_send_dg_msg(client);
+            client->addr = *pAddr;
+        }
+    }
+    else {
+        client->addr = *pAddr;
+    }
+
+    if (CASDEBUG>1) {
+        char    buf[40];
+
+        ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+        errlogPrintf ("CAS: cast server msg of %d bytes from addr %s\n",
+            client->recv.cnt, buf);
+    }
+
+    if (CASDEBUG>2)
+        count = ellCount (&client->chanList);
+
+    /*
+     * A datagram often carries many search requests, process them
+     * all while holding the send lock rather than taking it for
+     * each reply.
+     */
+    SEND_LOCK ( client );
+    status = camessage ( client );
+    SEND_UNLOCK ( client );
+    if(status == RSRV_OK){
+        if(client->recv.cnt !=
+            client->recv.stk){
+            char buf[40];
+
+            ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+
+            epicsPrintf ("CAS: partial (damaged?) UDP msg of %d bytes from %s ?\n",
+                client->recv.cnt - client->recv.stk, buf);
+
+            epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
+                &client->time_at_last_recv);
+            epicsPrintf ("CAS: message received at %s\n", buf);
+        }
+    }
+    else if (CASDEBUG>0){
+        char buf[40];
+
+        ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
+
+        epicsPrintf ("CAS: invalid (damaged?) UDP request from %s ?\n", buf);
+
+        epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
+            &client->time_at_last_recv);
+        epicsPrintf ("CAS: message received at %s\n", buf);
+    }
+
+    if (CASDEBUG>2) {
+        if ( ellCount (&client->chanList) ) {
+            errlogPrintf ("CAS: Fnd %d name matches (%d tot)\n",
+                ellCount(&client->chanList)-count,
+                ellCount(&client->chanList));
+        }
+    }
+}
+
 /*
  * CAST_SERVER
  *
@@ -118,13 +287,15 @@ void cast_server(void *pParm)
 {
     rsrv_iface_config *conf = pParm;
     int                 status;
-    int                 count=0;
     int                 mysocket=0;
     struct sockaddr_in  new_recv_addr;
     osiSocklen_t        recv_addr_size;
     osiSockIoctl_t      nchars;
     SOCKET              recv_sock, reply_sock;
     struct client      *client;
+#if RSRV_UDP_BATCH > 1u
+    recv_dg_batch      *pRecvBatch;
+#endif
 
     recv_addr_size = sizeof(new_recv_addr);
 
@@ -152,6 +323,15 @@ void cast_server(void *pParm)
     }
     client->udpRecv = recv_sock;
 
+#if RSRV_UDP_BATCH > 1u
+    /* without these datagrams are just handled one at a time */
+    pRecvBatch = create_recv_batch ( client );
+    if ( pRecvBatch && cas_enable_dg_batch ( client ) ) {
+        destroy_recv_batch ( pRecvBatch );
+        pRecvBatch = NULL;
+    }
+#endif
+
     casAttachThreadToClient ( client );
 
     /*
@@ -165,107 +345,50 @@ void cast_server(void *pParm)
     epicsEventSignal(casudp_startStopEvent);
 
     while (TRUE) {
-        status = recvfrom (
-            recv_sock,
-            client->recv.buf,
-            client->recv.maxstk,
-            0,
-            (struct sockaddr *)&new_recv_addr,
-            &recv_addr_size);
-        if (status < 0) {
-            if (SOCKERRNO != SOCK_EINTR) {
-                char sockErrBuf[64];
-                epicsSocketConvertErrnoToString (
-                    sockErrBuf, sizeof ( sockErrBuf ) );
-                epicsPrintf ("CAS: UDP recv error: %s\n",
-                        sockErrBuf);
-                epicsThreadSleep(1.0);
+#if RSRV_UDP_BATCH > 1u
+        if ( pRecvBatch ) {
+            char *pRecvBuf = client->recv.buf;
+            unsigned i;
+
+            for ( i = 0u; i < RSRV_UDP_BATCH; i++ ) {
+                pRecvBatch->msgs[i].msg_hdr.msg_namelen =
+                    sizeof ( pRecvBatch->addrs[i] );
             }
-
-        } else {
-            size_t idx;
-            for(idx=0; casIgnoreAddrs[idx]; idx++)
-            {
-                if(new_recv_addr.sin_addr.s_addr==casIgnoreAddrs[idx]) {
-                    status = -1; /* ignore */
-                    break;
-                }
+            status = recvmmsg ( recv_sock, pRecvBatch->msgs,
+                RSRV_UDP_BATCH, MSG_WAITFORONE, NULL );
+            if ( status < 0 && SOCKERRNO == ENOSYS ) {
+                /* kernel without recvmmsg(), fall back for good */
+                destroy_recv_batch ( pRecvBatch );
+                pRecvBatch = NULL;
+                cas_flush_dg_msgs ( client );
+                cas_disable_dg_batch ( client );
+                continue;
             }
-        }
-
-        if (status >= 0 && casudp_ctl == ctlRun) {
-            client->recv.cnt = (unsigned) status;
-            client->recv.stk = 0ul;
-            epicsTimeGetCurrent(&client->time_at_last_recv);
-
-            client->minor_version_number = CA_UKN_MINOR_VERSION;
-            client->seqNoOfReq = 0;
-
-            /*
-             * If we are talking to a new client flush to the old one
-             * in case we are holding UDP messages waiting to
-             * see if the next message is for this same client.
-             */
-            if (client->send.stk>sizeof(caHdr)) {
-                status = memcmp(&client->addr,
-                    &new_recv_addr, recv_addr_size);
-                if(status){
-                    /*
-                     * if the address is different
-                     */
-                    cas_send_dg_msg(client);
-                    client->addr = new_recv_addr;
-                }
+            if ( status < 0 ) {
+                recv_error ();
             }
-            else {
-                client->addr = new_recv_addr;
+            for ( i = 0u; (int) i < status; i++ ) {
+                client->recv.buf = pRecvBatch->bufs[i];
+                cast_dg ( client, pRecvBatch->msgs[i].msg_len,
+                    &pRecvBatch->addrs[i] );
             }
-
-            if (CASDEBUG>1) {
-                char    buf[40];
-
-                ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-                errlogPrintf ("CAS: cast server msg of %d bytes from addr %s\n",
-                    client->recv.cnt, buf);
-            }
-
-            if (CASDEBUG>2)
-                count = ellCount (&client->chanList);
-
-            status = camessage ( client );
-            if(status == RSRV_OK){
-                if(client->recv.cnt !=
-                    client->recv.stk){
-                    char buf[40];
-
-                    ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-
-                    epicsPrintf ("CAS: partial (damaged?) UDP msg of %d bytes from %s ?\n",
-                        client->recv.cnt - client->recv.stk, buf);
-
-                    epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
-                        &client->time_at_last_recv);
-                    epicsPrintf ("CAS: message received at %s\n", buf);
-                }
-            }
-            else if (CASDEBUG>0){
-                char buf[40];
-
-                ipAddrToDottedIP (&client->addr, buf, sizeof(buf));
-
-                epicsPrintf ("CAS: invalid (damaged?) UDP request from %s ?\n", buf);
-
-                epicsTimeToStrftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S",
-                    &client->time_at_last_recv);
-                epicsPrintf ("CAS: message received at %s\n", buf);
+            client->recv.buf = pRecvBuf;
+        }
+        else
+#endif
+        {
+            status = recvfrom (
+                recv_sock,
+                client->recv.buf,
+                client->recv.maxstk,
+                0,
+                (struct sockaddr *)&new_recv_addr,
+                &recv_addr_size);
+            if (status < 0) {
+                recv_error ();
             }
-
-            if (CASDEBUG>2) {
-                if ( ellCount (&client->chanList) ) {
-                    errlogPrintf ("CAS: Fnd %d name matches (%d tot)\n",
-                        ellCount(&client->chanList)-count,
-                        ellCount(&client->chanList));
-                }
+            else {
+                cast_dg ( client, (unsigned) status, &new_recv_addr );
             }
         }
 
@@ -276,17 +399,22 @@ void cast_server(void *pParm)
         status = socket_ioctl(recv_sock, FIONREAD, &nchars);
         if (status<0) {
             errlogPrintf ("CA cast server: Unable to fetch N characters pending\n");
-            cas_send_dg_msg (client);
+            cas_flush_dg_msgs (client);
             clean_addrq (client);
         }
         else if (nchars == 0) {
-            cas_send_dg_msg (client);
+            cas_flush_dg_msgs (client);
             clean_addrq (client);
         }
     }
 
     /* ATM never reached, just a placeholder */
 
+#if RSRV_UDP_BATCH > 1u
+    if ( pRecvBatch ) {
+        destroy_recv_batch ( pRecvBatch );
+    }
+#endif
     if(!mysocket)
         client->sock = INVALID_SOCKET; /* only one cast_server should destroy the reply socket */
     destroy_client(client);
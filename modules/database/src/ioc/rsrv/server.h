@@ -74,6 +74,17 @@ struct message_buffer {
 
 extern epicsThreadPrivateId rsrvCurrentClient;
 
+/*
+ * Linux can receive and send many UDP datagrams in one system call
+ * (recvmmsg() and sendmmsg()), the name server uses this to handle
+ * bursts of searches. Elsewhere datagrams are handled one at a time.
+ */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#  define RSRV_UDP_BATCH 16u
+#else
+#  define RSRV_UDP_BATCH 1u
+#endif
+
 typedef struct client {
   ELLNODE               node;
   /*! guarded by SEND_LOCK()  aka. client::lock */
@@ -102,6 +113,30 @@ typedef struct client {
   unsigned              recvBytesToDrain;
   unsigned              priority;
   char                  disconnect; /* disconnect detected */
+  /* UDP only, accessed by the cast_server thread w/o locks */
+  struct search_cache   *pSearchCache;
+  unsigned long         nSearchFound;
+  unsigned long         nSearchNotFound;
+  unsigned long         nSearchCached; /* not found, from pSearchCache */
+  struct send_dg_batch  *pSendBatch; /* replies not yet sent, may be NULL */
+  /* TCP only, guarded by SEND_LOCK(). Messages too large for send.buf
+   * are queued here and sent with it by one gather write */
+  ELLLIST               sendBlocks;
+  struct send_block     *pSendBlock; /* message not yet committed */
+  struct send_block     *pSpareBlock; /* reused for the next message */
+  size_t                sendBlockBytes; /* queued in sendBlocks */
+  /* TCP only, replies built without SEND_LOCK() by the receive
+   * thread [0] and the event task [1], cf. cas_stage_payload() */
+  struct send_block     *pStage[2];
+  /* SEND_LOCK() statistics, guarded by it, times in ns */
+  unsigned              sendLockDepth;
+  epicsUInt64           sendLockTaken;
+  unsigned long         nSendLock;
+  unsigned long         nSendLockWait;  /* found it held */
+  epicsUInt64           sendLockHeld;
+  epicsUInt64           sendLockHeldMax;
+  epicsUInt64           sendLockWaited;
+  epicsUInt64           sendLockWaitedMax;
 } client;
 
 /* Channel state shows which struct client list a
@@ -218,8 +253,8 @@ GLBLTYPE unsigned int       threadPrios[5];
 
 #define CAS_HASH_TABLE_SIZE 4096
 
-#define SEND_LOCK(CLIENT) epicsMutexMustLock((CLIENT)->lock)
-#define SEND_UNLOCK(CLIENT) epicsMutexUnlock((CLIENT)->lock)
+#define SEND_LOCK(CLIENT) cas_send_lock(CLIENT)
+#define SEND_UNLOCK(CLIENT) cas_send_unlock(CLIENT)
 
 #define LOCK_CLIENTQ    epicsMutexMustLock (clientQlock);
 #define UNLOCK_CLIENTQ  epicsMutexUnlock (clientQlock);
@@ -231,6 +266,9 @@ extern "C" {
 void camsgtask (void *client);
 void cas_send_bs_msg ( struct client *pclient, int lock_needed );
 void cas_send_dg_msg ( struct client *pclient );
+void cas_flush_dg_msgs ( struct client *pclient );
+int cas_enable_dg_batch ( struct client *pclient );
+void cas_disable_dg_batch ( struct client *pclient );
 void rsrv_online_notify_task (void *);
 void cast_server (void *);
 struct client *create_client ( SOCKET sock, int proto );
@@ -239,6 +277,8 @@ struct client *create_tcp_client ( SOCKET sock, const osiSockAddr* peerAddr );
 void destroy_tcp_client ( struct client * );
 void casAttachThreadToClient ( struct client * );
 int camessage ( struct client *client );
+struct search_cache *rsrvSearchCacheCreate ( void );
+void rsrvSearchCacheDestroy ( struct search_cache * );
 void rsrv_extra_labor ( void * pArg );
 int rsrvCheckPut ( const struct channel_in_use *pciu );
 int rsrv_version_reply ( struct client *client );
@@ -255,14 +295,28 @@ void casExpandRecvBuffer ( struct client *pClient, ca_uint32_t size );
 /*
  * outgoing protocol maintenance
  */
-void casExpandSendBuffer ( struct client *pClient, ca_uint32_t size );
+typedef void cas_release_func ( void *pPvt );
 int cas_copy_in_header (
     struct client *pClient, ca_uint16_t response, ca_uint32_t payloadSize,
     ca_uint16_t dataType, ca_uint32_t nElem, ca_uint32_t cid,
     ca_uint32_t responseSpecific, void **pPayload );
+int cas_copy_in_header_ref (
+    struct client *pClient, ca_uint16_t response, ca_uint32_t payloadSize,
+    ca_uint16_t dataType, ca_uint32_t nElem, ca_uint32_t cid,
+    ca_uint32_t responseSpecific, const void *pMeta, unsigned metaSize,
+    const void *pValue, cas_release_func *pRelease, void *pPvt );
+void cas_discard_send_blocks ( struct client *pClient );
 void cas_set_header_cid ( struct client *pClient, ca_uint32_t );
 void cas_set_header_count (struct client *pClient, ca_uint32_t count);
 void cas_commit_msg ( struct client *pClient, ca_uint32_t size );
+int cas_stage_payload ( struct client *pClient, ca_uint32_t payloadSize,
+    ca_uint32_t nElem, void **ppPayload );
+int cas_commit_staged (
+    struct client *pClient, ca_uint16_t response, ca_uint16_t dataType,
+    ca_uint32_t nElem, ca_uint32_t cid, ca_uint32_t responseSpecific,
+    ca_uint32_t size );
+void cas_send_lock ( struct client *pClient );
+void cas_send_unlock ( struct client *pClient );
 
 #ifdef __cplusplus
 }
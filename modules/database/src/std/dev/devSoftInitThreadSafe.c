@@ -0,0 +1,37 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Declare the soft device supports whose init_record() only touches
+ * the record being initialized, so iocInit may call it from several
+ * threads at once. The asynchronous ones are not included.
+ */
+
+#include "dbDefs.h"
+#include "iocInit.h"
+#include "epicsExport.h"
+
+static const char * const threadSafeDevSup[] = {
+    "devAiSoft", "devAiSoftRaw",
+    "devAoSoft", "devAoSoftRaw",
+    "devBiSoft", "devBiSoftRaw",
+    "devBoSoft", "devBoSoftRaw",
+    "devCalcoutSoft",
+    "devI64inSoft", "devI64outSoft",
+    "devLiSoft", "devLoSoft",
+    "devMbbiSoft", "devMbbiSoftRaw",
+    "devMbboSoft", "devMbboSoftRaw",
+    "devSiSoft", "devSoSoft"
+};
+
+static void devSoftInitThreadSafe(void)
+{
+    int i;
+
+    for (i = 0; i < NELEMENTS(threadSafeDevSup); i++)
+        iocInitDeviceThreadSafe(threadSafeDevSup[i]);
+}
+epicsExportRegistrar(devSoftInitThreadSafe);
@@ -0,0 +1,477 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Statistics filter: reduces the values of a window of updates, each
+ *  a scalar or an array, to their mean, RMS, standard deviation,
+ *  minimum or maximum, which is posted once the window is complete.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "alarm.h"
+#include "errlog.h"
+#include "freeList.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "db_field_log.h"
+#include "epicsMath.h"
+#include "epicsTime.h"
+#include "chfPlugin.h"
+#include "epicsExport.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define STATS_SSE2
+#  include <emmintrin.h>
+#endif
+
+typedef enum statsType {
+    statsMean=0,
+    statsRms=1,
+    statsStd=2,
+    statsMin=3,
+    statsMax=4
+} statsType;
+
+static const
+chfPluginEnumType typeEnum[] = {
+    {"mean", statsMean},
+    {"rms", statsRms},
+    {"std", statsStd},
+    {"min", statsMin},
+    {"max", statsMax},
+    {NULL, 0}
+};
+
+/* Welford's running mean and sum of squared differences from it */
+typedef struct accum {
+    double count;           /* of values */
+    double mean;
+    double m2;
+    double min;             /* of the values which aren't NaN */
+    double max;
+} accum;
+
+typedef struct myStruct {
+    statsType type;
+    epicsInt32 n;           /* updates in each window */
+    double t;               /* or seconds in each window */
+    epicsInt32 i;           /* updates in this window */
+    epicsTimeStamp start;   /* of the first one */
+    epicsTimeStamp last;
+    epicsUInt16 stat;       /* most severe alarm */
+    epicsUInt16 sevr;
+    accum acc;
+    double *buf;            /* the record's array as doubles */
+    long nbuf;
+    int nomem;              /* buf couldn't be allocated, reported */
+} myStruct;
+
+static void *myStructFreeList;
+
+static const
+chfPluginArgDef opts[] = {
+    chfEnum  (myStruct, type, "s", 0, 1, typeEnum),
+    chfInt32 (myStruct, n,    "n", 0, 0),
+    chfDouble(myStruct, t,    "t", 0, 1),
+    chfPluginArgEnd
+};
+
+static void accumReset(accum *pa)
+{
+    pa->count = 0;
+    pa->mean = 0;
+    pa->m2 = 0;
+    pa->min = HUGE_VAL;
+    pa->max = -HUGE_VAL;
+}
+
+/* Add the values counted in pb to pa (Chan et al.) */
+static void accumMerge(accum *pa, const accum *pb)
+{
+    double count = pa->count + pb->count;
+    double delta = pb->mean - pa->mean;
+
+    if (pb->count == 0)
+        return;
+    if (pa->count == 0) {
+        pa->mean = pb->mean;
+        pa->m2 = pb->m2;
+    }
+    else {
+        pa->mean += delta * (pb->count / count);
+        pa->m2 += pb->m2 + delta * delta * (pa->count * pb->count / count);
+    }
+    pa->count = count;
+    if (pb->min < pa->min)
+        pa->min = pb->min;
+    if (pb->max > pa->max)
+        pa->max = pb->max;
+}
+
+/*
+ * NaN values are left out of the minimum and maximum, but make the
+ * other statistics NaN. The double kernel keeps a running mean in each
+ * of several SIMD lanes and merges them, so its results may differ in
+ * the last bits from adding the values in order.
+ */
+
+static void accumDouble(accum *pa, const epicsFloat64 *p, long n)
+{
+    accum b;
+    long i = 0;
+
+    accumReset(&b);
+#ifdef STATS_SSE2
+    if (n >= 8) {
+        __m128d m0 = _mm_setzero_pd(), m1 = m0, q0 = m0, q1 = m0;
+        __m128d l0 = _mm_set1_pd(b.min), l1 = l0;
+        __m128d h0 = _mm_set1_pd(b.max), h1 = h0;
+        double means[4], m2s[4], lanes[2];
+        double k = 0;
+        accum lane;
+        int j;
+
+        for (; i + 4 <= n; i += 4) {
+            __m128d a = _mm_loadu_pd(p + i);
+            __m128d c = _mm_loadu_pd(p + i + 2);
+            /* every lane has seen the same number of values */
+            __m128d r = _mm_set1_pd(1 / ++k);
+            __m128d da = _mm_sub_pd(a, m0);
+            __m128d dc = _mm_sub_pd(c, m1);
+
+            m0 = _mm_add_pd(m0, _mm_mul_pd(da, r));
+            m1 = _mm_add_pd(m1, _mm_mul_pd(dc, r));
+            q0 = _mm_add_pd(q0, _mm_mul_pd(da, _mm_sub_pd(a, m0)));
+            q1 = _mm_add_pd(q1, _mm_mul_pd(dc, _mm_sub_pd(c, m1)));
+            /* the second operand is returned if either is a NaN */
+            l0 = _mm_min_pd(a, l0);
+            l1 = _mm_min_pd(c, l1);
+            h0 = _mm_max_pd(a, h0);
+            h1 = _mm_max_pd(c, h1);
+        }
+        _mm_storeu_pd(means, m0);
+        _mm_storeu_pd(means + 2, m1);
+        _mm_storeu_pd(m2s, q0);
+        _mm_storeu_pd(m2s + 2, q1);
+        lane.count = k;
+        lane.min = HUGE_VAL;
+        lane.max = -HUGE_VAL;
+        for (j = 0; j < 4; j++) {
+            lane.mean = means[j];
+            lane.m2 = m2s[j];
+            accumMerge(&b, &lane);
+        }
+        _mm_storeu_pd(lanes, _mm_min_pd(l0, l1));
+        b.min = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+        _mm_storeu_pd(lanes, _mm_max_pd(h0, h1));
+        b.max = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    }
+#endif
+    for (; i < n; i++) {
+        double v = p[i];
+        double delta = v - b.mean;
+
+        b.count++;
+        b.mean += delta / b.count;
+        b.m2 += delta * (v - b.mean);
+        if (v < b.min)
+            b.min = v;
+        if (v > b.max)
+            b.max = v;
+    }
+    accumMerge(pa, &b);
+}
+
+#define ACCUM(T) \
+static void accum##T(accum *pa, const T *p, long n) \
+{ \
+    accum b; \
+    long i; \
+ \
+    accumReset(&b); \
+    for (i = 0; i < n; i++) { \
+        double v = p[i]; \
+        double delta = v - b.mean; \
+ \
+        b.count++; \
+        b.mean += delta / b.count; \
+        b.m2 += delta * (v - b.mean); \
+        if (v < b.min) \
+            b.min = v; \
+        if (v > b.max) \
+            b.max = v; \
+    } \
+    accumMerge(pa, &b); \
+}
+
+ACCUM(epicsInt8)
+ACCUM(epicsUInt8)
+ACCUM(epicsInt16)
+ACCUM(epicsUInt16)
+ACCUM(epicsInt32)
+ACCUM(epicsUInt32)
+ACCUM(epicsInt64)
+ACCUM(epicsUInt64)
+ACCUM(epicsFloat32)
+
+static void accumulate(accum *pa, short field_type, const void *p, long n)
+{
+    switch (field_type) {
+    case DBF_CHAR:   accumepicsInt8(pa, p, n);    break;
+    case DBF_UCHAR:  accumepicsUInt8(pa, p, n);   break;
+    case DBF_SHORT:  accumepicsInt16(pa, p, n);   break;
+    case DBF_USHORT: accumepicsUInt16(pa, p, n);  break;
+    case DBF_LONG:   accumepicsInt32(pa, p, n);   break;
+    case DBF_ULONG:  accumepicsUInt32(pa, p, n);  break;
+    case DBF_INT64:  accumepicsInt64(pa, p, n);   break;
+    case DBF_UINT64: accumepicsUInt64(pa, p, n);  break;
+    case DBF_FLOAT:  accumepicsFloat32(pa, p, n); break;
+    case DBF_DOUBLE: accumDouble(pa, p, n);       break;
+    }
+}
+
+static double result(const accum *pa, statsType type)
+{
+    double var;
+
+    if (pa->count == 0)
+        return epicsNAN;
+
+    switch (type) {
+    case statsMean:
+        return pa->mean;
+    case statsRms:
+        return sqrt(pa->mean * pa->mean + pa->m2 / pa->count);
+    case statsStd:
+        var = pa->m2 / pa->count;
+        return var < 0 ? 0 : sqrt(var);
+    /* NaN if every value was NaN */
+    case statsMin:
+        return pa->min <= pa->max ? pa->min : epicsNAN;
+    case statsMax:
+        return pa->min <= pa->max ? pa->max : epicsNAN;
+    }
+    return epicsNAN;
+}
+
+static void * allocPvt(void)
+{
+    myStruct *my = (myStruct*) freeListCalloc(myStructFreeList);
+    if (!my) return NULL;
+
+    my->type = statsMean;
+    accumReset(&my->acc);
+    return (void *) my;
+}
+
+static void freePvt(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    free(my->buf);
+    freeListFree(myStructFreeList, pvt);
+}
+
+static int parse_ok(void *pvt)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* A window is either n updates or t seconds long */
+    if (my->n < 0 || my->t < 0 || (my->n > 0 && my->t > 0))
+        return -1;
+    if (my->t == 0 && my->n == 0)
+        my->n = 1;
+    return 0;
+}
+
+/* Add the update's values to pa, reading the record for a rec log */
+static void addLog(myStruct *my, dbChannel *chan, db_field_log *pfl,
+    accum *pa)
+{
+    if (pfl->type == dbfl_type_rec) {
+        dbCommon *prec = dbChannelRecord(chan);
+        long n = my->nbuf;
+        long status;
+
+        /* Only needed once the record has to be read */
+        if (!my->buf) {
+            my->buf = malloc(my->nbuf * sizeof(double));
+            if (!my->buf && !my->nomem)
+                errlogPrintf("stats: Can't allocate %ld values for '%s'\n",
+                    my->nbuf, dbChannelName(chan));
+            my->nomem = !my->buf;
+        }
+
+        dbScanLock(prec);
+        pfl->stat = prec->stat;
+        pfl->sevr = prec->sevr;
+        pfl->time = prec->time;
+        if (!my->buf)
+            status = S_db_noMemory;
+        else
+            status = dbChannelGet(chan, DBR_DOUBLE, my->buf, NULL, &n, NULL);
+        dbScanUnlock(prec);
+        if (status) {
+            /* no value, which the result shows as an invalid alarm */
+            pfl->stat = READ_ALARM;
+            pfl->sevr = INVALID_ALARM;
+            return;
+        }
+        accumDouble(pa, my->buf, n);
+    }
+    else if (pfl->type == dbfl_type_val) {
+        accumulate(pa, pfl->field_type, &pfl->u.v.field, 1);
+    }
+    else if (pfl->u.r.field) {
+        accumulate(pa, pfl->field_type, pfl->u.r.field, pfl->no_elements);
+    }
+}
+
+/* Replace the update's value with a statistic */
+static void setValue(db_field_log *pfl, double value)
+{
+    if (pfl->type == dbfl_type_ref && pfl->u.r.dtor)
+        pfl->u.r.dtor(pfl);
+    pfl->type = dbfl_type_val;
+    pfl->field_type = DBF_DOUBLE;
+    pfl->field_size = sizeof(epicsFloat64);
+    pfl->no_elements = 1;
+    pfl->u.v.field.dbf_double = value;
+}
+
+static db_field_log* filter(void* pvt, dbChannel *chan, db_field_log *pfl)
+{
+    myStruct *my = (myStruct*) pvt;
+    accum acc;
+    double value = 0;
+    epicsTimeStamp time;
+    epicsUInt16 stat = 0, sevr = 0;
+    int done = 0;
+
+    accumReset(&acc);
+    addLog(my, chan, pfl, &acc);
+
+    /* A read gets the statistic of the current value alone */
+    if (pfl->ctx == dbfl_context_read) {
+        setValue(pfl, result(&acc, my->type));
+        return pfl;
+    }
+
+    /* The first update at or after the end of a time window is the
+     * start of the next one */
+    if (my->t > 0 && my->i > 0) {
+        double dt = epicsTimeDiffInSeconds(&pfl->time, &my->start);
+
+        if (dt >= my->t || dt < 0) {
+            value = result(&my->acc, my->type);
+            time = my->last;
+            stat = my->stat;
+            sevr = my->sevr;
+            done = 1;
+            my->i = 0;
+            accumReset(&my->acc);
+        }
+    }
+
+    if (my->i++ == 0) {
+        my->start = pfl->time;
+        my->stat = pfl->stat;
+        my->sevr = pfl->sevr;
+    }
+    else if (pfl->sevr > my->sevr) {
+        my->stat = pfl->stat;
+        my->sevr = pfl->sevr;
+    }
+    my->last = pfl->time;
+    accumMerge(&my->acc, &acc);
+
+    if (my->n > 0 && my->i >= my->n) {
+        value = result(&my->acc, my->type);
+        time = my->last;
+        stat = my->stat;
+        sevr = my->sevr;
+        done = 1;
+        my->i = 0;
+        accumReset(&my->acc);
+    }
+
+    if (!done) {
+        db_delete_field_log(pfl);
+        return NULL;
+    }
+    setValue(pfl, value);
+    pfl->time = time;
+    pfl->stat = stat;
+    pfl->sevr = sevr;
+    return pfl;
+}
+
+static void channelRegisterPre(dbChannel *chan, void *pvt,
+    chPostEventFunc **cb_out, void **arg_out, db_field_log *probe)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    /* numeric data only */
+    if (probe->field_type < DBF_CHAR || probe->field_type > DBF_DOUBLE)
+        return;
+
+    /* buf is allocated when the record is first read */
+    my->nbuf = dbChannelElements(chan);
+    if (my->nbuf < 1)
+        my->nbuf = 1;
+
+    probe->field_type = DBF_DOUBLE;
+    probe->field_size = sizeof(epicsFloat64);
+    probe->no_elements = 1;
+    *cb_out = filter;
+    *arg_out = pvt;
+}
+
+static void channel_report(dbChannel *chan, void *pvt, int level,
+    const unsigned short indent)
+{
+    myStruct *my = (myStruct*) pvt;
+
+    printf("%*sStatistics (stats): s=%s, ", indent, "",
+           chfPluginEnumString(typeEnum, my->type, "n/a"));
+    if (my->t > 0)
+        printf("t=%g, i=%d\n", my->t, my->i);
+    else
+        printf("n=%d, i=%d\n", my->n, my->i);
+}
+
+static chfPluginIf pif = {
+    allocPvt,
+    freePvt,
+
+    NULL, /* parse_error, */
+    parse_ok,
+
+    NULL, /* channel_open, */
+    channelRegisterPre,
+    NULL, /* channelRegisterPost, */
+    channel_report,
+    NULL /* channel_close */
+};
+
+static void statsInitialize(void)
+{
+    static int firstTime = 1;
+
+    if (!firstTime) return;
+    firstTime = 0;
+
+    if (!myStructFreeList)
+        freeListInitPvt(&myStructFreeList, sizeof(myStruct), 64);
+
+    chfPluginRegister("stats", &pif, opts);
+}
+
+epicsExportRegistrar(statsInitialize);
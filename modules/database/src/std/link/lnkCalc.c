@@ -60,6 +60,9 @@ typedef struct calc_link {
     char *post_expr;
     char *post_major;
     char *post_minor;
+    calcCompiled *comp_expr;
+    calcCompiled *comp_major;
+    calcCompiled *comp_minor;
     char *units;
     short tinp;
     struct link inp[CALCPERFORM_NARGS];
@@ -114,6 +117,9 @@ static void lnkCalc_free(jlink *pjlink)
     free(clink->post_expr);
     free(clink->post_major);
     free(clink->post_minor);
+    calcCompiledFree(clink->comp_expr);
+    calcCompiledFree(clink->comp_major);
+    calcCompiledFree(clink->comp_minor);
     free(clink->units);
     free(clink);
 }
@@ -167,6 +173,7 @@ static jlif_result lnkCalc_string(jlink *pjlink, const char *val, size_t len)
 {
     calc_link *clink = CONTAINER(pjlink, struct calc_link, jlink);
     char *inbuf, *postbuf;
+    calcCompiled **ppcompiled;
     short err;
 
     if (clink->pstate == ps_units) {
@@ -208,14 +215,17 @@ static jlif_result lnkCalc_string(jlink *pjlink, const char *val, size_t len)
     if (clink->pstate == ps_major) {
         clink->major = inbuf;
         clink->post_major = postbuf;
+        ppcompiled = &clink->comp_major;
     }
     else if (clink->pstate == ps_minor) {
         clink->minor = inbuf;
         clink->post_minor = postbuf;
+        ppcompiled = &clink->comp_minor;
     }
     else {
         clink->expr = inbuf;
         clink->post_expr = postbuf;
+        ppcompiled = &clink->comp_expr;
     }
 
     if (postfix(inbuf, postbuf, &err) < 0) {
@@ -223,6 +233,7 @@ static jlif_result lnkCalc_string(jlink *pjlink, const char *val, size_t len)
             calcErrorStr(err));
         return jlif_stop;
     }
+    *ppcompiled = calcCompile(postbuf);
 
     return jlif_continue;
 }
@@ -486,6 +497,9 @@ static void lnkCalc_remove(struct dbLocker *locker, struct link *plink)
     free(clink->post_expr);
     free(clink->post_major);
     free(clink->post_minor);
+    calcCompiledFree(clink->comp_expr);
+    calcCompiledFree(clink->comp_major);
+    calcCompiledFree(clink->comp_minor);
     free(clink->units);
     free(clink);
     plink->value.json.jlink = NULL;
@@ -546,6 +560,15 @@ static long readLocked(struct link *pinp, void *vvt)
     return status;
 }
 
+/* Evaluate an expression, compiled if that was possible */
+static long linkCalcPerform(const calcCompiled *pcompiled,
+    const char *ppostfix, double *parg, double *presult)
+{
+    if (pcompiled)
+        return calcPerformCompiled(parg, presult, pcompiled);
+    return calcPerform(parg, presult, ppostfix);
+}
+
 static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     long *pnRequest)
 {
@@ -585,7 +608,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     clink->sevr = 0;
 
     if (clink->post_expr) {
-        status = calcPerform(clink->arg, &clink->val, clink->post_expr);
+        status = linkCalcPerform(clink->comp_expr, clink->post_expr,
+            clink->arg, &clink->val);
         if (!status)
             status = conv(&clink->val, pbuffer, NULL);
         if (!status && pnRequest)
@@ -600,7 +624,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if (!status && clink->post_major) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_major);
+        status = linkCalcPerform(clink->comp_major, clink->post_major,
+            clink->arg, &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MAJOR_ALARM;
@@ -611,7 +636,8 @@ static long lnkCalc_getValue(struct link *plink, short dbrType, void *pbuffer,
     if (!status && !clink->sevr && clink->post_minor) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_minor);
+        status = linkCalcPerform(clink->comp_minor, clink->post_minor,
+            clink->arg, &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MINOR_ALARM;
@@ -664,12 +690,14 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     status = conv(pbuffer, &clink->val, NULL);
 
     if (!status && clink->post_expr)
-        status = calcPerform(clink->arg, &clink->val, clink->post_expr);
+        status = linkCalcPerform(clink->comp_expr, clink->post_expr,
+            clink->arg, &clink->val);
 
     if (!status && clink->post_major) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_major);
+        status = linkCalcPerform(clink->comp_major, clink->post_major,
+            clink->arg, &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MAJOR_ALARM;
@@ -680,7 +708,8 @@ static long lnkCalc_putValue(struct link *plink, short dbrType,
     if (!status && !clink->sevr && clink->post_minor) {
         double alval = clink->val;
 
-        status = calcPerform(clink->arg, &alval, clink->post_minor);
+        status = linkCalcPerform(clink->comp_minor, clink->post_minor,
+            clink->arg, &alval);
         if (!status && alval) {
             clink->stat = LINK_ALARM;
             clink->sevr = MINOR_ALARM;
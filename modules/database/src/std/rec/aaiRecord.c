@@ -34,6 +34,7 @@
 #include "alarm.h"
 #include "callback.h"
 #include "dbAccess.h"
+#include "dbArrayBuf.h"
 #include "dbEvent.h"
 #include "dbFldTypes.h"
 #include "dbScan.h"
@@ -41,7 +42,6 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
-#include "cantProceed.h"
 #include "special.h"
 #include "menuYesNo.h"
 
@@ -112,6 +112,10 @@ static long init_record(struct dbCommon *pcommon, int pass)
             prec->ftvl = DBF_UCHAR;
         prec->nord = (prec->nelm == 1);
 
+        prec->rpvt = dbArrayBufPoolCreate(
+            (size_t) prec->nelm * dbValueSize(prec->ftvl));
+        prec->bptr = dbArrayBufCurrent(prec->rpvt);
+
         /* we must call pdset->init_record in pass 0
            because it may set prec->bptr which must
            not change after links are established before pass 1
@@ -124,10 +128,10 @@ static long init_record(struct dbCommon *pcommon, int pass)
             if (status)
                 return status;
         }
-        if (!prec->bptr) {
-            /* device support did not allocate memory so we must do it */
-            prec->bptr = callocMustSucceed(prec->nelm, dbValueSize(prec->ftvl),
-                "aai: buffer calloc failed");
+        if (prec->bptr != dbArrayBufCurrent(prec->rpvt)) {
+            /* device support provides the buffer, we can't share it */
+            dbArrayBufPoolDestroy(prec->rpvt);
+            prec->rpvt = NULL;
         }
         return 0;
     }
@@ -155,6 +159,11 @@ static long process(struct dbCommon *pcommon)
         return S_dev_missingSup;
     }
 
+    /* Monitors may still be sending the previous value */
+    if (!pact)
+        prec->bptr = dbArrayBufWritable(prec->rpvt, prec->bptr,
+            prec->nord * dbValueSize(prec->ftvl));
+
     status = readValue(prec); /* read the new value */
     if (!pact && prec->pact)
         return 0;
@@ -208,6 +217,10 @@ static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
 {
     aaiRecord *prec = (aaiRecord *)paddr->precord;
 
+    /* dbPut() writes to the buffer returned here, a read uses it as is */
+    if (dbArrayBufPutting())
+        prec->bptr = dbArrayBufWritable(prec->rpvt, prec->bptr,
+            prec->nord * dbValueSize(prec->ftvl));
     paddr->pfield = prec->bptr;
     *no_elements =  prec->nord;
     *offset = 0;
@@ -326,7 +339,8 @@ static void monitor(aaiRecord *prec)
     }
 
     if (monitor_mask)
-        db_post_events(prec, &prec->val, monitor_mask);
+        db_post_events_ref(prec, &prec->val, monitor_mask,
+            dbArrayBufShareable(prec->rpvt, prec->bptr), prec->nord);
 }
 
 static long readValue(aaiRecord *prec)
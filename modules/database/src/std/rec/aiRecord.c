@@ -35,6 +35,7 @@
 #include "menuSimm.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuConvert.h"
 
@@ -87,6 +88,12 @@ rset aiRSET={
 };
 epicsExportAddress(rset,aiRSET);
 
+static void aiInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("ai");
+}
+epicsExportRegistrar(aiInitThreadSafe);
+
 static void checkAlarms(aiRecord *prec, epicsTimeStamp *lastTime);
 static void convert(aiRecord *prec);
 static void monitor(aiRecord *prec);
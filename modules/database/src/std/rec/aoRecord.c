@@ -35,6 +35,7 @@
 #include "special.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "menuConvert.h"
 #include "menuOmsl.h"
 #include "menuYesNo.h"
@@ -86,6 +87,12 @@ rset aoRSET={
 };
 epicsExportAddress(rset,aoRSET);
 
+static void aoInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("ao");
+}
+epicsExportRegistrar(aoInitThreadSafe);
+
 static void checkAlarms(aoRecord *);
 static long fetch_value(aoRecord *, double *);
 static void convert(aoRecord *, double);
@@ -33,6 +33,7 @@
 #include "menuSimm.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 
 #define GEN_SIZE_OFFSET
@@ -80,6 +81,12 @@ rset biRSET={
 };
 epicsExportAddress(rset,biRSET);
 
+static void biInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("bi");
+}
+epicsExportRegistrar(biInitThreadSafe);
+
 static void checkAlarms(biRecord *);
 static void monitor(biRecord *);
 static long readValue(biRecord *);
@@ -31,6 +31,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuIvoa.h"
 #include "menuOmsl.h"
@@ -82,6 +83,12 @@ rset boRSET={
 };
 epicsExportAddress(rset,boRSET);
 
+static void boInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("bo");
+}
+epicsExportRegistrar(boInitThreadSafe);
+
 int boHIGHprecision = 2;
 epicsExportAddress(int, boHIGHprecision);
 double boHIGHlimit = 100000;
@@ -30,6 +30,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 
 #define GEN_SIZE_OFFSET
@@ -82,6 +83,12 @@ rset calcRSET={
 };
 epicsExportAddress(rset, calcRSET);
 
+static void calcInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("calc");
+}
+epicsExportRegistrar(calcInitThreadSafe);
+
 static void checkAlarms(calcRecord *prec, epicsTimeStamp *timeLast);
 static void monitor(calcRecord *prec);
 static int fetch_values(calcRecord *prec);
@@ -108,6 +115,7 @@ static long init_record(struct dbCommon *pcommon, int pass)
         errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
                      prec->name, calcErrorStr(error_number), prec->calc);
     }
+    prec->rpcc = calcCompile(prec->rpcl);
     return 0;
 }
 
@@ -118,7 +126,9 @@ static long process(struct dbCommon *pcommon)
 
     prec->pact = TRUE;
     if (fetch_values(prec) == 0) {
-        if (calcPerform(&prec->a, &prec->val, prec->rpcl)) {
+        if (prec->rpcc ?
+            calcPerformCompiled(&prec->a, &prec->val, prec->rpcc) :
+            calcPerform(&prec->a, &prec->val, prec->rpcl)) {
             recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
         } else
             prec->udf = isnan(prec->val);
@@ -143,14 +153,18 @@ static long special(DBADDR *paddr, int after)
 
     if (!after) return 0;
     if (paddr->special == SPC_CALC) {
+        long status = 0;
+
         if (postfix(prec->calc, prec->rpcl, &error_number)) {
             recGblRecordError(S_db_badField, (void *)prec,
                               "calc: Illegal CALC field");
             errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
                          prec->name, calcErrorStr(error_number), prec->calc);
-            return S_db_badField;
+            status = S_db_badField;
         }
-        return 0;
+        calcCompiledFree(prec->rpcc);
+        prec->rpcc = calcCompile(prec->rpcl);
+        return status;
     }
     recGblDbaddrError(S_db_badChoice, paddr, "calc::special - bad special value!");
     return S_db_badChoice;
@@ -35,6 +35,7 @@
 #include "recSup.h"
 #include "devSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "callback.h"
 #include "taskwd.h"
@@ -86,6 +87,12 @@ rset calcoutRSET = {
 };
 epicsExportAddress(rset, calcoutRSET);
 
+static void calcoutInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("calcout");
+}
+epicsExportRegistrar(calcoutInitThreadSafe);
+
 int calcoutODLYprecision = 2;
 epicsExportAddress(int, calcoutODLYprecision);
 double calcoutODLYlimit = 100000;
@@ -112,6 +119,8 @@ typedef struct rpvtStruct {
     epicsCallback checkLinkCb;
     short    cbScheduled;
     short    caLinkStat; /* NO_CA_LINKS, CA_LINKS_ALL_OK, CA_LINKS_NOT_OK */
+    calcCompiled *rpcc; /* compiled CALC */
+    calcCompiled *orcc; /* compiled OCAL */
 } rpvtStruct;
 
 static void checkAlarms(calcoutRecord *prec);
@@ -205,6 +214,8 @@ static long init_record(struct dbCommon *pcommon, int pass)
     }
 
     prpvt = prec->rpvt;
+    prpvt->rpcc = calcCompile(prec->rpcl);
+    prpvt->orcc = calcCompile(prec->orpc);
     callbackSetCallback(checkLinksCallback, &prpvt->checkLinkCb);
     callbackSetPriority(0, &prpvt->checkLinkCb);
     callbackSetUser(prec, &prpvt->checkLinkCb);
@@ -235,7 +246,9 @@ static long process(struct dbCommon *pcommon)
             checkLinks(prec);
         }
         if (fetch_values(prec) == 0) {
-            if (calcPerform(&prec->a, &prec->val, prec->rpcl)) {
+            if (prpvt->rpcc ?
+                calcPerformCompiled(&prec->a, &prec->val, prpvt->rpcc) :
+                calcPerform(&prec->a, &prec->val, prec->rpcl)) {
                 recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
             } else {
                 prec->udf = isnan(prec->val);
@@ -330,6 +343,8 @@ static long special(DBADDR *paddr, int after)
             errlogPrintf("%s.CALC: %s in expression \"%s\"\n",
                          prec->name, calcErrorStr(error_number), prec->calc);
         }
+        calcCompiledFree(prpvt->rpcc);
+        prpvt->rpcc = calcCompile(prec->rpcl);
         db_post_events(prec, &prec->clcv, DBE_VALUE);
         return 0;
 
@@ -341,6 +356,8 @@ static long special(DBADDR *paddr, int after)
             errlogPrintf("%s.OCAL: %s in expression \"%s\"\n",
                          prec->name, calcErrorStr(error_number), prec->ocal);
         }
+        calcCompiledFree(prpvt->orcc);
+        prpvt->orcc = calcCompile(prec->orpc);
         db_post_events(prec, &prec->oclv, DBE_VALUE);
         return 0;
       case(calcoutRecordINPA):
@@ -603,13 +620,17 @@ static void checkAlarms(calcoutRecord *prec)
 
 static void execOutput(calcoutRecord *prec)
 {
+    rpvtStruct *prpvt = prec->rpvt;
+
     /* Determine output data */
     switch(prec->dopt) {
     case calcoutDOPT_Use_VAL:
         prec->oval = prec->val;
         break;
     case calcoutDOPT_Use_OVAL:
-        if (calcPerform(&prec->a, &prec->oval, prec->orpc)) {
+        if (prpvt->orcc ?
+            calcPerformCompiled(&prec->a, &prec->oval, prpvt->orcc) :
+            calcPerform(&prec->a, &prec->oval, prec->orpc)) {
             recGblSetSevr(prec, CALC_ALARM, INVALID_ALARM);
         } else {
             prec->udf = isnan(prec->oval);
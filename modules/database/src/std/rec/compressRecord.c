@@ -21,7 +21,12 @@
 #include <math.h>
 
 #include "dbDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsMutex.h"
 #include "epicsPrint.h"
+#include "epicsThread.h"
+#include "epicsThreadPool.h"
 #include "alarm.h"
 #include "dbStaticLib.h"
 #include "dbAccess.h"
@@ -37,8 +42,24 @@
 #undef  GEN_SIZE_OFFSET
 #include "epicsExport.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define COMPRESS_SSE2
+#  include <emmintrin.h>
+#endif
+
 #define indexof(field) compressRecord##field
 
+/* N to 1 compression of arrays with at least PARALLEL_MIN elements uses
+ * compressThreads extra threads; 0 means none, negative numbers are
+ * relative to the number of CPUs.
+ */
+int compressThreads = 0;
+epicsExportAddress(int, compressThreads);
+
+#define PARALLEL_MIN 65536
+#define PARALLEL_BLOCK 8192
+
 /* Create RSET - Record Support Entry Table*/
 #define report NULL
 #define initialize NULL
@@ -120,16 +141,27 @@ static void put_value(compressRecord *prec, double *psource, int n)
     if (nuse > nsam)
         nuse = nsam;
 
-    while (n--) {
-        /* for LIFO, pre-decrement modulo nsam */
-        if (!fifo)
-            offset = (offset + nsam - 1) % nsam;
-
-        prec->bptr[offset] = *psource++;
-
-        /* for FIFO, post-increment modulo nsam */
-        if (fifo)
-            offset = (offset + 1) % nsam;
+    if (fifo) {
+        /* copy up to the end of the buffer, then wrap */
+        while (n > 0) {
+            epicsUInt32 count = nsam - offset;
+
+            if (count > (epicsUInt32) n)
+                count = n;
+            memcpy(&prec->bptr[offset], psource, count * sizeof(double));
+            psource += count;
+            n -= count;
+            offset += count;
+            if (offset == nsam)
+                offset = 0;
+        }
+    }
+    else {
+        while (n--) {
+            /* for LIFO, pre-decrement modulo nsam */
+            offset = offset ? offset - 1 : nsam - 1;
+            prec->bptr[offset] = *psource++;
+        }
     }
 
     prec->off = offset;
@@ -148,13 +180,418 @@ static int compare(const void *arg1, const void *arg2)
     else               return  1;
 }
 
+/*
+ * The N to 1 kernels below each compute nout results from consecutive
+ * groups of n values, and give the same results as the original loops
+ * which took each group's values one after another. The values of a
+ * group are never reassociated, instead several groups are worked on
+ * side by side in SIMD lanes. Long groups are searched for their lowest
+ * or highest value within the group; that can only choose differently
+ * between -0.0 and +0.0, so a zero result is found again the slow way.
+ *
+ * pdest may be psource, each result is stored after its group is read.
+ */
+
+#ifdef COMPRESS_SSE2
+
+/* Lowest or highest of each lane, which all started from the same value */
+static double lowLanes(__m128d a, __m128d b, __m128d c, __m128d d)
+{
+    double lanes[2];
+
+    a = _mm_min_pd(b, a);
+    c = _mm_min_pd(d, c);
+    _mm_storeu_pd(lanes, _mm_min_pd(c, a));
+    return lanes[0] > lanes[1] ? lanes[1] : lanes[0];
+}
+
+static double highLanes(__m128d a, __m128d b, __m128d c, __m128d d)
+{
+    double lanes[2];
+
+    a = _mm_max_pd(b, a);
+    c = _mm_max_pd(d, c);
+    _mm_storeu_pd(lanes, _mm_max_pd(c, a));
+    return lanes[0] < lanes[1] ? lanes[1] : lanes[0];
+}
+
+#endif /* COMPRESS_SSE2 */
+
+static double lowValue(const double *p, epicsInt32 n)
+{
+    double value = p[0];
+    epicsInt32 j = 1;
+
+#ifdef COMPRESS_SSE2
+    if (n >= 16) {
+        /* every lane starts from p[0], so a NaN there is kept */
+        __m128d a = _mm_set1_pd(value), b = a, c = a, d = a;
+
+        for (; j + 8 <= n; j += 8) {
+            a = _mm_min_pd(_mm_loadu_pd(p + j), a);
+            b = _mm_min_pd(_mm_loadu_pd(p + j + 2), b);
+            c = _mm_min_pd(_mm_loadu_pd(p + j + 4), c);
+            d = _mm_min_pd(_mm_loadu_pd(p + j + 6), d);
+        }
+        value = lowLanes(a, b, c, d);
+        for (; j < n; j++) {
+            if (value > p[j])
+                value = p[j];
+        }
+        if (value != 0.0)
+            return value;
+        value = p[0];
+        j = 1;
+    }
+#endif
+    for (; j < n; j++) {
+        if (value > p[j])
+            value = p[j];
+    }
+    return value;
+}
+
+static double highValue(const double *p, epicsInt32 n)
+{
+    double value = p[0];
+    epicsInt32 j = 1;
+
+#ifdef COMPRESS_SSE2
+    if (n >= 16) {
+        __m128d a = _mm_set1_pd(value), b = a, c = a, d = a;
+
+        for (; j + 8 <= n; j += 8) {
+            a = _mm_max_pd(_mm_loadu_pd(p + j), a);
+            b = _mm_max_pd(_mm_loadu_pd(p + j + 2), b);
+            c = _mm_max_pd(_mm_loadu_pd(p + j + 4), c);
+            d = _mm_max_pd(_mm_loadu_pd(p + j + 6), d);
+        }
+        value = highLanes(a, b, c, d);
+        for (; j < n; j++) {
+            if (value < p[j])
+                value = p[j];
+        }
+        if (value != 0.0)
+            return value;
+        value = p[0];
+        j = 1;
+    }
+#endif
+    for (; j < n; j++) {
+        if (value < p[j])
+            value = p[j];
+    }
+    return value;
+}
+
+/* Short groups are done four at a time, two in each of a and b */
+
+static void lowValues(const double *psource, epicsInt32 n,
+    double *pdest, epicsInt32 nout)
+{
+    epicsInt32 i = 0;
+
+#ifdef COMPRESS_SSE2
+    for (; n < 16 && i + 4 <= nout; i += 4) {
+        const double *p = psource + (size_t) i * n;
+        const double *q = p + 2 * (size_t) n;
+        __m128d a = _mm_set_pd(p[n], p[0]);
+        __m128d b = _mm_set_pd(q[n], q[0]);
+        epicsInt32 j;
+
+        for (j = 1; j < n; j++) {
+            a = _mm_min_pd(_mm_set_pd(p[n + j], p[j]), a);
+            b = _mm_min_pd(_mm_set_pd(q[n + j], q[j]), b);
+        }
+        _mm_storeu_pd(pdest + i, a);
+        _mm_storeu_pd(pdest + i + 2, b);
+    }
+#endif
+    for (; i < nout; i++)
+        pdest[i] = lowValue(psource + (size_t) i * n, n);
+}
+
+static void highValues(const double *psource, epicsInt32 n,
+    double *pdest, epicsInt32 nout)
+{
+    epicsInt32 i = 0;
+
+#ifdef COMPRESS_SSE2
+    for (; n < 16 && i + 4 <= nout; i += 4) {
+        const double *p = psource + (size_t) i * n;
+        const double *q = p + 2 * (size_t) n;
+        __m128d a = _mm_set_pd(p[n], p[0]);
+        __m128d b = _mm_set_pd(q[n], q[0]);
+        epicsInt32 j;
+
+        for (j = 1; j < n; j++) {
+            a = _mm_max_pd(_mm_set_pd(p[n + j], p[j]), a);
+            b = _mm_max_pd(_mm_set_pd(q[n + j], q[j]), b);
+        }
+        _mm_storeu_pd(pdest + i, a);
+        _mm_storeu_pd(pdest + i + 2, b);
+    }
+#endif
+    for (; i < nout; i++)
+        pdest[i] = highValue(psource + (size_t) i * n, n);
+}
+
+static void averageValues(const double *psource, epicsInt32 n,
+    double *pdest, epicsInt32 nout)
+{
+    epicsInt32 i = 0;
+
+#ifdef COMPRESS_SSE2
+    for (; i + 4 <= nout; i += 4) {
+        const double *p = psource + (size_t) i * n;
+        const double *q = p + 2 * (size_t) n;
+        __m128d a = _mm_setzero_pd();
+        __m128d b = _mm_setzero_pd();
+        epicsInt32 j;
+
+        for (j = 0; j < n; j++) {
+            a = _mm_add_pd(a, _mm_set_pd(p[n + j], p[j]));
+            b = _mm_add_pd(b, _mm_set_pd(q[n + j], q[j]));
+        }
+        _mm_storeu_pd(pdest + i, _mm_div_pd(a, _mm_set1_pd(n)));
+        _mm_storeu_pd(pdest + i + 2, _mm_div_pd(b, _mm_set1_pd(n)));
+    }
+#endif
+    for (; i < nout; i++) {
+        const double *p = psource + (size_t) i * n;
+        double value = 0;
+        epicsInt32 j;
+
+        for (j = 0; j < n; j++)
+            value += p[j];
+        pdest[i] = value / n;
+    }
+}
+
+/*
+ * Return the k'th lowest of n values, reordering them. This gives the
+ * value which sorting them would put at k, in O(n) time on average.
+ * If partitioning isn't making progress the rest is sorted instead.
+ */
+static double selectValue(double *p, epicsInt32 n, epicsInt32 k)
+{
+    epicsInt32 lo = 0, hi = n - 1;
+    epicsInt32 m;
+    int budget = 0;
+
+    for (m = n; m > 1; m >>= 1)
+        budget += 2;
+
+    while (hi > lo) {
+        epicsInt32 i, j, mid = lo + (hi - lo) / 2;
+        double pivot, tmp;
+
+        if (hi - lo < 16) {
+            /* insertion sort */
+            for (i = lo + 1; i <= hi; i++) {
+                tmp = p[i];
+                for (j = i; j > lo && tmp < p[j - 1]; j--)
+                    p[j] = p[j - 1];
+                p[j] = tmp;
+            }
+            break;
+        }
+        if (budget-- == 0) {
+            qsort(p + lo, hi - lo + 1, sizeof(double), compare);
+            break;
+        }
+
+        /* median of three */
+        if (p[mid] < p[lo]) { tmp = p[mid]; p[mid] = p[lo]; p[lo] = tmp; }
+        if (p[hi] < p[mid]) { tmp = p[hi]; p[hi] = p[mid]; p[mid] = tmp; }
+        if (p[mid] < p[lo]) { tmp = p[mid]; p[mid] = p[lo]; p[lo] = tmp; }
+        pivot = p[mid];
+
+        i = lo;
+        j = hi;
+        while (i <= j) {
+            while (i <= hi && p[i] < pivot)
+                i++;
+            while (j >= lo && pivot < p[j])
+                j--;
+            if (i <= j) {
+                tmp = p[i]; p[i] = p[j]; p[j] = tmp;
+                i++;
+                j--;
+            }
+        }
+        /* p[lo..j] <= pivot <= p[i..hi], anything between is the pivot */
+        if (k <= j)
+            hi = j;
+        else if (k >= i)
+            lo = i;
+        else
+            break;
+    }
+    return p[k];
+}
+
+static void medianValues(double *psource, epicsInt32 n,
+    double *pdest, epicsInt32 nout)
+{
+    epicsInt32 i;
+
+    for (i = 0; i < nout; i++)
+        pdest[i] = selectValue(psource + (size_t) i * n, n, n / 2);
+}
+
+static void compress_groups(int alg, double *psource, epicsInt32 n,
+    double *pdest, epicsInt32 nout)
+{
+    switch (alg) {
+    case compressALG_N_to_1_Low_Value:
+        lowValues(psource, n, pdest, nout);
+        break;
+    case compressALG_N_to_1_High_Value:
+        highValues(psource, n, pdest, nout);
+        break;
+    case compressALG_N_to_1_Average:
+        averageValues(psource, n, pdest, nout);
+        break;
+    case compressALG_N_to_1_Median:
+        /* note: reorders source array (OK; it's a work pointer) */
+        medianValues(psource, n, pdest, nout);
+        break;
+    }
+}
+
+/*
+ * Parallel compression of large arrays. The calling thread and the pool
+ * threads take blocks of groups until there are none left. One array is
+ * compressed at a time, so the pool can be replaced when compressThreads
+ * is changed. A record which finds the pool in use compresses its array
+ * serially instead of waiting for it.
+ */
+typedef struct compressWork {
+    int alg;
+    double *psource;
+    epicsInt32 n;
+    double *pdest;
+    size_t nout;
+    size_t per;
+    size_t next;
+    size_t running;
+    epicsEventId done;
+} compressWork;
+
+static epicsThreadOnceId parallelOnce = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId parallelLock;
+static epicsThreadPool *parallelPool;
+static int parallelThreads;
+
+static void parallelInit(void *unused)
+{
+    parallelLock = epicsMutexMustCreate();
+}
+
+static void compressBlocks(compressWork *pwork)
+{
+    size_t i;
+
+    while ((i = epicsAtomicAddSizeT(&pwork->next, pwork->per) - pwork->per)
+           < pwork->nout) {
+        size_t end = i + pwork->per;
+
+        if (end > pwork->nout)
+            end = pwork->nout;
+        compress_groups(pwork->alg, pwork->psource + i * pwork->n,
+            pwork->n, pwork->pdest + i, (epicsInt32) (end - i));
+    }
+}
+
+static void compressJob(void *arg, epicsJobMode mode)
+{
+    compressWork *pwork = arg;
+
+    if (mode == epicsJobModeRun)
+        compressBlocks(pwork);
+    if (epicsAtomicDecrSizeT(&pwork->running) == 0)
+        epicsEventMustTrigger(pwork->done);
+}
+
+/* Returns 0 if the array was compressed, else it must be done serially */
+static int compress_parallel(int alg, double *psource, epicsInt32 n,
+    double *pdest, epicsInt32 nout)
+{
+    compressWork work;
+    epicsJob *jobs[64];
+    int nthreads = compressThreads;
+    int njobs = 0;
+    int i;
+
+    if (nthreads < 0)
+        nthreads += epicsThreadGetCPUs();
+    if (nthreads < 1)
+        return 1;
+    if (nthreads > (int) NELEMENTS(jobs))
+        nthreads = NELEMENTS(jobs);
+
+    epicsThreadOnce(&parallelOnce, parallelInit, NULL);
+    if (epicsMutexTryLock(parallelLock) != epicsMutexLockOK)
+        return 1;
+
+    if (parallelPool && parallelThreads != nthreads) {
+        epicsThreadPoolDestroy(parallelPool);
+        parallelPool = NULL;
+    }
+    if (!parallelPool) {
+        epicsThreadPoolConfig conf;
+
+        epicsThreadPoolConfigDefaults(&conf);
+        conf.initialThreads = conf.maxThreads = nthreads;
+        conf.workerPriority = epicsThreadGetPrioritySelf();
+        parallelPool = epicsThreadPoolCreate(&conf);
+        parallelThreads = nthreads;
+        if (!parallelPool) {
+            epicsMutexUnlock(parallelLock);
+            return 1;
+        }
+    }
+
+    work.alg = alg;
+    work.psource = psource;
+    work.n = n;
+    work.pdest = pdest;
+    work.nout = nout;
+    work.per = PARALLEL_BLOCK / n > 4 ? PARALLEL_BLOCK / n : 4;
+    work.next = 0;
+    work.running = 0;
+    work.done = epicsEventMustCreate(epicsEventEmpty);
+
+    for (i = 0; i < nthreads && (size_t) (i + 1) * work.per < work.nout; i++) {
+        jobs[njobs] = epicsJobCreate(parallelPool, compressJob, &work);
+        if (!jobs[njobs])
+            break;
+        epicsAtomicIncrSizeT(&work.running);
+        if (epicsJobQueue(jobs[njobs])) {
+            epicsAtomicDecrSizeT(&work.running);
+            epicsJobDestroy(jobs[njobs]);
+            break;
+        }
+        njobs++;
+    }
+    compressBlocks(&work);
+    if (njobs)
+        epicsEventMustWait(work.done);
+    for (i = 0; i < njobs; i++)
+        epicsJobDestroy(jobs[i]);
+    epicsEventDestroy(work.done);
+
+    epicsMutexUnlock(parallelLock);
+    return 0;
+}
+
 static int compress_array(compressRecord *prec,
     double *psource, int no_elements)
 {
-    epicsInt32 i,j;
     epicsInt32 n, nnew;
     epicsInt32 nsam = prec->nsam;
-    double value;
+    double *pdest = psource;
 
     /* skip out of limit data */
     if (prec->ilil < prec->ihil) {
@@ -171,54 +608,22 @@ static int compress_array(compressRecord *prec,
         return 1; /*dont do anything*/
 
     /* determine number of samples to take */
-    if (no_elements < nsam * n)
-        nnew = (no_elements / n);
-    else nnew = nsam;
+    nnew = no_elements / n;
+    if (nnew > nsam)
+        nnew = nsam;
 
     /* compress according to specified algorithm */
-    switch (prec->alg){
-    case compressALG_N_to_1_Low_Value:
-        /* compress N to 1 keeping the lowest value */
-        for (i = 0; i < nnew; i++) {
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++) {
-                if (value > *psource)
-                    value = *psource;
-            }
-            put_value(prec, &value, 1);
-        }
-        break;
-    case compressALG_N_to_1_High_Value:
-        /* compress N to 1 keeping the highest value */
-        for (i = 0; i < nnew; i++){
-            value = *psource++;
-            for (j = 1; j < n; j++, psource++) {
-                if (value < *psource)
-                    value = *psource;
-            }
-            put_value(prec, &value, 1);
-        }
-        break;
-    case compressALG_N_to_1_Average:
-        /* compress N to 1 keeping the average value */
-        for (i = 0; i < nnew; i++) {
-            value = 0;
-            for (j = 0; j < n; j++, psource++)
-                value += *psource;
-            value /= n;
-            put_value(prec, &value, 1);
-        }
-        break;
-
-    case compressALG_N_to_1_Median:
-        /* compress N to 1 keeping the median value */
-        /* note: sorts source array (OK; it's a work pointer) */
-        for (i = 0; i < nnew; i++, psource += nnew) {
-            qsort(psource, n, sizeof(double), compare);
-            value = psource[n / 2];
-            put_value(prec, &value, 1);
-        }
-        break;
+    if ((size_t) nnew * n >= PARALLEL_MIN && compressThreads &&
+        (pdest = malloc(nnew * sizeof(double))) != NULL) {
+        if (compress_parallel(prec->alg, psource, n, pdest, nnew))
+            compress_groups(prec->alg, psource, n, pdest, nnew);
+        put_value(prec, pdest, nnew);
+        free(pdest);
+    }
+    else {
+        /* results overwrite the work array */
+        compress_groups(prec->alg, psource, n, psource, nnew);
+        put_value(prec, psource, nnew);
     }
     return 0;
 }
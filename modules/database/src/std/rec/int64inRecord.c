@@ -32,6 +32,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuYesNo.h"
 
@@ -83,6 +84,12 @@ rset int64inRSET={
 };
 epicsExportAddress(rset,int64inRSET);
 
+static void int64inInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("int64in");
+}
+epicsExportRegistrar(int64inInitThreadSafe);
+
 
 static void checkAlarms(int64inRecord *prec, epicsTimeStamp *timeLast);
 static void monitor(int64inRecord *prec);
@@ -29,6 +29,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuYesNo.h"
 #include "menuIvoa.h"
@@ -80,6 +81,12 @@ rset int64outRSET={
 };
 epicsExportAddress(rset,int64outRSET);
 
+static void int64outInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("int64out");
+}
+epicsExportRegistrar(int64outInitThreadSafe);
+
 
 static void checkAlarms(int64outRecord *prec);
 static void monitor(int64outRecord *prec);
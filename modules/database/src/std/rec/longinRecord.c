@@ -33,6 +33,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuYesNo.h"
 
@@ -84,6 +85,12 @@ rset longinRSET={
 };
 epicsExportAddress(rset,longinRSET);
 
+static void longinInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("longin");
+}
+epicsExportRegistrar(longinInitThreadSafe);
+
 static void checkAlarms(longinRecord *prec, epicsTimeStamp *timeLast);
 static void monitor(longinRecord *prec);
 static long readValue(longinRecord *prec);
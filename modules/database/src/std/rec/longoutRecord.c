@@ -30,6 +30,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuYesNo.h"
 #include "menuIvoa.h"
@@ -81,6 +82,12 @@ rset longoutRSET={
 };
 epicsExportAddress(rset,longoutRSET);
 
+static void longoutInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("longout");
+}
+epicsExportRegistrar(longoutInitThreadSafe);
+
 static void checkAlarms(longoutRecord *prec);
 static void monitor(longoutRecord *prec);
 static long writeValue(longoutRecord *prec);
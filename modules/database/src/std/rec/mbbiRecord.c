@@ -33,6 +33,7 @@
 #include "menuSimm.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 
 #define GEN_SIZE_OFFSET
@@ -84,6 +85,12 @@ rset mbbiRSET = {
 };
 epicsExportAddress(rset,mbbiRSET);
 
+static void mbbiInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("mbbi");
+}
+epicsExportRegistrar(mbbiInitThreadSafe);
+
 static void checkAlarms(mbbiRecord *, epicsTimeStamp *);
 static void monitor(mbbiRecord *);
 static long readValue(mbbiRecord *);
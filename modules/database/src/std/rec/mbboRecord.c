@@ -32,6 +32,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuOmsl.h"
 #include "menuIvoa.h"
@@ -83,6 +84,12 @@ rset mbboRSET = {
 };
 epicsExportAddress(rset,mbboRSET);
 
+static void mbboInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("mbbo");
+}
+epicsExportRegistrar(mbboInitThreadSafe);
+
 
 static void checkAlarms(mbboRecord *);
 static void convert(mbboRecord *);
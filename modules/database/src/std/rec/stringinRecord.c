@@ -32,6 +32,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuYesNo.h"
 
@@ -81,6 +82,12 @@ rset stringinRSET={
 };
 epicsExportAddress(rset,stringinRSET);
 
+static void stringinInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("stringin");
+}
+epicsExportRegistrar(stringinInitThreadSafe);
+
 static void monitor(stringinRecord *);
 static long readValue(stringinRecord *);
 
@@ -32,6 +32,7 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
+#include "iocInit.h"
 #include "special.h"
 #include "menuOmsl.h"
 #include "menuIvoa.h"
@@ -83,6 +84,12 @@ rset stringoutRSET={
 };
 epicsExportAddress(rset,stringoutRSET);
 
+static void stringoutInitThreadSafe(void)
+{
+    iocInitRecordTypeThreadSafe("stringout");
+}
+epicsExportRegistrar(stringoutInitThreadSafe);
+
 static void monitor(stringoutRecord *);
 static long writeValue(stringoutRecord *);
 
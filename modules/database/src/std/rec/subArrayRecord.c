@@ -28,6 +28,7 @@
 #include "epicsPrint.h"
 #include "alarm.h"
 #include "dbAccess.h"
+#include "dbArrayBuf.h"
 #include "dbEvent.h"
 #include "dbFldTypes.h"
 #include "dbScan.h"
@@ -35,7 +36,6 @@
 #include "errMdef.h"
 #include "recSup.h"
 #include "recGbl.h"
-#include "cantProceed.h"
 
 #define GEN_SIZE_OFFSET
 #include "subArrayRecord.h"
@@ -97,8 +97,9 @@ static long init_record(struct dbCommon *pcommon, int pass)
             prec->malm = 1;
         if (prec->ftvl > DBF_ENUM)
             prec->ftvl = DBF_UCHAR;
-        prec->bptr = callocMustSucceed(prec->malm, dbValueSize(prec->ftvl),
-            "subArrayRecord calloc failed");
+        prec->rpvt = dbArrayBufPoolCreate(
+            (size_t) prec->malm * dbValueSize(prec->ftvl));
+        prec->bptr = dbArrayBufCurrent(prec->rpvt);
         prec->nord = 0;
         if (prec->nelm > prec->malm)
             prec->nelm = prec->malm;
@@ -138,6 +139,11 @@ static long process(struct dbCommon *pcommon)
 
     if (pact && prec->busy) return 0;
 
+    /* Monitors may still be sending the previous value */
+    if (!pact)
+        prec->bptr = dbArrayBufWritable(prec->rpvt, prec->bptr,
+            prec->nord * dbValueSize(prec->ftvl));
+
     status=readValue(prec); /* read the new value */
     if (!pact && prec->pact) return 0;
     prec->pact = TRUE;
@@ -161,7 +167,6 @@ static long cvt_dbaddr(DBADDR *paddr)
 {
     subArrayRecord *prec = (subArrayRecord *) paddr->precord;
 
-    paddr->pfield = prec->bptr;
     paddr->no_elements = prec->malm;
     paddr->field_type = prec->ftvl;
     paddr->field_size = dbValueSize(prec->ftvl);
@@ -174,6 +179,11 @@ static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
 {
     subArrayRecord *prec = (subArrayRecord *) paddr->precord;
 
+    /* dbPut() writes to the buffer returned here, a read uses it as is */
+    if (dbArrayBufPutting())
+        prec->bptr = dbArrayBufWritable(prec->rpvt, prec->bptr,
+            prec->nord * dbValueSize(prec->ftvl));
+    paddr->pfield = prec->bptr;
     if (prec->udf)
        *no_elements = 0;
     else
@@ -293,7 +303,9 @@ static void monitor(subArrayRecord *prec)
     monitor_mask = recGblResetAlarms(prec);
     monitor_mask |= (DBE_LOG|DBE_VALUE);
 
-    db_post_events(prec, prec->bptr, monitor_mask);
+    db_post_events_ref(prec, &prec->val, monitor_mask,
+        dbArrayBufShareable(prec->rpvt, prec->bptr),
+        prec->udf ? 0 : prec->nord);
 
     return;
 }
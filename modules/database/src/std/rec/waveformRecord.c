@@ -26,6 +26,7 @@
 #include "alarm.h"
 #include "callback.h"
 #include "dbAccess.h"
+#include "dbArrayBuf.h"
 #include "dbEvent.h"
 #include "dbFldTypes.h"
 #include "dbScan.h"
@@ -34,7 +35,6 @@
 #include "recSup.h"
 #include "recGbl.h"
 #include "special.h"
-#include "cantProceed.h"
 #include "menuYesNo.h"
 
 #define GEN_SIZE_OFFSET
@@ -95,8 +95,9 @@ static long init_record(struct dbCommon *pcommon, int pass)
             prec->nelm = 1;
         if (prec->ftvl > DBF_ENUM)
             prec->ftvl = DBF_UCHAR;
-        prec->bptr = callocMustSucceed(prec->nelm, dbValueSize(prec->ftvl),
-            "waveform calloc failed");
+        prec->rpvt = dbArrayBufPoolCreate(
+            (size_t) prec->nelm * dbValueSize(prec->ftvl));
+        prec->bptr = dbArrayBufCurrent(prec->rpvt);
         prec->nord = (prec->nelm == 1);
         return 0;
     }
@@ -135,6 +136,11 @@ static long process(struct dbCommon *pcommon)
     if (pact && prec->busy)
         return 0;
 
+    /* Monitors may still be sending the previous value */
+    if (!pact)
+        prec->bptr = dbArrayBufWritable(prec->rpvt, prec->bptr,
+            prec->nord * dbValueSize(prec->ftvl));
+
     status = readValue(prec); /* read the new value */
     if (!pact && prec->pact)
         return 0;
@@ -188,6 +194,10 @@ static long get_array_info(DBADDR *paddr, long *no_elements, long *offset)
 {
     waveformRecord *prec = (waveformRecord *) paddr->precord;
 
+    /* dbPut() writes to the buffer returned here, a read uses it as is */
+    if (dbArrayBufPutting())
+        prec->bptr = dbArrayBufWritable(prec->rpvt, prec->bptr,
+            prec->nord * dbValueSize(prec->ftvl));
     paddr->pfield = prec->bptr;
     *no_elements = prec->nord;
     *offset = 0;
@@ -315,7 +325,8 @@ static void monitor(waveformRecord *prec)
     }
 
     if (monitor_mask) {
-        db_post_events(prec, &prec->val, monitor_mask);
+        db_post_events_ref(prec, &prec->val, monitor_mask,
+            dbArrayBufShareable(prec->rpvt, prec->bptr), prec->nord);
     }
 }
 
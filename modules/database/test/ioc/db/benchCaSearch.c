@@ -0,0 +1,189 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measure how fast the CA server's UDP name server answers bursts of
+ * search requests sent over the loopback interface, and when it starts
+ * to drop them. Each request datagram holds one search for a record
+ * this IOC has and several for names it doesn't, like the broadcasts
+ * sent when many clients reconnect at once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "envDefs.h"
+#include "epicsString.h"
+#include "epicsTime.h"
+#include "osiSock.h"
+#include "caProto.h"
+#include "dbAccess.h"
+#include "iocInit.h"
+#include "rsrv.h"
+#include "errlog.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define SERVER_PORT 15064u
+#define MINOR_VERSION 13u   /* CA V4.13 */
+#define NMISS 7             /* names not found per datagram */
+
+static SOCKET sock;
+static osiSockAddr server;
+
+static size_t addSearch(char *pBuf, const char *name, epicsUInt32 id)
+{
+    caHdr *pHdr = (caHdr *) pBuf;
+    size_t len = strlen(name) + 1;
+    size_t size = (len + 7u) & ~7u;
+
+    memset(pBuf, 0, sizeof(*pHdr) + size);
+    pHdr->m_cmmd = htons(CA_PROTO_SEARCH);
+    pHdr->m_postsize = htons((epicsUInt16) size);
+    pHdr->m_dataType = htons(DONTREPLY);
+    pHdr->m_count = htons(MINOR_VERSION);
+    pHdr->m_cid = htonl(id);
+    pHdr->m_available = htonl(id);
+    memcpy(pHdr + 1, name, len);
+    return sizeof(*pHdr) + size;
+}
+
+static size_t makeRequest(char *pBuf, epicsUInt32 seq)
+{
+    caHdr *pHdr = (caHdr *) pBuf;
+    size_t n = sizeof(*pHdr);
+    char name[40];
+    int i;
+
+    memset(pHdr, 0, sizeof(*pHdr));
+    pHdr->m_cmmd = htons(CA_PROTO_VERSION);
+    pHdr->m_count = htons(MINOR_VERSION);
+    pHdr->m_cid = htonl(seq);
+
+    for (i = 0; i < NMISS; i++) {
+        sprintf(name, "OTHER%02d:IOC:%u", i, (unsigned) (seq % 500u));
+        n += addSearch(pBuf + n, name, 0);
+    }
+    n += addSearch(pBuf + n, "x", seq + 1u);
+    return n;
+}
+
+/* Count search replies until nothing arrives for a while */
+static size_t collectReplies(char *found, size_t nreq, epicsTimeStamp *last)
+{
+    char buf[MAX_UDP_RECV];
+    size_t nfound = 0;
+
+    while (1) {
+        struct timeval timeout;
+        fd_set fds;
+        int status;
+        size_t off;
+
+        timeout.tv_sec = 0;
+        timeout.tv_usec = 300000;
+        FD_ZERO(&fds);
+        FD_SET(sock, &fds);
+        if (select((int) sock + 1, &fds, NULL, NULL, &timeout) <= 0)
+            break;
+
+        status = recv(sock, buf, sizeof(buf), 0);
+        if (status <= 0)
+            break;
+        epicsTimeGetCurrent(last);
+
+        for (off = 0; off + sizeof(caHdr) <= (size_t) status; ) {
+            caHdr *pHdr = (caHdr *) (buf + off);
+            epicsUInt32 id = ntohl(pHdr->m_available);
+
+            if (ntohs(pHdr->m_cmmd) == CA_PROTO_SEARCH &&
+                id >= 1u && id <= nreq && !found[id - 1u]) {
+                found[id - 1u] = 1;
+                nfound++;
+            }
+            off += sizeof(caHdr) + ntohs(pHdr->m_postsize);
+        }
+    }
+    return nfound;
+}
+
+static void runBurst(size_t nreq)
+{
+    char buf[MAX_UDP_SEND];
+    char *found = callocMustSucceed(nreq, 1, "runBurst");
+    epicsTimeStamp start, last;
+    size_t i, nfound;
+    double elapsed;
+
+    epicsTimeGetCurrent(&start);
+    last = start;
+    for (i = 0; i < nreq; i++) {
+        size_t n = makeRequest(buf, (epicsUInt32) i);
+
+        sendto(sock, buf, (int) n, 0, &server.sa, sizeof(server.ia));
+    }
+    nfound = collectReplies(found, nreq, &last);
+    elapsed = epicsTimeDiffInSeconds(&last, &start);
+
+    testDiag("Final: %lu datagrams, %lu searches answered of %lu "
+             "(%.1f%% dropped), %.1f ksearches/s",
+             (unsigned long) nreq, (unsigned long) nfound,
+             (unsigned long) nreq, 100.0 * (nreq - nfound) / nreq,
+             elapsed > 0 ? nfound * (NMISS + 1) / elapsed / 1e3 : 0.0);
+    free(found);
+}
+
+MAIN(benchCaSearch)
+{
+    char port[16];
+    int bufSize = 8 * 1024 * 1024;
+
+    testPlan(0);
+
+    sprintf(port, "%u", SERVER_PORT);
+    epicsEnvSet("EPICS_CA_SERVER_PORT", port);
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CAS_AUTO_BEACON_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CAS_BEACON_ADDR_LIST", "");
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+    rsrv_register_server();
+
+    /* testIocInitOk() doesn't start servers */
+    eltc(0);
+    if (iocInit())
+        testAbort("Failed to start up test database");
+    eltc(1);
+
+    sock = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+    if (sock == INVALID_SOCKET)
+        testAbort("Can't create UDP socket");
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (char *) &bufSize,
+        sizeof(bufSize));
+
+    memset(&server, 0, sizeof(server));
+    server.ia.sin_family = AF_INET;
+    server.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.ia.sin_port = htons(SERVER_PORT);
+
+    runBurst(100);
+    runBurst(1000);
+    runBurst(10000);
+    runBurst(50000);
+
+    epicsSocketDestroy(sock);
+
+    /* the servers keep running, so the database isn't freed */
+    iocShutdown();
+
+    return testDone();
+}
@@ -0,0 +1,147 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measure db_post_events() throughput as the number of monitors on
+ * one record grows.  The monitors are spread over several event
+ * contexts, like the subscriptions of several CA clients.
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "caeventmask.h"
+#include "cantProceed.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "dbAccess.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NCTX 4
+
+static size_t nUpdates;
+
+static void countUpdate(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    epicsAtomicIncrSizeT(&nUpdates);
+}
+
+static void runBench(xRecord *prec, unsigned nmon, size_t niter, size_t nrep)
+{
+    dbEventCtx ctx[NCTX];
+    dbChannel **chan;
+    dbEventSubscription *sub;
+    double *reptimes;
+    unsigned i;
+    size_t n, r;
+
+    testDiag("%u monitors on %u event contexts", nmon, NCTX);
+
+    chan = callocMustSucceed(nmon, sizeof(*chan), "runBench");
+    sub = callocMustSucceed(nmon, sizeof(*sub), "runBench");
+    reptimes = callocMustSucceed(nrep, sizeof(*reptimes), "runBench");
+
+    for (i = 0; i < NCTX; i++) {
+        ctx[i] = db_init_events();
+        db_start_events(ctx[i], "benchEvent", NULL, NULL,
+            epicsThreadPriorityLow);
+    }
+    for (i = 0; i < nmon; i++) {
+        chan[i] = dbChannelCreate("x.VAL");
+        if (!chan[i] || dbChannelOpen(chan[i]))
+            testAbort("Can't open channel x.VAL");
+        sub[i] = db_add_event(ctx[i % NCTX], chan[i], countUpdate, NULL,
+            DBE_VALUE);
+        db_event_enable(sub[i]);
+    }
+
+    epicsAtomicSetSizeT(&nUpdates, 0);
+
+    for (r = 0; r < nrep; r++) {
+        epicsTimeStamp start, stop;
+
+        epicsTimeGetCurrent(&start);
+        for (n = 0; n < niter; n++) {
+            dbScanLock((dbCommon *) prec);
+            prec->val = (epicsInt32) n;
+            db_post_events(prec, &prec->val, DBE_VALUE);
+            dbScanUnlock((dbCommon *) prec);
+        }
+        epicsTimeGetCurrent(&stop);
+
+        reptimes[r] = epicsTimeDiffInSeconds(&stop, &start);
+        testDiag("%lu posts in %.03f ms.  %.1f kposts/s",
+                 (unsigned long) niter, reptimes[r] * 1e3,
+                 niter / reptimes[r] / 1e3);
+    }
+
+    {
+        double sum = 0, sum2 = 0, mean;
+
+        for (r = 0; r < nrep; r++) {
+            sum += reptimes[r];
+            sum2 += reptimes[r] * reptimes[r];
+        }
+        mean = sum / nrep;
+        testDiag("Final: %.04f ms +- %.05f ms.  %.1f kposts/s, "
+                 "%.1f kevents/s  (for %u monitors)",
+                 mean * 1e3, sqrt(sum2 / nrep - mean * mean) * 1e3,
+                 niter / mean / 1e3, niter * nmon / mean / 1e3, nmon);
+    }
+
+    for (i = 0; i < nmon; i++) {
+        db_cancel_event(sub[i]);
+        dbChannelDelete(chan[i]);
+    }
+    for (i = 0; i < NCTX; i++)
+        db_close_events(ctx[i]);
+
+    testDiag("%lu updates delivered",
+             (unsigned long) epicsAtomicGetSizeT(&nUpdates));
+
+    free(reptimes);
+    free(sub);
+    free(chan);
+}
+
+MAIN(benchdbEvent)
+{
+    xRecord *prec;
+
+    testPlan(0);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    prec = (xRecord *) testdbRecordPtr("x");
+
+    runBench(prec, 1, 100000, 5);
+    runBench(prec, 10, 100000, 5);
+    runBench(prec, 50, 20000, 5);
+    runBench(prec, 200, 5000, 5);
+    runBench(prec, 1000, 1000, 5);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,98 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measure record name lookups in the PV directory, as done by CA name
+ * searches and dbChannelCreate(), for increasing numbers of records.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cantProceed.h"
+#include "epicsStdio.h"
+#include "epicsTime.h"
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+/* Names shaped like a typical naming convention */
+static void makeName(char *buf, size_t n, size_t i)
+{
+    epicsSnprintf(buf, n, "SR%02u:C%02u-BI{BPM:%u}Pos:%c-I",
+        (unsigned) (i / 20000), (unsigned) (i / 1000 % 20),
+        (unsigned) (i % 1000), "XYZT"[i % 4]);
+}
+
+static void runBench(size_t nrec, size_t nrep)
+{
+    char (*names)[40];
+    DBENTRY entry;
+    size_t i, r, found = 0;
+    epicsTimeStamp start, stop;
+    double hit, miss;
+
+    testDiag("%lu records", (unsigned long) nrec);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+
+    names = callocMustSucceed(nrec, sizeof(*names), "runBench");
+    dbInitEntry(pdbbase, &entry);
+    for (i = 0; i < nrec; i++) {
+        makeName(names[i], sizeof(names[i]), i);
+        if (dbFindRecordType(&entry, "x") || dbCreateRecord(&entry, names[i]))
+            testAbort("Can't create record %s", names[i]);
+    }
+
+    /* Look up in a scrambled order, like the names in a search burst */
+    epicsTimeGetCurrent(&start);
+    for (r = 0; r < nrep; r++) {
+        for (i = 0; i < nrec; i++) {
+            if (!dbFindRecord(&entry, names[(i * 7919) % nrec]))
+                found++;
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+    hit = epicsTimeDiffInSeconds(&stop, &start) / (nrec * nrep);
+
+    /* Names from another IOC */
+    for (i = 0; i < nrec; i++)
+        names[i][0] = 'L';
+    epicsTimeGetCurrent(&start);
+    for (r = 0; r < nrep; r++) {
+        for (i = 0; i < nrec; i++) {
+            if (!dbFindRecord(&entry, names[(i * 7919) % nrec]))
+                found++;
+        }
+    }
+    epicsTimeGetCurrent(&stop);
+    miss = epicsTimeDiffInSeconds(&stop, &start) / (nrec * nrep);
+
+    testDiag("Final: %.1f ns per found name, %.1f ns per missing name "
+             "(%lu of %lu found)", hit * 1e9, miss * 1e9,
+             (unsigned long) found, (unsigned long) (nrec * nrep));
+
+    dbFinishEntry(&entry);
+    free(names);
+    testdbCleanup();
+}
+
+MAIN(benchdbPvd)
+{
+    testPlan(0);
+
+    runBench(1000, 1000);
+    runBench(10000, 100);
+    runBench(100000, 10);
+    runBench(500000, 2);
+
+    return testDone();
+}
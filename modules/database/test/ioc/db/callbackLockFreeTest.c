@@ -0,0 +1,179 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Checks the lock-free callback queue mode: callbacks which re-queue
+ * themselves from a worker (local rings and work stealing), and the
+ * queue statistics reported by callbackQueueStatus() on overflow.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "callback.h"
+#include "dbAccessDefs.h"
+#include "epicsAtomic.h"
+#include "epicsThread.h"
+#include "epicsEvent.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NTHREADS 4
+#define QUEUESIZE 64
+#define NCHAINS 16
+#define NHOPS 1000
+
+typedef struct chainPvt {
+    epicsCallback cb;
+    int hops;
+} chainPvt;
+
+static chainPvt chains[NCHAINS];
+static int chainsDone;
+static int hopsRun;
+static epicsEventId chainsFinished;
+
+static int blockersStarted;
+static int blockersRelease;
+static epicsCallback blockers[NTHREADS];
+
+static int fillersRun;
+static epicsCallback fillers[QUEUESIZE + 1];
+
+static void chainCallback(epicsCallback *pcallback)
+{
+    chainPvt *pvt;
+
+    callbackGetUser(pvt, pcallback);
+    epicsAtomicIncrIntT(&hopsRun);
+    if (++pvt->hops < NHOPS) {
+        /* may transiently overflow, retry until queued */
+        while (callbackRequest(pcallback))
+            epicsThreadSleep(0.001);
+    }
+    else if (epicsAtomicIncrIntT(&chainsDone) == NCHAINS) {
+        epicsEventMustTrigger(chainsFinished);
+    }
+}
+
+static void blockCallback(epicsCallback *pcallback)
+{
+    epicsAtomicIncrIntT(&blockersStarted);
+    while (!epicsAtomicGetIntT(&blockersRelease))
+        epicsThreadSleep(0.01);
+}
+
+static void fillCallback(epicsCallback *pcallback)
+{
+    epicsAtomicIncrIntT(&fillersRun);
+}
+
+static void testChains(void)
+{
+    int i;
+
+    testDiag("Run %d self re-queueing callbacks %d times each",
+        NCHAINS, NHOPS);
+
+    chainsFinished = epicsEventMustCreate(epicsEventEmpty);
+
+    for (i = 0; i < NCHAINS; i++) {
+        callbackSetCallback(chainCallback, &chains[i].cb);
+        callbackSetPriority(i % NUM_CALLBACK_PRIORITIES, &chains[i].cb);
+        callbackSetUser(&chains[i], &chains[i].cb);
+        chains[i].hops = 0;
+        testOk1(callbackRequest(&chains[i].cb) == 0);
+    }
+
+    testOk(epicsEventWaitWithTimeout(chainsFinished, 30.0) == epicsEventOK,
+        "All chains completed");
+    testOk(epicsAtomicGetIntT(&hopsRun) == NCHAINS * NHOPS,
+        "Ran %d callbacks, expected %d", epicsAtomicGetIntT(&hopsRun),
+        NCHAINS * NHOPS);
+
+    epicsEventDestroy(chainsFinished);
+}
+
+static void testOverflow(void)
+{
+    callbackQueueStats stats;
+    int i, n;
+
+    testDiag("Occupy all %d cbLow workers, then fill the queue", NTHREADS);
+
+    for (i = 0; i < NTHREADS; i++) {
+        callbackSetCallback(blockCallback, &blockers[i]);
+        callbackSetPriority(priorityLow, &blockers[i]);
+        callbackRequest(&blockers[i]);
+    }
+    for (n = 0; n < 500 && epicsAtomicGetIntT(&blockersStarted) < NTHREADS; n++)
+        epicsThreadSleep(0.01);
+    testOk(epicsAtomicGetIntT(&blockersStarted) == NTHREADS,
+        "%d workers blocked", epicsAtomicGetIntT(&blockersStarted));
+
+    callbackQueueStatus(1, NULL);
+
+    for (i = 0; i < QUEUESIZE; i++) {
+        callbackSetCallback(fillCallback, &fillers[i]);
+        callbackSetPriority(priorityLow, &fillers[i]);
+        if (callbackRequest(&fillers[i]))
+            break;
+    }
+    testOk(i == QUEUESIZE, "Queued %d callbacks", i);
+
+    callbackSetCallback(fillCallback, &fillers[QUEUESIZE]);
+    callbackSetPriority(priorityLow, &fillers[QUEUESIZE]);
+    testOk(callbackRequest(&fillers[QUEUESIZE]) == S_db_bufFull,
+        "Request on a full queue fails");
+
+    testOk1(callbackQueueStatus(0, &stats) == 0);
+    testOk1(stats.size == QUEUESIZE);
+    testOk(stats.numUsed[priorityLow] == QUEUESIZE, "numUsed %d",
+        stats.numUsed[priorityLow]);
+    testOk(stats.maxUsed[priorityLow] == QUEUESIZE, "maxUsed %d",
+        stats.maxUsed[priorityLow]);
+    testOk(stats.numOverflow[priorityLow] == 1, "numOverflow %d",
+        stats.numOverflow[priorityLow]);
+
+    epicsAtomicSetIntT(&blockersRelease, 1);
+    for (n = 0; n < 500 && epicsAtomicGetIntT(&fillersRun) < QUEUESIZE; n++)
+        epicsThreadSleep(0.01);
+    testOk(epicsAtomicGetIntT(&fillersRun) == QUEUESIZE,
+        "Ran %d queued callbacks", epicsAtomicGetIntT(&fillersRun));
+
+    callbackQueueStatus(1, &stats);
+    testOk(stats.numUsed[priorityLow] == 0, "numUsed %d after drain",
+        stats.numUsed[priorityLow]);
+    callbackQueueStatus(0, &stats);
+    testOk(stats.maxUsed[priorityLow] == 0, "maxUsed %d after reset",
+        stats.maxUsed[priorityLow]);
+}
+
+MAIN(callbackLockFreeTest)
+{
+    testPlan(NCHAINS + 16);
+
+    testOk1(callbackSetQueueMode("nonsense") == -1);
+    testOk1(callbackSetQueueMode("lockfree") == 0);
+    callbackSetQueueSize(QUEUESIZE);
+    callbackParallelThreads(NTHREADS, "");
+    callbackInit();
+    testOk(callbackSetQueueMode("locked") == -1,
+        "Mode can't change after callbackInit()");
+
+    testChains();
+    testOverflow();
+
+    callbackStop();
+    callbackCleanup();
+
+    /* Restore defaults for other tests in the harness */
+    callbackSetQueueMode("locked");
+    callbackSetQueueSize(2000);
+
+    return testDone();
+}
@@ -0,0 +1,128 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Check that the event queue size of a context sets how many monitor
+ * updates are queued before they start being replaced.
+ */
+
+#include <string.h>
+
+#include "caeventmask.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "dbAccess.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "db_field_log.h"
+#include "dbLock.h"
+#include "errlog.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NPOSTS 500
+
+typedef struct monitor {
+    epicsEventId done;
+    int count;
+    int inOrder;
+    epicsInt32 last;
+} monitor;
+
+static void monitorUpdate(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    monitor *mon = (monitor *) user_arg;
+    epicsInt32 val = pfl->u.v.field.dbf_long;
+
+    if (mon->count && val <= mon->last)
+        mon->inOrder = 0;
+    mon->count++;
+    mon->last = val;
+    if (val == NPOSTS - 1)
+        epicsEventMustTrigger(mon->done);
+}
+
+/* Post NPOSTS updates before the event task runs, then count deliveries */
+static int postAndCount(int queueSize, monitor *mon)
+{
+    xRecord *prec = (xRecord *) testdbRecordPtr("x");
+    dbEventCtx ctx;
+    dbChannel *chan;
+    dbEventSubscription sub;
+    int i;
+
+    memset(mon, 0, sizeof(*mon));
+    mon->done = epicsEventMustCreate(epicsEventEmpty);
+    mon->inOrder = 1;
+
+    ctx = db_init_events();
+    testOk1(!!ctx);
+    if (queueSize)
+        testOk(db_set_event_queue_size(ctx, queueSize) == DB_EVENT_OK,
+            "Set queue size %d", queueSize);
+
+    chan = dbChannelCreate("x.VAL");
+    testOk1(chan && !dbChannelOpen(chan));
+    sub = db_add_event(ctx, chan, monitorUpdate, mon, DBE_VALUE);
+    testOk1(!!sub);
+    db_event_enable(sub);
+
+    testOk(db_set_event_queue_size(ctx, 64) == DB_EVENT_ERROR,
+        "Can't change queue size with a subscription");
+
+    for (i = 0; i < NPOSTS; i++) {
+        dbScanLock((dbCommon *) prec);
+        prec->val = i;
+        db_post_events(prec, &prec->val, DBE_VALUE);
+        dbScanUnlock((dbCommon *) prec);
+    }
+
+    testOk1(db_start_events(ctx, "testEvent", NULL, NULL,
+        epicsThreadPriorityLow) == DB_EVENT_OK);
+    testOk(epicsEventWaitWithTimeout(mon->done, 10.0) == epicsEventOK,
+        "Last update delivered");
+    testOk1(mon->inOrder);
+
+    db_cancel_event(sub);
+    db_close_events(ctx);
+    dbChannelDelete(chan);
+    epicsEventDestroy(mon->done);
+    return mon->count;
+}
+
+MAIN(dbEventTest)
+{
+    monitor mon;
+    int n;
+
+    testPlan(17);
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testDiag("Default queue size");
+    n = postAndCount(0, &mon);
+    testOk(n < NPOSTS, "%d of %d updates delivered", n, NPOSTS);
+
+    testDiag("Large queue size");
+    n = postAndCount(1024, &mon);
+    testOk(n == NPOSTS, "%d of %d updates delivered", n, NPOSTS);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
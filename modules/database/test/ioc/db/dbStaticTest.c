@@ -4,6 +4,7 @@
 * in file LICENSE that is included with this distribution.
  \*************************************************************************/
 
+#include <stdio.h>
 #include <string.h>
 
 #include <errlog.h>
@@ -189,11 +190,60 @@ static void testDbVerify(const char *record)
     dbFinishEntry(&entry);
 }
 
+/* Enough records to grow the PV directory a few times */
+#define NPVD 5000
+
+static void testPvd(void)
+{
+    DBENTRY entry;
+    char name[20];
+    int i, created = 0, deleted = 0, found = 0, missing = 0;
+
+    testDiag("PV directory with %d records, deleting every third", NPVD);
+
+    dbInitEntry(pdbbase, &entry);
+    for (i = 0; i < NPVD; i++) {
+        sprintf(name, "pvd%d", i);
+        if (!dbFindRecordType(&entry, "x") && !dbCreateRecord(&entry, name))
+            created++;
+    }
+    testOk(created == NPVD, "Created %d records", created);
+
+    sprintf(name, "pvd%d", 0);
+    testOk1(dbFindRecordType(&entry, "x") == 0 &&
+        dbCreateRecord(&entry, name) == S_dbLib_recExists);
+
+    for (i = 0; i < NPVD; i += 3) {
+        sprintf(name, "pvd%d", i);
+        if (!dbFindRecord(&entry, name) && !dbDeleteRecord(&entry))
+            deleted++;
+    }
+    testOk(deleted == (NPVD + 2) / 3, "Deleted %d records", deleted);
+
+    for (i = 0; i < NPVD; i++) {
+        sprintf(name, "pvd%d", i);
+        if (dbFindRecord(&entry, name))
+            missing++;
+        else
+            found++;
+    }
+    testOk(found == NPVD - deleted && missing == deleted,
+        "Found %d records, %d missing", found, missing);
+    testOk1(dbFindRecord(&entry, "pvd") == S_dbLib_recNotFound);
+
+    for (i = 0; i < NPVD; i++) {
+        sprintf(name, "pvd%d", i);
+        if (!dbFindRecord(&entry, name))
+            dbDeleteRecord(&entry);
+    }
+    dbFinishEntry(&entry);
+}
+
 void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
 
 MAIN(dbStaticTest)
 {
-    testPlan(223);
+    testPlan(228);
     testdbPrepare();
 
     testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
@@ -213,6 +263,8 @@ MAIN(dbStaticTest)
     testRec2Entry("testalias2");
     testRec2Entry("testalias3");
 
+    testPvd();
+
     eltc(0);
     testIocInitOk();
     eltc(1);
@@ -0,0 +1,203 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Check that the CA server answers a repeated UDP search for a name it
+ * doesn't have from its cache of misses, and that adding or deleting a
+ * record empties that cache.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "envDefs.h"
+#include "epicsStdio.h"
+#include "osiSock.h"
+#include "caProto.h"
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "iocInit.h"
+#include "rsrv.h"
+#include "errlog.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define SERVER_PORT 15067u
+#define MINOR_VERSION 13u   /* CA V4.13 */
+#define MISSING "rsrvSearchCacheTest:missing"
+#define ADDED "rsrvSearchCacheTest:added"
+
+static SOCKET sock;
+static osiSockAddr server;
+static epicsUInt32 nextId = 1u;
+
+static size_t addSearch(char *pBuf, const char *name, epicsUInt32 id)
+{
+    caHdr *pHdr = (caHdr *) pBuf;
+    size_t len = strlen(name) + 1;
+    size_t size = (len + 7u) & ~7u;
+
+    memset(pBuf, 0, sizeof(*pHdr) + size);
+    pHdr->m_cmmd = htons(CA_PROTO_SEARCH);
+    pHdr->m_postsize = htons((epicsUInt16) size);
+    pHdr->m_dataType = htons(DONTREPLY);
+    pHdr->m_count = htons(MINOR_VERSION);
+    pHdr->m_cid = htonl(id);
+    pHdr->m_available = htonl(id);
+    memcpy(pHdr + 1, name, len);
+    return sizeof(*pHdr) + size;
+}
+
+/* Search nmiss times for MISSING, then for x, and wait for the answer
+ * to that, which the server sends after handling the others */
+static void search(int nmiss)
+{
+    char buf[MAX_UDP_SEND];
+    epicsUInt32 id = nextId++;
+    size_t n = sizeof(caHdr);
+    caHdr *pHdr = (caHdr *) buf;
+    int i;
+
+    memset(pHdr, 0, sizeof(*pHdr));
+    pHdr->m_cmmd = htons(CA_PROTO_VERSION);
+    pHdr->m_count = htons(MINOR_VERSION);
+    for (i = 0; i < nmiss; i++)
+        n += addSearch(buf + n, MISSING, 0);
+    n += addSearch(buf + n, "x", id);
+    sendto(sock, buf, (int) n, 0, &server.sa, sizeof(server.ia));
+
+    while (1) {
+        struct timeval timeout;
+        fd_set fds;
+        int status;
+        size_t off;
+
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        FD_ZERO(&fds);
+        FD_SET(sock, &fds);
+        if (select((int) sock + 1, &fds, NULL, NULL, &timeout) <= 0)
+            testAbort("No reply to search %u", (unsigned) id);
+
+        status = recv(sock, buf, sizeof(buf), 0);
+        if (status <= 0)
+            testAbort("Can't receive search reply");
+        for (off = 0; off + sizeof(caHdr) <= (size_t) status; ) {
+            pHdr = (caHdr *) (buf + off);
+            if (ntohs(pHdr->m_cmmd) == CA_PROTO_SEARCH &&
+                ntohl(pHdr->m_available) == id)
+                return;
+            off += sizeof(caHdr) + ntohs(pHdr->m_postsize);
+        }
+    }
+}
+
+/* Read the name server's search counters from the casr() report */
+static void searchCounts(unsigned long *pNotFound, unsigned long *pCached)
+{
+    FILE *fp = epicsTempFile();
+    char line[256];
+
+    if (!fp)
+        testAbort("Can't create temporary file");
+    epicsSetThreadStdout(fp);
+    casr(2);
+    epicsSetThreadStdout(NULL);
+    rewind(fp);
+
+    *pNotFound = *pCached = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long found, notFound, cached;
+
+        if (sscanf(line,
+                " Searches: %lu found, %lu not found (%lu from cache)",
+                &found, &notFound, &cached) == 3) {
+            *pNotFound += notFound - cached;
+            *pCached += cached;
+        }
+    }
+    fclose(fp);
+}
+
+static void changeRecord(int add)
+{
+    DBENTRY entry;
+    unsigned int generation = dbPvdGeneration(pdbbase);
+
+    dbInitEntry(pdbbase, &entry);
+    if (add) {
+        testOk1(dbFindRecordType(&entry, "x") == 0 &&
+            dbCreateRecord(&entry, ADDED) == 0);
+    }
+    else {
+        testOk1(dbFindRecord(&entry, ADDED) == 0 &&
+            dbDeleteRecord(&entry) == 0);
+    }
+    dbFinishEntry(&entry);
+    testOk(dbPvdGeneration(pdbbase) != generation, "Generation changed");
+}
+
+static void checkCounts(unsigned long notFound, unsigned long cached,
+    const char *what)
+{
+    unsigned long n, c;
+
+    searchCounts(&n, &c);
+    testOk(n == notFound && c == cached,
+        "%s: %lu looked up, %lu from cache", what, n, c);
+}
+
+MAIN(rsrvSearchCacheTest)
+{
+    char port[16];
+
+    testPlan(7);
+
+    sprintf(port, "%u", SERVER_PORT);
+    epicsEnvSet("EPICS_CA_SERVER_PORT", port);
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CAS_AUTO_BEACON_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CAS_BEACON_ADDR_LIST", "");
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+    rsrv_register_server();
+
+    /* testIocInitOk() doesn't start servers */
+    eltc(0);
+    if (iocInit())
+        testAbort("Failed to start up test database");
+    eltc(1);
+
+    sock = epicsSocketCreate(AF_INET, SOCK_DGRAM, 0);
+    if (sock == INVALID_SOCKET)
+        testAbort("Can't create UDP socket");
+    memset(&server, 0, sizeof(server));
+    server.ia.sin_family = AF_INET;
+    server.ia.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.ia.sin_port = htons(SERVER_PORT);
+
+    search(3);
+    checkCounts(1, 2, "Repeated miss");
+
+    changeRecord(1);
+    search(2);
+    checkCounts(2, 3, "After adding a record");
+
+    changeRecord(0);
+    search(1);
+    checkCounts(3, 3, "After deleting a record");
+
+    epicsSocketDestroy(sock);
+
+    /* the servers keep running, so the database isn't freed */
+    iocShutdown();
+
+    return testDone();
+}
@@ -0,0 +1,171 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Process a periodic list in parallel partitions and check that the
+ * records of each lockset are still processed in PHAS order.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "epicsAtomic.h"
+#include "epicsMutex.h"
+#include "epicsThread.h"
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "dbScan.h"
+#include "errlog.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NGROUPS 8
+#define NRECS 5
+#define MAXTHREADS 8
+
+typedef struct group {
+    int last;
+    int scans;
+    int misordered;
+} group;
+
+static group groups[NGROUPS];
+
+static epicsMutexId threadLock;
+static epicsThreadId threads[MAXTHREADS];
+static int nthreads;
+
+static void noteThread(void)
+{
+    epicsThreadId self = epicsThreadGetIdSelf();
+    int i;
+
+    epicsMutexMustLock(threadLock);
+    for (i = 0; i < nthreads; i++) {
+        if (threads[i] == self)
+            break;
+    }
+    if (i == nthreads && nthreads < MAXTHREADS)
+        threads[nthreads++] = self;
+    epicsMutexUnlock(threadLock);
+}
+
+/* Runs with the lockset locked, so each group is only touched by one
+ * thread at a time. */
+static void checkOrder(xRecord *prec)
+{
+    group *pg;
+    int g, r;
+
+    if (sscanf(prec->name, "g%dr%d", &g, &r) != 2)
+        return;
+    pg = &groups[g];
+    if (r != (pg->last + 1) % NRECS)
+        pg->misordered++;
+    pg->last = r;
+    if (r == NRECS - 1)
+        pg->scans++;
+    noteThread();
+}
+
+static int groupScans(int g, int *pmisordered)
+{
+    xRecord *prec;
+    char name[20];
+    int scans;
+
+    sprintf(name, "g%dr0", g);
+    prec = (xRecord *) testdbRecordPtr(name);
+    dbScanLock((dbCommon *) prec);
+    scans = groups[g].scans;
+    if (pmisordered)
+        *pmisordered = groups[g].misordered;
+    dbScanUnlock((dbCommon *) prec);
+    return scans;
+}
+
+MAIN(scanParallelTest)
+{
+    char macros[40];
+    unsigned long lockId[NGROUPS];
+    int g, r, n, first;
+
+    testPlan(4 + 2 * NGROUPS);
+
+    threadLock = epicsMutexMustCreate();
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (g = 0; g < NGROUPS; g++) {
+        for (r = 0; r < NRECS; r++) {
+            if (r)
+                sprintf(macros, "G=%d,R=%d,LINK=g%dr0", g, r, g);
+            else
+                sprintf(macros, "G=%d,R=%d", g, r);
+            testdbReadDatabase("scanParallelTest.db", NULL, macros);
+        }
+        groups[g].last = NRECS - 1;
+    }
+
+    testOk1(scanPeriodicParallel(2) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(scanPeriodicParallel(0) == -1,
+        "Can't be changed after iocInit");
+
+    for (g = 0; g < NGROUPS; g++) {
+        for (r = 0; r < NRECS; r++) {
+            char name[20];
+            xRecord *prec;
+
+            sprintf(name, "g%dr%d", g, r);
+            prec = (xRecord *) testdbRecordPtr(name);
+            if (!r)
+                lockId[g] = dbLockGetLockId((dbCommon *) prec);
+            dbScanLock((dbCommon *) prec);
+            prec->clbk = checkOrder;
+            dbScanUnlock((dbCommon *) prec);
+        }
+    }
+    testOk(lockId[0] != lockId[1], "Groups are in different locksets");
+
+    /* Wait for some scans rather than counting them in a fixed time.
+     * Every group is in the same list, so all are scanned as often, give
+     * or take the scan in progress when checks were enabled or read. */
+    for (n = 0; n < 200 && groupScans(0, NULL) < 10; n++)
+        epicsThreadSleep(0.05);
+    first = groupScans(0, NULL);
+
+    for (g = 0; g < NGROUPS; g++) {
+        int misordered;
+        int scans = groupScans(g, &misordered);
+
+        testOk(first >= 10 && scans >= first - 2 && scans <= first + 2,
+            "group %d scanned %d times, group 0 %d", g, scans, first);
+        /* The first scan may be in progress when the checks are enabled */
+        testOk(misordered <= 1, "group %d misordered %d times",
+            g, misordered);
+    }
+
+    epicsMutexMustLock(threadLock);
+    testOk(nthreads > 1, "Processed by %d threads", nthreads);
+    epicsMutexUnlock(threadLock);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    scanPeriodicParallel(0);
+    epicsMutexDestroy(threadLock);
+
+    return testDone();
+}
@@ -0,0 +1,244 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Run periodic scans from the timer wheel engine and check that each
+ * list is scanned at its own rate, that lists due together are scanned
+ * fastest first, and that it stops while its workers are busy.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "dbAccess.h"
+#include "dbScan.h"
+#include "errlog.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+#include "xRecord.h"
+
+void dbTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NRECS 4
+
+static int fastCount[NRECS];
+static int slowCount[NRECS];
+
+static void countFast(xRecord *prec)
+{
+    epicsAtomicIncrIntT(&fastCount[prec->val]);
+}
+
+static void countSlow(xRecord *prec)
+{
+    epicsAtomicIncrIntT(&slowCount[prec->val]);
+}
+
+static void busy(xRecord *prec)
+{
+    epicsThreadSleep(0.02);
+}
+
+static epicsEventId blocked, release;
+static int released;
+static int slowScans = -1;
+static int sequence;
+static int scanOrder[3];
+
+/* Hold the only worker while the other lists become due. The first
+ * scans of each rate are spread over its period, which puts a 2 second
+ * deadline just after every other 1 second scan and ahead of the next
+ * .5 second one, so a plain FIFO would scan those two out of order.
+ * Those are the second 1 second scans after each 2 second scan.
+ */
+static void block(xRecord *prec)
+{
+    if (epicsAtomicGetIntT(&released) || slowScans < 0 || ++slowScans != 2)
+        return;
+    epicsEventMustTrigger(blocked);
+    epicsEventWaitWithTimeout(release, 10.0);
+    epicsAtomicSetIntT(&released, 1);
+}
+
+static void order(xRecord *prec)
+{
+    if (prec->val == 2 && slowScans < 0)
+        slowScans = 0;
+    if (epicsAtomicGetIntT(&released) && !scanOrder[prec->val])
+        scanOrder[prec->val] = epicsAtomicIncrIntT(&sequence);
+}
+
+static epicsEventId stopped;
+
+static void shutdownTask(void *arg)
+{
+    testIocShutdownOk();
+    epicsEventMustTrigger(stopped);
+}
+
+static void setCounter(const char *prefix, int i,
+    void (*clbk)(xRecord *))
+{
+    char name[20];
+    xRecord *prec;
+
+    sprintf(name, "%s%d", prefix, i);
+    prec = (xRecord *) testdbRecordPtr(name);
+    dbScanLock((dbCommon *) prec);
+    prec->val = i;
+    prec->clbk = clbk;
+    dbScanUnlock((dbCommon *) prec);
+}
+
+static void loadRecords(void)
+{
+    char macros[10];
+    int i;
+
+    testdbPrepare();
+    testdbReadDatabase("dbTestIoc.dbd", NULL, NULL);
+    dbTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NRECS; i++) {
+        sprintf(macros, "N=%d", i);
+        testdbReadDatabase("scanWheelTest.db", NULL, macros);
+    }
+}
+
+static void testBusyStop(void)
+{
+    int i;
+
+    testDiag("Stop the wheel while its workers are busy");
+
+    loadRecords();
+    testOk1(scanPeriodicWheel(4) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    for (i = 0; i < NRECS; i++) {
+        setCounter("fast", i, busy);
+        setCounter("slow", i, busy);
+    }
+    epicsThreadSleep(0.5);
+
+    /* Stop from another thread, so a hang fails the test */
+    stopped = epicsEventMustCreate(epicsEventEmpty);
+    epicsThreadMustCreate("shutdown", epicsThreadPriorityMedium,
+        epicsThreadGetStackSize(epicsThreadStackSmall), shutdownTask, NULL);
+    testOk(epicsEventWaitWithTimeout(stopped, 20.0) == epicsEventOK,
+        "Busy wheel stopped");
+    epicsEventDestroy(stopped);
+
+    testdbCleanup();
+    testOk1(scanPeriodicWheel(0) == 0);
+}
+
+static void testRateOrder(void)
+{
+    static const char *names[] = {"fifth0", "half0", "two0"};
+    int i, ordered = 1;
+
+    testDiag("Lists due together are scanned fastest first");
+
+    loadRecords();
+    testOk1(scanPeriodicWheel(1) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    blocked = epicsEventMustCreate(epicsEventEmpty);
+    release = epicsEventMustCreate(epicsEventEmpty);
+    for (i = 0; i < 3; i++) {
+        xRecord *prec = (xRecord *) testdbRecordPtr(names[i]);
+
+        dbScanLock((dbCommon *) prec);
+        prec->val = i;
+        prec->clbk = order;
+        dbScanUnlock((dbCommon *) prec);
+    }
+    setCounter("slow", 0, block);
+
+    testOk(epicsEventWaitWithTimeout(blocked, 10.0) == epicsEventOK,
+        "Worker blocked");
+    epicsThreadSleep(2.5);
+    epicsEventMustTrigger(release);
+    epicsThreadSleep(0.5);
+
+    for (i = 0; i < 3; i++) {
+        testDiag("%s scanned %d after release", names[i], scanOrder[i]);
+        if (!scanOrder[i] || (i > 0 && scanOrder[i] < scanOrder[i - 1]))
+            ordered = 0;
+    }
+    testOk(ordered, "Due lists scanned fastest first");
+
+    testIocShutdownOk();
+    testdbCleanup();
+    epicsEventDestroy(blocked);
+    epicsEventDestroy(release);
+    testOk1(scanPeriodicWheel(0) == 0);
+}
+
+MAIN(scanWheelTest)
+{
+    int i, n;
+
+    testPlan(3 + 2 * NRECS + 4 + 5 * 3);
+
+    loadRecords();
+
+    testOk1(scanPeriodicWheel(2) == 0);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testOk(scanPeriodicWheel(0) == -1,
+        "Engine can't be changed after iocInit");
+
+    for (i = 0; i < NRECS; i++) {
+        setCounter("fast", i, countFast);
+        setCounter("slow", i, countSlow);
+    }
+
+    /* Wait for a few slow scans, then compare the two rates with wide
+     * margins rather than counting scans in a fixed time */
+    for (n = 0; n < 200; n++) {
+        for (i = 0; i < NRECS; i++) {
+            if (epicsAtomicGetIntT(&slowCount[i]) < 3)
+                break;
+        }
+        if (i == NRECS)
+            break;
+        epicsThreadSleep(0.05);
+    }
+
+    for (i = 0; i < NRECS; i++) {
+        int slow = epicsAtomicGetIntT(&slowCount[i]);
+        int fast = epicsAtomicGetIntT(&fastCount[i]);
+
+        testOk(slow >= 3, "slow%d scanned %d times", i, slow);
+        testOk(fast >= 5 * (slow - 1) && fast <= 15 * (slow + 1),
+            "fast%d scanned %d times, about 10 per slow scan", i, fast);
+    }
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    testOk1(scanPeriodicWheel(0) == 0);
+
+    testRateOrder();
+
+    for (i = 0; i < 5; i++)
+        testBusyStop();
+
+    return testDone();
+}
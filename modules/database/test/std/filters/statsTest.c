@@ -0,0 +1,330 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ *  Tests for the statistics filter "stats"
+ */
+
+#include <string.h>
+#include <math.h>
+
+#include "alarm.h"
+#include "dbDefs.h"
+#include "dbStaticLib.h"
+#include "dbAccessDefs.h"
+#include "db_field_log.h"
+#include "dbCommon.h"
+#include "dbChannel.h"
+#include "registry.h"
+#include "chfPlugin.h"
+#include "errlog.h"
+#include "dbmf.h"
+#include "epicsMath.h"
+#include "epicsUnitTest.h"
+#include "dbUnitTest.h"
+#include "epicsTime.h"
+#include "testMain.h"
+#include "osiFileName.h"
+
+void filterTest_registerRecordDeviceDriver(struct dbBase *);
+
+static void fl_setup(db_field_log *pfl, long val, double t,
+    unsigned short sevr)
+{
+    memset(pfl, 0, sizeof(db_field_log));
+    pfl->ctx  = dbfl_context_event;
+    pfl->type = dbfl_type_val;
+    pfl->sevr = sevr;
+    pfl->stat = sevr ? HIGH_ALARM : NO_ALARM;
+    pfl->time.secPastEpoch = (epicsUInt32) t;
+    pfl->time.nsec = (epicsUInt32) ((t - floor(t)) * 1e9 + 0.5);
+    pfl->field_type  = DBF_LONG;
+    pfl->field_size  = sizeof(epicsInt32);
+    pfl->no_elements = 1;
+    pfl->u.v.field.dbf_long = val;
+}
+
+static db_field_log * logValue(dbChannel *pch, long val, double t,
+    unsigned short sevr)
+{
+    db_field_log *pfl = db_create_read_log(pch);
+
+    fl_setup(pfl, val, t, sevr);
+    return pfl;
+}
+
+/* An event log which reads the record */
+static db_field_log * logRecord(dbChannel *pch)
+{
+    db_field_log *pfl = db_create_read_log(pch);
+
+    pfl->ctx = dbfl_context_event;
+    return pfl;
+}
+
+static void testHead (char* title) {
+    testDiag("--------------------------------------------------------");
+    testDiag("%s", title);
+    testDiag("--------------------------------------------------------");
+}
+
+static void mustDrop(dbChannel *pch, db_field_log *pfl, char* m) {
+    int oldFree = db_available_logs();
+    db_field_log *pfl2 = dbChannelRunPreChain(pch, pfl);
+    int newFree = db_available_logs();
+
+    testOk(NULL == pfl2, "filter drops field_log (%s)", m);
+    testOk(newFree == oldFree + 1, "field_log was freed - %d+1 => %d",
+        oldFree, newFree);
+
+    db_delete_field_log(pfl2);
+}
+
+static int equal(double a, double b)
+{
+    if (isnan(b))
+        return isnan(a);
+    return fabs(a - b) <= 1e-9 * (fabs(b) > 1 ? fabs(b) : 1);
+}
+
+/* Returns the log which was passed, for the caller to delete */
+static db_field_log * mustPass(dbChannel *pch, db_field_log *pfl,
+    double expect, char* m)
+{
+    db_field_log *pfl2 = dbChannelRunPreChain(pch, pfl);
+
+    testOk(pfl2 == pfl && pfl->type == dbfl_type_val &&
+        pfl->field_type == DBF_DOUBLE && pfl->no_elements == 1 &&
+        equal(pfl->u.v.field.dbf_double, expect),
+        "filter passes %g (%s)", pfl2 ? pfl2->u.v.field.dbf_double : -1, m);
+    return pfl2;
+}
+
+static void mustPassDelete(dbChannel *pch, db_field_log *pfl,
+    double expect, char* m)
+{
+    db_delete_field_log(mustPass(pch, pfl, expect, m));
+}
+
+static dbChannel * openChannel(const char *name)
+{
+    dbChannel *pch = dbChannelCreate(name);
+
+    testOk(pch && !dbChannelOpen(pch) && ellCount(&pch->pre_chain) == 1 &&
+        dbChannelFinalFieldType(pch) == DBF_DOUBLE &&
+        dbChannelFinalElements(pch) == 1,
+        "%s gives a double", name);
+    if (!pch)
+        testAbort("Can't create %s", name);
+    return pch;
+}
+
+static int nDtor;
+
+static void dtor(db_field_log *pfl)
+{
+    nDtor++;
+}
+
+MAIN(statsTest)
+{
+    static const struct {
+        const char *name;
+        double value;
+    } stats[] = {
+        {"x.VAL{\"stats\":{\"s\":\"max\",\"n\":2}}", 5},
+        {"x.VAL{\"stats\":{\"s\":\"min\",\"n\":2}}", 3},
+        {"x.VAL{\"stats\":{\"s\":\"rms\",\"n\":2}}", 4.123105625617661},
+        {"x.VAL{\"stats\":{\"s\":\"std\",\"n\":2}}", 1},
+    };
+    static epicsInt16 shorts[] = {-4, 2, 8, 1, 3};
+    dbChannel *pch;
+    const chFilterPlugin *plug;
+    char myname[] = "stats";
+    db_field_log *pfl;
+    double vals[37];
+    int i, logsFree, logsFinal;
+    dbEventCtx evtctx;
+
+    testPlan(90);
+
+    testdbPrepare();
+
+    testdbReadDatabase("filterTest.dbd", NULL, NULL);
+
+    filterTest_registerRecordDeviceDriver(pdbbase);
+
+    testdbReadDatabase("xRecord.db", NULL, NULL);
+    testdbReadDatabase("statsTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    evtctx = db_init_events();
+
+    testOk(!!(plug = dbFindFilter(myname, strlen(myname))),
+        "plugin '%s' registered correctly", myname);
+
+    /* Bad parms */
+    testOk(!(pch = dbChannelCreate("x.VAL{\"stats\":{\"n\":-1}}")),
+           "dbChannel with stats (n=-1) failed");
+    testOk(!(pch = dbChannelCreate("x.VAL{\"stats\":{\"t\":-1}}")),
+           "dbChannel with stats (t=-1) failed");
+    testOk(!(pch = dbChannelCreate("x.VAL{\"stats\":{\"n\":2,\"t\":1}}")),
+           "dbChannel with stats (n=2, t=1) failed");
+    testOk(!(pch = dbChannelCreate("x.VAL{\"stats\":{\"s\":\"median\"}}")),
+           "dbChannel with stats (s=median) failed");
+    testOk(!(pch = dbChannelCreate("x.VAL{\"stats\":{\"x\":true}}")),
+           "dbChannel with stats (x=true) failed");
+
+    /* Start the free-list */
+    db_delete_field_log(db_create_read_log(NULL));
+    logsFree = db_available_logs();
+    testDiag("%d field_logs on free-list", logsFree);
+
+    testHead("Non-numeric field");
+    pch = dbChannelCreate("x.DESC{\"stats\":{}}");
+    testOk(pch && !dbChannelOpen(pch) && ellCount(&pch->pre_chain) == 0 &&
+        dbChannelFinalFieldType(pch) == DBF_STRING,
+        "stats isn't applied to a string");
+    dbChannelDelete(pch);
+
+    testHead("Mean of each 3 updates");
+    pch = openChannel("x.VAL{\"stats\":{\"n\":3}}");
+    mustDrop(pch, logValue(pch, 1, 1, NO_ALARM), "1");
+    mustDrop(pch, logValue(pch, 2, 2, NO_ALARM), "2");
+    mustPassDelete(pch, logValue(pch, 3, 3, NO_ALARM), 2, "3");
+    mustDrop(pch, logValue(pch, 4, 4, NO_ALARM), "4");
+    mustDrop(pch, logValue(pch, 5, 5, MINOR_ALARM), "5");
+    pfl = mustPass(pch, logValue(pch, 9, 6, NO_ALARM), 6, "9");
+    testOk(pfl && pfl->sevr == MINOR_ALARM && pfl->stat == HIGH_ALARM &&
+        pfl->time.secPastEpoch == 6,
+        "Result has the worst alarm and the last time stamp");
+    db_delete_field_log(pfl);
+    dbChannelDelete(pch);
+
+    testHead("Default window of one update");
+    pch = openChannel("x.VAL{\"stats\":{}}");
+    mustPassDelete(pch, logValue(pch, 7, 1, NO_ALARM), 7, "7");
+    dbChannelDelete(pch);
+
+    for (i = 0; i < NELEMENTS(stats); i++) {
+        testHead((char *) stats[i].name);
+        pch = openChannel(stats[i].name);
+        mustDrop(pch, logValue(pch, 3, 1, NO_ALARM), "3");
+        mustPassDelete(pch, logValue(pch, 5, 2, NO_ALARM), stats[i].value,
+            "5");
+        dbChannelDelete(pch);
+    }
+
+    testHead("Time window of 1 second");
+    pch = openChannel("x.VAL{\"stats\":{\"t\":1}}");
+    mustDrop(pch, logValue(pch, 1, 10.0, NO_ALARM), "1 at 10.0");
+    mustDrop(pch, logValue(pch, 2, 10.5, NO_ALARM), "2 at 10.5");
+    mustDrop(pch, logValue(pch, 3, 10.9, NO_ALARM), "3 at 10.9");
+    pfl = mustPass(pch, logValue(pch, 10, 11.0, NO_ALARM), 2, "10 at 11.0");
+    testOk(pfl && pfl->time.secPastEpoch == 10 &&
+        pfl->time.nsec == 900000000, "Result has the time of 3");
+    db_delete_field_log(pfl);
+    mustDrop(pch, logValue(pch, 20, 11.5, NO_ALARM), "20 at 11.5");
+    mustPassDelete(pch, logValue(pch, 0, 12.0, NO_ALARM), 15, "0 at 12.0");
+    mustPassDelete(pch, logValue(pch, 4, 5.0, NO_ALARM), 0,
+        "time went back");
+    dbChannelDelete(pch);
+
+    testHead("Arrays read from the record");
+    for (i = 0; i < 37; i++)
+        vals[i] = i;
+    testdbPutArrFieldOk("a", DBR_DOUBLE, 37, vals);
+
+    pch = openChannel("a.VAL{\"stats\":{}}");
+    mustPassDelete(pch, logRecord(pch), 18, "mean");
+    dbChannelDelete(pch);
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"std\"}}");
+    mustPassDelete(pch, logRecord(pch), sqrt(114), "std");
+    dbChannelDelete(pch);
+
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"min\",\"n\":2}}");
+    mustDrop(pch, logRecord(pch), "0..36");
+    for (i = 0; i < 37; i++)
+        vals[i] = 100 - i;
+    vals[33] = -3;
+    testdbPutArrFieldOk("a", DBR_DOUBLE, 37, vals);
+    mustPassDelete(pch, logRecord(pch), -3, "min of both");
+
+    testDiag("A read gets the statistic of the current value");
+    pfl = db_create_read_log(pch);
+    mustPassDelete(pch, pfl, -3, "read");
+    dbChannelDelete(pch);
+
+    testHead("NaN values");
+    vals[20] = epicsNAN;
+    testdbPutArrFieldOk("a", DBR_DOUBLE, 37, vals);
+    pch = openChannel("a.VAL{\"stats\":{}}");
+    mustPassDelete(pch, logRecord(pch), epicsNAN, "mean");
+    dbChannelDelete(pch);
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"max\"}}");
+    mustPassDelete(pch, logRecord(pch), 100, "max");
+    dbChannelDelete(pch);
+
+    testHead("All NaN values");
+    for (i = 0; i < 37; i++)
+        vals[i] = epicsNAN;
+    testdbPutArrFieldOk("a", DBR_DOUBLE, 37, vals);
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"min\"}}");
+    mustPassDelete(pch, logRecord(pch), epicsNAN, "min");
+    dbChannelDelete(pch);
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"max\"}}");
+    mustPassDelete(pch, logRecord(pch), epicsNAN, "max");
+    dbChannelDelete(pch);
+
+    testHead("Large offset");
+    pch = openChannel("x.VAL{\"stats\":{\"s\":\"std\",\"n\":4}}");
+    mustDrop(pch, logValue(pch, 100000000, 1, NO_ALARM), "1e8");
+    mustDrop(pch, logValue(pch, 100000001, 2, NO_ALARM), "1e8+1");
+    mustDrop(pch, logValue(pch, 100000002, 3, NO_ALARM), "1e8+2");
+    mustPassDelete(pch, logValue(pch, 100000003, 4, NO_ALARM),
+        sqrt(1.25), "1e8+3");
+    dbChannelDelete(pch);
+
+    for (i = 0; i < 37; i++)
+        vals[i] = 1e9 + i;
+    testdbPutArrFieldOk("a", DBR_DOUBLE, 37, vals);
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"std\",\"n\":2}}");
+    mustDrop(pch, logRecord(pch), "1e9+0..36");
+    mustPassDelete(pch, logRecord(pch), sqrt(114), "1e9+0..36 again");
+    dbChannelDelete(pch);
+    pch = openChannel("a.VAL{\"stats\":{\"s\":\"rms\"}}");
+    mustPassDelete(pch, logRecord(pch), sqrt((1e9 + 18) * (1e9 + 18) + 114),
+        "rms");
+    dbChannelDelete(pch);
+
+    testHead("Arrays in field logs");
+    pch = openChannel("b.VAL{\"stats\":{\"s\":\"max\"}}");
+    pfl = db_create_read_log(pch);
+    pfl->ctx = dbfl_context_event;
+    pfl->type = dbfl_type_ref;
+    pfl->field_type = DBF_SHORT;
+    pfl->field_size = sizeof(epicsInt16);
+    pfl->no_elements = NELEMENTS(shorts);
+    pfl->u.r.field = shorts;
+    pfl->u.r.dtor = dtor;
+    mustPassDelete(pch, pfl, 8, "shorts");
+    testOk(nDtor == 1, "Array was released");
+    dbChannelDelete(pch);
+
+    logsFinal = db_available_logs();
+    testOk(logsFree == logsFinal, "%d field_logs on free-list", logsFinal);
+
+    db_close_events(evtctx);
+
+    testIocShutdownOk();
+
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,335 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Array records share their buffers with the field logs of monitors,
+ * and swap in another buffer before writing to one which is shared.
+ */
+
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbArrayBuf.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "dbUnitTest.h"
+#include "db_field_log.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "errlog.h"
+
+#include "caeventmask.h"
+#include "waveformRecord.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static unsigned nConvert;
+
+static int convert(void *pdst, const void *psrc, size_t size, void *arg)
+{
+    const char *src = psrc;
+    char *dst = pdst;
+    size_t i;
+
+    for (i = 0; i < size; i++)
+        dst[i] = src[i] + (char) (size_t) arg;
+    nConvert++;
+    return 0;
+}
+
+static int failConvert(void *pdst, const void *psrc, size_t size, void *arg)
+{
+    return 1;
+}
+
+static void testPool(void)
+{
+    dbArrayBufPool *pool = dbArrayBufPoolCreate(16);
+    dbArrayBufStats stats;
+    char foreign[16];
+    char *buf, *nbuf;
+    const char *derived;
+    int i, zero = 1;
+
+    testDiag("dbArrayBuf pool");
+
+    buf = dbArrayBufCurrent(pool);
+    for (i = 0; i < 16; i++)
+        zero &= buf[i] == 0;
+    testOk(zero, "First buffer is zeroed");
+    testOk1(!dbArrayBufShared(buf));
+    testOk(dbArrayBufWritable(pool, buf, 16) == buf,
+        "Unshared buffer is written in place");
+    testOk(dbArrayBufShareable(pool, buf) == buf, "Current buffer is shareable");
+    testOk(dbArrayBufShareable(pool, foreign) == NULL,
+        "Other buffer isn't shareable");
+    testOk(dbArrayBufWritable(pool, foreign, 16) == foreign,
+        "Other buffer is written in place");
+    dbArrayBufShare = 0;
+    testOk(dbArrayBufShareable(pool, buf) == NULL,
+        "Nothing is shareable with dbArrayBufShare=0");
+    dbArrayBufShare = 1;
+
+    for (i = 0; i < 16; i++)
+        buf[i] = i;
+    dbArrayBufRef(buf);
+    testOk1(dbArrayBufShared(buf));
+    nbuf = dbArrayBufWritable(pool, buf, 8);
+    testOk(nbuf != buf, "Shared buffer is swapped");
+    testOk1(dbArrayBufCurrent(pool) == nbuf);
+    testOk(memcmp(nbuf, buf, 8) == 0 && nbuf[8] == 0,
+        "First 8 bytes were copied");
+    testOk(buf[15] == 15, "Shared buffer is unchanged");
+    dbArrayBufPoolStats(pool, &stats);
+    testOk(stats.size == 16 && stats.nBuffers == 2 && stats.maxBuffers == 2 &&
+        stats.nCopies == 1, "size %u buffers %u max %u copies %u",
+        (unsigned) stats.size, (unsigned) stats.nBuffers,
+        (unsigned) stats.maxBuffers, (unsigned) stats.nCopies);
+    dbArrayBufRelease(buf);
+
+    dbArrayBufRef(nbuf);
+    buf = dbArrayBufWritable(pool, nbuf, 0);
+    testOk(buf != nbuf, "Spare buffer is reused");
+    dbArrayBufRelease(nbuf);
+    dbArrayBufPoolStats(pool, &stats);
+    testOk(stats.nBuffers == 2 && stats.nCopies == 1,
+        "buffers %u copies %u", (unsigned) stats.nBuffers,
+        (unsigned) stats.nCopies);
+
+    testDiag("Derived copies");
+    buf[0] = 10;
+    dbArrayBufRef(buf);
+    nConvert = 0;
+    derived = dbArrayBufDerived(buf, 4, convert, (void *) 1);
+    testOk(derived && derived[0] == 11, "Derived copy made");
+    testOk(dbArrayBufDerived(buf, 2, convert, (void *) 1) == derived &&
+        nConvert == 1, "Derived copy is cached");
+    testOk1(!dbArrayBufDerived(buf, 8, convert, (void *) 1));
+    testOk1(!dbArrayBufDerived(buf, 4, convert, (void *) 2));
+    testOk1(!dbArrayBufDerived(buf, 17, convert, (void *) 1));
+    dbArrayBufRelease(buf);
+    testOk1(dbArrayBufWritable(pool, buf, 16) == buf);
+    buf[0] = 20;
+    derived = dbArrayBufDerived(buf, 4, convert, (void *) 1);
+    testOk(derived && derived[0] == 21 && nConvert == 2,
+        "Writing drops the derived copy");
+    testOk1(dbArrayBufWritable(pool, buf, 16) == buf);
+    testOk1(!dbArrayBufDerived(buf, 4, failConvert, NULL));
+
+    dbArrayBufPoolDestroy(pool);
+}
+
+typedef struct monitor {
+    epicsEventId wake;
+    unsigned count;
+    int type;
+    void *shared;
+    long nelem;
+    double vals[8];
+} monitor;
+
+static void monitorUpdate(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    monitor *mon = user_arg;
+    long nelem = 8;
+
+    mon->type = pfl->type;
+    mon->shared = dbArrayBufFromLog(pfl);
+    memset(mon->vals, 0, sizeof(mon->vals));
+    if (dbChannelGetField(chan, DBR_DOUBLE, mon->vals, NULL, &nelem, pfl))
+        nelem = -1;
+    mon->nelem = nelem;
+    mon->count++;
+    epicsEventMustTrigger(mon->wake);
+}
+
+static dbEventSubscription subscribe(dbEventCtx ctx, const char *name,
+    monitor *mon)
+{
+    dbChannel *chan = dbChannelCreate(name);
+    dbEventSubscription sub;
+
+    memset(mon, 0, sizeof(*mon));
+    mon->wake = epicsEventMustCreate(epicsEventEmpty);
+    if (!chan || dbChannelOpen(chan))
+        testAbort("Can't open %s", name);
+    sub = db_add_event(ctx, chan, monitorUpdate, mon, DBE_VALUE);
+    db_event_enable(sub);
+    return sub;
+}
+
+static void unsubscribe(dbEventSubscription sub, monitor *mon)
+{
+    dbChannel *chan = ((struct evSubscrip *) sub)->chan;
+
+    db_cancel_event(sub);
+    dbChannelDelete(chan);
+    epicsEventDestroy(mon->wake);
+}
+
+static void waitFor(monitor *mon, unsigned count)
+{
+    while (mon->count < count) {
+        if (epicsEventWaitWithTimeout(mon->wake, 10.0) != epicsEventOK)
+            testAbort("Timed out waiting for update %u", count);
+    }
+}
+
+static void waitUnshared(void *buf)
+{
+    int i;
+
+    for (i = 0; i < 1000 && dbArrayBufShared(buf); i++)
+        epicsThreadSleep(0.01);
+}
+
+static void testRecords(void)
+{
+    static const double v1[] = {1, 2, 3, 4}, v2[] = {5, 6, 7, 8};
+    static const epicsInt32 l1[] = {9, 10, 11};
+    waveformRecord *wf;
+    dbArrayBufStats stats;
+    dbEventCtx ctx;
+    dbEventSubscription sub, subArr, subSa, subAai;
+    monitor mon, monArr, monSa, monAai;
+    void *b1, *b2;
+
+    testDiag("Records and monitors");
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("arrayShareTest.db", NULL, NULL);
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    wf = (waveformRecord *) testdbRecordPtr("wf");
+    testOk(wf->rpvt && wf->bptr == dbArrayBufCurrent(wf->rpvt),
+        "waveform data is in its pool");
+
+    /* The event task isn't started yet, so updates stay queued */
+    ctx = db_init_events();
+    sub = subscribe(ctx, "wf", &mon);
+    subArr = subscribe(ctx, "wf.[1:2]", &monArr);
+
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, 4, v1);
+    b1 = wf->bptr;
+    testOk(dbArrayBufShared(b1), "Queued update shares the buffer");
+
+    dbArrayBufPoolStats(wf->rpvt, &stats);
+    testdbGetArrFieldEqual("wf", DBR_DOUBLE, 8, 4, v1);
+    {
+        dbArrayBufStats after;
+
+        dbArrayBufPoolStats(wf->rpvt, &after);
+        testOk(wf->bptr == b1 && after.nCopies == stats.nCopies,
+            "Reading a shared buffer leaves it in place");
+    }
+
+    /* Keep it to look at after it has been replaced */
+    dbArrayBufRef(b1);
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, 4, v2);
+    testOk(wf->bptr != b1, "Put into a shared buffer swaps it");
+    testOk(memcmp(b1, v1, sizeof(v1)) == 0, "Shared buffer is unchanged");
+    testOk(memcmp(wf->bptr, v2, sizeof(v2)) == 0, "New buffer has the put");
+    dbArrayBufRelease(b1);
+    testdbGetArrFieldEqual("wf", DBR_DOUBLE, 8, 4, v2);
+
+    db_start_events(ctx, "arrayShare", NULL, NULL, epicsThreadPriorityLow);
+    waitFor(&mon, 1);
+    waitFor(&monArr, 1);
+    epicsThreadSleep(0.1);
+    testOk(mon.count == 1, "Unsent update was replaced (%u)", mon.count);
+    testOk(mon.type == dbfl_type_ref && mon.shared,
+        "Monitor got a shared buffer");
+    testOk(mon.nelem == 4 && memcmp(mon.vals, v2, sizeof(v2)) == 0,
+        "Monitor got %ld elements %g %g %g %g", mon.nelem,
+        mon.vals[0], mon.vals[1], mon.vals[2], mon.vals[3]);
+    testOk(monArr.count == 1, "Filtered monitor's update was replaced too (%u)",
+        monArr.count);
+    testOk(monArr.type == dbfl_type_ref && !monArr.shared &&
+        monArr.nelem == 2 && monArr.vals[0] == 6 && monArr.vals[1] == 7,
+        "Filtered monitor got its own copy of %ld elements %g %g",
+        monArr.nelem, monArr.vals[0], monArr.vals[1]);
+
+    testDiag("Processing");
+    waitUnshared(wf->bptr);
+    b2 = wf->bptr;
+    dbArrayBufPoolStats(wf->rpvt, &stats);
+    testdbPutFieldOk("wf.PROC", DBR_LONG, 1);
+    waitFor(&mon, 2);
+    testOk(wf->bptr == b2, "Unshared buffer is used again");
+    dbArrayBufRef(b2);
+    waitUnshared(b2);
+    testdbPutFieldOk("wf.PROC", DBR_LONG, 1);
+    waitFor(&mon, 3);
+    testOk(wf->bptr != b2 && memcmp(wf->bptr, v2, sizeof(v2)) == 0,
+        "Processing swaps a shared buffer and keeps the data");
+    dbArrayBufRelease(b2);
+    {
+        dbArrayBufStats after;
+
+        dbArrayBufPoolStats(wf->rpvt, &after);
+        testOk(after.nCopies == stats.nCopies + 1,
+            "Only the shared buffer was copied");
+    }
+
+    testDiag("dbArrayBufShare=0");
+    dbArrayBufShare = 0;
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, 4, v1);
+    waitFor(&mon, 4);
+    testOk(mon.type == dbfl_type_rec && !mon.shared &&
+        mon.nelem == 4 && mon.vals[3] == 4,
+        "Monitor reads the record");
+    dbArrayBufShare = 1;
+
+    testDiag("subArray");
+    subSa = subscribe(ctx, "sa", &monSa);
+    testdbPutFieldOk("sa.PROC", DBR_LONG, 1);
+    waitFor(&monSa, 1);
+    testOk(monSa.type == dbfl_type_ref && monSa.shared &&
+        monSa.nelem == 3 && monSa.vals[0] == 2 && monSa.vals[2] == 4,
+        "subArray monitor got %ld shared elements %g %g %g", monSa.nelem,
+        monSa.vals[0], monSa.vals[1], monSa.vals[2]);
+    {
+        static const double expect[] = {2, 3, 4};
+        testdbGetArrFieldEqual("sa", DBR_DOUBLE, 8, 3, expect);
+    }
+
+    testDiag("aai");
+    subAai = subscribe(ctx, "aai", &monAai);
+    testdbPutArrFieldOk("aai", DBR_LONG, 3, l1);
+    waitFor(&monAai, 1);
+    testOk(monAai.type == dbfl_type_ref && monAai.shared &&
+        monAai.nelem == 3 && monAai.vals[0] == 9 && monAai.vals[2] == 11,
+        "aai monitor got %ld shared elements %g %g %g", monAai.nelem,
+        monAai.vals[0], monAai.vals[1], monAai.vals[2]);
+    testdbGetArrFieldEqual("aai", DBR_LONG, 8, 3, l1);
+
+    unsubscribe(sub, &mon);
+    unsubscribe(subArr, &monArr);
+    unsubscribe(subSa, &monSa);
+    unsubscribe(subAai, &monAai);
+    db_close_events(ctx);
+
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+MAIN(arrayShareTest)
+{
+    testPlan(53);
+    /* Sharing is off by default */
+    testOk1(dbArrayBufShare == 0);
+    dbArrayBufShare = 1;
+    testPool();
+    testRecords();
+    return testDone();
+}
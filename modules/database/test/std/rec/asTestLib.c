@@ -23,6 +23,7 @@
 #include "recSup.h"
 #include "iocsh.h"
 #include "dbAccess.h"
+#include "dbArrayBuf.h"
 #include "dbConvert.h"
 #include "dbStaticLib.h"
 #include "registry.h"
@@ -272,7 +273,7 @@ void testRestore(void)
     testIocShutdownOk();
 
     /* recSup doesn't cleanup after itself */
-    free(rec1->bptr);
+    dbArrayBufPoolDestroy(rec1->rpvt);
 
     testdbCleanup();
 }
@@ -0,0 +1,205 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measure how fast a 16 MB waveform is delivered to several database
+ * monitors, each with its own event task, when their field logs share
+ * the record's buffer and when each of them copies the array out of
+ * the record (dbArrayBufShare=0).
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include "dbAccess.h"
+#include "dbArrayBuf.h"
+#include "dbChannel.h"
+#include "dbEvent.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "db_field_log.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+#include "waveformRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NELM 2000000
+#define NSUBS 10
+
+typedef struct subscriber {
+    dbEventCtx ctx;
+    dbChannel *chan;
+    dbEventSubscription sub;
+    epicsFloat64 *copy;
+    size_t bad;
+} subscriber;
+
+static subscriber subs[NSUBS];
+static size_t nUpdates;
+static epicsEventId updated;
+
+static void monitorUpdate(void *user_arg, struct dbChannel *chan,
+    int eventsRemaining, struct db_field_log *pfl)
+{
+    subscriber *psub = user_arg;
+    const epicsFloat64 *data;
+    long nelem = NELM;
+
+    if (dbArrayBufFromLog(pfl)) {
+        data = pfl->u.r.field;
+        nelem = pfl->no_elements;
+    }
+    else {
+        dbCommon *prec = dbChannelRecord(chan);
+
+        dbScanLock(prec);
+        if (dbChannelGetField(chan, DBR_DOUBLE, psub->copy, NULL, &nelem, pfl))
+            nelem = 0;
+        dbScanUnlock(prec);
+        data = psub->copy;
+    }
+    if (nelem != NELM || data[NELM - 1] != NELM - 1)
+        psub->bad++;
+
+    epicsAtomicIncrSizeT(&nUpdates);
+    epicsEventMustTrigger(updated);
+}
+
+static void waitForUpdates(size_t n)
+{
+    while (epicsAtomicGetSizeT(&nUpdates) < n) {
+        if (epicsEventWaitWithTimeout(updated, 10.0) != epicsEventOK)
+            testAbort("Timed out after %lu of %lu updates",
+                (unsigned long) epicsAtomicGetSizeT(&nUpdates),
+                (unsigned long) n);
+    }
+}
+
+static void runBench(int share, unsigned niter, unsigned nrep)
+{
+    waveformRecord *prec = (waveformRecord *) testdbRecordPtr("wf");
+    double *reptimes = calloc(nrep, sizeof(*reptimes));
+    dbArrayBufStats before, after;
+    size_t expect, held, bad = 0;
+    unsigned i, r, n;
+
+    dbArrayBufShare = share;
+    testDiag("dbArrayBufShare=%d: %u monitors, %u doubles",
+        share, NSUBS, NELM);
+
+    epicsAtomicSetSizeT(&nUpdates, 0);
+    for (i = 0; i < NSUBS; i++) {
+        subscriber *psub = &subs[i];
+
+        /* The first update reads the record even when sharing */
+        psub->copy = calloc(NELM, sizeof(epicsFloat64));
+        psub->bad = 0;
+        psub->ctx = db_init_events();
+        psub->chan = dbChannelCreate("wf");
+        if (!psub->ctx || !psub->chan || dbChannelOpen(psub->chan) ||
+            db_start_events(psub->ctx, "bench", NULL, NULL,
+                epicsThreadPriorityMedium))
+            testAbort("Can't subscribe to wf");
+        psub->sub = db_add_event(psub->ctx, psub->chan, monitorUpdate,
+            psub, DBE_VALUE);
+        db_event_enable(psub->sub);
+        db_post_single_event(psub->sub);
+    }
+    expect = NSUBS;
+    waitForUpdates(expect);
+
+    dbArrayBufPoolStats(prec->rpvt, &before);
+    for (r = 0; r < nrep; r++) {
+        epicsTimeStamp start, stop;
+
+        epicsTimeGetCurrent(&start);
+        for (n = 0; n < niter; n++) {
+            dbScanLock((dbCommon *) prec);
+            dbProcess((dbCommon *) prec);
+            dbScanUnlock((dbCommon *) prec);
+            expect += NSUBS;
+            waitForUpdates(expect);
+        }
+        epicsTimeGetCurrent(&stop);
+
+        reptimes[r] = epicsTimeDiffInSeconds(&stop, &start);
+        testDiag("%u updates in %.03f ms.  %.1f updates/s, %.1f MB/s",
+            niter, reptimes[r] * 1e3, niter / reptimes[r],
+            niter * NSUBS * 8.0 * NELM / reptimes[r] / 1e6);
+    }
+    dbArrayBufPoolStats(prec->rpvt, &after);
+
+    for (i = 0; i < NSUBS; i++) {
+        subscriber *psub = &subs[i];
+
+        db_cancel_event(psub->sub);
+        db_close_events(psub->ctx);
+        dbChannelDelete(psub->chan);
+        free(psub->copy);
+        psub->copy = NULL;
+        bad += psub->bad;
+    }
+    if (bad)
+        testAbort("%lu updates had the wrong data", (unsigned long) bad);
+
+    /* Only a monitor which copies every update needs an array of its own */
+    held = after.maxBuffers * after.size;
+    if (!share)
+        held += NSUBS * after.size;
+
+    {
+        double sum = 0, sum2 = 0, mean;
+
+        for (r = 0; r < nrep; r++) {
+            sum += reptimes[r];
+            sum2 += reptimes[r] * reptimes[r];
+        }
+        mean = sum / nrep;
+        testDiag("Final: %.04f ms +- %.05f ms.  %.1f updates/s, "
+                 "%.1f MB/s, %.1f MB held, %.2f copies/update  "
+                 "(dbArrayBufShare=%d, %u monitors)",
+                 mean * 1e3, sqrt(sum2 / nrep - mean * mean) * 1e3,
+                 niter / mean, niter * NSUBS * 8.0 * NELM / mean / 1e6,
+                 held / 1e6, share ? (double) (after.nCopies -
+                     before.nCopies) / (niter * nrep) : (double) NSUBS,
+                 share, NSUBS);
+    }
+
+    free(reptimes);
+}
+
+MAIN(benchArrayShare)
+{
+    epicsFloat64 *buf = calloc(NELM, sizeof(*buf));
+    unsigned i;
+
+    testPlan(0);
+
+    updated = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("benchCaArray.db", NULL, "NELM=2000000");
+    testIocInitOk();
+
+    for (i = 0; i < NELM; i++)
+        buf[i] = i;
+    testdbPutArrFieldOk("wf", DBR_DOUBLE, NELM, buf);
+    free(buf);
+
+    runBench(0, 10, 3);
+    runBench(1, 10, 3);
+
+    testIocShutdownOk();
+    testdbCleanup();
+
+    return testDone();
+}
@@ -0,0 +1,228 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measure how fast the CA server delivers large array monitor updates
+ * to several clients, for a channel read from the record and for one
+ * whose array filter makes a private copy which is sent in place.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "envDefs.h"
+#include "epicsAtomic.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsUnitTest.h"
+#include "iocInit.h"
+#include "rsrv.h"
+#include "testMain.h"
+
+#include "cadef.h"
+
+/* Declarations from dbUnitTest.h and dbAccess.h which we can't include
+ * here because they conflict with db_access.h */
+struct dbBase;
+epicsShareExtern struct dbBase *pdbbase;
+epicsShareFunc void testdbPrepare(void);
+epicsShareFunc void testdbReadDatabase(const char* file,
+    const char* path, const char* substitutions);
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NELM 500000
+#define MAXCLIENTS 20
+
+static struct ca_client_context *contexts[MAXCLIENTS];
+static size_t nUpdates;
+static size_t nBytes;
+static epicsEventId updated;
+
+static void monitorUpdate(struct event_handler_args args)
+{
+    epicsAtomicAddSizeT(&nBytes, dbr_size_n(args.type, args.count));
+    epicsAtomicIncrSizeT(&nUpdates);
+    epicsEventMustTrigger(updated);
+}
+
+static void waitForUpdates(size_t n)
+{
+    while (epicsAtomicGetSizeT(&nUpdates) < n) {
+        if (epicsEventWaitWithTimeout(updated, 10.0) != epicsEventOK)
+            testAbort("Timed out after %lu of %lu updates",
+                (unsigned long) epicsAtomicGetSizeT(&nUpdates),
+                (unsigned long) n);
+    }
+}
+
+static void runBench(const char *name, unsigned nclients, unsigned niter,
+    unsigned nrep)
+{
+    chid chans[MAXCLIENTS], proc;
+    evid subs[MAXCLIENTS];
+    double *reptimes = calloc(nrep, sizeof(*reptimes));
+    unsigned i, r, n;
+    size_t expect;
+
+    testDiag("%s: %u clients, %u doubles", name, nclients, NELM);
+
+    for (i = 0; i < nclients; i++) {
+        ca_attach_context(contexts[i]);
+        if (ca_create_channel(name, NULL, NULL, 0, &chans[i]) != ECA_NORMAL ||
+            ca_pend_io(10.0) != ECA_NORMAL)
+            testAbort("Can't connect to %s", name);
+        ca_detach_context();
+    }
+    ca_attach_context(contexts[0]);
+    if (ca_create_channel("wf.PROC", NULL, NULL, 0, &proc) != ECA_NORMAL ||
+        ca_pend_io(10.0) != ECA_NORMAL)
+        testAbort("Can't connect to wf.PROC");
+    ca_detach_context();
+
+    /* Each subscription starts with one update of the current value */
+    epicsAtomicSetSizeT(&nUpdates, 0);
+    for (i = 0; i < nclients; i++) {
+        ca_attach_context(contexts[i]);
+        ca_create_subscription(DBR_DOUBLE, 0, chans[i], DBE_VALUE,
+            monitorUpdate, NULL, &subs[i]);
+        ca_flush_io();
+        ca_detach_context();
+    }
+    expect = nclients;
+    waitForUpdates(expect);
+
+    ca_attach_context(contexts[0]);
+    for (r = 0; r < nrep; r++) {
+        epicsTimeStamp start, stop;
+        size_t bytes;
+
+        epicsAtomicSetSizeT(&nBytes, 0);
+        epicsTimeGetCurrent(&start);
+        for (n = 0; n < niter; n++) {
+            epicsInt32 one = 1;
+
+            ca_put(DBR_LONG, proc, &one);
+            ca_flush_io();
+            expect += nclients;
+            waitForUpdates(expect);
+        }
+        epicsTimeGetCurrent(&stop);
+        bytes = epicsAtomicGetSizeT(&nBytes);
+
+        reptimes[r] = epicsTimeDiffInSeconds(&stop, &start);
+        testDiag("%u updates in %.03f ms.  %.1f updates/s, %.1f MB/s",
+            niter, reptimes[r] * 1e3, niter / reptimes[r],
+            bytes / reptimes[r] / 1e6);
+    }
+    ca_detach_context();
+
+    {
+        double sum = 0, sum2 = 0, mean;
+
+        for (r = 0; r < nrep; r++) {
+            sum += reptimes[r];
+            sum2 += reptimes[r] * reptimes[r];
+        }
+        mean = sum / nrep;
+        testDiag("Final: %.04f ms +- %.05f ms.  %.1f updates/s, "
+                 "%.1f MB/s  (%s, %u clients)",
+                 mean * 1e3, sqrt(sum2 / nrep - mean * mean) * 1e3,
+                 niter / mean, niter * nclients * 8.0 * NELM / mean / 1e6,
+                 name, nclients);
+    }
+
+    for (i = 0; i < nclients; i++) {
+        ca_attach_context(contexts[i]);
+        ca_clear_subscription(subs[i]);
+        ca_clear_channel(chans[i]);
+        ca_flush_io();
+        ca_detach_context();
+    }
+    ca_attach_context(contexts[0]);
+    ca_clear_channel(proc);
+    ca_flush_io();
+    ca_detach_context();
+
+    free(reptimes);
+}
+
+static void fillArray(void)
+{
+    dbr_double_t *buf = calloc(NELM, sizeof(*buf));
+    chid wf;
+    unsigned i;
+
+    for (i = 0; i < NELM; i++)
+        buf[i] = i;
+
+    ca_attach_context(contexts[0]);
+    if (ca_create_channel("wf", NULL, NULL, 0, &wf) != ECA_NORMAL ||
+        ca_pend_io(10.0) != ECA_NORMAL ||
+        ca_array_put(DBR_DOUBLE, NELM, wf, buf) != ECA_NORMAL ||
+        ca_pend_io(10.0) != ECA_NORMAL)
+        testAbort("Can't write to wf");
+    ca_clear_channel(wf);
+    ca_flush_io();
+    ca_detach_context();
+    free(buf);
+}
+
+MAIN(benchCaArray)
+{
+    char nelm[16];
+    unsigned i;
+
+    testPlan(0);
+
+    epicsEnvSet("EPICS_CA_SERVER_PORT", "15067");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CAS_AUTO_BEACON_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CAS_BEACON_ADDR_LIST", "");
+    epicsEnvSet("EPICS_CA_MAX_ARRAY_BYTES", "100000000");
+
+    updated = epicsEventMustCreate(epicsEventEmpty);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    sprintf(nelm, "NELM=%d", NELM);
+    testdbReadDatabase("benchCaArray.db", NULL, nelm);
+    rsrv_register_server();
+
+    /* Contexts created before iocInit() connect through the server,
+     * each has its own TCP circuit */
+    for (i = 0; i < MAXCLIENTS; i++) {
+        if (ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+            testAbort("Can't create CA context");
+        contexts[i] = ca_current_context();
+        ca_detach_context();
+    }
+    if (iocInit())
+        testAbort("iocInit() failed");
+
+    /* Subscriptions to an empty array see no initial update */
+    fillArray();
+
+    runBench("wf", 1, 20, 3);
+    runBench("wf.[0:-1]", 1, 20, 3);
+    runBench("wf", 5, 10, 3);
+    runBench("wf.[0:-1]", 5, 10, 3);
+    runBench("wf", MAXCLIENTS, 5, 3);
+    runBench("wf.[0:-1]", MAXCLIENTS, 5, 3);
+
+    for (i = 0; i < MAXCLIENTS; i++) {
+        ca_attach_context(contexts[i]);
+        ca_context_destroy();
+    }
+
+    iocShutdown();
+
+    return testDone();
+}
@@ -0,0 +1,203 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Measure the N to 1 algorithms of the compress record on a 1M element
+ * waveform, against the loops and put_value() they replaced. Set
+ * COMPRESS_THREADS in the environment to try the parallel path.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbLock.h"
+#include "dbUnitTest.h"
+#include "epicsTime.h"
+#include "errlog.h"
+#include "iocsh.h"
+#include "testMain.h"
+
+#include "compressRecord.h"
+#include "waveformRecord.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NELM 1000000
+#define NREP 10
+
+static int compare(const void *arg1, const void *arg2)
+{
+    double a = *(double *)arg1;
+    double b = *(double *)arg2;
+
+    if      ( a <  b ) return -1;
+    else if ( a == b ) return  0;
+    else               return  1;
+}
+
+static double *ring;
+static epicsUInt32 ringOff;
+
+/* The original put_value() for one FIFO element */
+static void oldPutValue(double *psource)
+{
+    ring[ringOff] = *psource;
+    ringOff = (ringOff + 1) % NELM;
+}
+
+/* The original loops, with the median's stride corrected */
+static void oldCompress(int alg, double *psource, epicsInt32 n,
+    epicsInt32 nnew)
+{
+    epicsInt32 i, j;
+    double value;
+
+    switch (alg) {
+    case compressALG_N_to_1_Low_Value:
+        for (i = 0; i < nnew; i++) {
+            value = *psource++;
+            for (j = 1; j < n; j++, psource++) {
+                if (value > *psource)
+                    value = *psource;
+            }
+            oldPutValue(&value);
+        }
+        break;
+    case compressALG_N_to_1_High_Value:
+        for (i = 0; i < nnew; i++) {
+            value = *psource++;
+            for (j = 1; j < n; j++, psource++) {
+                if (value < *psource)
+                    value = *psource;
+            }
+            oldPutValue(&value);
+        }
+        break;
+    case compressALG_N_to_1_Average:
+        for (i = 0; i < nnew; i++) {
+            value = 0;
+            for (j = 0; j < n; j++, psource++)
+                value += *psource;
+            value /= n;
+            oldPutValue(&value);
+        }
+        break;
+    case compressALG_N_to_1_Median:
+        for (i = 0; i < nnew; i++, psource += n) {
+            qsort(psource, n, sizeof(double), compare);
+            value = psource[n / 2];
+            oldPutValue(&value);
+        }
+        break;
+    }
+}
+
+static void setField(const char *pv, short dbrType, const void *pvalue)
+{
+    DBADDR addr;
+
+    if (dbNameToAddr(pv, &addr) || dbPutField(&addr, dbrType, pvalue, 1))
+        testAbort("Can't set '%s'", pv);
+}
+
+static void fill(double *data)
+{
+    epicsUInt32 r = 1;
+    long i;
+
+    for (i = 0; i < NELM; i++) {
+        r = r * 1103515245u + 12345u;
+        data[i] = (double)(r >> 8) / 65536.0;
+    }
+}
+
+static void runBench(int alg, const char *name, epicsUInt32 n,
+    const double *data)
+{
+    waveformRecord *wrec = (waveformRecord*)testdbRecordPtr("wf");
+    compressRecord *crec = (compressRecord*)testdbRecordPtr("comp");
+    double *work = malloc(NELM * sizeof(double));
+    epicsEnum16 ealg = alg;
+    epicsTimeStamp start, stop;
+    double told = 0.0, tnew = 0.0;
+    int rep;
+
+    if (!work)
+        testAbort("Out of memory");
+
+    /* the record starts by copying the waveform, so that's counted */
+    for (rep = 0; rep < NREP; rep++) {
+        epicsTimeGetCurrent(&start);
+        memcpy(work, data, NELM * sizeof(double));
+        oldCompress(alg, work, n, NELM / n);
+        epicsTimeGetCurrent(&stop);
+        told += epicsTimeDiffInSeconds(&stop, &start);
+    }
+
+    setField("comp.ALG", DBR_ENUM, &ealg);
+    setField("comp.N", DBR_ULONG, &n);
+
+    for (rep = 0; rep < NREP; rep++) {
+        dbScanLock((dbCommon*)wrec);
+        memcpy(wrec->bptr, data, NELM * sizeof(double));
+        wrec->nord = NELM;
+        dbScanUnlock((dbCommon*)wrec);
+        dbScanLock((dbCommon*)crec);
+        epicsTimeGetCurrent(&start);
+        dbProcess((dbCommon*)crec);
+        epicsTimeGetCurrent(&stop);
+        dbScanUnlock((dbCommon*)crec);
+        tnew += epicsTimeDiffInSeconds(&stop, &start);
+    }
+
+    testDiag("%-8s N=%-6u old %8.2f ms  new %8.2f ms  (%.1fx)",
+        name, (unsigned) n, told * 1e3 / NREP, tnew * 1e3 / NREP,
+        told / tnew);
+    free(work);
+}
+
+MAIN(benchCompress)
+{
+    static const epicsUInt32 ns[] = {4, 16, 1000, NELM};
+    double *data = malloc(NELM * sizeof(double));
+    unsigned i;
+
+    testPlan(0);
+
+    ring = calloc(NELM, sizeof(double));
+    if (!data || !ring)
+        testAbort("Out of memory");
+    fill(data);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("compressArray.db", NULL, "NELM=1000000");
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    if (getenv("COMPRESS_THREADS")) {
+        char cmd[64];
+
+        sprintf(cmd, "var compressThreads %s", getenv("COMPRESS_THREADS"));
+        iocshCmd(cmd);
+    }
+
+    for (i = 0; i < NELEMENTS(ns); i++) {
+        runBench(compressALG_N_to_1_Low_Value, "Low", ns[i], data);
+        runBench(compressALG_N_to_1_High_Value, "High", ns[i], data);
+        runBench(compressALG_N_to_1_Average, "Average", ns[i], data);
+        runBench(compressALG_N_to_1_Median, "Median", ns[i], data);
+    }
+
+    testIocShutdownOk();
+    testdbCleanup();
+    free(ring);
+    free(data);
+    return testDone();
+}
@@ -0,0 +1,121 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Compare loading records from a .db file with loading the same
+ * records from a snapshot written by dbSaveSnapshot().
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epicsTime.h"
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static const char dbFile[] = "benchdbSnapshot.db";
+static const char snapFile[] = "benchdbSnapshot.dbs";
+
+/* Groups of records like those of a typical device IOC */
+static void writeDb(size_t nrec)
+{
+    FILE *fp = fopen(dbFile, "w");
+    size_t i;
+
+    if (!fp)
+        testAbort("Can't create %s", dbFile);
+    for (i = 0; i < nrec; i += 4) {
+        fprintf(fp,
+            "record(ai, \"DEV%06u:Temp-I\") {\n"
+            "  field(DESC, \"Temperature %u\")\n"
+            "  field(SCAN, \"1 second\")\n"
+            "  field(INP, \"DEV%06u:Raw-I MS\")\n"
+            "  field(EGU, \"degC\")\n"
+            "  field(PREC, \"2\")\n"
+            "  field(HIHI, \"80\")\n"
+            "  field(HHSV, \"MAJOR\")\n"
+            "  field(FLNK, \"DEV%06u:Avg-I\")\n"
+            "  info(autosaveFields, \"HIHI HHSV\")\n"
+            "}\n"
+            "record(ai, \"DEV%06u:Raw-I\") {\n"
+            "  field(VAL, \"21.5\")\n"
+            "}\n"
+            "record(calc, \"DEV%06u:Avg-I\") {\n"
+            "  field(INPA, \"DEV%06u:Temp-I NPP\")\n"
+            "  field(CALC, \"(A+B*9)/10;B:=VAL\")\n"
+            "}\n"
+            "record(bo, \"DEV%06u:Enable-Sel\") {\n"
+            "  field(ZNAM, \"Off\")\n"
+            "  field(ONAM, \"On\")\n"
+            "  field(PINI, \"YES\")\n"
+            "}\n"
+            "alias(\"DEV%06u:Enable-Sel\", \"DEV%06u:Ena\")\n",
+            (unsigned) i, (unsigned) i, (unsigned) i, (unsigned) i,
+            (unsigned) i, (unsigned) i, (unsigned) i, (unsigned) i,
+            (unsigned) i, (unsigned) i);
+    }
+    fclose(fp);
+}
+
+static double elapsed(const epicsTimeStamp *pstart)
+{
+    epicsTimeStamp now;
+
+    epicsTimeGetCurrent(&now);
+    return epicsTimeDiffInSeconds(&now, pstart);
+}
+
+static void runBench(size_t nrec)
+{
+    epicsTimeStamp start;
+    double tparse, tsave, tload;
+
+    testDiag("%lu records", (unsigned long) nrec);
+    writeDb(nrec);
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    epicsTimeGetCurrent(&start);
+    if (dbReadDatabase(&pdbbase, dbFile, NULL, NULL))
+        testAbort("Can't load %s", dbFile);
+    tparse = elapsed(&start);
+
+    epicsTimeGetCurrent(&start);
+    if (dbSaveSnapshot(pdbbase, snapFile))
+        testAbort("Can't save %s", snapFile);
+    tsave = elapsed(&start);
+    testdbCleanup();
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    epicsTimeGetCurrent(&start);
+    if (dbLoadSnapshot(pdbbase, snapFile))
+        testAbort("Can't load %s", snapFile);
+    tload = elapsed(&start);
+    testdbCleanup();
+
+    testDiag("Final: .db parse %.3f sec, snapshot save %.3f sec, "
+             "snapshot load %.3f sec (%.1fx)",
+             tparse, tsave, tload, tparse / tload);
+}
+
+MAIN(benchdbSnapshot)
+{
+    testPlan(0);
+
+    runBench(10000);
+    runBench(100000);
+
+    remove(dbFile);
+    remove(snapFile);
+    return testDone();
+}
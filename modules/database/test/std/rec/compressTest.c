@@ -5,15 +5,20 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "dbUnitTest.h"
 #include "testMain.h"
 #include "dbLock.h"
 #include "errlog.h"
 #include "dbAccess.h"
 #include "epicsMath.h"
+#include "iocsh.h"
 
 #include "aiRecord.h"
 #include "compressRecord.h"
+#include "waveformRecord.h"
 
 #define testDEq(A,B,D) testOk(fabs((A)-(B))<(D), #A " (%f) ~= " #B " (%f)", A, B)
 
@@ -346,10 +351,219 @@ void testLIFOCirc(void)
     testdbCleanup();
 }
 
+/* The N to 1 array algorithms as they were first written */
+static
+int refCompare(const void *arg1, const void *arg2)
+{
+    double a = *(double *)arg1;
+    double b = *(double *)arg2;
+
+    if      ( a <  b ) return -1;
+    else if ( a == b ) return  0;
+    else               return  1;
+}
+
+static
+void refCompress(int alg, double *psource, epicsInt32 n, epicsInt32 nnew,
+    double *pdest)
+{
+    epicsInt32 i, j;
+    double value;
+
+    switch (alg) {
+    case compressALG_N_to_1_Low_Value:
+        for (i = 0; i < nnew; i++) {
+            value = *psource++;
+            for (j = 1; j < n; j++, psource++) {
+                if (value > *psource)
+                    value = *psource;
+            }
+            pdest[i] = value;
+        }
+        break;
+    case compressALG_N_to_1_High_Value:
+        for (i = 0; i < nnew; i++) {
+            value = *psource++;
+            for (j = 1; j < n; j++, psource++) {
+                if (value < *psource)
+                    value = *psource;
+            }
+            pdest[i] = value;
+        }
+        break;
+    case compressALG_N_to_1_Average:
+        for (i = 0; i < nnew; i++) {
+            value = 0;
+            for (j = 0; j < n; j++, psource++)
+                value += *psource;
+            value /= n;
+            pdest[i] = value;
+        }
+        break;
+    case compressALG_N_to_1_Median:
+        for (i = 0; i < nnew; i++, psource += n) {
+            qsort(psource, n, sizeof(double), refCompare);
+            pdest[i] = psource[n / 2];
+        }
+        break;
+    }
+}
+
+static
+void setField(const char *pv, short dbrType, const void *pvalue)
+{
+    DBADDR addr;
+
+    if (dbNameToAddr(pv, &addr) || dbPutField(&addr, dbrType, pvalue, 1))
+        testAbort("Can't set '%s'", pv);
+}
+
+static const char * const algNames[] = {
+    "Low", "High", "Average", "", "", "Median"
+};
+
+static
+void checkNto1(int alg, epicsUInt32 n, const double *data, long nelem)
+{
+    waveformRecord *wrec = (waveformRecord*)testdbRecordPtr("wf");
+    compressRecord *crec = (compressRecord*)testdbRecordPtr("comp");
+    epicsEnum16 ealg = alg;
+    long nout = nelem / n;
+    double *work = malloc(nelem * sizeof(double));
+    double *expect = malloc(nout * sizeof(double));
+    int match;
+
+    if (!work || !expect)
+        testAbort("Out of memory");
+    memcpy(work, data, nelem * sizeof(double));
+    refCompress(alg, work, n, nout, expect);
+
+    setField("comp.ALG", DBR_ENUM, &ealg);
+    setField("comp.N", DBR_ULONG, &n);
+
+    dbScanLock((dbCommon*)wrec);
+    memcpy(wrec->bptr, data, nelem * sizeof(double));
+    wrec->nord = nelem;
+    dbScanUnlock((dbCommon*)wrec);
+
+    dbScanLock((dbCommon*)crec);
+    dbProcess((dbCommon*)crec);
+    match = crec->nuse == nout &&
+        memcmp(crec->bptr, expect, nout * sizeof(double)) == 0;
+    testOk(match, "%s, %ld elements, N=%u", algNames[alg], nelem, n);
+    if (!match) {
+        long i;
+
+        testDiag("nuse %u expected %ld", crec->nuse, nout);
+        for (i = 0; i < nout && i < (long)crec->nuse; i++) {
+            if (memcmp(&crec->bptr[i], &expect[i], sizeof(double))) {
+                testDiag("[%ld] -> %g != %g", i, crec->bptr[i], expect[i]);
+                break;
+            }
+        }
+    }
+    dbScanUnlock((dbCommon*)crec);
+
+    free(expect);
+    free(work);
+}
+
+/* The median must be last, the order of its equal values is unspecified */
+static const int algs[] = {
+    compressALG_N_to_1_Low_Value,
+    compressALG_N_to_1_High_Value,
+    compressALG_N_to_1_Average,
+    compressALG_N_to_1_Median
+};
+
+/* Exact binary fractions with repeats, or with NaNs and signed zeros,
+ * or signed zeros with 1 (special 2) or -1 (special 3) */
+static
+void fillData(double *data, long nelem, int special)
+{
+    epicsUInt32 r = 12345;
+    long i;
+
+    for (i = 0; i < nelem; i++) {
+        r = r * 1103515245u + 12345u;
+        data[i] = (double)((int)(r >> 16) % 2001 - 1000) / 8.0;
+        if (special >= 2) {
+            data[i] = (r >> 12) % 2 ? 0.0 : -0.0;
+            if ((r >> 13) % 4 == 0)
+                data[i] = special == 2 ? 1.0 : -1.0;
+        }
+        else if (special) {
+            switch ((r >> 8) % 7) {
+            case 0: data[i] = 0.0; break;
+            case 1: data[i] = -0.0; break;
+            case 2: data[i] = (r >> 12) % 8 ? data[i] : epicsNAN; break;
+            }
+        }
+    }
+}
+
+static
+void testNto1Array(void)
+{
+    static const epicsUInt32 small[] = {1, 2, 3, 7, 16, 17, 100, 4099};
+    static const epicsUInt32 large[] = {1, 3, 1000, 200000};
+    const long nsmall = 4099, nlarge = 200000;
+    double *data = malloc(nlarge * sizeof(double));
+    unsigned i, j;
+
+    testDiag("Test N to 1 algorithms on arrays");
+
+    if (!data)
+        testAbort("Out of memory");
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("compressArray.db", NULL, "NELM=200000");
+
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    for (i = 0; i < NELEMENTS(small); i++) {
+        fillData(data, nsmall, 0);
+        for (j = 0; j < NELEMENTS(algs); j++)
+            checkNto1(algs[j], small[i], data, nsmall);
+        fillData(data, nsmall, 1);
+        for (j = 0; j + 1 < NELEMENTS(algs); j++)
+            checkNto1(algs[j], small[i], data, nsmall);
+        fillData(data, nsmall, 2);
+        checkNto1(compressALG_N_to_1_Low_Value, small[i], data, nsmall);
+        fillData(data, nsmall, 3);
+        checkNto1(compressALG_N_to_1_High_Value, small[i], data, nsmall);
+    }
+
+    testDiag("In parallel");
+    iocshCmd("var compressThreads 2");
+    for (i = 0; i < NELEMENTS(large); i++) {
+        fillData(data, nlarge, 0);
+        for (j = 0; j < NELEMENTS(algs); j++)
+            checkNto1(algs[j], large[i], data, nlarge);
+        fillData(data, nlarge, 1);
+        for (j = 0; j + 1 < NELEMENTS(algs); j++)
+            checkNto1(algs[j], large[i], data, nlarge);
+        fillData(data, nlarge, 2);
+        checkNto1(compressALG_N_to_1_Low_Value, large[i], data, nlarge);
+        fillData(data, nlarge, 3);
+        checkNto1(compressALG_N_to_1_High_Value, large[i], data, nlarge);
+    }
+    iocshCmd("var compressThreads 0");
+
+    testIocShutdownOk();
+    testdbCleanup();
+    free(data);
+}
+
 MAIN(compressTest)
 {
-    testPlan(116);
+    testPlan(224);
     testFIFOCirc();
     testLIFOCirc();
+    testNto1Array();
     return testDone();
 }
@@ -0,0 +1,203 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbAccess.h"
+#include "dbStaticLib.h"
+#include "dbUnitTest.h"
+#include "errlog.h"
+#include "epicsStdio.h"
+
+#include "testMain.h"
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+static const char snapFile[] = "dbSnapshotTest.dbs";
+
+static void prepare(void)
+{
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+}
+
+static char * readFile(const char *name, size_t *plen)
+{
+    FILE *fp = fopen(name, "rb");
+    char *data;
+    long len;
+
+    if (!fp)
+        testAbort("Can't open %s", name);
+    fseek(fp, 0, SEEK_END);
+    len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data = calloc(1, len + 1);
+    if (!data || fread(data, 1, len, fp) != (size_t) len)
+        testAbort("Can't read %s", name);
+    fclose(fp);
+    *plen = len;
+    return data;
+}
+
+static void writeFile(const char *name, const char *data, size_t len)
+{
+    FILE *fp = fopen(name, "wb");
+
+    if (!fp || fwrite(data, 1, len, fp) != len || fclose(fp))
+        testAbort("Can't write %s", name);
+}
+
+/* Every field, info item and alias, as dbWriteRecord() shows them */
+static char * dumpRecords(const char *name)
+{
+    size_t len;
+
+    if (dbWriteRecord(pdbbase, name, NULL, 2))
+        testAbort("dbWriteRecord failed");
+    return readFile(name, &len);
+}
+
+static void testRoundTrip(void)
+{
+    char *before, *after;
+
+    testDiag("testRoundTrip");
+
+    prepare();
+    testdbReadDatabase("dbSnapshotTest.db", NULL, NULL);
+    before = dumpRecords("dbSnapshotTest1.txt");
+    testOk1(dbSaveSnapshot(pdbbase, snapFile) == 0);
+    testdbCleanup();
+
+    prepare();
+    testOk1(dbLoadSnapshot(pdbbase, snapFile) == 0);
+    after = dumpRecords("dbSnapshotTest2.txt");
+    testOk(strcmp(before, after) == 0, "Records match after reload");
+    free(after);
+
+    testDiag("Loading twice fails");
+    eltc(0);
+    testOk1(dbLoadSnapshot(pdbbase, snapFile) == S_dbLib_recExists);
+    eltc(1);
+    after = dumpRecords("dbSnapshotTest2.txt");
+    testOk(strcmp(before, after) == 0, "Records unchanged");
+    free(after);
+    free(before);
+
+    testDiag("Loaded records run");
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+
+    testdbGetFieldEqual("snap:src:alias", DBR_DOUBLE, 21.0);
+    testdbGetFieldEqual("snap:mbbo:a2", DBR_STRING, "One");
+    testdbGetFieldEqual("snap:si", DBR_STRING, "a json constant");
+    testdbPutFieldOk("snap:src", DBR_DOUBLE, 5.0);
+    testdbPutFieldOk("snap:ai.PROC", DBR_LONG, 1);
+    testdbGetFieldEqual("snap:ai", DBR_DOUBLE, 5.0);
+    testdbGetFieldEqual("snap:calc", DBR_DOUBLE, 11.0);
+    testdbPutFieldOk("snap:lo", DBR_LONG, 42);
+    testdbGetFieldEqual("snap:si.DESC", DBR_STRING, "42");
+
+    testDiag("Can't save or load after iocInit");
+    eltc(0);
+    testOk1(dbSaveSnapshot(pdbbase, "dbSnapshotTest3.dbs") != 0);
+    testOk1(dbLoadSnapshot(pdbbase, snapFile) != 0);
+    eltc(1);
+
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
+static void testBadFiles(void)
+{
+    DBENTRY entry;
+    size_t len;
+    char *data;
+
+    testDiag("testBadFiles");
+
+    data = readFile(snapFile, &len);
+    prepare();
+    eltc(0);
+
+    testOk1(dbLoadSnapshot(pdbbase, "no-such-file.dbs") == S_dbLib_badSnapshot);
+
+    writeFile("dbSnapshotTest3.dbs", "record(ai, \"x\") {}\n", 19);
+    testOk1(dbLoadSnapshot(pdbbase, "dbSnapshotTest3.dbs") == S_dbLib_badSnapshot);
+
+    writeFile("dbSnapshotTest3.dbs", data, len / 2);
+    testOk1(dbLoadSnapshot(pdbbase, "dbSnapshotTest3.dbs") == S_dbLib_badSnapshot);
+
+    writeFile("dbSnapshotTest3.dbs", data, len - 4);
+    testOk1(dbLoadSnapshot(pdbbase, "dbSnapshotTest3.dbs") == S_dbLib_badSnapshot);
+
+    eltc(1);
+
+    dbInitEntry(pdbbase, &entry);
+    testOk(dbFindRecord(&entry, "snap:ai") == S_dbLib_recNotFound,
+        "No records were created");
+    dbFinishEntry(&entry);
+
+    testdbCleanup();
+    free(data);
+}
+
+/* Rename a record or alias in the snapshot to repeat another name */
+static void testRepeatedName(const char *from, const char *to)
+{
+    DBENTRY entry;
+    size_t len, n = strlen(from) + 1;
+    char *data, *pos;
+    int nRecords = 0;
+    long status;
+
+    testDiag("testRepeatedName %s => %s", from, to);
+
+    data = readFile(snapFile, &len);
+    for (pos = data; pos + n <= data + len; pos++) {
+        if (memcmp(pos, from, n) == 0)
+            break;
+    }
+    if (pos + n > data + len)
+        testAbort("'%s' is not in %s", from, snapFile);
+    memcpy(pos, to, n);
+    writeFile("dbSnapshotTest3.dbs", data, len);
+
+    prepare();
+    eltc(0);
+    testOk1(dbLoadSnapshot(pdbbase, "dbSnapshotTest3.dbs") == S_dbLib_recExists);
+    eltc(1);
+
+    dbInitEntry(pdbbase, &entry);
+    for (status = dbFirstRecordType(&entry); !status;
+         status = dbNextRecordType(&entry))
+        nRecords += dbGetNRecords(&entry);
+    dbFinishEntry(&entry);
+    testOk(nRecords == 0, "No records were created (%d)", nRecords);
+
+    testdbCleanup();
+    free(data);
+}
+
+MAIN(dbSnapshotTest)
+{
+    testPlan(25);
+    testRoundTrip();
+    testBadFiles();
+    /* Across record types, and between aliases of one type */
+    testRepeatedName("snap:si", "snap:ai");
+    testRepeatedName("snap:mbbo:a1", "snap:mbbo:a2");
+    remove("dbSnapshotTest1.txt");
+    remove("dbSnapshotTest2.txt");
+    remove("dbSnapshotTest3.dbs");
+    remove(snapFile);
+    return testDone();
+}
@@ -20,6 +20,8 @@ int arrayOpTest(void);
 int asTest(void);
 int linkRetargetLinkTest(void);
 int linkInitTest(void);
+int dbSnapshotTest(void);
+int arrayShareTest(void);
 int asyncSoftTest(void);
 int simmTest(void);
 int mbbioDirectTest(void);
@@ -43,6 +45,10 @@ void epicsRunRecordTests(void)
 
     runTest(linkInitTest);
 
+    runTest(dbSnapshotTest);
+
+    runTest(arrayShareTest);
+
     runTest(asyncSoftTest);
 
     runTest(simmTest);
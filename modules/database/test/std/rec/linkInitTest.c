@@ -5,6 +5,7 @@
 * in file LICENSE that is included with this distribution.
 \*************************************************************************/
 
+#include <stdio.h>
 #include <string.h>
 
 #include "dbAccess.h"
@@ -13,8 +14,12 @@
 #include "dbUnitTest.h"
 #include "errlog.h"
 #include "epicsThread.h"
+#include "iocInit.h"
 
+#include "aiRecord.h"
+#include "calcRecord.h"
 #include "longinRecord.h"
+#include "stringinRecord.h"
 
 #include "testMain.h"
 
@@ -241,9 +246,71 @@ void testInt64Inputs(void)
 }
 
 
+#define NPARALLEL 200
+
+static void testParallelInit(void)
+{
+    int badAi = 0, badLi = 0, badAsync = 0, badCalc = 0, badSi = 0;
+    char buf[40];
+    int i;
+
+    testDiag("testParallelInit");
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    for (i = 0; i < NPARALLEL; i++) {
+        sprintf(buf, "N=%d", i);
+        testdbReadDatabase("linkInitParallel.db", NULL, buf);
+    }
+
+    dbInitRecordThreads = 2;
+    eltc(0);
+    testIocInitOk();
+    eltc(1);
+    dbInitRecordThreads = 0;
+
+    for (i = 0; i < NPARALLEL; i++) {
+        aiRecord *pai;
+        longinRecord *pli;
+        calcRecord *pcalc;
+        stringinRecord *psi;
+
+        sprintf(buf, "pai%d", i);
+        pai = (aiRecord *)testdbRecordPtr(buf);
+        badAi += pai->val != i || pai->udf || !pai->mlok;
+
+        sprintf(buf, "pli%d", i);
+        pli = (longinRecord *)testdbRecordPtr(buf);
+        badLi += pli->val != i || pli->udf || !pli->mlok;
+
+        sprintf(buf, "pla%d", i);
+        pli = (longinRecord *)testdbRecordPtr(buf);
+        badAsync += pli->val != i || !pli->mlok;
+
+        sprintf(buf, "pcalc%d", i);
+        pcalc = (calcRecord *)testdbRecordPtr(buf);
+        badCalc += pcalc->a != i || !pcalc->rpcc || !pcalc->mlok;
+
+        sprintf(buf, "psi%d", i);
+        psi = (stringinRecord *)testdbRecordPtr(buf);
+        sprintf(buf, "s%d", i);
+        badSi += strcmp(psi->val, buf) != 0 || !psi->mlok;
+    }
+    testOk(badAi == 0, "%d ai records initialized wrongly", badAi);
+    testOk(badLi == 0, "%d longin records initialized wrongly", badLi);
+    testOk(badAsync == 0, "%d async longin records initialized wrongly",
+        badAsync);
+    testOk(badCalc == 0, "%d calc records initialized wrongly", badCalc);
+    testOk(badSi == 0, "%d stringin records initialized wrongly", badSi);
+
+    testIocShutdownOk();
+    testdbCleanup();
+}
+
 MAIN(linkInitTest)
 {
-    testPlan(78);
+    testPlan(83);
 
     testLongStringInit();
     testCalcInit();
@@ -251,6 +318,7 @@ MAIN(linkInitTest)
     testArrayInputs();
     testEventRecord();
     testInt64Inputs();
+    testParallelInit();
 
     return testDone();
 }
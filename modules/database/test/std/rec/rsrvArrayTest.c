@@ -0,0 +1,298 @@
+/*************************************************************************\
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+
+/*
+ * Read and monitor arrays larger than the CA server's send buffer,
+ * both straight from a record and through an array filter, whose
+ * private copy of the data the server sends without copying it.
+ * Replies to gets are built by the server's receive thread while its
+ * event task builds monitor updates, each in its own staging buffer.
+ */
+
+#include <string.h>
+
+#include "envDefs.h"
+#include "epicsEvent.h"
+#include "epicsUnitTest.h"
+#include "iocInit.h"
+#include "rsrv.h"
+#include "testMain.h"
+
+#include "cadef.h"
+
+/* Declarations from dbUnitTest.h and dbAccess.h which we can't include
+ * here because they conflict with db_access.h */
+struct dbBase;
+epicsShareExtern struct dbBase *pdbbase;
+epicsShareFunc void testdbPrepare(void);
+epicsShareFunc void testdbReadDatabase(const char* file,
+    const char* path, const char* substitutions);
+
+void recTestIoc_registerRecordDeviceDriver(struct dbBase *);
+
+#define NELM 100000
+
+typedef struct result {
+    epicsEventId done;
+    double offset;      /* value[i] is expected to be start + i + offset */
+    long start;         /* index of the first element returned */
+    long count;
+    long nBad;
+    int status;
+    int waitValue;      /* monitors: wait for this value[0] */
+} result;
+
+static void checkValues(result *pres, struct event_handler_args args)
+{
+    long i;
+
+    pres->status = args.status;
+    pres->count = args.count;
+    pres->nBad = 0;
+    if (args.status != ECA_NORMAL)
+        return;
+
+    for (i = 0; i < args.count; i++) {
+        double expect = pres->start + i + pres->offset;
+        double val;
+
+        switch (args.type % (LAST_TYPE + 1)) {
+        case DBR_DOUBLE:
+            val = ((const dbr_double_t *)
+                dbr_value_ptr(args.dbr, args.type))[i];
+            break;
+        case DBR_FLOAT:
+            val = ((const dbr_float_t *)
+                dbr_value_ptr(args.dbr, args.type))[i];
+            break;
+        default:
+            val = -1;
+        }
+        if (val != expect)
+            pres->nBad++;
+    }
+    if (dbr_type_is_TIME(args.type) &&
+        ((const struct dbr_time_double *) args.dbr)->severity != 0)
+        pres->nBad++;
+}
+
+static void getDone(struct event_handler_args args)
+{
+    result *pres = (result *) args.usr;
+
+    checkValues(pres, args);
+    epicsEventMustTrigger(pres->done);
+}
+
+static void monitorUpdate(struct event_handler_args args)
+{
+    result *pres = (result *) args.usr;
+    const dbr_double_t *pval = args.dbr ?
+        (const dbr_double_t *) dbr_value_ptr(args.dbr, args.type) : NULL;
+    result now = *pres;
+
+    /* Any complete update is fine, but not a mix of two */
+    now.offset = pval && args.count ? pval[0] : 0;
+    checkValues(&now, args);
+    if (now.status != ECA_NORMAL || now.nBad) {
+        pres->nBad++;
+    }
+    else if (now.count && pval[0] == pres->waitValue) {
+        pres->count = now.count;
+        epicsEventMustTrigger(pres->done);
+    }
+}
+
+static void putArray(chid chan, double offset)
+{
+    static dbr_double_t buf[NELM];
+    long i;
+
+    for (i = 0; i < NELM; i++)
+        buf[i] = i + offset;
+    testOk(ca_array_put(DBR_DOUBLE, NELM, chan, buf) == ECA_NORMAL &&
+        ca_pend_io(5.0) == ECA_NORMAL, "Put %d elements", NELM);
+}
+
+static void startGet(result *pres, chid chan, chtype type,
+    unsigned long count, long start, double offset)
+{
+    memset(pres, 0, sizeof(*pres));
+    pres->done = epicsEventMustCreate(epicsEventEmpty);
+    pres->start = start;
+    pres->offset = offset;
+    pres->status = ca_array_get_callback(type, count, chan, getDone, pres);
+}
+
+static void finishGet(result *pres, chid chan, chtype type,
+    unsigned long count, long expectCount)
+{
+    if (pres->status != ECA_NORMAL ||
+        epicsEventWaitWithTimeout(pres->done, 10.0) != epicsEventOK) {
+        testFail("%s get %s[%lu] failed", ca_name(chan),
+            dbr_type_to_text(type), count);
+    }
+    else {
+        testOk(pres->status == ECA_NORMAL && pres->count == expectCount &&
+            pres->nBad == 0, "%s get %s[%lu] returned %ld elements, %ld wrong",
+            ca_name(chan), dbr_type_to_text(type), count, pres->count,
+            pres->nBad);
+    }
+    epicsEventDestroy(pres->done);
+}
+
+static void testGet(chid chan, chtype type, unsigned long count,
+    long start, long expectCount, double offset)
+{
+    result res;
+
+    startGet(&res, chan, type, count, start, offset);
+    ca_flush_io();
+    finishGet(&res, chan, type, count, expectCount);
+}
+
+static void testMonitor(chid chan, chid wr)
+{
+    result res;
+    evid ev;
+    int i;
+
+    memset(&res, 0, sizeof(res));
+    res.done = epicsEventMustCreate(epicsEventEmpty);
+    res.waitValue = -1;
+
+    testOk(ca_create_subscription(DBR_TIME_DOUBLE, 0, chan, DBE_VALUE,
+        monitorUpdate, &res, &ev) == ECA_NORMAL,
+        "Subscribe to %s", ca_name(chan));
+    ca_flush_io();
+
+    for (i = 1; i <= 3; i++) {
+        res.waitValue = i;
+        putArray(wr, i);
+        testOk(epicsEventWaitWithTimeout(res.done, 10.0) == epicsEventOK &&
+            res.count == NELM, "%s update %d received, %ld elements",
+            ca_name(chan), i, res.count);
+    }
+    testOk(res.nBad == 0, "%s: %ld bad updates", ca_name(chan), res.nBad);
+
+    ca_clear_subscription(ev);
+    ca_flush_io();
+    epicsEventDestroy(res.done);
+}
+
+static void testGetWhileMonitored(chid chan, chid wr)
+{
+    result mon, res[4];
+    evid ev;
+    int i, j;
+
+    memset(&mon, 0, sizeof(mon));
+    mon.done = epicsEventMustCreate(epicsEventEmpty);
+    mon.waitValue = -1;
+
+    testOk(ca_create_subscription(DBR_TIME_DOUBLE, 0, chan, DBE_VALUE,
+        monitorUpdate, &mon, &ev) == ECA_NORMAL,
+        "Subscribe to %s", ca_name(chan));
+    ca_flush_io();
+
+    for (i = 4; i <= 6; i++) {
+        static dbr_double_t buf[NELM];
+        long k;
+
+        for (k = 0; k < NELM; k++)
+            buf[k] = k + i;
+        mon.waitValue = i;
+        ca_array_put(DBR_DOUBLE, NELM, wr, buf);
+        for (j = 0; j < 4; j++)
+            startGet(&res[j], chan, DBR_DOUBLE, 0, 0, i);
+        ca_flush_io();
+        for (j = 0; j < 4; j++)
+            finishGet(&res[j], chan, DBR_DOUBLE, 0, NELM);
+        testOk(epicsEventWaitWithTimeout(mon.done, 10.0) == epicsEventOK,
+            "%s update %d received", ca_name(chan), i);
+    }
+    testOk(mon.nBad == 0, "%s: %ld bad updates", ca_name(chan), mon.nBad);
+
+    ca_clear_subscription(ev);
+    ca_flush_io();
+    epicsEventDestroy(mon.done);
+}
+
+MAIN(rsrvArrayTest)
+{
+    chid wf, wfArr, wfSlice, wfs;
+    result res[5];
+
+    testPlan(49);
+
+    epicsEnvSet("EPICS_CA_SERVER_PORT", "15066");
+    epicsEnvSet("EPICS_CA_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CA_AUTO_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CAS_INTF_ADDR_LIST", "127.0.0.1");
+    epicsEnvSet("EPICS_CAS_AUTO_BEACON_ADDR_LIST", "NO");
+    epicsEnvSet("EPICS_CAS_BEACON_ADDR_LIST", "");
+    epicsEnvSet("EPICS_CA_MAX_ARRAY_BYTES", "10000000");
+
+    testdbPrepare();
+    testdbReadDatabase("recTestIoc.dbd", NULL, NULL);
+    recTestIoc_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("rsrvArrayTest.db", NULL, NULL);
+    rsrv_register_server();
+
+    /* Created before iocInit() installs the local database service
+     * in new contexts, so this one connects through the server */
+    if (ca_context_create(ca_enable_preemptive_callback) != ECA_NORMAL)
+        testAbort("Can't create CA context");
+    if (iocInit())
+        testAbort("iocInit() failed");
+    if (ca_create_channel("wf", NULL, NULL, 0, &wf) != ECA_NORMAL ||
+        ca_create_channel("wf.[0:-1]", NULL, NULL, 0, &wfArr) != ECA_NORMAL ||
+        ca_create_channel("wf.[0:9]", NULL, NULL, 0, &wfSlice) != ECA_NORMAL ||
+        ca_create_channel("wfs", NULL, NULL, 0, &wfs) != ECA_NORMAL ||
+        ca_pend_io(10.0) != ECA_NORMAL)
+        testAbort("Can't connect to the test IOC");
+
+    putArray(wf, 0.25);
+
+    testDiag("Copied into the send buffer");
+    testGet(wf, DBR_TIME_DOUBLE, 0, 0, NELM, 0.25);
+    testGet(wf, DBR_DOUBLE, NELM, 0, NELM, 0.25);
+    testGet(wf, DBR_DOUBLE, 5000, 0, 5000, 0.25);
+    testGet(wf, DBR_FLOAT, 0, 0, NELM, 0.25);
+    testGet(wfSlice, DBR_DOUBLE, 10, 0, 10, 0.25);
+
+    testDiag("Sent from the field log");
+    testGet(wfArr, DBR_TIME_DOUBLE, 0, 0, NELM, 0.25);
+    testGet(wfArr, DBR_CTRL_DOUBLE, 0, 0, NELM, 0.25);
+    testGet(wfArr, DBR_DOUBLE, 0, 0, NELM, 0.25);
+    testGet(wfArr, DBR_DOUBLE, 5000, 0, 5000, 0.25);
+    testGet(wfArr, DBR_FLOAT, 0, 0, NELM, 0.25);
+
+    testDiag("Interleaved with small messages");
+    startGet(&res[0], wfSlice, DBR_DOUBLE, 10, 0, 0.25);
+    startGet(&res[1], wfArr, DBR_TIME_DOUBLE, 0, 0, 0.25);
+    startGet(&res[2], wfSlice, DBR_TIME_DOUBLE, 10, 0, 0.25);
+    startGet(&res[3], wf, DBR_DOUBLE, 0, 0, 0.25);
+    startGet(&res[4], wfs, DBR_DOUBLE, 1, 0, 0);
+    ca_flush_io();
+    finishGet(&res[0], wfSlice, DBR_DOUBLE, 10, 10);
+    finishGet(&res[1], wfArr, DBR_TIME_DOUBLE, 0, NELM);
+    finishGet(&res[2], wfSlice, DBR_TIME_DOUBLE, 10, 10);
+    finishGet(&res[3], wf, DBR_DOUBLE, 0, NELM);
+    finishGet(&res[4], wfs, DBR_DOUBLE, 1, 1);
+
+    testMonitor(wf, wf);
+    testMonitor(wfArr, wf);
+
+    testDiag("Gets racing monitor updates");
+    testGetWhileMonitored(wf, wf);
+    casr(3);
+
+    ca_context_destroy();
+
+    iocShutdown();
+
+    return testDone();
+}
@@ -0,0 +1,689 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Compile a postfix expression into a form that is quicker to evaluate.
+ *
+ * The compiled form is an array of instructions, each holding its operand
+ * rather than having it follow the opcode. Constant subexpressions are
+ * evaluated once here, by calcPerform() itself so the results can't differ.
+ * The target of each conditional is found once, using the same search that
+ * calcPerform() does every time. A binary operator whose right operand is
+ * an input or a constant becomes a single instruction. With GCC the
+ * instructions hold the address of their handler, and each handler jumps
+ * straight to the next.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "dbDefs.h"
+#include "epicsMath.h"
+#include "epicsTypes.h"
+#include "postfix.h"
+#include "postfixPvt.h"
+
+#if defined(__GNUC__)
+#  define CALC_THREADED
+#endif
+
+/* Opcodes which only appear in compiled expressions */
+enum {
+    C_LITERAL = NOT_GENERATED + 1,  /* push value */
+    C_FETCH,                        /* push parg[arg] */
+    C_STORE,                        /* pop into parg[arg] */
+    C_JUMP,                         /* continue at arg */
+    C_JUMP_IF_ZERO,                 /* pop, continue at arg if zero */
+    /* Binary operators with their right operand in parg[arg] or value */
+    C_ADD_ARG, C_ADD_CONST,
+    C_SUB_ARG, C_SUB_CONST,
+    C_MULT_ARG, C_MULT_CONST,
+    C_DIV_ARG, C_DIV_CONST,
+    C_NOT_EQ_ARG, C_NOT_EQ_CONST,
+    C_LESS_THAN_ARG, C_LESS_THAN_CONST,
+    C_LESS_OR_EQ_ARG, C_LESS_OR_EQ_CONST,
+    C_EQUAL_ARG, C_EQUAL_CONST,
+    C_GR_OR_EQ_ARG, C_GR_OR_EQ_CONST,
+    C_GR_THAN_ARG, C_GR_THAN_CONST,
+    C_NOPS
+};
+
+typedef struct calcInst {
+#ifdef CALC_THREADED
+    const void *handler;
+#endif
+    int op;
+    int arg;        /* input, number of arguments or jump target */
+    double value;   /* for C_LITERAL and the _CONST operators */
+} calcInst;
+
+struct calcCompiled {
+    calcInst inst[1];   /* up to END_EXPRESSION */
+};
+
+/* As in calcPerform() */
+#define d2i(x) ((x)<0?(epicsInt32)(x):(epicsInt32)(epicsUInt32)(x))
+#define d2ui(x) ((x)<0?(epicsUInt32)(epicsInt32)(x):(epicsUInt32)(x))
+
+#ifdef CALC_THREADED
+static const void *handlers[C_NOPS];
+#  define OP(name) L_##name
+#  define DISPATCH() goto *pi->handler
+#else
+#  define OP(name) case name
+#  define DISPATCH() continue
+#endif
+#define NEXT() pi++; DISPATCH()
+
+#define BINARY_OPS(name, expr) \
+    OP(name): \
+        top = *ptop--; \
+        *ptop = expr; \
+        NEXT(); \
+    OP(C_##name##_ARG): \
+        top = parg[pi->arg]; \
+        *ptop = expr; \
+        NEXT(); \
+    OP(C_##name##_CONST): \
+        top = pi->value; \
+        *ptop = expr; \
+        NEXT();
+
+/* Evaluate compiled instructions. Called with pinst NULL it just
+ * fills in the handlers table.
+ */
+static long calcRun(const calcInst *pinst, double *parg, double *presult)
+{
+    double stack[CALCPERFORM_STACK+1];  /* zero'th entry not used */
+    double *ptop = stack;
+    const calcInst *pi = pinst;
+    double top;
+    epicsInt32 itop;
+    int nargs;
+
+#ifdef CALC_THREADED
+    if (!pinst) {
+#  define HANDLER(name) handlers[name] = &&L_##name
+#  define HANDLERS(name) HANDLER(name); HANDLER(C_##name##_ARG); \
+        HANDLER(C_##name##_CONST)
+        HANDLER(END_EXPRESSION); HANDLER(C_LITERAL); HANDLER(C_FETCH);
+        HANDLER(C_STORE); HANDLER(FETCH_VAL); HANDLER(C_JUMP);
+        HANDLER(C_JUMP_IF_ZERO); HANDLER(UNARY_NEG);
+        HANDLERS(ADD); HANDLERS(SUB); HANDLERS(MULT); HANDLERS(DIV);
+        HANDLER(MODULO); HANDLER(POWER); HANDLER(ABS_VAL); HANDLER(EXP);
+        HANDLER(LOG_10); HANDLER(LOG_E); HANDLER(MAX); HANDLER(MIN);
+        HANDLER(SQU_RT); HANDLER(ACOS); HANDLER(ASIN); HANDLER(ATAN);
+        HANDLER(ATAN2); HANDLER(COS); HANDLER(SIN); HANDLER(TAN);
+        HANDLER(COSH); HANDLER(SINH); HANDLER(TANH); HANDLER(CEIL);
+        HANDLER(FLOOR); HANDLER(FINITE); HANDLER(ISINF); HANDLER(ISNAN);
+        HANDLER(NINT); HANDLER(RANDOM); HANDLER(REL_OR); HANDLER(REL_AND);
+        HANDLER(REL_NOT); HANDLER(BIT_OR); HANDLER(BIT_AND);
+        HANDLER(BIT_EXCL_OR); HANDLER(BIT_NOT); HANDLER(RIGHT_SHIFT_ARITH);
+        HANDLER(LEFT_SHIFT_ARITH); HANDLER(RIGHT_SHIFT_LOGIC);
+        HANDLERS(NOT_EQ); HANDLERS(LESS_THAN); HANDLERS(LESS_OR_EQ);
+        HANDLERS(EQUAL); HANDLERS(GR_OR_EQ); HANDLERS(GR_THAN);
+#  undef HANDLERS
+#  undef HANDLER
+        return 0;
+    }
+    DISPATCH();
+    {
+#else
+    for (;;) {
+        switch (pi->op) {
+#endif
+
+    OP(C_LITERAL):
+        *++ptop = pi->value;
+        NEXT();
+
+    OP(C_FETCH):
+        *++ptop = parg[pi->arg];
+        NEXT();
+
+    OP(C_STORE):
+        parg[pi->arg] = *ptop--;
+        NEXT();
+
+    OP(FETCH_VAL):
+        *++ptop = *presult;
+        NEXT();
+
+    OP(C_JUMP):
+        pi = pinst + pi->arg;
+        DISPATCH();
+
+    OP(C_JUMP_IF_ZERO):
+        if (*ptop-- == 0.0) {
+            pi = pinst + pi->arg;
+            DISPATCH();
+        }
+        NEXT();
+
+    OP(UNARY_NEG):
+        *ptop = - *ptop;
+        NEXT();
+
+    OP(ADD):
+        top = *ptop--;
+        *ptop += top;
+        NEXT();
+    OP(C_ADD_ARG):
+        *ptop += parg[pi->arg];
+        NEXT();
+    OP(C_ADD_CONST):
+        *ptop += pi->value;
+        NEXT();
+
+    OP(SUB):
+        top = *ptop--;
+        *ptop -= top;
+        NEXT();
+    OP(C_SUB_ARG):
+        *ptop -= parg[pi->arg];
+        NEXT();
+    OP(C_SUB_CONST):
+        *ptop -= pi->value;
+        NEXT();
+
+    OP(MULT):
+        top = *ptop--;
+        *ptop *= top;
+        NEXT();
+    OP(C_MULT_ARG):
+        *ptop *= parg[pi->arg];
+        NEXT();
+    OP(C_MULT_CONST):
+        *ptop *= pi->value;
+        NEXT();
+
+    OP(DIV):
+        top = *ptop--;
+        *ptop /= top;
+        NEXT();
+    OP(C_DIV_ARG):
+        *ptop /= parg[pi->arg];
+        NEXT();
+    OP(C_DIV_CONST):
+        *ptop /= pi->value;
+        NEXT();
+
+    OP(MODULO):
+        itop = (epicsInt32) *ptop--;
+        if (itop)
+            *ptop = (epicsInt32) *ptop % itop;
+        else
+            *ptop = epicsNAN;
+        NEXT();
+
+    OP(POWER):
+        top = *ptop--;
+        *ptop = pow(*ptop, top);
+        NEXT();
+
+    OP(ABS_VAL):
+        *ptop = fabs(*ptop);
+        NEXT();
+
+    OP(EXP):
+        *ptop = exp(*ptop);
+        NEXT();
+
+    OP(LOG_10):
+        *ptop = log10(*ptop);
+        NEXT();
+
+    OP(LOG_E):
+        *ptop = log(*ptop);
+        NEXT();
+
+    OP(MAX):
+        nargs = pi->arg;
+        while (--nargs) {
+            top = *ptop--;
+            if (*ptop < top || isnan(top))
+                *ptop = top;
+        }
+        NEXT();
+
+    OP(MIN):
+        nargs = pi->arg;
+        while (--nargs) {
+            top = *ptop--;
+            if (*ptop > top || isnan(top))
+                *ptop = top;
+        }
+        NEXT();
+
+    OP(SQU_RT):
+        *ptop = sqrt(*ptop);
+        NEXT();
+
+    OP(ACOS):
+        *ptop = acos(*ptop);
+        NEXT();
+
+    OP(ASIN):
+        *ptop = asin(*ptop);
+        NEXT();
+
+    OP(ATAN):
+        *ptop = atan(*ptop);
+        NEXT();
+
+    OP(ATAN2):
+        top = *ptop--;
+        *ptop = atan2(top, *ptop);  /* Args backwards, as in calcPerform() */
+        NEXT();
+
+    OP(COS):
+        *ptop = cos(*ptop);
+        NEXT();
+
+    OP(SIN):
+        *ptop = sin(*ptop);
+        NEXT();
+
+    OP(TAN):
+        *ptop = tan(*ptop);
+        NEXT();
+
+    OP(COSH):
+        *ptop = cosh(*ptop);
+        NEXT();
+
+    OP(SINH):
+        *ptop = sinh(*ptop);
+        NEXT();
+
+    OP(TANH):
+        *ptop = tanh(*ptop);
+        NEXT();
+
+    OP(CEIL):
+        *ptop = ceil(*ptop);
+        NEXT();
+
+    OP(FLOOR):
+        *ptop = floor(*ptop);
+        NEXT();
+
+    OP(FINITE):
+        nargs = pi->arg;
+        top = finite(*ptop);
+        while (--nargs) {
+            --ptop;
+            top = top && finite(*ptop);
+        }
+        *ptop = top;
+        NEXT();
+
+    OP(ISINF):
+        *ptop = isinf(*ptop);
+        NEXT();
+
+    OP(ISNAN):
+        nargs = pi->arg;
+        top = isnan(*ptop);
+        while (--nargs) {
+            --ptop;
+            top = top || isnan(*ptop);
+        }
+        *ptop = top;
+        NEXT();
+
+    OP(NINT):
+        top = *ptop;
+        *ptop = (epicsInt32) (top >= 0 ? top + 0.5 : top - 0.5);
+        NEXT();
+
+    OP(RANDOM):
+        *++ptop = epicsCalcRandom();
+        NEXT();
+
+    OP(REL_OR):
+        top = *ptop--;
+        *ptop = *ptop || top;
+        NEXT();
+
+    OP(REL_AND):
+        top = *ptop--;
+        *ptop = *ptop && top;
+        NEXT();
+
+    OP(REL_NOT):
+        *ptop = ! *ptop;
+        NEXT();
+
+    OP(BIT_OR):
+        top = *ptop--;
+        *ptop = (double)(d2i(*ptop) | d2i(top));
+        NEXT();
+
+    OP(BIT_AND):
+        top = *ptop--;
+        *ptop = (double)(d2i(*ptop) & d2i(top));
+        NEXT();
+
+    OP(BIT_EXCL_OR):
+        top = *ptop--;
+        *ptop = (double)(d2i(*ptop) ^ d2i(top));
+        NEXT();
+
+    OP(BIT_NOT):
+        *ptop = (double)~d2i(*ptop);
+        NEXT();
+
+    OP(RIGHT_SHIFT_ARITH):
+        top = *ptop--;
+        *ptop = (double)(d2i(*ptop) >> (d2i(top) & 31));
+        NEXT();
+
+    OP(LEFT_SHIFT_ARITH):
+        top = *ptop--;
+        *ptop = (double)(d2i(*ptop) << (d2i(top) & 31));
+        NEXT();
+
+    OP(RIGHT_SHIFT_LOGIC):
+        top = *ptop--;
+        *ptop = (double)(d2ui(*ptop) >> (d2ui(top) & 31u));
+        NEXT();
+
+    BINARY_OPS(NOT_EQ, *ptop != top)
+    BINARY_OPS(LESS_THAN, *ptop < top)
+    BINARY_OPS(LESS_OR_EQ, *ptop <= top)
+    BINARY_OPS(EQUAL, *ptop == top)
+    BINARY_OPS(GR_OR_EQ, *ptop >= top)
+    BINARY_OPS(GR_THAN, *ptop > top)
+
+    OP(END_EXPRESSION):
+        ;
+#ifndef CALC_THREADED
+        break;
+        default:
+            return -1;
+        }
+        break;
+#endif
+    }
+
+    /* The stack should now have one item on it, the expression value */
+    if (ptop != stack + 1)
+        return -1;
+    *presult = *ptop;
+    return 0;
+}
+
+LIBCOM_API long
+    calcPerformCompiled(double *parg, double *presult,
+        const calcCompiled *pcompiled)
+{
+    return calcRun(pcompiled->inst, parg, presult);
+}
+
+
+/* Bytes taken by the instruction at pinst */
+static int instSize(const char *pinst)
+{
+    switch (*pinst) {
+    case LITERAL_DOUBLE:
+        return 1 + sizeof(double);
+    case LITERAL_INT:
+        return 1 + sizeof(epicsInt32);
+    case MIN:
+    case MAX:
+    case FINITE:
+    case ISNAN:
+        return 2;
+    default:
+        return 1;
+    }
+}
+
+/* The same search as calcPerform() makes for the instruction after the
+ * matching COND_ELSE or COND_END.
+ */
+static const char * condTarget(const char *pinst, int match)
+{
+    int count = 1;
+    int op;
+
+    while ((op = *pinst) != END_EXPRESSION) {
+        pinst += instSize(pinst);
+        if (op == match && --count == 0)
+            return pinst;
+        if (op == COND_IF)
+            count++;
+    }
+    return NULL;
+}
+
+/* Stack inputs of the operators which can be folded, or 0 */
+static int foldInputs(const char *pinst)
+{
+    switch (*pinst) {
+    case CONST_PI: case CONST_D2R: case CONST_R2D:
+        return 0;
+    case UNARY_NEG: case ABS_VAL: case EXP: case LOG_10: case LOG_E:
+    case SQU_RT: case ACOS: case ASIN: case ATAN: case COS: case COSH:
+    case SIN: case SINH: case TAN: case TANH: case CEIL: case FLOOR:
+    case ISINF: case NINT: case REL_NOT: case BIT_NOT:
+        return 1;
+    case ADD: case SUB: case MULT: case DIV: case MODULO: case POWER:
+    case ATAN2: case REL_OR: case REL_AND: case BIT_OR: case BIT_AND:
+    case BIT_EXCL_OR: case RIGHT_SHIFT_ARITH: case LEFT_SHIFT_ARITH:
+    case RIGHT_SHIFT_LOGIC: case NOT_EQ: case LESS_THAN: case LESS_OR_EQ:
+    case EQUAL: case GR_OR_EQ: case GR_THAN:
+        return 2;
+    case MAX: case MIN: case FINITE: case ISNAN:
+        return pinst[1];
+    default:
+        return -1;
+    }
+}
+
+/* Binary operators that have _ARG and _CONST forms */
+static int fusedOp(int op)
+{
+    switch (op) {
+    case ADD: return C_ADD_ARG;
+    case SUB: return C_SUB_ARG;
+    case MULT: return C_MULT_ARG;
+    case DIV: return C_DIV_ARG;
+    case NOT_EQ: return C_NOT_EQ_ARG;
+    case LESS_THAN: return C_LESS_THAN_ARG;
+    case LESS_OR_EQ: return C_LESS_OR_EQ_ARG;
+    case EQUAL: return C_EQUAL_ARG;
+    case GR_OR_EQ: return C_GR_OR_EQ_ARG;
+    case GR_THAN: return C_GR_THAN_ARG;
+    default: return 0;
+    }
+}
+
+/* Apply the operator at pinst to the literals that end pout */
+static int fold(const calcInst *pout, int nin, const char *pinst,
+    double *pvalue)
+{
+    char rpn[2 + CALCPERFORM_STACK * (1 + sizeof(double)) + 2];
+    char *prpn = rpn;
+    double args[CALCPERFORM_NARGS];
+    int i;
+
+    if (nin > CALCPERFORM_STACK)
+        return -1;
+    for (i = -nin; i < 0; i++) {
+        *prpn++ = LITERAL_DOUBLE;
+        memcpy(prpn, &pout[i].value, sizeof(double));
+        prpn += sizeof(double);
+    }
+    memcpy(prpn, pinst, instSize(pinst));
+    prpn += instSize(pinst);
+    *prpn = END_EXPRESSION;
+    return calcPerform(args, pvalue, rpn);
+}
+
+LIBCOM_API calcCompiled *
+    calcCompile(const char *ppostfix)
+{
+    const char *pinst;
+    const char **targets;
+    calcCompiled *pcompiled;
+    calcInst *pout;
+    int *map;
+    int nops = 0;
+    int barrier = 0;
+    int n = 0;
+    int i;
+
+#ifdef CALC_THREADED
+    calcRun(NULL, NULL, NULL);
+#endif
+
+    for (pinst = ppostfix; *pinst != END_EXPRESSION; pinst += instSize(pinst))
+        nops++;
+
+    pcompiled = malloc(sizeof(calcCompiled) + nops * sizeof(calcInst));
+    targets = malloc((nops + 1) * sizeof(const char *));
+    map = malloc((nops + 1) * sizeof(int));
+    if (!pcompiled || !targets || !map)
+        goto fail;
+
+    /* Find where each conditional goes */
+    for (pinst = ppostfix, i = 0; i < nops; pinst += instSize(pinst), i++) {
+        targets[i] = NULL;
+        if (*pinst == COND_IF || *pinst == COND_ELSE) {
+            targets[i] = condTarget(pinst + 1,
+                *pinst == COND_IF ? COND_ELSE : COND_END);
+            if (!targets[i])
+                goto fail;
+        }
+    }
+
+    pout = pcompiled->inst;
+    for (pinst = ppostfix, i = 0; ; pinst += instSize(pinst), i++) {
+        int op = *pinst;
+        int nin, j;
+
+        map[i] = n;
+        /* Nothing may be combined across a jump target */
+        for (j = 0; j < nops; j++) {
+            if (targets[j] == pinst) {
+                barrier = n;
+                break;
+            }
+        }
+        if (op == END_EXPRESSION)
+            break;
+
+        pout[n].arg = 0;
+        pout[n].value = 0.0;
+        switch (op) {
+        case LITERAL_DOUBLE:
+            pout[n].op = C_LITERAL;
+            memcpy(&pout[n].value, pinst + 1, sizeof(double));
+            n++;
+            continue;
+
+        case FETCH_A: case FETCH_B: case FETCH_C: case FETCH_D:
+        case FETCH_E: case FETCH_F: case FETCH_G: case FETCH_H:
+        case FETCH_I: case FETCH_J: case FETCH_K: case FETCH_L:
+            pout[n].op = C_FETCH;
+            pout[n++].arg = op - FETCH_A;
+            continue;
+
+        case STORE_A: case STORE_B: case STORE_C: case STORE_D:
+        case STORE_E: case STORE_F: case STORE_G: case STORE_H:
+        case STORE_I: case STORE_J: case STORE_K: case STORE_L:
+            pout[n].op = C_STORE;
+            pout[n++].arg = op - STORE_A;
+            continue;
+
+        case COND_IF:
+        case COND_ELSE:
+            /* Jump targets are instruction numbers, fixed up below */
+            pout[n].op = op == COND_IF ? C_JUMP_IF_ZERO : C_JUMP;
+            pout[n++].arg = i;
+            continue;
+
+        case COND_END:
+            continue;
+
+        case FETCH_VAL:
+        case RANDOM:
+            pout[n++].op = op;
+            continue;
+        }
+
+        if (op == LITERAL_INT) {
+            epicsInt32 itop;
+
+            memcpy(&itop, pinst + 1, sizeof(epicsInt32));
+            pout[n].op = C_LITERAL;
+            pout[n++].value = itop;
+            continue;
+        }
+
+        nin = foldInputs(pinst);
+        if (nin < 0)
+            goto fail;          /* Not an opcode */
+
+        /* Replace an operator and its constant inputs with the result */
+        for (j = 1; j <= nin; j++) {
+            if (n - j < barrier || pout[n - j].op != C_LITERAL)
+                break;
+        }
+        if (j > nin && fold(pout + n, nin, pinst, &pout[n - nin].value) == 0) {
+            n -= nin;
+            pout[n++].op = C_LITERAL;
+            continue;
+        }
+
+        /* Merge a binary operator into the push of its right operand */
+        if (fusedOp(op) && n - 1 >= barrier &&
+            (pout[n - 1].op == C_FETCH || pout[n - 1].op == C_LITERAL)) {
+            pout[n - 1].op = fusedOp(op) +
+                (pout[n - 1].op == C_LITERAL);
+            continue;
+        }
+
+        pout[n].op = op;
+        if (op == MAX || op == MIN || op == FINITE || op == ISNAN)
+            pout[n].arg = pinst[1];
+        n++;
+    }
+    pout[n++].op = END_EXPRESSION;
+
+    /* Fix up the jumps */
+    for (i = 0; i < n; i++) {
+        if (pout[i].op == C_JUMP || pout[i].op == C_JUMP_IF_ZERO) {
+            const char *ptarget = targets[pout[i].arg];
+            int k;
+
+            for (pinst = ppostfix, k = 0; pinst != ptarget;
+                 pinst += instSize(pinst))
+                k++;
+            pout[i].arg = map[k];
+        }
+#ifdef CALC_THREADED
+        pout[i].handler = handlers[pout[i].op];
+#endif
+    }
+
+    free(targets);
+    free(map);
+    return pcompiled;
+
+fail:
+    free(pcompiled);
+    free(targets);
+    free(map);
+    return NULL;
+}
+
+LIBCOM_API void
+    calcCompiledFree(calcCompiled *pcompiled)
+{
+    free(pcompiled);
+}
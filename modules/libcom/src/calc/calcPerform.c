@@ -26,7 +26,6 @@
 #include "postfixPvt.h"
 
 
-static double calcRandom(void);
 static int cond_search(const char **ppinst, int match);
 
 #ifndef PI
@@ -270,7 +269,7 @@ LIBCOM_API long
             break;
 
         case RANDOM:
-            *++ptop = calcRandom();
+            *++ptop = epicsCalcRandom();
             break;
 
         case REL_OR:
@@ -474,7 +473,7 @@ static unsigned short seed = 0xa3bf;
 static unsigned short multy = 191 * 8 + 5;  /* 191 % 8 == 5 */
 static unsigned short addy = 0x3141;
 
-static double calcRandom(void)
+double epicsCalcRandom(void)
 {
     seed = (seed * multy) + addy;
 
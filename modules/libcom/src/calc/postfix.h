@@ -341,6 +341,48 @@ LIBCOM_API long
 LIBCOM_API long
     calcArgUsage(const char *ppostfix, unsigned long *pinputs, unsigned long *pstores);
 
+/** \brief A compiled postfix expression, see calcCompile() */
+typedef struct calcCompiled calcCompiled;
+
+/** \brief Compile a postfix expression for faster evaluation
+ *
+ * Translates the output of postfix() into a form which calcPerformCompiled()
+ * can evaluate more quickly than calcPerform() evaluates the original.
+ * Constant sub-expressions are calculated once, the destinations of
+ * conditional operators are found in advance, and a binary operator
+ * whose right operand is an argument or a constant becomes a single
+ * instruction. The results are always identical to calcPerform()'s.
+ *
+ * The caller owns the result and must free it with calcCompiledFree().
+ * A NULL result means the expression couldn't be compiled, and should
+ * be evaluated with calcPerform() instead.
+ * \param ppostfix The postfix expression created by postfix().
+ * \return The compiled expression, or NULL.
+ */
+LIBCOM_API calcCompiled *
+    calcCompile(const char *ppostfix);
+
+/** \brief Run the calculation engine on a compiled expression
+ *
+ * Exactly like calcPerform(), but evaluates an expression compiled by
+ * calcCompile().
+ * \param parg Pointer to an array of double values for the arguments A-L.
+ * \param presult Where to put the calculated result.
+ * \param pcompiled The expression returned by calcCompile().
+ * \return Status value 0 for OK, or non-zero if an error is discovered
+ * during the evaluation process.
+ */
+LIBCOM_API long
+    calcPerformCompiled(double *parg, double *presult,
+        const calcCompiled *pcompiled);
+
+/** \brief Free a compiled expression
+ *
+ * \param pcompiled The expression returned by calcCompile(), may be NULL.
+ */
+LIBCOM_API void
+    calcCompiledFree(calcCompiled *pcompiled);
+
 /** \brief Convert an error code to a string.
  *
  * Gives out a printable version of an individual error code.
@@ -103,4 +103,9 @@ typedef enum {
     NOT_GENERATED
 } rpn_opcode;
 
+/* The RANDOM operator, shared by calcPerform() and calcPerformCompiled().
+ * Internal to libCom, this header is not installed.
+ */
+double epicsCalcRandom(void);
+
 #endif /* INCpostfixPvth */
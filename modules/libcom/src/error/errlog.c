@@ -20,8 +20,8 @@
 #include <errno.h>
 
 #define ERRLOG_INIT
-#include "adjustment.h"
 #include "dbDefs.h"
+#include "epicsAtomic.h"
 #include "epicsThread.h"
 #include "cantProceed.h"
 #include "epicsMutex.h"
@@ -37,6 +37,7 @@
 
 #define BUFFER_SIZE 1280
 #define MAX_MESSAGE_SIZE 256
+#define MAX_BATCH 32
 
 /*Declare storage for errVerbose */
 int errVerbose = 0;
@@ -44,28 +45,47 @@ int errVerbose = 0;
 static void errlogExitHandler(void *);
 static void errlogThread(void);
 
-static char *msgbufGetFree(int noConsoleMessage);
-static void msgbufSetSize(int size); /* Send 'size' chars plus trailing '\0' */
-static char *msgbufGetSend(int *noConsoleMessage);
-static void msgbufFreeSend(void);
+/* Index into pvtData.dropped for messages without a severity */
+#define SEV_NONE 4
+
+static int msgbufSend(const char *message, int nchar, int noConsoleMessage,
+    int sev);
+static int msgbufDeliver(void);
 
 typedef struct listenerNode{
     ELLNODE node;
     errlogListener listener;
+    errlogBatchListener batchListener;
     void *pPrivate;
 } listenerNode;
 
-/*each message consists of a msgNode immediately followed by the message */
+/*
+ * The buffer is a ring which any thread may write and errlogThread reads.
+ * A writer claims space by advancing head with a compare and swap, copies
+ * its message in, then sets state to show that it is ready. errlogThread
+ * delivers ready messages in order, zeroes them and advances tail.
+ * Each message is a msgNode immediately followed by the text. A message
+ * which won't fit before the end of the ring goes at the start, and a
+ * msgNode with state MSG_PAD covers the space it skipped.
+ */
+#define MSG_READY 0x52454459
+#define MSG_PAD 0x50414444
+
 typedef struct msgNode {
-    ELLNODE node;
-    char *message;
-    int length;
+    int state;      /* MSG_READY or MSG_PAD once written, else zero */
+    int size;       /* bytes of the ring used, including this header */
+    int length;     /* of the message, including the trailing '\0' */
     int noConsoleMessage;
 } msgNode;
 
+/* Messages are formatted here before being copied into the ring */
+typedef struct msgText {
+    char *pbuf;
+    char local[MAX_MESSAGE_SIZE];
+} msgText;
+
 static struct {
     epicsEventId waitForWork; /*errlogThread waits for this*/
-    epicsMutexId msgQueueLock;
     epicsMutexId listenerLock;
     epicsEventId waitForFlush; /*errlogFlush waits for this*/
     epicsEventId flush; /*errlogFlush sets errlogThread does a Try*/
@@ -73,19 +93,33 @@ static struct {
     epicsEventId waitForExit; /*errlogExitHandler waits for this*/
     int          atExit;      /*TRUE when errlogExitHandler is active*/
     ELLLIST      listenerList;
-    ELLLIST      msgQueue;
-    msgNode      *pnextSend;
     int          errlogInitFailed;
-    int          buffersize;
+    size_t       buffersize;  /* a power of two */
     int          maxMsgSize;
-    int          msgNeeded;
     int          sevToLog;
     int          toConsole;
     FILE         *console;
-    int          missedMessages;
+    size_t       head;        /* total bytes ever claimed by writers */
+    size_t       tail;        /* total bytes ever freed by errlogThread */
+    size_t       discarded;   /* since the last report */
+    size_t       dropped[SEV_NONE + 1];
     char         *pbuffer;
 } pvtData;
 
+static char * msgTextInit(msgText *ptext)
+{
+    ptext->pbuf = ptext->local;
+    if (pvtData.maxMsgSize > sizeof ptext->local)
+        ptext->pbuf = malloc(pvtData.maxMsgSize);
+    return ptext->pbuf;
+}
+
+static void msgTextFree(msgText *ptext)
+{
+    if (ptext->pbuf != ptext->local)
+        free(ptext->pbuf);
+}
+
 
 /*
  * vsnprintf with truncation message
@@ -106,6 +140,7 @@ static int tvsnPrint(char *str, size_t size, const char *format, va_list ap)
 int errlogPrintf(const char *pFormat, ...)
 {
     va_list pvar;
+    msgText text;
     char *pbuffer;
     int nchar;
     int isOkToBlock;
@@ -131,20 +166,23 @@ int errlogPrintf(const char *pFormat, ...)
     if (pvtData.atExit)
         return nchar;
 
-    pbuffer = msgbufGetFree(isOkToBlock);
+    pbuffer = msgTextInit(&text);
     if (!pbuffer)
         return 0;
 
     va_start(pvar, pFormat);
     nchar = tvsnPrint(pbuffer, pvtData.maxMsgSize, pFormat?pFormat:"", pvar);
     va_end(pvar);
-    msgbufSetSize(nchar);
+    if (!msgbufSend(pbuffer, nchar, isOkToBlock, SEV_NONE))
+        nchar = 0;
+    msgTextFree(&text);
     return nchar;
 }
 
 int errlogVprintf(const char *pFormat,va_list pvar)
 {
     int nchar;
+    msgText text;
     char *pbuffer;
     int isOkToBlock;
     FILE *console;
@@ -160,13 +198,9 @@ int errlogVprintf(const char *pFormat,va_list pvar)
         return 0;
     isOkToBlock = epicsThreadIsOkToBlock();
 
-    pbuffer = msgbufGetFree(isOkToBlock);
-    if (!pbuffer) {
-        console = pvtData.console ? pvtData.console : stderr;
-        vfprintf(console, pFormat, pvar);
-        fflush(console);
+    pbuffer = msgTextInit(&text);
+    if (!pbuffer)
         return 0;
-    }
 
     nchar = tvsnPrint(pbuffer, pvtData.maxMsgSize, pFormat?pFormat:"", pvar);
     if (pvtData.atExit || (isOkToBlock && pvtData.toConsole)) {
@@ -174,7 +208,9 @@ int errlogVprintf(const char *pFormat,va_list pvar)
         fprintf(console, "%s", pbuffer);
         fflush(console);
     }
-    msgbufSetSize(nchar);
+    if (!msgbufSend(pbuffer, nchar, isOkToBlock, SEV_NONE))
+        nchar = 0;
+    msgTextFree(&text);
     return nchar;
 }
 
@@ -205,6 +241,7 @@ int errlogPrintfNoConsole(const char *pFormat, ...)
 int errlogVprintfNoConsole(const char *pFormat, va_list pvar)
 {
     int nchar;
+    msgText text;
     char *pbuffer;
 
     if (epicsInterruptIsInterruptContext()) {
@@ -217,12 +254,14 @@ int errlogVprintfNoConsole(const char *pFormat, va_list pvar)
     if (pvtData.atExit)
         return 0;
 
-    pbuffer = msgbufGetFree(1);
+    pbuffer = msgTextInit(&text);
     if (!pbuffer)
         return 0;
 
     nchar = tvsnPrint(pbuffer, pvtData.maxMsgSize, pFormat?pFormat:"", pvar);
-    msgbufSetSize(nchar);
+    if (!msgbufSend(pbuffer, nchar, 1, SEV_NONE))
+        nchar = 0;
+    msgTextFree(&text);
     return nchar;
 }
 
@@ -262,6 +301,7 @@ int errlogSevPrintf(errlogSevEnum severity, const char *pFormat, ...)
 
 int errlogSevVprintf(errlogSevEnum severity, const char *pFormat, va_list pvar)
 {
+    msgText text;
     char *pnext;
     int nchar;
     int totalChar = 0;
@@ -278,7 +318,7 @@ int errlogSevVprintf(errlogSevEnum severity, const char *pFormat, va_list pvar)
         return 0;
 
     isOkToBlock = epicsThreadIsOkToBlock();
-    pnext = msgbufGetFree(isOkToBlock);
+    pnext = msgTextInit(&text);
     if (!pnext)
         return 0;
 
@@ -290,7 +330,10 @@ int errlogSevVprintf(errlogSevEnum severity, const char *pFormat, va_list pvar)
         strcpy(pnext,"\n");
         totalChar++;
     }
-    msgbufSetSize(totalChar);
+    if (!msgbufSend(text.pbuf, totalChar, isOkToBlock,
+            severity <= errlogFatal ? severity : SEV_NONE))
+        nchar = 0;
+    msgTextFree(&text);
     return nchar;
 }
 
@@ -315,6 +358,16 @@ errlogSevEnum errlogGetSevToLog(void)
     return pvtData.sevToLog;
 }
 
+void errlogGetDropCounts(errlogDropCounts *pcounts)
+{
+    int i;
+
+    errlogInit(0);
+    for (i = errlogInfo; i <= errlogFatal; i++)
+        pcounts->severity[i] = epicsAtomicGetSizeT(&pvtData.dropped[i]);
+    pcounts->other = epicsAtomicGetSizeT(&pvtData.dropped[SEV_NONE]);
+}
+
 void errlogAddListener(errlogListener listener, void *pPrivate)
 {
     listenerNode *plistenerNode;
@@ -332,7 +385,25 @@ void errlogAddListener(errlogListener listener, void *pPrivate)
     epicsMutexUnlock(pvtData.listenerLock);
 }
 
-int errlogRemoveListeners(errlogListener listener, void *pPrivate)
+void errlogAddBatchListener(errlogBatchListener listener, void *pPrivate)
+{
+    listenerNode *plistenerNode;
+
+    errlogInit(0);
+    if (pvtData.atExit)
+        return;
+
+    plistenerNode = callocMustSucceed(1,sizeof(listenerNode),
+        "errlogAddBatchListener");
+    epicsMutexMustLock(pvtData.listenerLock);
+    plistenerNode->batchListener = listener;
+    plistenerNode->pPrivate = pPrivate;
+    ellAdd(&pvtData.listenerList,&plistenerNode->node);
+    epicsMutexUnlock(pvtData.listenerLock);
+}
+
+static int removeListeners(errlogListener listener,
+    errlogBatchListener batchListener, void *pPrivate, const char *caller)
 {
     listenerNode *plistenerNode;
     int count = 0;
@@ -346,6 +417,7 @@ int errlogRemoveListeners(errlogListener listener, void *pPrivate)
         listenerNode *pnext = (listenerNode *)ellNext(&plistenerNode->node);
 
         if (plistenerNode->listener == listener &&
+            plistenerNode->batchListener == batchListener &&
             plistenerNode->pPrivate == pPrivate) {
             ellDelete(&pvtData.listenerList, &plistenerNode->node);
             free(plistenerNode);
@@ -360,12 +432,23 @@ int errlogRemoveListeners(errlogListener listener, void *pPrivate)
     if (count == 0) {
         FILE *console = pvtData.console ? pvtData.console : stderr;
 
-        fprintf(console,
-            "errlogRemoveListeners: No listeners found\n");
+        fprintf(console, "%s: No listeners found\n", caller);
     }
     return count;
 }
 
+int errlogRemoveListeners(errlogListener listener, void *pPrivate)
+{
+    return removeListeners(listener, NULL, pPrivate,
+        "errlogRemoveListeners");
+}
+
+int errlogRemoveBatchListeners(errlogBatchListener listener, void *pPrivate)
+{
+    return removeListeners(NULL, listener, pPrivate,
+        "errlogRemoveBatchListeners");
+}
+
 int eltc(int yesno)
 {
     errlogInit(0);
@@ -385,6 +468,7 @@ void errPrintf(long status, const char *pFileName, int lineno,
     const char *pformat, ...)
 {
     va_list pvar;
+    msgText text;
     char    *pnext;
     int     nchar;
     int     totalChar=0;
@@ -424,7 +508,7 @@ void errPrintf(long status, const char *pFileName, int lineno,
     if (pvtData.atExit)
         return;
 
-    pnext = msgbufGetFree(isOkToBlock);
+    pnext = msgTextInit(&text);
     if (!pnext)
         return;
 
@@ -447,7 +531,8 @@ void errPrintf(long status, const char *pFileName, int lineno,
     }
     strcpy(pnext, "\n");
     totalChar++ ; /*include the \n */
-    msgbufSetSize(totalChar);
+    msgbufSend(text.pbuf, totalChar, isOkToBlock, SEV_NONE);
+    msgTextFree(&text);
 }
 
 
@@ -469,17 +554,19 @@ static void errlogInitPvt(void *arg)
     epicsThreadId tid;
 
     pvtData.errlogInitFailed = TRUE;
-    pvtData.buffersize = pconfig->bufsize;
     pvtData.maxMsgSize = pconfig->maxMsgSize;
-    pvtData.msgNeeded = adjustToWorstCaseAlignment(pvtData.maxMsgSize +
-        sizeof(msgNode));
+    /* A power of two so head and tail can simply wrap, and room for
+     * the largest message wherever the last one ended.
+     */
+    pvtData.buffersize = sizeof(msgNode);
+    while (pvtData.buffersize < pconfig->bufsize ||
+        pvtData.buffersize < 2 * (pvtData.maxMsgSize + 2 * sizeof(msgNode)))
+        pvtData.buffersize *= 2;
     ellInit(&pvtData.listenerList);
-    ellInit(&pvtData.msgQueue);
     pvtData.toConsole = TRUE;
     pvtData.console = NULL;
     pvtData.waitForWork = epicsEventMustCreate(epicsEventEmpty);
     pvtData.listenerLock = epicsMutexMustCreate();
-    pvtData.msgQueueLock = epicsMutexMustCreate();
     pvtData.waitForFlush = epicsEventMustCreate(epicsEventEmpty);
     pvtData.flush = epicsEventMustCreate(epicsEventEmpty);
     pvtData.flushLock = epicsMutexMustCreate();
@@ -529,17 +616,13 @@ int errlogInit(int bufsize)
 
 void errlogFlush(void)
 {
-    int count;
-
     errlogInit(0);
     if (pvtData.atExit)
         return;
 
    /*If nothing in queue dont wake up errlogThread*/
-    epicsMutexMustLock(pvtData.msgQueueLock);
-    count = ellCount(&pvtData.msgQueue);
-    epicsMutexUnlock(pvtData.msgQueueLock);
-    if (count <= 0)
+    if (epicsAtomicGetSizeT(&pvtData.head) ==
+        epicsAtomicGetSizeT(&pvtData.tail))
         return;
 
     /*must let errlogThread empty queue*/
@@ -552,31 +635,11 @@ void errlogFlush(void)
 
 static void errlogThread(void)
 {
-    listenerNode *plistenerNode;
-    int noConsoleMessage;
-    char *pmessage;
-
     epicsAtExit(errlogExitHandler,0);
     while (TRUE) {
         epicsEventMustWait(pvtData.waitForWork);
-        while ((pmessage = msgbufGetSend(&noConsoleMessage))) {
-            epicsMutexMustLock(pvtData.listenerLock);
-            if (pvtData.toConsole && !noConsoleMessage) {
-                FILE *console = pvtData.console ? pvtData.console : stderr;
-
-                fprintf(console, "%s", pmessage);
-                fflush(console);
-            }
-
-            plistenerNode = (listenerNode *)ellFirst(&pvtData.listenerList);
-            while (plistenerNode) {
-                (*plistenerNode->listener)(plistenerNode->pPrivate, pmessage);
-                plistenerNode = (listenerNode *)ellNext(&plistenerNode->node);
-            }
-
-            epicsMutexUnlock(pvtData.listenerLock);
-            msgbufFreeSend();
-        }
+        while (msgbufDeliver())
+            ;
 
         if (pvtData.atExit)
             break;
@@ -590,106 +653,165 @@ static void errlogThread(void)
 }
 
 
-static msgNode * msgbufGetNode(void)
+/* Claim 'size' bytes of the ring, returning 0 if there isn't room */
+static msgNode * msgbufClaim(size_t size)
 {
-    char *pbuffer = pvtData.pbuffer;
-    char *pnextFree;
-    msgNode *pnextSend;
+    size_t mask = pvtData.buffersize - 1;
 
-    if (ellCount(&pvtData.msgQueue) == 0 ) {
-        pnextFree = pbuffer;        /* Reset if empty */
-    }
-    else {
-        msgNode *pfirst = (msgNode *)ellFirst(&pvtData.msgQueue);
-        msgNode *plast = (msgNode *)ellLast(&pvtData.msgQueue);
-        char *plimit = pbuffer + pvtData.buffersize;
-
-        pnextFree = plast->message + adjustToWorstCaseAlignment(plast->length);
-        if (pfirst > plast) {
-            plimit = (char *)pfirst;
-        }
-        else if (pnextFree + pvtData.msgNeeded > plimit) {
-            pnextFree = pbuffer;    /* Hit end, wrap to start */
-            plimit = (char *)pfirst;
-        }
-        if (pnextFree + pvtData.msgNeeded > plimit) {
+    while (TRUE) {
+        size_t head = epicsAtomicGetSizeT(&pvtData.head);
+        size_t tail = epicsAtomicGetSizeT(&pvtData.tail);
+        size_t pos = head & mask;
+        size_t toEnd = pvtData.buffersize - pos;
+        size_t claim = size;
+
+        if (size > toEnd)
+            claim += toEnd;         /* Hit end, wrap to start */
+        if (head - tail + claim > pvtData.buffersize)
             return 0;               /* No room */
+
+        if (epicsAtomicCmpAndSwapSizeT(&pvtData.head, head, head + claim)
+                != head)
+            continue;
+
+        if (size > toEnd) {
+            msgNode *ppad = (msgNode *)(pvtData.pbuffer + pos);
+
+            ppad->size = toEnd;
+            epicsAtomicWriteMemoryBarrier();
+            epicsAtomicSetIntT(&ppad->state, MSG_PAD);
+            pos = 0;
         }
+        return (msgNode *)(pvtData.pbuffer + pos);
     }
-
-    pnextSend = (msgNode *)pnextFree;
-    pnextSend->message = pnextFree + sizeof(msgNode);
-    pnextSend->length = 0;
-    return pnextSend;
 }
 
-static char * msgbufGetFree(int noConsoleMessage)
+/* Copy 'nchar' chars plus a trailing '\0' into the ring */
+static int msgbufPut(const char *message, int nchar, int noConsoleMessage)
 {
-    msgNode *pnextSend;
+    size_t size = sizeof(msgNode) + nchar + 1;
+    msgNode *pnode;
 
-    if (epicsMutexLock(pvtData.msgQueueLock) != epicsMutexLockOK)
+    size = (size + sizeof(msgNode) - 1) / sizeof(msgNode) * sizeof(msgNode);
+    pnode = msgbufClaim(size);
+    if (!pnode)
         return 0;
 
-    if ((ellCount(&pvtData.msgQueue) == 0) && pvtData.missedMessages) {
-        int nchar;
+    pnode->size = size;
+    pnode->length = nchar + 1;
+    pnode->noConsoleMessage = noConsoleMessage;
+    memcpy(pnode + 1, message, nchar);
+    ((char *)(pnode + 1))[nchar] = '\0';
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetIntT(&pnode->state, MSG_READY);
+    return 1;
+}
 
-        pnextSend = msgbufGetNode();
-        nchar = sprintf(pnextSend->message,
-            "errlog: %d messages were discarded\n", pvtData.missedMessages);
-        pnextSend->length = nchar + 1;
-        pvtData.missedMessages = 0;
-        ellAdd(&pvtData.msgQueue, &pnextSend->node);
+/* Queue a message for errlogThread, counting it by severity if there's
+ * no room for it.
+ */
+static int msgbufSend(const char *message, int nchar, int noConsoleMessage,
+    int sev)
+{
+    size_t discarded = epicsAtomicGetSizeT(&pvtData.discarded);
+    int sent;
+
+    /* Report losses once everything queued before them has gone */
+    if (discarded &&
+        epicsAtomicGetSizeT(&pvtData.head) ==
+            epicsAtomicGetSizeT(&pvtData.tail) &&
+        epicsAtomicCmpAndSwapSizeT(&pvtData.discarded, discarded, 0) ==
+            discarded) {
+        char notice[64];
+        int n = sprintf(notice, "errlog: %lu messages were discarded\n",
+            (unsigned long) discarded);
+
+        if (!msgbufPut(notice, n, 0))
+            epicsAtomicAddSizeT(&pvtData.discarded, discarded);
     }
 
-    pvtData.pnextSend = pnextSend = msgbufGetNode();
-    if (pnextSend) {
-        pnextSend->noConsoleMessage = noConsoleMessage;
-        pnextSend->length = 0;
-        return pnextSend->message;  /* NB: msgQueueLock is still locked */
+    sent = msgbufPut(message, nchar, noConsoleMessage);
+    if (!sent) {
+        epicsAtomicIncrSizeT(&pvtData.discarded);
+        epicsAtomicIncrSizeT(&pvtData.dropped[sev]);
     }
-
-    ++pvtData.missedMessages;
-    epicsMutexUnlock(pvtData.msgQueueLock);
-    return 0;
+    epicsEventSignal(pvtData.waitForWork);
+    return sent;
 }
 
-static void msgbufSetSize(int size)
+/* Zero a message and give its space back to the writers */
+static void msgbufFree(msgNode *pnode)
 {
-    msgNode *pnextSend = pvtData.pnextSend;
+    size_t size = pnode->size;
 
-    pnextSend->length = size+1;
-    ellAdd(&pvtData.msgQueue, &pnextSend->node);
-    epicsMutexUnlock(pvtData.msgQueueLock);
-    epicsEventSignal(pvtData.waitForWork);
+    memset(pnode, 0, size);
+    epicsAtomicWriteMemoryBarrier();
+    epicsAtomicSetSizeT(&pvtData.tail, pvtData.tail + size);
 }
 
-
-static char * msgbufGetSend(int *noConsoleMessage)
+/*
+ * Deliver up to MAX_BATCH ready messages from the front of the ring and
+ * return how many. Batch listeners get them all in one call, the console
+ * and the other listeners one at a time. Each message is freed as soon as
+ * it has been delivered.
+ */
+static int msgbufDeliver(void)
 {
-    msgNode *pnextSend;
+    const char *messages[MAX_BATCH];
+    msgNode *nodes[MAX_BATCH];
+    size_t mask = pvtData.buffersize - 1;
+    size_t pos = pvtData.tail;
+    listenerNode *plistenerNode;
+    FILE *console = NULL;
+    int count = 0;
+    int i;
 
-    epicsMutexMustLock(pvtData.msgQueueLock);
-    pnextSend = (msgNode *)ellFirst(&pvtData.msgQueue);
-    epicsMutexUnlock(pvtData.msgQueueLock);
-    if (!pnextSend)
-        return 0;
+    while (count < MAX_BATCH) {
+        msgNode *pnode = (msgNode *)(pvtData.pbuffer + (pos & mask));
+        int state = epicsAtomicGetIntT(&pnode->state);
 
-    *noConsoleMessage = pnextSend->noConsoleMessage;
-    return pnextSend->message;
-}
+        epicsAtomicReadMemoryBarrier();
+        if (state == MSG_PAD && count == 0) {
+            pos += pnode->size;
+            msgbufFree(pnode);
+            continue;
+        }
+        if (state != MSG_READY)
+            break;
 
-static void msgbufFreeSend(void)
-{
-    msgNode *pnextSend;
+        nodes[count] = pnode;
+        messages[count++] = (const char *)(pnode + 1);
+        pos += pnode->size;
+    }
+    if (count == 0)
+        return 0;
 
-    epicsMutexMustLock(pvtData.msgQueueLock);
-    pnextSend = (msgNode *)ellFirst(&pvtData.msgQueue);
-    if (!pnextSend) {
-        FILE *console = pvtData.console ? pvtData.console : stderr;
+    epicsMutexMustLock(pvtData.listenerLock);
+    plistenerNode = (listenerNode *)ellFirst(&pvtData.listenerList);
+    while (plistenerNode) {
+        if (plistenerNode->batchListener)
+            (*plistenerNode->batchListener)(plistenerNode->pPrivate,
+                messages, count);
+        plistenerNode = (listenerNode *)ellNext(&plistenerNode->node);
+    }
 
-        fprintf(console, "errlog: msgbufFreeSend logic error\n");
-        epicsThreadSuspendSelf();
+    for (i = 0; i < count; i++) {
+        if (pvtData.toConsole && !nodes[i]->noConsoleMessage) {
+            console = pvtData.console ? pvtData.console : stderr;
+            fputs(messages[i], console);
+        }
+
+        plistenerNode = (listenerNode *)ellFirst(&pvtData.listenerList);
+        while (plistenerNode) {
+            if (plistenerNode->listener)
+                (*plistenerNode->listener)(plistenerNode->pPrivate,
+                    messages[i]);
+            plistenerNode = (listenerNode *)ellNext(&plistenerNode->node);
+        }
+        msgbufFree(nodes[i]);
     }
-    ellDelete(&pvtData.msgQueue, &pnextSend->node);
-    epicsMutexUnlock(pvtData.msgQueueLock);
+    if (console)
+        fflush(console);
+    epicsMutexUnlock(pvtData.listenerLock);
+    return count;
 }
@@ -23,6 +23,9 @@ extern "C" {
 #endif
 
 typedef void (*errlogListener)(void *pPrivate, const char *message);
+/* Called with up to 32 messages at a time, in the order they were logged */
+typedef void (*errlogBatchListener)(void *pPrivate,
+    const char * const *messages, int count);
 
 typedef enum {
     errlogInfo,
@@ -31,6 +34,12 @@ typedef enum {
     errlogFatal
 } errlogSevEnum;
 
+/* Messages discarded because the buffer was full */
+typedef struct {
+    size_t severity[errlogFatal + 1]; /* from errlogSevPrintf() etc. */
+    size_t other;                     /* from all the other routines */
+} errlogDropCounts;
+
 LIBCOM_API extern int errVerbose;
 
 
@@ -68,6 +77,11 @@ LIBCOM_API errlogSevEnum errlogGetSevToLog(void);
 LIBCOM_API void errlogAddListener(errlogListener listener, void *pPrivate);
 LIBCOM_API int errlogRemoveListeners(errlogListener listener,
     void *pPrivate);
+LIBCOM_API void errlogAddBatchListener(errlogBatchListener listener,
+    void *pPrivate);
+LIBCOM_API int errlogRemoveBatchListeners(errlogBatchListener listener,
+    void *pPrivate);
+LIBCOM_API void errlogGetDropCounts(errlogDropCounts *pcounts);
 
 LIBCOM_API int eltc(int yesno);
 LIBCOM_API int errlogSetConsole(FILE *stream);
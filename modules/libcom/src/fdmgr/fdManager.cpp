@@ -20,6 +20,16 @@
 //
 
 #include <algorithm>
+#include <climits>
+#include <cmath>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__linux__)
+#   include <unistd.h>
+#   include <sys/epoll.h>
+#   define FDMGR_EPOLL
+#endif
 
 #define instantiateRecourceLib
 #include "epicsAssert.h"
@@ -34,6 +44,9 @@ fdManager fileDescriptorManager;
 const unsigned mSecPerSec = 1000u;
 const unsigned uSecPerSec = 1000u * mSecPerSec;
 
+// events collected by one epoll_wait() call
+const int maxEpollEvents = 256;
+
 //
 // fdManager::fdManager()
 //
@@ -44,7 +57,23 @@ LIBCOM_API fdManager::fdManager () :
     sleepQuantum ( epicsThreadSleepQuantum () ),
         fdSetsPtr ( new fd_set [fdrNEnums] ),
         pTimerQueue ( 0 ), maxFD ( 0 ), processInProg ( false ),
-        pCBReg ( 0 )
+        pCBReg ( 0 ), epollFD ( -1 ), useEpoll ( false ), nAlwaysReady ( 0u ),
+        pEpollEvents ( 0 )
+{
+    this->init ( fdmbDefault );
+}
+
+LIBCOM_API fdManager::fdManager ( fdManagerBackend backend ) :
+    sleepQuantum ( epicsThreadSleepQuantum () ),
+        fdSetsPtr ( new fd_set [fdrNEnums] ),
+        pTimerQueue ( 0 ), maxFD ( 0 ), processInProg ( false ),
+        pCBReg ( 0 ), epollFD ( -1 ), useEpoll ( false ), nAlwaysReady ( 0u ),
+        pEpollEvents ( 0 )
+{
+    this->init ( backend );
+}
+
+void fdManager::init ( fdManagerBackend backend )
 {
     int status = osiSockAttach ();
     assert (status);
@@ -52,6 +81,20 @@ LIBCOM_API fdManager::fdManager () :
     for ( size_t i = 0u; i < fdrNEnums; i++ ) {
         FD_ZERO ( &fdSetsPtr[i] );
     }
+
+    //
+    // The epoll instance is created when the first fd is registered
+    // so that processes which never use this fdManager dont hold an
+    // extra file descriptor.
+    //
+#ifdef FDMGR_EPOLL
+    this->useEpoll = ( backend == fdmbDefault );
+#endif
+}
+
+LIBCOM_API const char * fdManager::backendName () const
+{
+    return this->useEpoll ? "epoll" : "select";
 }
 
 //
@@ -71,6 +114,12 @@ LIBCOM_API fdManager::~fdManager()
     }
     delete this->pTimerQueue;
     delete [] this->fdSetsPtr;
+#ifdef FDMGR_EPOLL
+    if ( this->epollFD >= 0 ) {
+        close ( this->epollFD );
+    }
+    delete [] this->pEpollEvents;
+#endif
     osiSockRelease();
 }
 
@@ -102,11 +151,28 @@ LIBCOM_API void fdManager::process (double delay)
         minDelay = delay;
     }
 
+    if ( this->useEpoll ) {
+        this->processEpoll ( minDelay );
+    }
+    else {
+        this->processSelect ( minDelay );
+    }
+    this->processInProg = false;
+}
+
+//
+// fdManager::processSelect()
+//
+void fdManager::processSelect ( double minDelay )
+{
     bool ioPending = false;
     tsDLIter < fdReg > iter = this->regList.firstIter ();
     while ( iter.valid () ) {
-        FD_SET(iter->getFD(), &this->fdSetsPtr[iter->getType()]);
-        ioPending = true;
+        // the fdReg constructor refused larger fds
+        if ( FD_IN_FDSET ( iter->getFD () ) ) {
+            FD_SET(iter->getFD(), &this->fdSetsPtr[iter->getType()]);
+            ioPending = true;
+        }
         ++iter;
     }
 
@@ -141,38 +207,7 @@ LIBCOM_API void fdManager::process (double delay)
                 iter = tmp;
             }
 
-            //
-            // I am careful to prevent problems if they access the
-            // above list while in a "callBack()" routine
-            //
-            fdReg * pReg;
-            while ( (pReg = this->activeList.get()) ) {
-                pReg->state = fdReg::limbo;
-
-                //
-                // Tag current fdReg so that we
-                // can detect if it was deleted
-                // during the call back
-                //
-                this->pCBReg = pReg;
-                pReg->callBack();
-                if (this->pCBReg != NULL) {
-                    //
-                    // check only after we see that it is non-null so
-                    // that we dont trigger bounds-checker dangling pointer
-                    // error
-                    //
-                    assert (this->pCBReg==pReg);
-                    this->pCBReg = 0;
-                    if (pReg->onceOnly) {
-                        pReg->destroy();
-                    }
-                    else {
-                        this->regList.add(*pReg);
-                        pReg->state = fdReg::pending;
-                    }
-                }
-            }
+            this->dispatchActive ();
         }
         else if ( status < 0 ) {
             int errnoCpy = SOCKERRNO;
@@ -205,8 +240,137 @@ LIBCOM_API void fdManager::process (double delay)
         epicsThreadSleep(minDelay);
         this->pTimerQueue->process(epicsTime::getCurrent());
     }
-    this->processInProg = false;
-    return;
+}
+
+//
+// fdManager::processEpoll()
+//
+// Level triggered, so that like select() a callBack() which leaves
+// input unread is called again on the next pass.
+//
+void fdManager::processEpoll ( double minDelay )
+{
+#ifdef FDMGR_EPOLL
+    if ( this->regList.count () == 0u || this->epollFD < 0 ) {
+        epicsThreadSleep(minDelay);
+        this->pTimerQueue->process(epicsTime::getCurrent());
+        return;
+    }
+
+    // round up so that timers arent serviced early
+    int timeout = INT_MAX;
+    if ( minDelay <= 0.0 || this->nAlwaysReady ) {
+        timeout = 0;
+    }
+    else if ( minDelay < INT_MAX / mSecPerSec ) {
+        timeout = static_cast < int > ( ceil ( minDelay * mSecPerSec ) );
+    }
+
+    int status = epoll_wait ( this->epollFD, this->pEpollEvents,
+        maxEpollEvents, timeout );
+    int errnoCpy = errno;
+
+    this->pTimerQueue->process(epicsTime::getCurrent());
+
+    if ( status > 0 ) {
+        for ( int i = 0; i < status; i++ ) {
+            SOCKET fd = this->pEpollEvents[i].data.fd;
+            unsigned events = this->pEpollEvents[i].events;
+
+            // the same conditions as satisfy select() on Linux, but
+            // epoll() always reports a hang up or error, so it goes to
+            // every interest in the fd, or it would be reported again
+            // on each pass without ever being dispatched
+            unsigned always = events & ( EPOLLHUP | EPOLLERR );
+            if ( events & EPOLLIN || always ) {
+                this->activate ( fd, fdrRead );
+            }
+            if ( events & EPOLLOUT || always ) {
+                this->activate ( fd, fdrWrite );
+            }
+            if ( events & EPOLLPRI || always ) {
+                this->activate ( fd, fdrException );
+            }
+        }
+    }
+    else if ( status < 0 && errnoCpy != EINTR ) {
+        fprintf ( stderr,
+            "fdManager: epoll_wait failed because \"%s\"\n",
+            strerror ( errnoCpy ) );
+    }
+
+    // select() finds them readable and writable on every pass
+    if ( this->nAlwaysReady ) {
+        tsDLIter < fdReg > iter = this->regList.firstIter ();
+        while ( iter.valid () ) {
+            tsDLIter < fdReg > tmp = iter;
+            tmp++;
+            if ( iter->alwaysReady && iter->getType () != fdrException ) {
+                this->activate ( iter->getFD (), iter->getType () );
+            }
+            iter = tmp;
+        }
+    }
+    this->dispatchActive ();
+#endif
+}
+
+//
+// fdManager::activate()
+//
+void fdManager::activate ( SOCKET fd, fdRegType type )
+{
+    fdReg * pReg = this->lookUpFD ( fd, type );
+    if ( pReg && pReg->state == fdReg::pending ) {
+        this->regList.remove ( *pReg );
+        // writes first, as installReg() arranges for select()
+        if ( type == fdrWrite ) {
+            this->activeList.push ( *pReg );
+        }
+        else {
+            this->activeList.add ( *pReg );
+        }
+        pReg->state = fdReg::active;
+    }
+}
+
+//
+// fdManager::dispatchActive()
+//
+void fdManager::dispatchActive ()
+{
+    //
+    // I am careful to prevent problems if they access the
+    // above list while in a "callBack()" routine
+    //
+    fdReg * pReg;
+    while ( (pReg = this->activeList.get()) ) {
+        pReg->state = fdReg::limbo;
+
+        //
+        // Tag current fdReg so that we
+        // can detect if it was deleted
+        // during the call back
+        //
+        this->pCBReg = pReg;
+        pReg->callBack();
+        if (this->pCBReg != NULL) {
+            //
+            // check only after we see that it is non-null so
+            // that we dont trigger bounds-checker dangling pointer
+            // error
+            //
+            assert (this->pCBReg==pReg);
+            this->pCBReg = 0;
+            if (pReg->onceOnly) {
+                pReg->destroy();
+            }
+            else {
+                this->regList.add(*pReg);
+                pReg->state = fdReg::pending;
+            }
+        }
+    }
 }
 
 //
@@ -257,6 +421,12 @@ void fdRegId::show ( unsigned level ) const
 //
 void fdManager::installReg (fdReg &reg)
 {
+    // before it is listed, the fdReg is gone if this throws
+    int status = this->fdTbl.add ( reg );
+    if ( status != 0 ) {
+        throwWithLocation ( fdInterestSubscriptionAlreadyExits () );
+    }
+
     this->maxFD = max ( this->maxFD, reg.getFD()+1 );
     // Most applications will find that its important to push here to
     // the front of the list so that transient writes get executed
@@ -265,9 +435,23 @@ void fdManager::installReg (fdReg &reg)
     this->regList.push ( reg );
     reg.state = fdReg::pending;
 
-    int status = this->fdTbl.add ( reg );
-    if ( status != 0 ) {
-        throwWithLocation ( fdInterestSubscriptionAlreadyExits () );
+    if ( this->useEpoll && ! this->epollUpdate ( reg.getFD () ) ) {
+        if ( this->epollFD < 0 ) {
+            // this is the first registration, so select() takes over
+            fprintf ( stderr, "fdManager: no epoll instance, "
+                "using select\n" );
+            this->useEpoll = false;
+        }
+        else {
+            //
+            // Some descriptors (regular files for instance) cant be
+            // watched by epoll(), but select() always finds them ready.
+            // Dont switch to select(), which would ignore any fd at or
+            // above FD_SETSIZE, instead dispatch this one on every pass.
+            //
+            reg.alwaysReady = true;
+            this->nAlwaysReady++;
+        }
     }
 }
 
@@ -310,7 +494,64 @@ void fdManager::removeReg (fdReg &regIn)
     }
     regIn.state = fdReg::limbo;
 
-    FD_CLR(regIn.getFD(), &this->fdSetsPtr[regIn.getType()]);
+    if ( regIn.alwaysReady ) {
+        regIn.alwaysReady = false;
+        this->nAlwaysReady--;
+    }
+    else if ( this->useEpoll ) {
+        this->epollUpdate ( regIn.getFD () );
+    }
+    else if ( FD_IN_FDSET ( regIn.getFD () ) ) {
+        FD_CLR(regIn.getFD(), &this->fdSetsPtr[regIn.getType()]);
+    }
+}
+
+//
+// fdManager::epollUpdate ()
+//
+// Make the epoll interest set for fd match its registrations,
+// returns false if epoll() cant watch the fd.
+//
+bool fdManager::epollUpdate ( SOCKET fd )
+{
+#ifdef FDMGR_EPOLL
+    if ( this->epollFD < 0 ) {
+        this->epollFD = epoll_create1 ( EPOLL_CLOEXEC );
+        if ( this->epollFD < 0 ) {
+            return false;
+        }
+        this->pEpollEvents = new epoll_event [ maxEpollEvents ];
+    }
+
+    struct epoll_event ev;
+    memset ( &ev, 0, sizeof ( ev ) );
+    ev.data.fd = fd;
+    if ( this->lookUpFD ( fd, fdrRead ) ) {
+        ev.events |= EPOLLIN;
+    }
+    if ( this->lookUpFD ( fd, fdrWrite ) ) {
+        ev.events |= EPOLLOUT;
+    }
+    if ( this->lookUpFD ( fd, fdrException ) ) {
+        ev.events |= EPOLLPRI;
+    }
+
+    if ( ev.events == 0u ) {
+        // fails harmlessly if the fd has already been closed
+        epoll_ctl ( this->epollFD, EPOLL_CTL_DEL, fd, &ev );
+        return true;
+    }
+    if ( epoll_ctl ( this->epollFD, EPOLL_CTL_MOD, fd, &ev ) == 0 ) {
+        return true;
+    }
+    if ( errno == ENOENT &&
+            epoll_ctl ( this->epollFD, EPOLL_CTL_ADD, fd, &ev ) == 0 ) {
+        return true;
+    }
+    return false;
+#else
+    return true;
+#endif
 }
 
 //
@@ -345,9 +586,9 @@ LIBCOM_API fdReg *fdManager::lookUpFD (const SOCKET fd, const fdRegType type)
 fdReg::fdReg (const SOCKET fdIn, const fdRegType typIn,
         const bool onceOnlyIn, fdManager &managerIn) :
     fdRegId (fdIn,typIn), state (limbo),
-    onceOnly (onceOnlyIn), manager (managerIn)
+    onceOnly (onceOnlyIn), alwaysReady (false), manager (managerIn)
 {
-    if (!FD_IN_FDSET(fdIn)) {
+    if (!managerIn.useEpoll && !FD_IN_FDSET(fdIn)) {
         fprintf (stderr, "%s: fd > FD_SETSIZE ignored\n",
             __FILE__);
         return;
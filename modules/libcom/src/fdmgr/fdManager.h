@@ -28,6 +28,16 @@
 
 enum fdRegType {fdrRead, fdrWrite, fdrException, fdrNEnums};
 
+//
+// How fdManager::process() waits for file descriptor activity.
+// fdmbDefault uses epoll() on Linux, when the kernel provides it,
+// and select() everywhere else. Only epoll() accepts file descriptors
+// numbered FD_SETSIZE or above.
+//
+enum fdManagerBackend {fdmbDefault, fdmbSelect};
+
+struct epoll_event;
+
 //
 // fdRegId
 //
@@ -78,6 +88,7 @@ public:
     class fdInterestSubscriptionAlreadyExits {};
 
     LIBCOM_API fdManager ();
+    LIBCOM_API fdManager ( fdManagerBackend );
     LIBCOM_API virtual ~fdManager ();
     LIBCOM_API void process ( double delay ); // delay parameter is in seconds
 
@@ -86,6 +97,9 @@ public:
 
     epicsTimer & createTimer ();
 
+    // "epoll" or "select"
+    LIBCOM_API const char * backendName () const;
+
 private:
     tsDLList < fdReg > regList;
     tsDLList < fdReg > activeList;
@@ -100,6 +114,19 @@ private:
     // and nill otherwise
     //
     fdReg * pCBReg;
+    //
+    // epoll instance, created with the first registration
+    //
+    int epollFD;
+    bool useEpoll;
+    unsigned nAlwaysReady;
+    struct epoll_event * pEpollEvents;
+    void init ( fdManagerBackend );
+    void processSelect ( double minDelay );
+    void processEpoll ( double minDelay );
+    void activate ( SOCKET fd, fdRegType type );
+    void dispatchActive ();
+    bool epollUpdate ( SOCKET fd );
     void reschedule ();
     double quantum ();
     void installReg (fdReg &reg);
@@ -157,6 +184,7 @@ private:
 
     unsigned char state; // state enums go here
     unsigned char onceOnly;
+    unsigned char alwaysReady; // epoll() cant watch the fd
     fdManager &manager;
 
     fdReg ( const fdReg & );
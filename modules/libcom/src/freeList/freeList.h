@@ -20,6 +20,16 @@ extern "C" {
 #endif
 
 LIBCOM_API void epicsStdCall freeListInitPvt(void **ppvt,int size,int nmalloc);
+/* As freeListInitPvt, but each thread keeps up to ncache free blocks of
+ * its own which it allocates and frees without locking. Blocks move to
+ * and from the shared list ncache/2 at a time, and a thread's blocks
+ * go back when an epicsThread exits. Threads not created by
+ * epicsThreadCreate(), and any started before the first free list was
+ * created, use the shared list. Uses one epicsThreadPrivate key, so
+ * meant for a few long lived lists with heavy traffic.
+ */
+LIBCOM_API void epicsStdCall freeListInitPvtCached(void **ppvt,int size,
+    int nmalloc,int ncache);
 LIBCOM_API void * epicsStdCall freeListCalloc(void *pvt);
 LIBCOM_API void * epicsStdCall freeListMalloc(void *pvt);
 LIBCOM_API void epicsStdCall freeListFree(void *pvt,void*pmem);
@@ -23,7 +23,11 @@
 #endif
 
 #include "cantProceed.h"
+#include "ellLib.h"
+#include "epicsAtomic.h"
+#include "epicsExit.h"
 #include "epicsMutex.h"
+#include "epicsThread.h"
 #include "freeList.h"
 #include "adjustment.h"
 
@@ -36,10 +40,49 @@ typedef struct {
     int         nmalloc;
     void        *head;
     allocMem    *mallochead;
-    size_t      nBlocksAvailable;
+    size_t      nBlocksAvailable;   /* on the shared list */
     epicsMutexId lock;
+    int         ncache;             /* 0 when not cached */
+    epicsThreadPrivateId cacheId;
+    ELLLIST     caches;
 }FREELISTPVT;
 
+/* A thread's cache of free blocks for one list.
+ * Only the owning thread changes count and blocks.
+ */
+typedef struct freeListCache {
+    ELLNODE     node;
+    FREELISTPVT *pfl;               /* NULL after freeListCleanup() */
+    size_t      count;
+    void        *blocks[1];         /* ncache entries */
+}freeListCache;
+
+/* Guards freeListCache.pfl, taken before any list's lock */
+static epicsMutexId cacheLock;
+static epicsThreadOnceId cacheOnce = EPICS_THREAD_ONCE_INIT;
+
+/* Marks a thread whose caches have been released at its exit */
+static char cacheExited;
+
+/* Marks a thread made by epicsThreadCreate(). Other threads never run
+ * their epicsAtThreadExit() routines, so they use the shared list.
+ */
+static epicsThreadPrivateId cacheThreadId;
+static char cacheThread;
+
+static void cacheThreadStart(epicsThreadId id)
+{
+    epicsThreadPrivateSet(cacheThreadId, &cacheThread);
+}
+
+static void cacheInit(void *junk)
+{
+    cacheLock = epicsMutexMustCreate();
+    cacheThreadId = epicsThreadPrivateCreate();
+    if(cacheThreadId)
+        epicsThreadHookAdd(cacheThreadStart);
+}
+
 LIBCOM_API void epicsStdCall 
     freeListInitPvt(void **ppvt,int size,int nmalloc)
 {
@@ -52,11 +95,155 @@ LIBCOM_API void epicsStdCall
     pfl->mallochead = NULL;
     pfl->nBlocksAvailable = 0u;
     pfl->lock = epicsMutexMustCreate();
+    /* Early, as threads started before this never get a cache */
+    epicsThreadOnce(&cacheOnce, cacheInit, NULL);
     *ppvt = (void *)pfl;
     VALGRIND_CREATE_MEMPOOL(pfl, REDZONE, 0);
     return;
 }
 
+LIBCOM_API void epicsStdCall
+    freeListInitPvtCached(void **ppvt,int size,int nmalloc,int ncache)
+{
+    freeListInitPvt(ppvt, size, nmalloc);
+#   ifndef EPICS_FREELIST_DEBUG
+    if(ncache >= 2) {
+        FREELISTPVT *pfl = *ppvt;
+
+        pfl->cacheId = epicsThreadPrivateCreate();
+        if(pfl->cacheId)
+            pfl->ncache = ncache;
+    }
+#   endif
+}
+
+/* Add nmalloc blocks to the shared list, called with lock held */
+static int freeListGrow(FREELISTPVT *pfl)
+{
+    void        *ptemp;
+    void        **ppnext;
+    allocMem    *pallocmem;
+    int         i;
+
+    /* layout of each block. nmalloc+1 REDZONEs for nmallocs.
+     * The first sizeof(void*) bytes are used to store a pointer
+     * to the next free block.
+     *
+     * | RED | size0 ------ | RED | size1 | ... | RED |
+     * |     | next | ----- |
+     */
+    ptemp = (void *)malloc(pfl->nmalloc*(pfl->size+REDZONE)+REDZONE);
+    if(ptemp==0)
+        return 0;
+    pallocmem = (allocMem *)calloc(1,sizeof(allocMem));
+    if(pallocmem==0) {
+        free(ptemp);
+        return 0;
+    }
+    pallocmem->memory = ptemp; /* real allocation */
+    ptemp = REDZONE + (char *) ptemp; /* skip first REDZONE */
+    if(pfl->mallochead)
+        pallocmem->next = pfl->mallochead;
+    pfl->mallochead = pallocmem;
+    for(i=0; i<pfl->nmalloc; i++) {
+        ppnext = ptemp;
+        VALGRIND_MEMPOOL_ALLOC(pfl, ptemp, sizeof(void*));
+        *ppnext = pfl->head;
+        pfl->head = ptemp;
+        ptemp = ((char *)ptemp) + pfl->size+REDZONE;
+    }
+    pfl->nBlocksAvailable += pfl->nmalloc;
+    return 1;
+}
+
+/* Move the n oldest blocks of a cache to the shared list,
+ * called with lock held */
+static void cacheDrain(FREELISTPVT *pfl, freeListCache *pcache, size_t n)
+{
+    size_t      i;
+
+    for(i=0; i<n; i++) {
+        void **ppnext = pcache->blocks[i];
+        *ppnext = pfl->head;
+        pfl->head = ppnext;
+    }
+    pfl->nBlocksAvailable += n;
+    memmove(pcache->blocks, pcache->blocks + n,
+        (pcache->count - n) * sizeof(void *));
+    epicsAtomicSetSizeT(&pcache->count, pcache->count - n);
+}
+
+/* Fill half of an empty cache from the shared list */
+static int cacheRefill(FREELISTPVT *pfl, freeListCache *pcache)
+{
+    size_t      n = 0;
+
+    epicsMutexMustLock(pfl->lock);
+    while(n < (size_t)pfl->ncache/2u) {
+        void **ppnext;
+
+        if(!pfl->head && !freeListGrow(pfl))
+            break;
+        ppnext = pfl->head;
+        pfl->head = *ppnext;
+        pfl->nBlocksAvailable--;
+        pcache->blocks[n++] = ppnext;
+    }
+    epicsAtomicSetSizeT(&pcache->count, n);
+    epicsMutexUnlock(pfl->lock);
+    return n > 0;
+}
+
+/* epicsAtThreadExit() routine, returns the exiting thread's blocks */
+static void cacheRelease(void *arg)
+{
+    freeListCache *pcache = arg;
+    FREELISTPVT *pfl;
+
+    epicsMutexMustLock(cacheLock);
+    pfl = pcache->pfl;
+    if(pfl) {
+        epicsMutexMustLock(pfl->lock);
+        cacheDrain(pfl, pcache, pcache->count);
+        ellDelete(&pfl->caches, &pcache->node);
+        epicsMutexUnlock(pfl->lock);
+        /* in case a later exit routine uses this list */
+        epicsThreadPrivateSet(pfl->cacheId, &cacheExited);
+    }
+    epicsMutexUnlock(cacheLock);
+    free(pcache);
+}
+
+/* The calling thread's cache, or NULL to use the shared list */
+static freeListCache * getCache(FREELISTPVT *pfl)
+{
+    freeListCache *pcache = epicsThreadPrivateGet(pfl->cacheId);
+
+    if(pcache == (void *)&cacheExited)
+        return NULL;
+    if(pcache)
+        return pcache;
+    if(!cacheThreadId || !epicsThreadPrivateGet(cacheThreadId))
+        return NULL;
+
+    pcache = calloc(1, sizeof(freeListCache) +
+        (pfl->ncache - 1) * sizeof(void *));
+    if(!pcache)
+        return NULL;
+    if(epicsAtThreadExit(cacheRelease, pcache)) {
+        free(pcache);
+        return NULL;
+    }
+    pcache->pfl = pfl;
+    epicsMutexMustLock(cacheLock);
+    epicsMutexMustLock(pfl->lock);
+    ellAdd(&pfl->caches, &pcache->node);
+    epicsMutexUnlock(pfl->lock);
+    epicsMutexUnlock(cacheLock);
+    epicsThreadPrivateSet(pfl->cacheId, pcache);
+    return pcache;
+}
+
 LIBCOM_API void * epicsStdCall freeListCalloc(void *pvt)
 {
     FREELISTPVT *pfl = pvt;
@@ -79,45 +266,24 @@ LIBCOM_API void * epicsStdCall freeListMalloc(void *pvt)
 #   else
     void        *ptemp;
     void        **ppnext;
-    allocMem    *pallocmem;
-    int         i;
+    freeListCache *pcache;
 
-    epicsMutexMustLock(pfl->lock);
-    ptemp = pfl->head;
-    if(ptemp==0) {
-        /* layout of each block. nmalloc+1 REDZONEs for nmallocs.
-         * The first sizeof(void*) bytes are used to store a pointer
-         * to the next free block.
-         *
-         * | RED | size0 ------ | RED | size1 | ... | RED |
-         * |     | next | ----- |
-         */
-        ptemp = (void *)malloc(pfl->nmalloc*(pfl->size+REDZONE)+REDZONE);
-        if(ptemp==0) {
-            epicsMutexUnlock(pfl->lock);
-            return(0);
-        }
-        pallocmem = (allocMem *)calloc(1,sizeof(allocMem));
-        if(pallocmem==0) {
-            epicsMutexUnlock(pfl->lock);
-            free(ptemp);
+    if(pfl->ncache && (pcache = getCache(pfl))) {
+        if(pcache->count == 0 && !cacheRefill(pfl, pcache))
             return(0);
-        }
-        pallocmem->memory = ptemp; /* real allocation */
-        ptemp = REDZONE + (char *) ptemp; /* skip first REDZONE */
-        if(pfl->mallochead)
-            pallocmem->next = pfl->mallochead;
-        pfl->mallochead = pallocmem;
-        for(i=0; i<pfl->nmalloc; i++) {
-            ppnext = ptemp;
-            VALGRIND_MEMPOOL_ALLOC(pfl, ptemp, sizeof(void*));
-            *ppnext = pfl->head;
-            pfl->head = ptemp;
-            ptemp = ((char *)ptemp) + pfl->size+REDZONE;
-        }
-        ptemp = pfl->head;
-        pfl->nBlocksAvailable += pfl->nmalloc;
+        ptemp = pcache->blocks[pcache->count - 1];
+        epicsAtomicSetSizeT(&pcache->count, pcache->count - 1);
+        VALGRIND_MEMPOOL_FREE(pfl, ptemp);
+        VALGRIND_MEMPOOL_ALLOC(pfl, ptemp, pfl->size);
+        return(ptemp);
+    }
+
+    epicsMutexMustLock(pfl->lock);
+    if(pfl->head==0 && !freeListGrow(pfl)) {
+        epicsMutexUnlock(pfl->lock);
+        return(0);
     }
+    ptemp = pfl->head;
     ppnext = pfl->head;
     pfl->head = *ppnext;
     pfl->nBlocksAvailable--;
@@ -136,10 +302,22 @@ LIBCOM_API void epicsStdCall freeListFree(void *pvt,void*pmem)
     free(pmem);
 #   else
     void        **ppnext;
+    freeListCache *pcache;
 
     VALGRIND_MEMPOOL_FREE(pvt, pmem);
     VALGRIND_MEMPOOL_ALLOC(pvt, pmem, sizeof(void*));
 
+    if(pfl->ncache && (pcache = getCache(pfl))) {
+        if(pcache->count == (size_t)pfl->ncache) {
+            epicsMutexMustLock(pfl->lock);
+            cacheDrain(pfl, pcache, pfl->ncache/2);
+            epicsMutexUnlock(pfl->lock);
+        }
+        pcache->blocks[pcache->count] = pmem;
+        epicsAtomicSetSizeT(&pcache->count, pcache->count + 1);
+        return;
+    }
+
     epicsMutexMustLock(pfl->lock);
     ppnext = pmem;
     *ppnext = pfl->head;
@@ -157,6 +335,17 @@ LIBCOM_API void epicsStdCall freeListCleanup(void *pvt)
 
     VALGRIND_DESTROY_MEMPOOL(pvt);
 
+    if(pfl->ncache) {
+        freeListCache *pcache;
+
+        /* Caches are freed when their threads exit */
+        epicsMutexMustLock(cacheLock);
+        while((pcache = (freeListCache *)ellGet(&pfl->caches)))
+            pcache->pfl = NULL;
+        epicsMutexUnlock(cacheLock);
+        epicsThreadPrivateDelete(pfl->cacheId);
+    }
+
     phead = pfl->mallochead;
     while(phead) {
         pnext = phead->next;
@@ -172,8 +361,12 @@ LIBCOM_API size_t epicsStdCall freeListItemsAvail(void *pvt)
 {
     FREELISTPVT *pfl = pvt;
     size_t nBlocksAvailable;
+    ELLNODE *pnode;
     epicsMutexMustLock(pfl->lock);
     nBlocksAvailable = pfl->nBlocksAvailable;
+    for(pnode = ellFirst(&pfl->caches); pnode; pnode = ellNext(pnode))
+        nBlocksAvailable += epicsAtomicGetSizeT(
+            &((freeListCache *)pnode)->count);
     epicsMutexUnlock(pfl->lock);
     return nBlocksAvailable;
 }
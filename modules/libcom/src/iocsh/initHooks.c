@@ -21,9 +21,15 @@
 #include "ellLib.h"
 #include "epicsMutex.h"
 #include "epicsThread.h"
+#include "epicsTime.h"
+#include "epicsExport.h"
 
 #include "initHooks.h"
 
+/* Print the time taken between announced states */
+int initHookTiming = 0;
+epicsExportAddress(int, initHookTiming);
+
 typedef struct initHookLink {
     ELLNODE          node;
     initHookFunction func;
@@ -32,6 +38,9 @@ typedef struct initHookLink {
 static ELLLIST functionList = ELLLIST_INIT;
 static epicsMutexId listLock;
 
+static epicsUInt64 lastAnnounceTime;
+static int lastAnnounceState = -1;
+
 /*
  * Lazy initialization functions
  */
@@ -80,6 +89,17 @@ void initHookAnnounce(initHookState state)
 
     initHookInit();
 
+    if (initHookTiming) {
+        epicsUInt64 now = epicsMonotonicGet();
+
+        if (lastAnnounceState >= 0 && state != initHookAtIocBuild)
+            printf("%s: %.3f sec after %s\n", initHookName(state),
+                (now - lastAnnounceTime) * 1e-9,
+                initHookName(lastAnnounceState));
+        lastAnnounceTime = now;
+        lastAnnounceState = state;
+    }
+
     epicsMutexMustLock(listLock);
     hook = (initHookLink *)ellFirst(&functionList);
     epicsMutexUnlock(listLock);
@@ -128,6 +148,13 @@ const char *initHookName(int state)
         "initHookAfterCaServerPaused",
         "initHookAfterDatabasePaused",
         "initHookAfterIocPaused",
+        "initHookAtShutdown",
+        "initHookAfterCloseLinks",
+        "initHookAfterStopScan",
+        "initHookAfterStopCallback",
+        "initHookAfterStopLinks",
+        "initHookBeforeFree",
+        "initHookAfterShutdown",
         "initHookAfterInterruptAccept",
         "initHookAtEnd"
     };
@@ -22,6 +22,7 @@
 #include <stdio.h>
 
 #include "epicsSpin.h"
+#include "epicsAtomic.h"
 #include "dbDefs.h"
 #include "epicsRingBytes.h"
 
@@ -33,15 +34,49 @@
  */
 #define SLOP    16
 
+#define CACHELINE 64
+
+/* The put and get indices are in separate cache lines, so that a
+ * producer and a consumer on different CPUs don't share one.
+ */
 typedef struct ringPvt {
     epicsSpinId    lock;
-    volatile int   nextPut;
-    volatile int   nextGet;
     int            size;
+    char           padRead[CACHELINE];
+    /* written by the producer */
+    volatile int   nextPut;
     int            highWaterMark;
+    char           padPut[CACHELINE - 2 * sizeof(int)];
+    /* written by the consumer */
+    volatile int   nextGet;
+    char           padGet[CACHELINE - sizeof(int)];
     volatile char buffer[1]; /* actually larger */
 }ringPvt;
 
+/* Read the other side's index with acquire ordering, so the data it
+ * covers is seen. Publish our own with release ordering, after the data.
+ */
+static int loadAcquire(const volatile int *p)
+{
+#if defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+    int value = *p;
+    epicsAtomicReadMemoryBarrier();
+    return value;
+#endif
+}
+
+static void storeRelease(volatile int *p, int value)
+{
+#if defined(__ATOMIC_RELEASE)
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#else
+    epicsAtomicWriteMemoryBarrier();
+    *p = value;
+#endif
+}
+
 LIBCOM_API epicsRingBytesId  epicsStdCall epicsRingBytesCreate(int size)
 {
     ringPvt *pring = malloc(sizeof(ringPvt) + size + SLOP);
@@ -80,7 +115,7 @@ LIBCOM_API int epicsStdCall epicsRingBytesGet(
 
     if (pring->lock) epicsSpinLock(pring->lock);
     nextGet = pring->nextGet;
-    nextPut = pring->nextPut;
+    nextPut = loadAcquire(&pring->nextPut);
     size = pring->size;
 
     if (nextGet <= nextPut) {
@@ -109,7 +144,7 @@ LIBCOM_API int epicsStdCall epicsRingBytesGet(
             nbytes = count;
         }
     }
-    pring->nextGet = nextGet;
+    storeRelease(&pring->nextGet, nextGet);
 
     if (pring->lock) epicsSpinUnlock(pring->lock);
     return nbytes;
@@ -123,7 +158,7 @@ LIBCOM_API int epicsStdCall epicsRingBytesPut(
     int freeCount, copyCount, topCount, used;
 
     if (pring->lock) epicsSpinLock(pring->lock);
-    nextGet = pring->nextGet;
+    nextGet = loadAcquire(&pring->nextGet);
     nextPut = pring->nextPut;
     size = pring->size;
 
@@ -157,7 +192,7 @@ LIBCOM_API int epicsStdCall epicsRingBytesPut(
             nextPut = nLeft;
         }
     }
-    pring->nextPut = nextPut;
+    storeRelease(&pring->nextPut, nextPut);
 
     used = nextPut - nextGet;
     if (used < 0) used += pring->size;
@@ -244,7 +279,7 @@ LIBCOM_API void epicsStdCall epicsRingBytesResetHighWaterMark(epicsRingBytesId i
     ringPvt *pring = (ringPvt *)id;
     int used;
     if (pring->lock) epicsSpinLock(pring->lock);
-    used = pring->nextGet - pring->nextPut;
+    used = pring->nextPut - pring->nextGet;
     if (used < 0) used += pring->size;
     pring->highWaterMark = used;
     if (pring->lock) epicsSpinUnlock(pring->lock);
@@ -18,11 +18,17 @@
  * (first in first out circular buffers) that store bytes. The unlocked
  * variant is designed so that one writer thread and one reader thread
  * can access the ring simultaneously without requiring mutual exclusion.
+ * The writer publishes its index with release ordering and the reader
+ * reads it with acquire ordering, and the reverse, so this is safe on
+ * weakly ordered CPUs too. The two indices live in separate cache lines.
  * The locked variant uses an epicsSpinLock, and works with any numbers of
  * writer and reader threads.
  * \note If there is only one writer it is not necessary to lock for puts.
  * If there is a single reader it is not necessary to lock for gets.
  * epicsRingBytesLocked uses a spinlock.
+ * \note A ring holding fixed size entries can move many of them with one
+ * call by putting or getting a multiple of the entry size. A put stores
+ * all of the entries or none, a get takes as many as are there.
  */
 
 #ifndef INCepicsRingBytesh
@@ -55,6 +55,20 @@ LIBCOM_API int epicsStdCall epicsRingPointerPush(epicsRingPointerId id, void *p)
     return((pvoidPointer->push(p) ? 1 : 0));
 }
 
+LIBCOM_API int epicsStdCall epicsRingPointerPushN(epicsRingPointerId id,
+    void * const *p, int n)
+{
+    voidPointer *pvoidPointer = reinterpret_cast<voidPointer*>(id);
+    return pvoidPointer->pushN(p, n);
+}
+
+LIBCOM_API int epicsStdCall epicsRingPointerPopN(epicsRingPointerId id,
+    void **p, int n)
+{
+    voidPointer *pvoidPointer = reinterpret_cast<voidPointer*>(id);
+    return pvoidPointer->popN(p, n);
+}
+
 LIBCOM_API void epicsStdCall epicsRingPointerFlush(epicsRingPointerId id)
 {
     voidPointer *pvoidPointer = reinterpret_cast<voidPointer*>(id);
@@ -17,12 +17,17 @@
  * epicsRingPointer.h provides both C and C++ APIs for creating and using ring
  * buffers (first in first out circular buffers) that store pointers. The
  * unlocked kind is designed so that one writer thread and one reader thread
- * can access the ring simultaneously without requiring mutual exclusion. The
- * locked variant uses an epicsSpinLock, and works with any numbers of writer
- * and reader threads.
+ * can access the ring simultaneously without requiring mutual exclusion.
+ * The writer publishes its index with release ordering and the reader
+ * reads it with acquire ordering, and the reverse, so this is safe on
+ * weakly ordered CPUs too. The two indices live in separate cache lines.
+ * The locked variant uses an epicsSpinLock, and works with any numbers of
+ * writer and reader threads.
  * \note If there is only one writer it is not necessary to lock pushes.
  * If there is a single reader it is not necessary to lock pops.
  * epicsRingPointerLocked uses a spinlock.
+ * \note pushN() and popN() move many elements for the cost of one
+ * push() or pop(), taking the lock just once.
  */
 
 #ifndef INCepicsRingPointerh
@@ -30,6 +35,7 @@
 
 
 #include "epicsSpin.h"
+#include "epicsAtomic.h"
 #include "libComAPI.h"
 
 #ifdef __cplusplus
@@ -57,6 +63,18 @@ public: /* Functions */
      * \return The element, or NULL if the ring was empty
      */
     T* pop();
+    /**\brief Push up to n entries on the ring
+     * \param p The entries to push, in order
+     * \param n How many to push
+     * \return The number pushed, less than n if the ring filled up
+     */
+    int pushN(T * const *p, int n);
+    /**\brief Take up to n elements off the ring
+     * \param p Where to store the elements, in order
+     * \param n Maximum number to take
+     * \return The number taken, 0 if the ring was empty
+     */
+    int popN(T **p, int n);
     /**\brief Remove all elements from the ring.
      * \note If this operation is performed on a ring buffer of the
      * unsecured kind, all access to the ring should be locked.
@@ -102,14 +120,22 @@ private: /* Prevent compiler-generated member functions */
     epicsRingPointer(const epicsRingPointer &);
     epicsRingPointer& operator=(const epicsRingPointer &);
     int getUsedNoLock() const;
+    static int loadAcquire(const volatile int *p);
+    static void storeRelease(volatile int *p, int value);
 
 private: /* Data */
+    enum { cacheLine = 64 };
     epicsSpinId lock;
-    volatile int nextPush;
-    volatile int nextPop;
     int size;
-    int highWaterMark;
     T  * volatile * buffer;
+    char padRead[cacheLine];
+    /* written by the producer */
+    volatile int nextPush;
+    int highWaterMark;
+    char padPush[cacheLine - 2 * sizeof(int)];
+    /* written by the consumer */
+    volatile int nextPop;
+    char padPop[cacheLine - sizeof(int)];
 };
 
 extern "C" {
@@ -148,6 +174,24 @@ LIBCOM_API int  epicsStdCall epicsRingPointerPush(epicsRingPointerId id,void *p)
  * \return The pointer from the buffer, or NULL if the ring was empty
  */
 LIBCOM_API void* epicsStdCall epicsRingPointerPop(epicsRingPointerId id) ;
+/**
+ * \brief Push up to n pointers into the ring buffer
+ * \param id Ring buffer identifier
+ * \param p The pointers to be pushed, in order
+ * \param n How many to push
+ * \return The number pushed, less than n if the buffer filled up
+ */
+LIBCOM_API int  epicsStdCall epicsRingPointerPushN(epicsRingPointerId id,
+    void * const *p, int n);
+/**
+ * \brief Take up to n elements off the ring
+ * \param id Ring buffer identifier
+ * \param p Where to store the pointers, in order
+ * \param n Maximum number to take
+ * \return The number taken, 0 if the ring was empty
+ */
+LIBCOM_API int  epicsStdCall epicsRingPointerPopN(epicsRingPointerId id,
+    void **p, int n);
 /**
  * \brief Remove all elements from the ring
  * \param id Ring buffer identifier
@@ -218,13 +262,40 @@ LIBCOM_API void epicsStdCall epicsRingPointerResetHighWaterMark(epicsRingPointer
 
 template <class T>
 inline epicsRingPointer<T>::epicsRingPointer(int sz, bool locked) :
-    lock(0), nextPush(0), nextPop(0), size(sz+1), highWaterMark(0),
-    buffer(new T* [sz+1])
+    lock(0), size(sz+1), buffer(new T* [sz+1]),
+    nextPush(0), highWaterMark(0), nextPop(0)
 {
     if (locked)
         lock = epicsSpinCreate();
 }
 
+/* The index owned by the other side is read with acquire ordering, so
+ * the entries it covers are seen. Our own index is published with
+ * release ordering, after the entries.
+ */
+template <class T>
+inline int epicsRingPointer<T>::loadAcquire(const volatile int *p)
+{
+#if defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+    int value = *p;
+    epicsAtomicReadMemoryBarrier();
+    return value;
+#endif
+}
+
+template <class T>
+inline void epicsRingPointer<T>::storeRelease(volatile int *p, int value)
+{
+#if defined(__ATOMIC_RELEASE)
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#else
+    epicsAtomicWriteMemoryBarrier();
+    *p = value;
+#endif
+}
+
 template <class T>
 inline epicsRingPointer<T>::~epicsRingPointer()
 {
@@ -239,12 +310,12 @@ inline bool epicsRingPointer<T>::push(T *p)
     int next = nextPush;
     int newNext = next + 1;
     if(newNext>=size) newNext=0;
-    if (newNext == nextPop) {
+    if (newNext == loadAcquire(&nextPop)) {
         if (lock) epicsSpinUnlock(lock);
         return(false);
     }
     buffer[next] = p;
-    nextPush = newNext;
+    storeRelease(&nextPush, newNext);
     int used = getUsedNoLock();
     if (used > highWaterMark) highWaterMark = used;
     if (lock) epicsSpinUnlock(lock);
@@ -256,18 +327,54 @@ inline T* epicsRingPointer<T>::pop()
 {
     if (lock) epicsSpinLock(lock);
     int next = nextPop;
-    if (next == nextPush) {
+    if (next == loadAcquire(&nextPush)) {
         if (lock) epicsSpinUnlock(lock);
         return(0);
     }
     T*p  = buffer[next];
     ++next;
     if(next >=size) next = 0;
-    nextPop = next;
+    storeRelease(&nextPop, next);
     if (lock) epicsSpinUnlock(lock);
     return(p);
 }
 
+template <class T>
+inline int epicsRingPointer<T>::pushN(T * const *p, int n)
+{
+    if (lock) epicsSpinLock(lock);
+    int next = nextPush;
+    int nFree = loadAcquire(&nextPop) - next - 1;
+    if (nFree < 0) nFree += size;
+    if (n > nFree) n = nFree;
+    for (int i = 0; i < n; i++) {
+        buffer[next] = p[i];
+        if (++next >= size) next = 0;
+    }
+    storeRelease(&nextPush, next);
+    int used = getUsedNoLock();
+    if (used > highWaterMark) highWaterMark = used;
+    if (lock) epicsSpinUnlock(lock);
+    return n;
+}
+
+template <class T>
+inline int epicsRingPointer<T>::popN(T **p, int n)
+{
+    if (lock) epicsSpinLock(lock);
+    int next = nextPop;
+    int nUsed = loadAcquire(&nextPush) - next;
+    if (nUsed < 0) nUsed += size;
+    if (n > nUsed) n = nUsed;
+    for (int i = 0; i < n; i++) {
+        p[i] = buffer[next];
+        if (++next >= size) next = 0;
+    }
+    storeRelease(&nextPop, next);
+    if (lock) epicsSpinUnlock(lock);
+    return n;
+}
+
 template <class T>
 inline void epicsRingPointer<T>::flush()
 {
@@ -64,8 +64,9 @@ epicsTimerNotify::expireStatus epicsTimerForC::expire ( const epicsTime & )
 
 epicsTimerQueueActiveForC ::
     epicsTimerQueueActiveForC ( RefMgr & refMgr,
-        bool okToShare, unsigned priority ) :
-    timerQueueActive ( refMgr, okToShare, priority )
+        bool okToShare, unsigned priority,
+        epicsTimerQueueBackend backend ) :
+    timerQueueActive ( refMgr, okToShare, priority, backend )
 {
     timerQueueActive::start();
 }
@@ -218,6 +219,23 @@ extern "C" epicsTimerQueueId epicsStdCall
     }
 }
 
+extern "C" epicsTimerQueueId epicsStdCall
+    epicsTimerQueueAllocateBackend ( int okToShare,
+        unsigned int threadPriority, epicsTimerQueueBackend backend )
+{
+    try {
+        epicsSingleton < timerQueueActiveMgr > :: reference ref =
+            timerQueueMgrEPICS.getReference ();
+        epicsTimerQueueActiveForC & tmr =
+            ref->allocate ( ref, okToShare ? true : false,
+                threadPriority, backend );
+        return &tmr;
+    }
+    catch ( ... ) {
+        return 0;
+    }
+}
+
 extern "C" void epicsStdCall epicsTimerQueueRelease ( epicsTimerQueueId pQueue )
 {
     pQueue->release ();
@@ -20,6 +20,18 @@
 #include "epicsTime.h"
 #include "epicsThread.h"
 
+/* How a timer queue keeps its pending timers.
+ * A sorted list expires timers exactly in order, but starting a timer
+ * takes time proportional to the number pending.
+ * A timing wheel starts and cancels timers in constant time, but may
+ * expire a timer up to 1 ms late, and timers due in the same
+ * millisecond in any order.
+ */
+typedef enum {
+    epicsTimerQueueSortedList,
+    epicsTimerQueueTimingWheel
+} epicsTimerQueueBackend;
+
 #ifdef __cplusplus
 
 /*
@@ -83,6 +95,8 @@ class epicsTimerQueueActive
 public:
     static LIBCOM_API epicsTimerQueueActive & allocate (
         bool okToShare, unsigned threadPriority = epicsThreadPriorityMin + 10 );
+    static LIBCOM_API epicsTimerQueueActive & allocate (
+        bool okToShare, unsigned threadPriority, epicsTimerQueueBackend );
     virtual void release () = 0;
 protected:
     LIBCOM_API virtual ~epicsTimerQueueActive () = 0;
@@ -104,6 +118,8 @@ class epicsTimerQueuePassive
     : public epicsTimerQueue {
 public:
     static LIBCOM_API epicsTimerQueuePassive & create ( epicsTimerQueueNotify & );
+    static LIBCOM_API epicsTimerQueuePassive & create ( epicsTimerQueueNotify &,
+        epicsTimerQueueBackend );
     LIBCOM_API virtual ~epicsTimerQueuePassive () = 0; /* ok to call delete */
     virtual double process ( const epicsTime & currentTime ) = 0; /* returns delay to next expire */
 };
@@ -137,6 +153,9 @@ typedef void ( *epicsTimerCallback ) ( void *pPrivate );
 typedef struct epicsTimerQueueActiveForC * epicsTimerQueueId;
 LIBCOM_API epicsTimerQueueId epicsStdCall
     epicsTimerQueueAllocate ( int okToShare, unsigned int threadPriority );
+LIBCOM_API epicsTimerQueueId epicsStdCall
+    epicsTimerQueueAllocateBackend ( int okToShare,
+        unsigned int threadPriority, epicsTimerQueueBackend backend );
 LIBCOM_API void epicsStdCall 
     epicsTimerQueueRelease ( epicsTimerQueueId );
 LIBCOM_API epicsTimerId epicsStdCall 
@@ -22,6 +22,7 @@
 #include "epicsSingleton.h"
 #include "tsDLList.h"
 #include "epicsTimer.h"
+#include "epicsTypes.h"
 #include "compilerDependencies.h"
 
 #ifdef DEBUG
@@ -51,6 +52,8 @@ private:
     epicsTime exp; // experation time
     state curState; // current state
     epicsTimerNotify * pNotify; // callback
+    tsDLList < timer > * pSlot; // timing wheel slot while pending
+    unsigned slotLevel; // timing wheel level of that slot
     void privateStart ( epicsTimerNotify & notify, const epicsTime & );
     timer & operator = ( const timer & );
     // Visual C++ .net appears to require operator delete if
@@ -60,6 +63,7 @@ private:
     // no undefined symbols.
     void operator delete ( void * );
     friend class timerQueue;
+    friend class timerWheel;
 };
 
 struct epicsTimerForC : public epicsTimerNotify, public timer {
@@ -86,20 +90,62 @@ private:
 
 using std :: type_info;
 
+//
+// Pending timers hashed by expire time into the slots of a hierarchical
+// timing wheel. The root level has a slot for each millisecond tick of
+// the next 256. Each higher level has 64 slots, each as long as all of
+// the level below, and a slot is moved down a level when its time comes.
+// Timers more than 2^32 ticks ahead wait on an overflow list.
+//
+class timerWheel {
+public:
+    timerWheel ();
+    bool insert ( timer & ); // true if now the first to expire
+    void remove ( timer & );
+    timer * expired ( const epicsTime & currentTime );
+    double delay ( const epicsTime & currentTime );
+    timer * get ();
+    unsigned count () const;
+private:
+    enum { rootBits = 8u, levelBits = 6u, nLevels = 4u };
+    enum { rootSlots = 1u << rootBits, levelSlots = 1u << levelBits };
+    static const double tickPeriod;
+    static const epicsUInt64 never;
+    epicsTime base;
+    epicsUInt64 curTick; // all ticks before this have expired
+    epicsUInt64 wakeTick; // tick reported to the queue's owner
+    unsigned nPending;
+    unsigned levelCount [ nLevels + 2u ]; // root, levels, overflow
+    tsDLList < timer > root [ rootSlots ];
+    tsDLList < timer > levels [ nLevels ] [ levelSlots ];
+    tsDLList < timer > overflow;
+    epicsUInt64 tickOf ( const epicsTime & ) const;
+    void rebase ( const epicsTime & currentTime );
+    void place ( timer & );
+    void cascade ( tsDLList < timer > & );
+    void advance ();
+    epicsUInt64 firstTick () const;
+    timerWheel ( const timerWheel & );
+    timerWheel & operator = ( const timerWheel & );
+};
+
 class timerQueue : public epicsTimerQueue {
 public:
-    timerQueue ( epicsTimerQueueNotify &notify );
+    timerQueue ( epicsTimerQueueNotify &notify,
+        epicsTimerQueueBackend = epicsTimerQueueSortedList );
     virtual ~timerQueue ();
     epicsTimer & createTimer ();
     epicsTimerForC & createTimerForC ( epicsTimerCallback pCallback, void *pArg );
     double process ( const epicsTime & currentTime );
     void show ( unsigned int level ) const;
+    epicsTimerQueueBackend backend () const;
 private:
     tsFreeList < timer, 0x20 > timerFreeList;
     tsFreeList < epicsTimerForC, 0x20 > timerForCFreeList;
     mutable epicsMutex mutex;
     epicsEvent cancelBlockingEvent;
     tsDLList < timer > timerList;
+    timerWheel * pWheel; // zero when timerList is used
     epicsTimerQueueNotify & notify;
     timer * pExpireTmr;
     epicsThreadId processThread;
@@ -108,6 +154,11 @@ private:
     static const double exceptMsgMinPeriod;
     void printExceptMsg ( const char * pName,
                 const type_info & type );
+    bool insert ( timer & );
+    void remove ( timer & );
+    timer * nextExpired ( const epicsTime & currentTime );
+    double delayToFirst ( const epicsTime & currentTime );
+    unsigned pendingCount () const;
     timerQueue ( const timerQueue & );
     timerQueue & operator = ( const timerQueue & );
     friend class timer;
@@ -131,13 +182,15 @@ class timerQueueActive : public epicsTimerQueueActive,
     public timerQueueActiveMgrPrivate {
 public:
     typedef epicsSingleton < timerQueueActiveMgr > :: reference RefMgr;
-    timerQueueActive ( RefMgr &, bool okToShare, unsigned priority );
+    timerQueueActive ( RefMgr &, bool okToShare, unsigned priority,
+        epicsTimerQueueBackend = epicsTimerQueueSortedList );
     void start ();
     epicsTimer & createTimer ();
     epicsTimerForC & createTimerForC ( epicsTimerCallback pCallback, void *pArg );
     void show ( unsigned int level ) const;
     bool sharingOK () const;
     unsigned threadPriority () const;
+    epicsTimerQueueBackend backend () const;
 protected:
     ~timerQueueActive ();
     RefMgr _refMgr;
@@ -167,7 +220,8 @@ public:
     timerQueueActiveMgr ();
     ~timerQueueActiveMgr ();
     epicsTimerQueueActiveForC & allocate ( RefThis &, bool okToShare,
-        unsigned threadPriority = epicsThreadPriorityMin + 10 );
+        unsigned threadPriority = epicsThreadPriorityMin + 10,
+        epicsTimerQueueBackend = epicsTimerQueueSortedList );
     void release ( epicsTimerQueueActiveForC & );
 private:
     epicsMutex mutex;
@@ -180,7 +234,8 @@ extern epicsSingleton < timerQueueActiveMgr > timerQueueMgrEPICS;
 
 class timerQueuePassive : public epicsTimerQueuePassive {
 public:
-    timerQueuePassive ( epicsTimerQueueNotify & );
+    timerQueuePassive ( epicsTimerQueueNotify &,
+        epicsTimerQueueBackend = epicsTimerQueueSortedList );
     epicsTimer & createTimer ();
     epicsTimerForC & createTimerForC ( epicsTimerCallback pCallback, void *pArg );
     void show ( unsigned int level ) const;
@@ -215,7 +270,8 @@ private:
 struct epicsTimerQueueActiveForC : public timerQueueActive,
     public tsDLNode < epicsTimerQueueActiveForC > {
 public:
-    epicsTimerQueueActiveForC ( RefMgr &, bool okToShare, unsigned priority );
+    epicsTimerQueueActiveForC ( RefMgr &, bool okToShare, unsigned priority,
+        epicsTimerQueueBackend = epicsTimerQueueSortedList );
     void release ();
     void * operator new ( size_t );
     void operator delete ( void * );
@@ -236,6 +292,22 @@ inline unsigned timerQueueActive::threadPriority () const
     return thread.getPriority ();
 }
 
+inline epicsTimerQueueBackend timerQueueActive::backend () const
+{
+    return this->queue.backend ();
+}
+
+inline epicsTimerQueueBackend timerQueue::backend () const
+{
+    return this->pWheel ?
+        epicsTimerQueueTimingWheel : epicsTimerQueueSortedList;
+}
+
+inline unsigned timerWheel::count () const
+{
+    return this->nPending;
+}
+
 inline void * timer::operator new ( size_t size,
                      tsFreeList < timer, 0x20 > & freeList )
 {
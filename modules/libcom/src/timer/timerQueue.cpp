@@ -24,8 +24,10 @@ const double timerQueue :: exceptMsgMinPeriod = 60.0 * 5.0; // seconds
 
 epicsTimerQueue::~epicsTimerQueue () {}
 
-timerQueue::timerQueue ( epicsTimerQueueNotify & notifyIn ) :
+timerQueue::timerQueue ( epicsTimerQueueNotify & notifyIn,
+        epicsTimerQueueBackend backendIn ) :
     mutex(__FILE__, __LINE__),
+    pWheel ( 0 ),
     notify ( notifyIn ),
     pExpireTmr ( 0 ),
     processThread ( 0 ),
@@ -33,6 +35,9 @@ timerQueue::timerQueue ( epicsTimerQueueNotify & notifyIn ) :
         epicsTime :: getCurrent () - exceptMsgMinPeriod ),
     cancelPending ( false )
 {
+    if ( backendIn == epicsTimerQueueTimingWheel ) {
+        this->pWheel = new timerWheel;
+    }
 }
 
 timerQueue::~timerQueue ()
@@ -41,6 +46,88 @@ timerQueue::~timerQueue ()
     while ( ( pTmr = this->timerList.get () ) ) {
         pTmr->curState = timer::stateLimbo;
     }
+    if ( this->pWheel ) {
+        while ( ( pTmr = this->pWheel->get () ) ) {
+            pTmr->curState = timer::stateLimbo;
+        }
+        delete this->pWheel;
+    }
+}
+
+//
+// Add a timer to the pending timers, returning true if it will now
+// be the first to expire.
+//
+bool timerQueue::insert ( timer & tmr )
+{
+    if ( this->pWheel ) {
+        return this->pWheel->insert ( tmr );
+    }
+
+    //
+    // Finds proper time sorted location using a linear search.
+    //
+    tsDLIter < timer > pTmr = this->timerList.lastIter ();
+    while ( pTmr.valid () ) {
+        if ( pTmr->exp <= tmr.exp ) {
+            //
+            // add after the item found that expires earlier
+            //
+            this->timerList.insertAfter ( tmr, *pTmr );
+            return false;
+        }
+        --pTmr;
+    }
+    this->timerList.push ( tmr );
+    return true;
+}
+
+void timerQueue::remove ( timer & tmr )
+{
+    if ( this->pWheel ) {
+        this->pWheel->remove ( tmr );
+    }
+    else {
+        this->timerList.remove ( tmr );
+    }
+}
+
+// Remove and return a timer which has expired, if there is one
+timer * timerQueue::nextExpired ( const epicsTime & currentTime )
+{
+    if ( this->pWheel ) {
+        return this->pWheel->expired ( currentTime );
+    }
+    timer * pTmr = this->timerList.first ();
+    if ( pTmr && currentTime >= pTmr->exp ) {
+        this->timerList.remove ( *pTmr );
+        return pTmr;
+    }
+    return 0;
+}
+
+double timerQueue::delayToFirst ( const epicsTime & currentTime )
+{
+    if ( this->pWheel ) {
+        return this->pWheel->delay ( currentTime );
+    }
+    timer * pTmr = this->timerList.first ();
+    if ( pTmr ) {
+        double delay = pTmr->exp - currentTime;
+        if ( delay < 0.0 ) {
+            delay = 0.0;
+        }
+        return delay;
+    }
+    return DBL_MAX;
+}
+
+unsigned timerQueue::pendingCount () const
+{
+    if ( this->pWheel ) {
+        return this->pWheel->count ();
+    }
+    return this->timerList.count ();
 }
 
 void timerQueue ::
@@ -83,41 +170,25 @@ double timerQueue::process ( const epicsTime & currentTime )
     if ( this->pExpireTmr ) {
         // if some other thread is processing the queue
         // (or if this is a recursive call)
-        timer * pTmr = this->timerList.first ();
-        if ( pTmr ) {
-            double delay = pTmr->exp - currentTime;
-            if ( delay < 0.0 ) {
-                delay = 0.0;
-            }
-            return delay;
-        }
-        else {
-            return DBL_MAX;
-        }
+        return this->delayToFirst ( currentTime );
     }
 
     //
     // Tag current epired tmr so that we can detect if call back
     // is in progress when canceling the timer.
     //
-    if ( this->timerList.first () ) {
-        if ( currentTime >= this->timerList.first ()->exp ) {
-            this->pExpireTmr = this->timerList.first ();
-            this->timerList.remove ( *this->pExpireTmr );
-            this->pExpireTmr->curState = timer::stateActive;
-            this->processThread = epicsThreadGetIdSelf ();
-#           ifdef DEBUG
-                this->pExpireTmr->show ( 0u );
-#           endif
-        }
-        else {
-            double delay = this->timerList.first ()->exp - currentTime;
-            debugPrintf ( ( "no activity process %f to next\n", delay ) );
-            return delay;
-        }
+    this->pExpireTmr = this->nextExpired ( currentTime );
+    if ( this->pExpireTmr ) {
+        this->pExpireTmr->curState = timer::stateActive;
+        this->processThread = epicsThreadGetIdSelf ();
+#       ifdef DEBUG
+            this->pExpireTmr->show ( 0u );
+#       endif
     }
     else {
-        return DBL_MAX;
+        double delay = this->delayToFirst ( currentTime );
+        debugPrintf ( ( "no activity process %f to next\n", delay ) );
+        return delay;
     }
 
 #   ifdef DEBUG
@@ -176,26 +247,16 @@ double timerQueue::process ( const epicsTime & currentTime )
                     *pTmpNotify, currentTime + expStat.expirationDelay() );
             }
         }
-        this->pExpireTmr = 0;
-
-        if ( this->timerList.first () ) {
-            if ( currentTime >= this->timerList.first ()->exp ) {
-                this->pExpireTmr = this->timerList.first ();
-                this->timerList.remove ( *this->pExpireTmr );
-                this->pExpireTmr->curState = timer::stateActive;
-#               ifdef DEBUG
-                    this->pExpireTmr->show ( 0u );
-#               endif
-            }
-            else {
-                delay = this->timerList.first ()->exp - currentTime;
-                this->processThread = 0;
-                break;
-            }
+        this->pExpireTmr = this->nextExpired ( currentTime );
+        if ( this->pExpireTmr ) {
+            this->pExpireTmr->curState = timer::stateActive;
+#           ifdef DEBUG
+                this->pExpireTmr->show ( 0u );
+#           endif
         }
         else {
+            delay = this->delayToFirst ( currentTime );
             this->processThread = 0;
-            delay = DBL_MAX;
             break;
         }
     }
@@ -215,8 +276,9 @@ epicsTimerForC & timerQueue::createTimerForC ( epicsTimerCallback pCallback, voi
 void timerQueue::show ( unsigned level ) const
 {
     epicsGuard < epicsMutex > locker ( this->mutex );
-    printf ( "epicsTimerQueue with %u items pending\n", this->timerList.count () );
-    if ( level >= 1u ) {
+    printf ( "epicsTimerQueue with %u items pending%s\n", this->pendingCount (),
+        this->pWheel ? " on a timing wheel" : "" );
+    if ( level >= 1u && ! this->pWheel ) {
         tsDLIterConst < timer > iter = this->timerList.firstIter ();
         while ( iter.valid () ) {
             iter->show ( level - 1u );
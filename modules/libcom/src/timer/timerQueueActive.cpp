@@ -41,10 +41,19 @@ epicsTimerQueueActive & epicsTimerQueueActive::allocate ( bool okToShare, unsign
     return pMgr->allocate ( pMgr, okToShare, threadPriority );
 }
 
+epicsTimerQueueActive & epicsTimerQueueActive::allocate ( bool okToShare,
+    unsigned threadPriority, epicsTimerQueueBackend backend )
+{
+    epicsSingleton < timerQueueActiveMgr >::reference pMgr =
+        timerQueueMgrEPICS.getReference ();
+    return pMgr->allocate ( pMgr, okToShare, threadPriority, backend );
+}
+
 timerQueueActive ::
     timerQueueActive ( RefMgr & refMgr,
-        bool okToShareIn, unsigned priority ) :
-    _refMgr ( refMgr ), queue ( *this ), thread ( *this, "timerQueue",
+        bool okToShareIn, unsigned priority,
+        epicsTimerQueueBackend backend ) :
+    _refMgr ( refMgr ), queue ( *this, backend ), thread ( *this, "timerQueue",
         epicsThreadGetStackSize ( epicsThreadStackMedium ), priority ),
     sleepQuantum ( epicsThreadSleepQuantum() ), okToShare ( okToShareIn ),
     exitFlag ( 0 ), terminateFlag ( false )
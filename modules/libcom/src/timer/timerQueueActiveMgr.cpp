@@ -29,13 +29,15 @@ timerQueueActiveMgr::~timerQueueActiveMgr ()
 }
 
 epicsTimerQueueActiveForC & timerQueueActiveMgr ::
-    allocate ( RefThis & refThis, bool okToShare, unsigned threadPriority )
+    allocate ( RefThis & refThis, bool okToShare, unsigned threadPriority,
+        epicsTimerQueueBackend backend )
 {
     epicsGuard < epicsMutex > locker ( this->mutex );
     if ( okToShare ) {
         tsDLIter < epicsTimerQueueActiveForC > iter = this->sharedQueueList.firstIter ();
         while ( iter.valid () ) {
-            if ( iter->threadPriority () == threadPriority ) {
+            if ( iter->threadPriority () == threadPriority &&
+                    iter->backend () == backend ) {
                 assert ( iter->timerQueueActiveMgrPrivate::referenceCount < UINT_MAX );
                 iter->timerQueueActiveMgrPrivate::referenceCount++;
                 return *iter;
@@ -45,7 +47,8 @@ epicsTimerQueueActiveForC & timerQueueActiveMgr ::
     }
 
     epicsTimerQueueActiveForC & queue =
-        * new epicsTimerQueueActiveForC ( refThis, okToShare, threadPriority );
+        * new epicsTimerQueueActiveForC ( refThis, okToShare,
+            threadPriority, backend );
     queue.timerQueueActiveMgrPrivate::referenceCount = 1u;
     if ( okToShare ) {
         this->sharedQueueList.add ( queue );
@@ -32,8 +32,15 @@ epicsTimerQueuePassive & epicsTimerQueuePassive::create ( epicsTimerQueueNotify
     return * new timerQueuePassive ( notify );
 }
 
-timerQueuePassive::timerQueuePassive ( epicsTimerQueueNotify &notifyIn ) :
-    queue ( notifyIn ) {}
+epicsTimerQueuePassive & epicsTimerQueuePassive::create (
+    epicsTimerQueueNotify &notify, epicsTimerQueueBackend backend )
+{
+    return * new timerQueuePassive ( notify, backend );
+}
+
+timerQueuePassive::timerQueuePassive ( epicsTimerQueueNotify &notifyIn,
+    epicsTimerQueueBackend backend ) :
+    queue ( notifyIn, backend ) {}
 
 timerQueuePassive::~timerQueuePassive () {}
 
@@ -0,0 +1,262 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Hierarchical timing wheel, an alternative to the sorted timer list.
+ *  Starting and canceling a timer takes constant time however many are
+ *  pending, and finding those which have expired takes time
+ *  proportional to the number of ticks elapsed.
+ */
+
+#include <math.h>
+#include <float.h>
+
+#include "timerPrivate.h"
+
+const double timerWheel :: tickPeriod = 0.001; // seconds
+const epicsUInt64 timerWheel :: never = ~ static_cast < epicsUInt64 > ( 0u );
+
+static const epicsUInt64 one = 1u;
+
+timerWheel::timerWheel () :
+    base ( epicsTime::getCurrent () ), curTick ( 0u ), wakeTick ( never ),
+    nPending ( 0u )
+{
+    for ( unsigned i = 0u; i < nLevels + 2u; i++ ) {
+        this->levelCount[i] = 0u;
+    }
+}
+
+// the first tick at or after the expire time, so none expire early
+epicsUInt64 timerWheel::tickOf ( const epicsTime & exp ) const
+{
+    double ticks = ceil ( ( exp - this->base ) / tickPeriod );
+    if ( ticks <= static_cast < double > ( this->curTick ) ) {
+        return this->curTick;
+    }
+    if ( ticks >= 1e18 ) {
+        ticks = 1e18;
+    }
+    return static_cast < epicsUInt64 > ( ticks );
+}
+
+// After the clock steps back count on from the current tick, so timers
+// started since are due after their delay and not the size of the step.
+void timerWheel::rebase ( const epicsTime & currentTime )
+{
+    double ticks = ( currentTime - this->base ) / tickPeriod;
+    if ( ticks + 1.0 < static_cast < double > ( this->curTick ) ) {
+        this->base = currentTime - this->curTick * tickPeriod;
+    }
+}
+
+void timerWheel::place ( timer & tmr )
+{
+    epicsUInt64 tick = this->tickOf ( tmr.exp );
+    epicsUInt64 ahead = tick - this->curTick;
+    tsDLList < timer > * pSlot = & this->overflow;
+    unsigned level = nLevels + 1u;
+
+    if ( ahead < rootSlots ) {
+        pSlot = & this->root [ tick & ( rootSlots - 1u ) ];
+        level = 0u;
+    }
+    else {
+        unsigned shift = rootBits;
+        for ( unsigned i = 0u; i < nLevels; i++ ) {
+            if ( ahead < ( one << ( shift + levelBits ) ) ) {
+                pSlot = & this->levels[i][( tick >> shift ) & ( levelSlots - 1u )];
+                level = i + 1u;
+                break;
+            }
+            shift += levelBits;
+        }
+    }
+    pSlot->add ( tmr );
+    tmr.pSlot = pSlot;
+    tmr.slotLevel = level;
+    this->levelCount[level]++;
+}
+
+bool timerWheel::insert ( timer & tmr )
+{
+    // only idle or already due timers need to read the clock
+    if ( this->nPending == 0u ||
+            ( tmr.exp - this->base ) / tickPeriod < this->curTick ) {
+        epicsTime current = epicsTime::getCurrent ();
+        this->rebase ( current );
+        if ( this->nPending == 0u ) {
+            // idle, so skip the ticks which have passed
+            double ticks = ( current - this->base ) / tickPeriod;
+            if ( ticks > static_cast < double > ( this->curTick ) ) {
+                this->curTick = static_cast < epicsUInt64 > ( ticks );
+            }
+        }
+    }
+    this->place ( tmr );
+    this->nPending++;
+
+    epicsUInt64 tick = this->tickOf ( tmr.exp );
+    if ( tick < this->wakeTick ) {
+        this->wakeTick = tick;
+        return true;
+    }
+    return false;
+}
+
+void timerWheel::remove ( timer & tmr )
+{
+    tmr.pSlot->remove ( tmr );
+    tmr.pSlot = 0;
+    this->levelCount[tmr.slotLevel]--;
+    this->nPending--;
+}
+
+// move the timers in a slot down to where they now belong
+void timerWheel::cascade ( tsDLList < timer > & slot )
+{
+    tsDLList < timer > moving;
+    slot.removeAll ( moving );
+    timer * pTmr;
+    while ( ( pTmr = moving.get () ) ) {
+        this->levelCount[pTmr->slotLevel]--;
+        this->place ( *pTmr );
+    }
+}
+
+// the slots of each level are due when the level below wraps around
+void timerWheel::advance ()
+{
+    unsigned shift = rootBits;
+    for ( unsigned i = 0u; i < nLevels; i++ ) {
+        if ( this->curTick & ( ( one << shift ) - 1u ) ) {
+            return;
+        }
+        this->cascade ( this->levels[i][
+            ( this->curTick >> shift ) & ( levelSlots - 1u )] );
+        shift += levelBits;
+    }
+    this->cascade ( this->overflow );
+}
+
+timer * timerWheel::expired ( const epicsTime & currentTime )
+{
+    this->rebase ( currentTime );
+    // woken at the start of a tick may look like just before it
+    double now = ( currentTime - this->base ) / tickPeriod + 1e-3;
+    if ( now < static_cast < double > ( this->curTick ) ) {
+        return 0;
+    }
+    epicsUInt64 nowTick = static_cast < epicsUInt64 > ( now < 1e18 ? now : 1e18 );
+
+    while ( true ) {
+        timer * pTmr = this->root[this->curTick & ( rootSlots - 1u )].get ();
+        if ( pTmr ) {
+            pTmr->pSlot = 0;
+            this->levelCount[0]--;
+            this->nPending--;
+            return pTmr;
+        }
+        if ( this->curTick >= nowTick ) {
+            return 0;
+        }
+        if ( this->nPending == 0u ) {
+            this->curTick = nowTick;
+            return 0;
+        }
+
+        // step over ticks where no slot can have any timers
+        epicsUInt64 next = this->curTick + 1u;
+        if ( this->levelCount[0] == 0u ) {
+            unsigned shift = rootBits;
+            for ( unsigned i = 1u; i < nLevels && this->levelCount[i] == 0u; i++ ) {
+                shift += levelBits;
+            }
+            next = ( ( this->curTick >> shift ) + 1u ) << shift;
+            if ( next > nowTick ) {
+                this->curTick = nowTick;
+                return 0;
+            }
+        }
+        this->curTick = next;
+        this->advance ();
+    }
+}
+
+// no timer expires before this tick
+epicsUInt64 timerWheel::firstTick () const
+{
+    epicsUInt64 first = never;
+
+    if ( this->levelCount[0] ) {
+        for ( unsigned i = 0u; i < rootSlots; i++ ) {
+            if ( this->root[( this->curTick + i ) & ( rootSlots - 1u )].count () ) {
+                first = this->curTick + i;
+                break;
+            }
+        }
+    }
+    // the higher levels are only known to the start of a slot
+    unsigned shift = rootBits;
+    for ( unsigned l = 0u; l < nLevels; l++ ) {
+        if ( this->levelCount[l + 1u] ) {
+            epicsUInt64 pos = this->curTick >> shift;
+            for ( unsigned i = 1u; i <= levelSlots; i++ ) {
+                if ( this->levels[l][( pos + i ) & ( levelSlots - 1u )].count () ) {
+                    epicsUInt64 tick = ( pos + i ) << shift;
+                    if ( tick < first ) {
+                        first = tick;
+                    }
+                    break;
+                }
+            }
+        }
+        shift += levelBits;
+    }
+    if ( this->overflow.count () ) {
+        shift -= levelBits;
+        epicsUInt64 tick = ( ( this->curTick >> shift ) + 1u ) << shift;
+        if ( tick < first ) {
+            first = tick;
+        }
+    }
+    return first;
+}
+
+double timerWheel::delay ( const epicsTime & currentTime )
+{
+    this->wakeTick = this->firstTick ();
+    if ( this->wakeTick == never ) {
+        return DBL_MAX;
+    }
+    double delay = ( this->base + this->wakeTick * tickPeriod ) - currentTime;
+    return delay > 0.0 ? delay : 0.0;
+}
+
+timer * timerWheel::get ()
+{
+    tsDLList < timer > * pSlot = 0;
+    if ( this->nPending == 0u ) {
+        return 0;
+    }
+    for ( unsigned i = 0u; ! pSlot && i < rootSlots; i++ ) {
+        if ( this->root[i].count () ) {
+            pSlot = & this->root[i];
+        }
+    }
+    for ( unsigned l = 0u; ! pSlot && l < nLevels; l++ ) {
+        for ( unsigned i = 0u; ! pSlot && i < levelSlots; i++ ) {
+            if ( this->levels[l][i].count () ) {
+                pSlot = & this->levels[l][i];
+            }
+        }
+    }
+    if ( ! pSlot ) {
+        pSlot = & this->overflow;
+    }
+    timer * pTmr = pSlot->first ();
+    this->remove ( *pTmr );
+    return pTmr;
+}
@@ -0,0 +1,114 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Compare the speed of calcPerform() and calcPerformCompiled() on
+ * expressions of the kind found in calc and calcout records.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "postfix.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+#define NLOOPS 1000000
+
+static const char * const corpus[] = {
+    "A+B",
+    "A-B",
+    "A*B+C",
+    "(A+B)/2",
+    "(A+B+C+D)/4",
+    "A*0.001+B",
+    "A*1000/3600",
+    "(A-32)*5/9",
+    "A>B?A:B",
+    "A<0?0:A>10?10:A",
+    "A&&B",
+    "A#0&&B#0",
+    "A>=B&&A<=C",
+    "ABS(A-B)>C",
+    "A=1?B:A=2?C:D",
+    "!A",
+    "A?1:0",
+    "(A>>4)&0xF",
+    "A|(B<<8)",
+    "SQRT(A*A+B*B)",
+    "SIN(A*PI/180)",
+    "NINT(A*100)/100",
+    "FLOOR(A/B)",
+    "MAX(A,B,C,D)",
+    "MIN(A,0)",
+    "LOG(A)/LOG(10)",
+    "VAL+1",
+    "(VAL+A)%360",
+    "A*(1+2*3-4/8)+B*2**10",
+    "C:=C+1;C>10?0:C",
+};
+
+static double measure(const char *rpn, const calcCompiled *pcompiled)
+{
+    double args[CALCPERFORM_NARGS] = {
+        1.5, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
+    };
+    double result = 0.0;
+    epicsTimeStamp t0, t1;
+    int i;
+
+    epicsTimeGetCurrent(&t0);
+    if (pcompiled) {
+        for (i = 0; i < NLOOPS; i++)
+            calcPerformCompiled(args, &result, pcompiled);
+    }
+    else {
+        for (i = 0; i < NLOOPS; i++)
+            calcPerform(args, &result, rpn);
+    }
+    epicsTimeGetCurrent(&t1);
+    return epicsTimeDiffInSeconds(&t1, &t0) / NLOOPS;
+}
+
+MAIN(epicsCalcPerform)
+{
+    double total = 0.0, ctotal = 0.0;
+    unsigned i;
+
+    printf("Nanoseconds per evaluation\n");
+    printf("%-24s %12s %12s %8s\n", "expression", "calcPerform",
+        "compiled", "speedup");
+    for (i = 0; i < sizeof(corpus) / sizeof(corpus[0]); i++) {
+        char *rpn = malloc(INFIX_TO_POSTFIX_SIZE(strlen(corpus[i]) + 1));
+        calcCompiled *pcompiled;
+        double t, ct;
+        short err;
+
+        if (!rpn || postfix(corpus[i], rpn, &err)) {
+            printf("%-24s can't be parsed\n", corpus[i]);
+            free(rpn);
+            continue;
+        }
+        pcompiled = calcCompile(rpn);
+        if (!pcompiled) {
+            printf("%-24s can't be compiled\n", corpus[i]);
+            free(rpn);
+            continue;
+        }
+
+        t = measure(rpn, NULL);
+        ct = measure(rpn, pcompiled);
+        total += t;
+        ctotal += ct;
+        printf("%-24s %12.1f %12.1f %8.2f\n", corpus[i], t * 1e9, ct * 1e9,
+            t / ct);
+        calcCompiledFree(pcompiled);
+        free(rpn);
+    }
+    printf("%-24s %12.1f %12.1f %8.2f\n", "all", total * 1e9, ctotal * 1e9,
+        total / ctotal);
+    return 0;
+}
@@ -19,6 +19,35 @@
 
 /* Infrastructure for running tests */
 
+static int nCompiled, nCompiledDiffer;
+
+void checkCompiled(const char *expr, const char *rpn,
+    long status, double result) {
+    /* Evaluate the compiled form, which must give the identical result */
+    double args[CALCPERFORM_NARGS] = {
+        1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0, 9.0, 10.0, 11.0, 12.0
+    };
+    calcCompiled *pcompiled = calcCompile(rpn);
+    double cresult = 0.0;
+    long cstatus;
+    cresult /= cresult;  /* Start as NaN */
+
+    nCompiled++;
+    if (!pcompiled) {
+        testDiag("calcCompile: failed for '%s'", expr);
+        nCompiledDiffer++;
+        return;
+    }
+    cstatus = calcPerformCompiled(args, &cresult, pcompiled);
+    if (cstatus != status ||
+        (!status && memcmp(&cresult, &result, sizeof(double)) != 0)) {
+        testDiag("calcPerformCompiled: '%s' gave %g (status %ld), not %g (%ld)",
+            expr, cresult, cstatus, result, status);
+        nCompiledDiffer++;
+    }
+    calcCompiledFree(pcompiled);
+}
+
 double doCalc(const char *expr) {
     /* Evaluate expression, return result */
     double args[CALCPERFORM_NARGS] = {
@@ -62,10 +91,14 @@ void testCalc(const char *expr, double expected) {
 
     if (postfix(expr, rpn, &err)) {
         testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
-    } else
-        if (calcPerform(args, &result, rpn) && finite(result)) {
+    } else {
+        long status = calcPerform(args, &result, rpn);
+
+        if (status && finite(result)) {
             testDiag("calcPerform: error evaluating '%s'", expr);
         }
+        checkCompiled(expr, rpn, status, result);
+    }
 
     if (finite(expected) && finite(result)) {
         pass = fabs(expected - result) < 1e-8;
@@ -100,10 +133,14 @@ void testUInt32Calc(const char *expr, epicsUInt32 expected) {
 
     if (postfix(expr, rpn, &err)) {
         testDiag("postfix: %s in expression '%s'", calcErrorStr(err), expr);
-    } else
-        if (calcPerform(args, &result, rpn) && finite(result)) {
+    } else {
+        long status = calcPerform(args, &result, rpn);
+
+        if (status && finite(result)) {
             testDiag("calcPerform: error evaluating '%s'", expr);
         }
+        checkCompiled(expr, rpn, status, result);
+    }
 
     uresult = (result < 0.0 ? (epicsUInt32)(epicsInt32)result : (epicsUInt32)result);
     pass = (uresult == expected);
@@ -298,7 +335,7 @@ MAIN(epicsCalcTest)
     const double a=1.0, b=2.0, c=3.0, d=4.0, e=5.0, f=6.0,
                  g=7.0, h=8.0, i=9.0, j=10.0, k=11.0, l=12.0;
 
-    testPlan(630);
+    testPlan(631);
 
     /* LITERAL_OPERAND elements */
     testExpr(0);
@@ -1005,5 +1042,8 @@ MAIN(epicsCalcTest)
     testUInt32Calc("-1431655766.1 << 0.1", 0xaaaaaaaau);
     testUInt32Calc("2863311530.1 << 0.1", 0xaaaaaaaau);
 
+    testOk(nCompiledDiffer == 0,
+        "Compiled results identical for %d expressions", nCompiled);
+
     return testDone();
 }
@@ -83,6 +83,7 @@ typedef struct {
 } clientPvt;
 
 static void testLogPrefix(void);
+static void testBatchListener(void);
 static void acceptNewClient( void *pParam );
 static void readFromClient( void *pParam );
 static void testPrefixLogandCompare( const char* logmessage);
@@ -167,13 +168,95 @@ void logClient(void* raw, const char* msg)
     epicsEventSignal(pvt->done);
 }
 
+typedef struct {
+    unsigned int calls;
+    unsigned int count;
+    int ordered;
+    int jam;
+    epicsEventId jammer;
+} batchPvt;
+
+/* Expects the messages "0", "1", "2" ... */
+static
+void batchClient(void *raw, const char * const *messages, int count)
+{
+    batchPvt *pvt = raw;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (atoi(messages[i]) != pvt->count++)
+            pvt->ordered = 0;
+    }
+    pvt->calls++;
+
+    if (pvt->jam) {
+        pvt->jam = 0;
+        epicsEventMustWait(pvt->jammer);
+    }
+}
+
+static void testBatchListener(void)
+{
+    batchPvt pvt;
+    errlogDropCounts before, after;
+    int i;
+
+    testDiag("Check batch listener");
+
+    /* Clear "errlog: <n> messages were discarded" status */
+    errlogPrintfNoConsole(".");
+    errlogFlush();
+
+    memset(&pvt, 0, sizeof pvt);
+    pvt.ordered = 1;
+    pvt.jammer = epicsEventMustCreate(epicsEventEmpty);
+    errlogAddBatchListener(&batchClient, &pvt);
+
+    /* The first message holds up the rest, which then arrive together */
+    pvt.jam = 1;
+    errlogPrintfNoConsole("0");
+    epicsThreadSleep(0.5);
+    for (i = 1; i <= 10; i++)
+        errlogPrintfNoConsole("%d", i);
+    epicsEventSignal(pvt.jammer);
+    errlogFlush();
+
+    testEqInt(pvt.count, 11);
+    testEqInt(pvt.calls, 2);
+    testOk(pvt.ordered, "Messages delivered in order");
+
+    testDiag("Check drop counts");
+
+    /* Fill the buffer with severity messages */
+    eltc(0);
+    pvt.jam = 1;
+    errlogPrintfNoConsole("%d", pvt.count);
+    epicsThreadSleep(0.5);
+    errlogGetDropCounts(&before);
+    while (errlogSevPrintf(errlogMajor, "%s", longmsg))
+        ;
+    errlogGetDropCounts(&after);
+    epicsEventSignal(pvt.jammer);
+    eltc(1);
+
+    testEqInt(after.severity[errlogMajor] - before.severity[errlogMajor], 1);
+    testEqInt(after.severity[errlogMinor] - before.severity[errlogMinor], 0);
+    testEqInt(after.other - before.other, 0);
+
+    testOk(1 == errlogRemoveBatchListeners(&batchClient, &pvt),
+        "Removed 1 batch listener");
+    epicsEventDestroy(pvt.jammer);
+}
+
 MAIN(epicsErrlogTest)
 {
     size_t mlen, i, N;
     char msg[256];
     clientPvt pvt, pvt2;
+    errlogDropCounts drops;
+    size_t nother;
 
-    testPlan(40);
+    testPlan(49);
 
     strcpy(msg, truncmsg);
 
@@ -329,24 +412,25 @@ MAIN(epicsErrlogTest)
 
     testDiag("Checking buffer use after partial flush");
 
-    /* Use the numbers from the largest block size above */
+    /* Use the largest block size above */
     mlen /= 2;
     msg[mlen - 1] = '\0';
 
+    errlogGetDropCounts(&drops);
+    nother = drops.other;
+
     pvt.jam = 1;
     pvt.count = 0;
 
-    testDiag("Filling with %d messages of size %d", (int) N, (int) mlen);
-
-    for (i = 0; i < N; i++) {
-        errlogPrintfNoConsole("%s", msg);
-    }
+    for (N = 0; errlogPrintfNoConsole("%s", msg); N++)
+        ;
+    testDiag("Filled with %d messages of size %d", (int) N, (int) mlen);
 
     testOk(epicsEventWaitWithTimeout(pvt.done, 0.5) == epicsEventWaitTimeout,
         "%d: Listener 1 didn't run", __LINE__);
     testEqInt(pvt.count, 0);
 
-    /* Extract the first 2 messages, 2*(sizeof(msgNode) + 128) bytes */
+    /* Extract the first 2 messages */
     pvt.jam = -2;
     epicsEventSignal(pvt.jammer);
     epicsThreadSleep(0.5);
@@ -355,11 +439,10 @@ MAIN(epicsErrlogTest)
     epicsEventMustWait(pvt.done);
     testEqInt(pvt.count, 2);
 
-    /* The buffer has space for 1 more message: sizeof(msgNode) + 256 bytes */
-    errlogPrintfNoConsole("%s", msg); /* Use up that space */
-
-    testDiag("Overflow the buffer");
-    errlogPrintfNoConsole("%s", msg);
+    /* Their space can be reused, until the buffer overflows again */
+    for (i = 0; errlogPrintfNoConsole("%s", msg); i++)
+        ;
+    testOk(i >= 1, "%d more messages fit", (int) i);
 
     testOk(epicsEventWaitWithTimeout(pvt.done, 0.5) == epicsEventWaitTimeout,
         "%d: Listener 1 didn't run", __LINE__);
@@ -370,12 +453,17 @@ MAIN(epicsErrlogTest)
 
     testDiag("Logged %u messages", pvt.count);
     epicsEventMustWait(pvt.done);
-    testEqInt(pvt.count, N+1);
+    testEqInt(pvt.count, N + i);
+
+    errlogGetDropCounts(&drops);
+    testEqInt(drops.other - nother, 2);
 
     /* Clean up */
     testOk(1 == errlogRemoveListeners(&logClient, &pvt),
         "Removed 1 listener");
 
+    testBatchListener();
+
     testLogPrefix();
 
     return testDone();
@@ -50,6 +50,8 @@ int epicsTimeZoneTest(void);
 #endif
 int epicsTypesTest(void);
 int epicsInlineTest(void);
+int fdManagerTest(void);
+int freeListTest(void);
 int ipAddrToAsciiTest(void);
 int macDefExpandTest(void);
 int macLibTest(void);
@@ -105,6 +107,8 @@ void epicsRunLibComTests(void)
     runTest(epicsTimeZoneTest);
 #endif
     runTest(epicsTypesTest);
+    runTest(fdManagerTest);
+    runTest(freeListTest);
     runTest(ipAddrToAsciiTest);
     runTest(macDefExpandTest);
     runTest(macLibTest);
@@ -0,0 +1,111 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Measure how long it takes to start, restart, cancel and expire
+ *  timers as the number pending grows, with each timer queue backend.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "epicsTimer.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+namespace {
+
+class perfNotify : public epicsTimerNotify, public epicsTimerQueueNotify {
+public:
+    perfNotify () : count ( 0u ) {}
+    unsigned long count;
+private:
+    expireStatus expire ( const epicsTime & )
+    {
+        count++;
+        return noRestart;
+    }
+    void reschedule () {}
+    double quantum () { return 0.0; }
+};
+
+// up to a minute ahead, in microseconds
+double randomDelay ()
+{
+    return 1.0 + ( rand () % 59000000 ) * 1e-6;
+}
+
+void measure ( epicsTimerQueueBackend backend, const char * pName,
+    unsigned n )
+{
+    printf ( "%-12s %7u ", pName, n );
+    if ( backend == epicsTimerQueueSortedList && n > 20000u ) {
+        printf ( "%10s %10s %10s %10s  (too slow)\n", "-", "-", "-", "-" );
+        return;
+    }
+
+    perfNotify notify;
+    epicsTimerQueuePassive & queue =
+        epicsTimerQueuePassive::create ( notify, backend );
+    epicsTimer ** pTimers = new epicsTimer * [n];
+    for ( unsigned i = 0u; i < n; i++ ) {
+        pTimers[i] = & queue.createTimer ();
+    }
+
+    srand ( 1u );
+    epicsTime now = epicsTime::getCurrent ();
+    epicsTime begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < n; i++ ) {
+        pTimers[i]->start ( notify, now + randomDelay () );
+    }
+    double start = ( epicsTime::getCurrent () - begin ) / n;
+
+    begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < n; i++ ) {
+        pTimers[i]->start ( notify, now + randomDelay () );
+    }
+    double restart = ( epicsTime::getCurrent () - begin ) / n;
+
+    begin = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < n; i++ ) {
+        pTimers[i]->cancel ();
+    }
+    double cancel = ( epicsTime::getCurrent () - begin ) / n;
+
+    for ( unsigned i = 0u; i < n; i++ ) {
+        pTimers[i]->start ( notify, now + randomDelay () );
+    }
+    begin = epicsTime::getCurrent ();
+    queue.process ( now + 61.0 );
+    double expire = ( epicsTime::getCurrent () - begin ) / n;
+    if ( notify.count != n ) {
+        fprintf ( stderr, "%lu of %u timers expired\n", notify.count, n );
+    }
+
+    printf ( "%10.3f %10.3f %10.3f %10.3f\n", start * 1e6, restart * 1e6,
+        cancel * 1e6, expire * 1e6 );
+
+    for ( unsigned i = 0u; i < n; i++ ) {
+        pTimers[i]->destroy ();
+    }
+    delete [] pTimers;
+    delete & queue;
+}
+
+} // namespace
+
+MAIN(epicsTimerPerform)
+{
+    static const unsigned counts[] = { 100u, 1000u, 10000u, 100000u };
+
+    printf ( "Timers expiring randomly within a minute, microseconds each\n" );
+    printf ( "%-12s %7s %10s %10s %10s %10s\n", "backend", "timers",
+        "start", "restart", "cancel", "expire" );
+    for ( unsigned i = 0u; i < sizeof ( counts ) / sizeof ( counts[0] ); i++ ) {
+        measure ( epicsTimerQueueSortedList, "sorted list", counts[i] );
+        measure ( epicsTimerQueueTimingWheel, "timing wheel", counts[i] );
+    }
+    return 0;
+}
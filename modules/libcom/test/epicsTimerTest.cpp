@@ -14,6 +14,7 @@
  */
 
 #include <math.h>
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -59,6 +60,11 @@ void testRefCount()
     T2->destroy();
     Q2->release();
 
+    Q2 = &epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin,
+        epicsTimerQueueTimingWheel );
+    testOk(Q1!=Q2, "Queues with different backends not shared");
+    Q2->release();
+
     T1->destroy();
     Q1->release();
 }
@@ -140,7 +146,7 @@ epicsTimerNotify::expireStatus delayVerify::expire ( const epicsTime &currentTim
 //
 // verify reasonable timer interval accuracy
 //
-void testAccuracy ()
+void testAccuracy ( epicsTimerQueueBackend backend )
 {
     static const unsigned nTimers = 25u;
     delayVerify *pTimers[nTimers];
@@ -150,7 +156,8 @@ void testAccuracy ()
     testDiag ( "Testing timer accuracy" );
 
     epicsTimerQueueActive &queue =
-        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMax );
+        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMax,
+            backend );
 
     for ( i = 0u; i < nTimers; i++ ) {
         pTimers[i] = new delayVerify ( i * 0.1 + delayVerifyOffset, queue );
@@ -231,7 +238,7 @@ epicsTimerNotify::expireStatus cancelVerify::expire ( const epicsTime & )
 //
 // verify that expire() won't be called after the timer is cancelled
 //
-void testCancel ()
+void testCancel ( epicsTimerQueueBackend backend )
 {
     static const unsigned nTimers = 25u;
     cancelVerify *pTimers[nTimers];
@@ -244,7 +251,8 @@ void testCancel ()
     testDiag ( "Testing timer cancellation" );
 
     epicsTimerQueueActive &queue =
-        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin );
+        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin,
+            backend );
 
     for ( i = 0u; i < nTimers; i++ ) {
         pTimers[i] = new cancelVerify ( queue );
@@ -322,7 +330,7 @@ epicsTimerNotify::expireStatus expireDestroyVerify::expire ( const epicsTime & )
 //
 // verify that a timer can be destroyed in expire
 //
-void testExpireDestroy ()
+void testExpireDestroy ( epicsTimerQueueBackend backend )
 {
     static const unsigned nTimers = 25u;
     expireDestroyVerify *pTimers[nTimers];
@@ -333,7 +341,8 @@ void testExpireDestroy ()
     testDiag ( "Testing timer destruction in expire()" );
 
     epicsTimerQueueActive &queue =
-        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin );
+        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin,
+            backend );
 
     for ( i = 0u; i < nTimers; i++ ) {
         pTimers[i] = new expireDestroyVerify ( queue );
@@ -417,7 +426,7 @@ epicsTimerNotify::expireStatus periodicVerify::expire ( const epicsTime & )
 //
 // verify periodic timers
 //
-void testPeriodic ()
+void testPeriodic ( epicsTimerQueueBackend backend )
 {
     static const unsigned nTimers = 25u;
     periodicVerify *pTimers[nTimers];
@@ -427,7 +436,8 @@ void testPeriodic ()
     testDiag ( "Testing periodic timers" );
 
     epicsTimerQueueActive &queue =
-        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin );
+        epicsTimerQueueActive::allocate ( true, epicsThreadPriorityMin,
+            backend );
 
     for ( i = 0u; i < nTimers; i++ ) {
         pTimers[i] = new periodicVerify ( queue );
@@ -454,13 +464,164 @@ void testPeriodic ()
     queue.release ();
 }
 
+class passiveNotify : public epicsTimerQueueNotify {
+public:
+    unsigned rescheduled;
+    passiveNotify () : rescheduled ( 0u ) {}
+    void reschedule () { rescheduled++; }
+    double quantum () { return 0.0; }
+};
+
+class orderVerify : public epicsTimerNotify {
+public:
+    orderVerify ( epicsTimerQueue & queue ) :
+        timer ( queue.createTimer () ), nExpire ( 0u ), order ( 0u ) {}
+    ~orderVerify () { timer.destroy (); }
+    epicsTimer & timer;
+    epicsTime due;
+    epicsTime expired;
+    unsigned nExpire;
+    unsigned order;
+    static unsigned nextOrder;
+private:
+    expireStatus expire ( const epicsTime & currentTime )
+    {
+        expired = currentTime;
+        nExpire++;
+        order = nextOrder++;
+        return noRestart;
+    }
+};
+
+unsigned orderVerify::nextOrder;
+
+//
+// verify that a timing wheel expires timers from a millisecond
+// to months ahead, in order and no more than a tick late
+//
+void testWheel ()
+{
+    static const double delays[] = {
+        0.0, 0.0005, 0.001, 0.2, 0.256, 0.3, 5.0, 17.0, 300.0,
+        7200.0, 86400.0, 5.0e6, 1.0e7
+    };
+    static const unsigned nTimers = sizeof ( delays ) / sizeof ( delays[0] );
+    orderVerify *pTimers[nTimers];
+    unsigned i;
+
+    testDiag ( "Testing timing wheel with a passive queue" );
+
+    passiveNotify notify;
+    epicsTimerQueuePassive & queue =
+        epicsTimerQueuePassive::create ( notify, epicsTimerQueueTimingWheel );
+    epicsTime start = epicsTime::getCurrent ();
+
+    for ( i = 0u; i < nTimers; i++ ) {
+        pTimers[i] = new orderVerify ( queue );
+        pTimers[i]->due = start + delays[i];
+        pTimers[i]->timer.start ( *pTimers[i], pTimers[i]->due );
+    }
+    testOk ( notify.rescheduled > 0u, "Reschedule requested" );
+
+    // a second start moves the timer, cancel removes it
+    pTimers[nTimers - 1u]->due = start + 2.0;
+    pTimers[nTimers - 1u]->timer.start ( *pTimers[nTimers - 1u],
+        pTimers[nTimers - 1u]->due );
+    orderVerify * pCanceled = new orderVerify ( queue );
+    pCanceled->timer.start ( *pCanceled, start + 1.0 );
+    pCanceled->timer.cancel ();
+
+    orderVerify::nextOrder = 0u;
+    epicsTime now = start;
+    unsigned wakeups = 0u;
+    while ( wakeups < 1000u ) {
+        double delay = queue.process ( now );
+        if ( delay == DBL_MAX ) {
+            break;
+        }
+        now += delay;
+        wakeups++;
+    }
+
+    bool once = true, early = false, late = false, ordered = true;
+    double maxLate = 0.0;
+    for ( i = 0u; i < nTimers; i++ ) {
+        orderVerify & t = *pTimers[i];
+        double lateness = t.expired - t.due;
+        once &= t.nExpire == 1u;
+        early |= lateness < -1e-6;
+        late |= lateness > 0.001 + 1e-6;
+        if ( lateness > maxLate ) {
+            maxLate = lateness;
+        }
+        for ( unsigned j = 0u; j < nTimers; j++ ) {
+            if ( pTimers[j]->due < t.due && pTimers[j]->order > t.order ) {
+                ordered = false;
+            }
+        }
+    }
+    testOk ( once, "Each timer expired once" );
+    testOk ( ! early, "None expired early" );
+    testOk ( ! late, "None expired more than a tick late (%.3f ms)",
+        maxLate * 1000.0 );
+    testOk ( ordered, "Expired in order" );
+    testOk ( pCanceled->nExpire == 0u && wakeups < 100u,
+        "Canceled timer not expired, %u calls to process()", wakeups );
+
+    for ( i = 0u; i < nTimers; i++ ) {
+        delete pTimers[i];
+    }
+    delete pCanceled;
+    delete & queue;
+}
+
+//
+// verify that a timer started after the clock steps back expires
+// after its delay, and is not held back by the size of the step
+//
+void testWheelStepBack ()
+{
+    testDiag ( "Testing timing wheel after a backward clock step" );
+
+    passiveNotify notify;
+    epicsTimerQueuePassive & queue =
+        epicsTimerQueuePassive::create ( notify, epicsTimerQueueTimingWheel );
+    epicsTime start = epicsTime::getCurrent ();
+
+    // the wheel is processed 10 seconds ahead of the clock,
+    // which looks the same as the clock then stepping back
+    orderVerify * pPending = new orderVerify ( queue );
+    pPending->timer.start ( *pPending, start + 20.0 );
+    queue.process ( start + 10.0 );
+
+    orderVerify * pStepped = new orderVerify ( queue );
+    pStepped->due = epicsTime::getCurrent () + 0.2;
+    pStepped->timer.start ( *pStepped, pStepped->due );
+    queue.process ( pStepped->due - 0.1 );
+    testOk ( pStepped->nExpire == 0u, "Not expired before it is due" );
+    queue.process ( pStepped->due + 0.002 );
+    testOk ( pStepped->nExpire == 1u, "Expired when due after a step back" );
+
+    delete pPending;
+    delete pStepped;
+    delete & queue;
+}
+
 MAIN(epicsTimerTest)
 {
-    testPlan(41);
+    testPlan(90);
     testRefCount();
-    testAccuracy ();
-    testCancel ();
-    testExpireDestroy ();
-    testPeriodic ();
+    testWheel ();
+    testWheelStepBack ();
+    testDiag ( "Sorted list backend" );
+    testAccuracy ( epicsTimerQueueSortedList );
+    testCancel ( epicsTimerQueueSortedList );
+    testExpireDestroy ( epicsTimerQueueSortedList );
+    testPeriodic ( epicsTimerQueueSortedList );
+    testDiag ( "Timing wheel backend" );
+    testAccuracy ( epicsTimerQueueTimingWheel );
+    testCancel ( epicsTimerQueueTimingWheel );
+    testExpireDestroy ( epicsTimerQueueTimingWheel );
+    testPeriodic ( epicsTimerQueueTimingWheel );
     return testDone();
 }
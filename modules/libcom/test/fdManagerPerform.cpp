@@ -0,0 +1,178 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Measure how long fdManager::process() takes to dispatch activity on
+ *  one of many registered sockets, and on a tenth of them at once, with
+ *  each backend.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fdManager.h"
+#include "osiSock.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <sys/resource.h>
+#endif
+
+namespace {
+
+class perfReg : public fdReg {
+public:
+    perfReg ( SOCKET fd, fdManager & mgr ) :
+        fdReg ( fd, fdrRead, false, mgr ), count ( 0 ) {}
+    unsigned long count;
+private:
+    void callBack ()
+    {
+        char buf[4];
+        recv ( getFD (), buf, sizeof ( buf ), 0 );
+        count++;
+    }
+};
+
+struct perfSock {
+    SOCKET sock;
+    osiSockAddr addr;
+    perfReg * pReg;
+};
+
+bool openSockets ( perfSock * socks, unsigned n )
+{
+    for ( unsigned i = 0u; i < n; i++ ) {
+        perfSock & s = socks[i];
+        s.pReg = 0;
+        s.sock = epicsSocketCreate ( AF_INET, SOCK_DGRAM, 0 );
+        if ( s.sock == INVALID_SOCKET ) {
+            while ( i-- > 0u )
+                epicsSocketDestroy ( socks[i].sock );
+            return false;
+        }
+        memset ( &s.addr, 0, sizeof ( s.addr ) );
+        s.addr.ia.sin_family = AF_INET;
+        s.addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+        osiSocklen_t slen = sizeof ( s.addr );
+        if ( bind ( s.sock, &s.addr.sa, sizeof ( s.addr.ia ) ) ||
+                getsockname ( s.sock, &s.addr.sa, &slen ) ) {
+            fprintf ( stderr, "Can't bind socket\n" );
+            exit ( 1 );
+        }
+    }
+    return true;
+}
+
+void closeSockets ( perfSock * socks, unsigned n )
+{
+    for ( unsigned i = 0u; i < n; i++ ) {
+        delete socks[i].pReg;
+        epicsSocketDestroy ( socks[i].sock );
+    }
+}
+
+void send ( SOCKET from, const perfSock & to )
+{
+    char msg = 'x';
+    sendto ( from, &msg, 1, 0, &to.addr.sa, sizeof ( to.addr.ia ) );
+}
+
+void measure ( fdManagerBackend backend, unsigned n, unsigned iter )
+{
+    fdManager mgr ( backend );
+    perfSock * socks = new perfSock [n];
+    SOCKET sender = epicsSocketCreate ( AF_INET, SOCK_DGRAM, 0 );
+
+    printf ( "%-7s %6u ", mgr.backendName (), n );
+    if ( ! openSockets ( socks, n ) ) {
+        printf ( "%12s %12s  (too many sockets)\n", "-", "-" );
+        delete [] socks;
+        epicsSocketDestroy ( sender );
+        return;
+    }
+    for ( unsigned i = 0u; i < n; i++ ) {
+        if ( backend == fdmbSelect && ! FD_IN_FDSET ( socks[i].sock ) ) {
+            printf ( "%12s %12s  (fd > FD_SETSIZE)\n", "-", "-" );
+            closeSockets ( socks, n );
+            delete [] socks;
+            epicsSocketDestroy ( sender );
+            return;
+        }
+        socks[i].pReg = new perfReg ( socks[i].sock, mgr );
+    }
+
+    // one active among n idle, round trip of send and dispatch
+    epicsTime start = epicsTime::getCurrent ();
+    for ( unsigned i = 0u; i < iter; i++ ) {
+        perfSock & s = socks[( i * 7919u ) % n];
+        unsigned long before = s.pReg->count;
+        send ( sender, s );
+        while ( s.pReg->count == before )
+            mgr.process ( 1.0 );
+    }
+    double single = ( epicsTime::getCurrent () - start ) / iter;
+
+    // a tenth of them active together
+    unsigned nActive = n / 10u;
+    unsigned rounds = iter / nActive + 1u;
+    unsigned long events = 0u;
+    double busy = 0.0;
+    for ( unsigned r = 0u; r < rounds; r++ ) {
+        unsigned long total = 0u;
+        for ( unsigned i = 0u; i < n; i++ )
+            total += socks[i].pReg->count;
+        for ( unsigned i = 0u; i < nActive; i++ )
+            send ( sender, socks[( r + i * 10u ) % n] );
+        start = epicsTime::getCurrent ();
+        unsigned long now;
+        do {
+            mgr.process ( 1.0 );
+            now = 0u;
+            for ( unsigned i = 0u; i < n; i++ )
+                now += socks[i].pReg->count;
+        } while ( now < total + nActive );
+        busy += epicsTime::getCurrent () - start;
+        events += nActive;
+    }
+
+    printf ( "%12.2f %12.3f\n", single * 1e6, busy / events * 1e6 );
+
+    closeSockets ( socks, n );
+    delete [] socks;
+    epicsSocketDestroy ( sender );
+}
+
+} // namespace
+
+MAIN(fdManagerPerform)
+{
+    static const unsigned counts[] = { 100u, 1000u, 10000u };
+    const unsigned iter = 2000u;
+
+#if defined(__unix__) || defined(__APPLE__)
+    {
+        struct rlimit lim;
+        if ( getrlimit ( RLIMIT_NOFILE, &lim ) == 0 ) {
+            lim.rlim_cur = lim.rlim_max;
+            setrlimit ( RLIMIT_NOFILE, &lim );
+        }
+    }
+#endif
+    osiSockAttach ();
+
+    printf ( "fdManager dispatch, %u iterations\n", iter );
+    printf ( "%-7s %6s %12s %12s\n", "backend", "fds",
+        "1 active us", "10% us/event" );
+    for ( unsigned i = 0u; i < sizeof ( counts ) / sizeof ( counts[0] ); i++ ) {
+        measure ( fdmbDefault, counts[i], iter );
+        measure ( fdmbSelect, counts[i], iter );
+    }
+
+    osiSockRelease ();
+    return 0;
+}
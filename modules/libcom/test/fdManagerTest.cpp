@@ -0,0 +1,245 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ *  Check that fdManager dispatches file descriptor activity the same
+ *  way with each of its backends.
+ */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "fdManager.h"
+#include "osiSock.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#if defined(__linux__)
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/socket.h>
+#endif
+
+namespace {
+
+// A UDP socket bound to the loopback interface
+struct udpSock {
+    SOCKET sock;
+    osiSockAddr addr;
+
+    udpSock () : sock ( epicsSocketCreate ( AF_INET, SOCK_DGRAM, 0 ) )
+    {
+        if ( sock == INVALID_SOCKET )
+            testAbort ( "Can't create socket" );
+        memset ( &addr, 0, sizeof ( addr ) );
+        addr.ia.sin_family = AF_INET;
+        addr.ia.sin_addr.s_addr = htonl ( INADDR_LOOPBACK );
+        osiSocklen_t slen = sizeof ( addr );
+        if ( bind ( sock, &addr.sa, sizeof ( addr.ia ) ) ||
+                getsockname ( sock, &addr.sa, &slen ) )
+            testAbort ( "Can't bind socket" );
+    }
+    ~udpSock ()
+    {
+        epicsSocketDestroy ( sock );
+    }
+    void send ( SOCKET from ) const
+    {
+        char msg = 'x';
+        if ( sendto ( from, &msg, 1, 0, &addr.sa, sizeof ( addr.ia ) ) != 1 )
+            testAbort ( "Can't send datagram" );
+    }
+};
+
+class testReg : public fdReg {
+public:
+    testReg ( SOCKET fd, fdRegType type, fdManager & mgr,
+            bool onceOnly = false ) :
+        fdReg ( fd, type, onceOnly, mgr ), count ( 0 ),
+        deleteSelf ( false ), pDestroyed ( 0 ) {}
+    ~testReg ()
+    {
+        if ( pDestroyed )
+            *pDestroyed = true;
+    }
+    unsigned count;
+    bool deleteSelf;
+    bool * pDestroyed;
+private:
+    void callBack ()
+    {
+        count++;
+        if ( getType () == fdrRead ) {
+            // one datagram per call
+            char buf[4];
+            recv ( getFD (), buf, sizeof ( buf ), 0 );
+        }
+        if ( deleteSelf )
+            delete this;
+    }
+};
+
+void testBackend ( fdManagerBackend backend, const char * name )
+{
+    fdManager mgr ( backend );
+    udpSock a, b;
+
+    testDiag ( "fdManager using %s", name );
+    testOk ( strcmp ( mgr.backendName (), name ) == 0,
+        "backendName() is \"%s\"", mgr.backendName () );
+
+    testReg * pRead = new testReg ( a.sock, fdrRead, mgr );
+    testOk1 ( mgr.lookUpFD ( a.sock, fdrRead ) == pRead );
+    testOk1 ( mgr.lookUpFD ( a.sock, fdrWrite ) == NULL );
+
+    mgr.process ( 0.01 );
+    testOk ( pRead->count == 0u, "Idle socket not dispatched" );
+
+    a.send ( b.sock );
+    mgr.process ( 1.0 );
+    testOk ( pRead->count == 1u, "Readable socket dispatched" );
+    mgr.process ( 0.01 );
+    testOk ( pRead->count == 1u, "Not dispatched after input read" );
+
+    // unread input is reported again, as with select()
+    a.send ( b.sock );
+    a.send ( b.sock );
+    mgr.process ( 1.0 );
+    mgr.process ( 1.0 );
+    testOk ( pRead->count == 3u, "Each pending datagram dispatched (%u)",
+        pRead->count );
+
+    try {
+        testReg dup ( a.sock, fdrRead, mgr );
+        testFail ( "Duplicate registration accepted" );
+    }
+    catch ( fdManager::fdInterestSubscriptionAlreadyExits & ) {
+        testPass ( "Duplicate registration rejected" );
+    }
+
+    // write interest on the same fd as the read, used once
+    bool writeDestroyed = false;
+    testReg * pWrite = new testReg ( a.sock, fdrWrite, mgr, true );
+    pWrite->pDestroyed = & writeDestroyed;
+    mgr.process ( 1.0 );
+    testOk ( writeDestroyed, "Once only write dispatched and destroyed" );
+    testOk1 ( mgr.lookUpFD ( a.sock, fdrWrite ) == NULL );
+    testOk ( pRead->count == 3u, "Read not dispatched by write" );
+
+    a.send ( b.sock );
+    mgr.process ( 1.0 );
+    testOk ( pRead->count == 4u, "Read still dispatched after write removed" );
+
+    // removal of an interest in its own callBack()
+    bool readDestroyed = false;
+    pRead->deleteSelf = true;
+    pRead->pDestroyed = & readDestroyed;
+    a.send ( b.sock );
+    mgr.process ( 1.0 );
+    testOk ( readDestroyed, "Read interest deleted in callBack()" );
+    testOk1 ( mgr.lookUpFD ( a.sock, fdrRead ) == NULL );
+
+    // an fd which is closed while its interest exists
+    {
+        udpSock c;
+        testReg * pClosed = new testReg ( c.sock, fdrRead, mgr );
+        epicsSocketDestroy ( c.sock );
+        delete pClosed;
+        c.sock = epicsSocketCreate ( AF_INET, SOCK_DGRAM, 0 );
+    }
+
+    // several ready at once
+    udpSock s[5];
+    testReg * regs[5];
+    for ( unsigned i = 0u; i < 5u; i++ ) {
+        regs[i] = new testReg ( s[i].sock, fdrRead, mgr );
+        if ( i % 2u == 0u )
+            s[i].send ( b.sock );
+    }
+    mgr.process ( 1.0 );
+    testOk ( regs[0]->count == 1u && regs[1]->count == 0u &&
+        regs[2]->count == 1u && regs[3]->count == 0u &&
+        regs[4]->count == 1u, "Only the readable sockets dispatched" );
+    for ( unsigned i = 0u; i < 5u; i++ )
+        delete regs[i];
+
+#if defined(__linux__)
+    if ( strcmp ( name, "epoll" ) == 0 ) {
+        // descriptors select() can't handle
+        int high = fcntl ( a.sock, F_DUPFD, FD_SETSIZE + 10 );
+        if ( high < 0 ) {
+            testSkip ( 4, "Can't create fd above FD_SETSIZE" );
+        }
+        else {
+            testReg * pHigh = new testReg ( high, fdrRead, mgr );
+            a.send ( b.sock );
+            mgr.process ( 1.0 );
+            testOk ( pHigh->count == 1u, "fd %d > FD_SETSIZE dispatched",
+                high );
+
+            // a regular file, which epoll() can't watch, registered after it
+            FILE * fp = tmpfile ();
+            if ( ! fp ) {
+                testSkip ( 3, "Can't create temporary file" );
+            }
+            else {
+                testReg * pFile = new testReg ( fileno ( fp ), fdrWrite, mgr );
+                testOk ( strcmp ( mgr.backendName (), "epoll" ) == 0,
+                    "Still using %s with a regular file", mgr.backendName () );
+                mgr.process ( 1.0 );
+                testOk ( pFile->count == 1u, "Regular file dispatched" );
+                a.send ( b.sock );
+                mgr.process ( 1.0 );
+                testOk ( pHigh->count == 2u,
+                    "fd > FD_SETSIZE dispatched with a regular file" );
+                delete pFile;
+                fclose ( fp );
+            }
+            delete pHigh;
+            close ( high );
+        }
+
+        // a hang up is reported whatever the interest
+        int sv[2];
+        if ( socketpair ( AF_UNIX, SOCK_STREAM, 0, sv ) ) {
+            testSkip ( 1, "Can't create socket pair" );
+        }
+        else {
+            bool excDestroyed = false;
+            testReg * pExc = new testReg ( sv[0], fdrException, mgr, true );
+            pExc->pDestroyed = & excDestroyed;
+            shutdown ( sv[0], SHUT_RDWR );
+            mgr.process ( 1.0 );
+            testOk ( excDestroyed, "Hang up dispatched to exception interest" );
+            if ( ! excDestroyed )
+                delete pExc;
+            close ( sv[0] );
+            close ( sv[1] );
+        }
+    }
+#endif
+}
+
+} // namespace
+
+MAIN(fdManagerTest)
+{
+#if defined(__linux__)
+    testPlan(35);
+#else
+    testPlan(30);
+#endif
+    osiSockAttach ();
+
+#if defined(__linux__)
+    testBackend ( fdmbDefault, "epoll" );
+#else
+    testBackend ( fdmbDefault, "select" );
+#endif
+    testBackend ( fdmbSelect, "select" );
+
+    osiSockRelease ();
+    return testDone();
+}
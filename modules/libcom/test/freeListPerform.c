@@ -0,0 +1,84 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Measure freeListMalloc()/freeListFree() throughput with 1 to 16
+ * threads sharing one list, with and without per-thread caches.
+ */
+
+#include <stdio.h>
+
+#include "freeList.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsTime.h"
+#include "testMain.h"
+
+#define NLOOPS 200000
+#define NBATCH 8
+#define MAXTHREADS 16
+
+static void *pvt;
+static epicsEventId start;
+
+static void churn(void *arg)
+{
+    void *blocks[NBATCH];
+    unsigned i, j;
+
+    epicsEventMustWait(start);
+    /* wake the next one */
+    epicsEventMustTrigger(start);
+    for (i = 0; i < NLOOPS; i++) {
+        for (j = 0; j < NBATCH; j++)
+            blocks[j] = freeListMalloc(pvt);
+        for (j = 0; j < NBATCH; j++)
+            freeListFree(pvt, blocks[j]);
+    }
+}
+
+static double measure(int ncache, unsigned nthreads)
+{
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    epicsThreadId tids[MAXTHREADS];
+    epicsTimeStamp t0, t1;
+    unsigned i;
+
+    if (ncache)
+        freeListInitPvtCached(&pvt, 64, 256, ncache);
+    else
+        freeListInitPvt(&pvt, 64, 256);
+    start = epicsEventMustCreate(epicsEventEmpty);
+    opts.joinable = 1;
+    for (i = 0; i < nthreads; i++)
+        tids[i] = epicsThreadCreateOpt("churn", churn, NULL, &opts);
+
+    epicsTimeGetCurrent(&t0);
+    epicsEventMustTrigger(start);
+    for (i = 0; i < nthreads; i++)
+        epicsThreadMustJoin(tids[i]);
+    epicsTimeGetCurrent(&t1);
+
+    epicsEventDestroy(start);
+    freeListCleanup(pvt);
+    /* malloc+free pairs per second */
+    return nthreads * (double) NLOOPS * NBATCH /
+        epicsTimeDiffInSeconds(&t1, &t0);
+}
+
+MAIN(freeListPerform)
+{
+    unsigned nthreads;
+
+    printf("freeListMalloc()+freeListFree() pairs, millions per second\n");
+    printf("%8s %12s %12s\n", "threads", "locked", "cached");
+    for (nthreads = 1; nthreads <= MAXTHREADS; nthreads *= 2) {
+        double locked = measure(0, nthreads);
+        double cached = measure(32, nthreads);
+
+        printf("%8u %12.2f %12.2f\n", nthreads, locked / 1e6, cached / 1e6);
+    }
+    return 0;
+}
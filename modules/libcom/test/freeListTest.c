@@ -0,0 +1,235 @@
+/*************************************************************************\
+* SPDX-License-Identifier: EPICS
+* EPICS BASE is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+\*************************************************************************/
+/*
+ * Check the block accounting of free lists with and without per-thread
+ * caches, and that cached blocks are never handed out twice.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "freeList.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+#include "epicsUnitTest.h"
+#include "testMain.h"
+
+#define NMALLOC 4
+#define NCACHE 8
+#define NBLOCKS 50
+
+typedef struct {
+    void *pvt;
+    void *blocks[NBLOCKS];
+    unsigned n;
+} blockSet;
+
+static void allocBlocks(void *arg)
+{
+    blockSet *pset = arg;
+
+    for (pset->n = 0; pset->n < NBLOCKS; pset->n++)
+        pset->blocks[pset->n] = freeListMalloc(pset->pvt);
+}
+
+static void freeBlocks(void *arg)
+{
+    blockSet *pset = arg;
+
+    while (pset->n > 0)
+        freeListFree(pset->pvt, pset->blocks[--pset->n]);
+}
+
+static void allocFree(void *arg)
+{
+    allocBlocks(arg);
+    freeBlocks(arg);
+}
+
+static void runThread(const char *name, EPICSTHREADFUNC func, void *arg)
+{
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    epicsThreadId tid;
+
+    opts.joinable = 1;
+    tid = epicsThreadCreateOpt(name, func, arg, &opts);
+    if (!tid)
+        testAbort("Can't create thread %s", name);
+    epicsThreadMustJoin(tid);
+}
+
+/* No block on the list is handed out twice */
+static int allDistinct(void * const *blocks, unsigned n)
+{
+    unsigned i, j;
+
+    for (i = 0; i < n; i++)
+        for (j = i + 1; j < n; j++)
+            if (blocks[i] == blocks[j])
+                return 0;
+    return 1;
+}
+
+/* Blocks only come into existence nmalloc at a time and are never lost.
+ * Those in other threads' caches aren't available to this one, so the
+ * list may grow.
+ */
+static size_t total;
+
+static void testTotal(const blockSet *pset, const char *what)
+{
+    size_t avail = freeListItemsAvail(pset->pvt);
+    size_t now = pset->n + avail;
+
+    testOk(now % NMALLOC == 0 && now >= total,
+        "%s: %u allocated + %u available", what, pset->n, (unsigned) avail);
+    total = now;
+}
+
+static void testAccounting(int ncache)
+{
+    blockSet set;
+
+    testDiag("Free list with ncache=%d", ncache);
+    if (ncache)
+        freeListInitPvtCached(&set.pvt, 24, NMALLOC, ncache);
+    else
+        freeListInitPvt(&set.pvt, 24, NMALLOC);
+    testOk1(freeListItemsAvail(set.pvt) == 0);
+    total = 0;
+
+    allocBlocks(&set);
+    testOk(allDistinct(set.blocks, set.n), "%u blocks distinct", set.n);
+    testTotal(&set, "malloc");
+    freeBlocks(&set);
+    testTotal(&set, "free");
+
+    /* allocated in another thread, freed here */
+    runThread("alloc", allocBlocks, &set);
+    testTotal(&set, "malloc by thread");
+    freeBlocks(&set);
+    testTotal(&set, "free");
+
+    /* allocated here, freed by another thread which then exits */
+    allocBlocks(&set);
+    runThread("free", freeBlocks, &set);
+    testTotal(&set, "free by thread");
+
+    /* a thread which uses the list and exits */
+    runThread("allocFree", allocFree, &set);
+    testTotal(&set, "malloc and free by thread");
+
+    allocBlocks(&set);
+    testOk(allDistinct(set.blocks, set.n), "%u blocks distinct", set.n);
+    freeBlocks(&set);
+    testTotal(&set, "free");
+
+    freeListCleanup(set.pvt);
+}
+
+#define NTHREADS 4
+#define NLOOPS 2000
+
+typedef struct {
+    void *pvt;
+    unsigned id;
+    int ok;
+} stressArg;
+
+/* Each block is stamped by its owner while in use */
+static void stress(void *arg)
+{
+    stressArg *parg = arg;
+    unsigned *blocks[16];
+    unsigned i, j, n;
+
+    parg->ok = 1;
+    for (i = 0; i < NLOOPS; i++) {
+        n = 1 + (i * 7 + parg->id) % 16;
+        for (j = 0; j < n; j++) {
+            blocks[j] = freeListMalloc(parg->pvt);
+            blocks[j][0] = parg->id;
+            blocks[j][1] = j;
+        }
+        epicsThreadSleep(0.0);
+        for (j = 0; j < n; j++) {
+            if (blocks[j][0] != parg->id || blocks[j][1] != j)
+                parg->ok = 0;
+            freeListFree(parg->pvt, blocks[j]);
+        }
+    }
+}
+
+static void testStress(void)
+{
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    epicsThreadId tids[NTHREADS];
+    stressArg args[NTHREADS];
+    void *pvt;
+    unsigned i;
+    int ok = 1;
+
+    testDiag("%d threads sharing a cached free list", NTHREADS);
+    freeListInitPvtCached(&pvt, 2 * sizeof(unsigned), NMALLOC, NCACHE);
+    opts.joinable = 1;
+    for (i = 0; i < NTHREADS; i++) {
+        args[i].pvt = pvt;
+        args[i].id = i + 1;
+        tids[i] = epicsThreadCreateOpt("stress", stress, &args[i], &opts);
+        if (!tids[i])
+            testAbort("Can't create thread");
+    }
+    for (i = 0; i < NTHREADS; i++) {
+        epicsThreadMustJoin(tids[i]);
+        ok &= args[i].ok;
+    }
+    testOk(ok, "No block used by two threads at once");
+    testOk(freeListItemsAvail(pvt) % NMALLOC == 0,
+        "%u available, none lost", (unsigned) freeListItemsAvail(pvt));
+    freeListCleanup(pvt);
+}
+
+/* A thread holding a cache exits after the list is cleaned up */
+static blockSet lateSet;
+static epicsEventId lateUsed, lateExit;
+
+static void late(void *arg)
+{
+    allocFree(&lateSet);
+    epicsEventMustTrigger(lateUsed);
+    epicsEventMustWait(lateExit);
+}
+
+static void testCleanup(void)
+{
+    epicsThreadOpts opts = EPICS_THREAD_OPTS_INIT;
+    epicsThreadId tid;
+
+    lateUsed = epicsEventMustCreate(epicsEventEmpty);
+    lateExit = epicsEventMustCreate(epicsEventEmpty);
+    freeListInitPvtCached(&lateSet.pvt, 24, NMALLOC, NCACHE);
+    opts.joinable = 1;
+    tid = epicsThreadCreateOpt("late", late, NULL, &opts);
+    if (!tid)
+        testAbort("Can't create thread");
+    epicsEventMustWait(lateUsed);
+    freeListCleanup(lateSet.pvt);
+    epicsEventMustTrigger(lateExit);
+    epicsThreadMustJoin(tid);
+    testPass("Thread exit after freeListCleanup()");
+    epicsEventDestroy(lateUsed);
+    epicsEventDestroy(lateExit);
+}
+
+MAIN(freeListTest)
+{
+    testPlan(23);
+    testAccounting(0);
+    testAccounting(NCACHE);
+    testStress();
+    testCleanup();
+    return testDone();
+}
@@ -60,7 +60,7 @@ MAIN(ringBytesTest)
     char get[RINGSIZE+1];
     epicsRingBytesId ring;
 
-    testPlan(292);
+    testPlan(293);
 
     pinfo = calloc(1,sizeof(info));
     if (!pinfo) {
@@ -124,6 +124,12 @@ MAIN(ringBytesTest)
     testOk(n==1, "ring get %d", 1);
     check(ring, RINGSIZE, 1);
 
+    n = epicsRingBytesPut(ring, put, 5);
+    epicsRingBytesResetHighWaterMark(ring);
+    testOk(epicsRingBytesHighWaterMark(ring) == 5,
+        "HighWaterMark reset to usage: %d == 5",
+        epicsRingBytesHighWaterMark(ring));
+
     epicsRingBytesDelete(ring);
     epicsEventDestroy(consumerEvent);
     free(pinfo);
@@ -139,6 +139,49 @@ static void testSingle(void)
     epicsRingPointerDelete(ring);
 }
 
+static void testBulk(int locked)
+{
+    const int rsize = 10;
+    void *in[15], *out[15];
+    int i, n, ok;
+    epicsRingPointerId ring = locked ? epicsRingPointerLockedCreate(rsize) :
+        epicsRingPointerCreate(rsize);
+
+    testDiag("Bulk operations with%s locking", locked ? "" : "out");
+
+    for (i = 0; i < 15; i++)
+        in[i] = int2ptr(i + 1);
+
+    testOk1(epicsRingPointerPopN(ring, out, 15) == 0);
+    n = epicsRingPointerPushN(ring, in, 15);
+    testOk(n == rsize, "pushN to empty ring %d == %d", n, rsize);
+    testOk1(epicsRingPointerIsFull(ring));
+    testOk1(epicsRingPointerGetHighWaterMark(ring) == rsize);
+    testOk1(epicsRingPointerPushN(ring, in, 1) == 0);
+
+    n = epicsRingPointerPopN(ring, out, 7);
+    ok = n == 7;
+    for (i = 0; i < n; i++)
+        ok &= out[i] == in[i];
+    testOk(ok, "popN 7 in order");
+    testOk1(epicsRingPointerGetUsed(ring) == 3);
+
+    /* these wrap around the end of the buffer */
+    epicsRingPointerResetHighWaterMark(ring);
+    n = epicsRingPointerPushN(ring, in + 10, 5);
+    testOk(n == 5, "pushN across the end %d == 5", n);
+    testOk1(epicsRingPointerGetHighWaterMark(ring) == 8);
+    testOk1(epicsRingPointerPop(ring) == in[7]);
+    n = epicsRingPointerPopN(ring, out, 15);
+    ok = n == 7;
+    for (i = 0; i < n; i++)
+        ok &= out[i] == in[i + 8];
+    testOk(ok, "popN across the end %d == 7, in order", n);
+    testOk1(epicsRingPointerIsEmpty(ring));
+
+    epicsRingPointerDelete(ring);
+}
+
 typedef struct {
     epicsRingPointerId ring;
     epicsEventId sync, wait;
@@ -244,8 +287,10 @@ MAIN(ringPointerTest)
 {
     int prio = epicsThreadGetPrioritySelf();
 
-    testPlan(42);
+    testPlan(66);
     testSingle();
+    testBulk(0);
+    testBulk(1);
     if (prio)
         epicsThreadSetPriority(epicsThreadGetIdSelf(), epicsThreadPriorityScanLow);
     testPair(0);